@@ -27,6 +27,7 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include <functional>
 #include <vector>
 #include <Eigen/Geometry> 
 
@@ -169,6 +170,9 @@ struct indexed_triangle_set
 };
 
 extern bool stl_open(stl_file *stl, const char *file);
+// Read an STL file in chunks of at most chunk_size facets without keeping all the facets in memory.
+// fn() is called for each chunk, stl->stats are filled in as by stl_open(), stl->facet_start stays empty.
+extern bool stl_read_chunks(stl_file *stl, const char *file, size_t chunk_size, const std::function<void(std::vector<stl_facet>&)> &fn);
 extern void stl_stats_out(stl_file *stl, FILE *file, char *input_file);
 extern bool stl_print_neighbors(stl_file *stl, char *file);
 extern bool stl_write_ascii(stl_file *stl, const char *file, const char *label);
@@ -142,21 +142,11 @@ static FILE* stl_open_count_facets(stl_file *stl, const char *file)
   	return fp;
 }
 
-/* Reads the contents of the file pointed to by fp into the stl structure,
-   starting at facet first_facet.  The second argument says if it's our first
-   time running this for the stl and therefore we should reset our max and min stats. */
-static bool stl_read(stl_file *stl, FILE *fp, int first_facet, bool first)
+// Read a single facet from a binary or ASCII .STL file, i is the index of the facet for error reporting.
+static bool stl_read_facet(FILE *fp, stl_type type, uint32_t i, stl_facet &facet)
 {
-	if (stl->stats.type == binary)
-    	fseek(fp, HEADER_SIZE, SEEK_SET);
-  	else
-    	rewind(fp);
-
   	char normal_buf[3][32];
-  	for (uint32_t i = first_facet; i < stl->stats.number_of_facets; ++ i) {
-  	  	stl_facet facet;
-
-    	if (stl->stats.type == binary) {
+    	if (type == binary) {
       		// Read a single facet from a binary .STL file. We assume little-endian architecture!
       		if (fread(&facet, 1, SIZEOF_STL_FACET, fp) != SIZEOF_STL_FACET)
       			return false;
@@ -231,6 +221,23 @@ static bool stl_read(stl_file *stl, FILE *fp, int first_facet, bool first)
 			}
 		}
 
+	return true;
+}
+
+/* Reads the contents of the file pointed to by fp into the stl structure,
+   starting at facet first_facet.  The second argument says if it's our first
+   time running this for the stl and therefore we should reset our max and min stats. */
+static bool stl_read(stl_file *stl, FILE *fp, int first_facet, bool first)
+{
+	if (stl->stats.type == binary)
+    	fseek(fp, HEADER_SIZE, SEEK_SET);
+  	else
+    	rewind(fp);
+
+  	for (uint32_t i = first_facet; i < stl->stats.number_of_facets; ++ i) {
+  	  	stl_facet facet;
+  	  	if (! stl_read_facet(fp, stl->stats.type, i, facet))
+  	  		return false;
 		// Write the facet into memory.
 		stl->facet_start[i] = facet;
 		stl_facet_stats(stl, facet, first);
@@ -254,6 +261,49 @@ bool stl_open(stl_file *stl, const char *file)
   	return result;
 }
 
+bool stl_read_chunks(stl_file *stl, const char *file, size_t chunk_size, const std::function<void(std::vector<stl_facet>&)> &fn)
+{
+    Slic3r::CNumericLocalesSetter locales_setter;
+	stl->clear();
+	FILE *fp = stl_open_count_facets(stl, file);
+	if (fp == nullptr)
+		return false;
+	if (stl->stats.type == binary)
+    	fseek(fp, HEADER_SIZE, SEEK_SET);
+  	else
+    	rewind(fp);
+
+	std::vector<stl_facet> chunk;
+	chunk.reserve(std::min<size_t>(std::max<size_t>(chunk_size, 1), stl->stats.number_of_facets));
+	bool first  = true;
+	bool result = true;
+	try {
+	  	for (uint32_t i = 0; i < stl->stats.number_of_facets; ++ i) {
+	  	  	stl_facet facet;
+	  	  	if (! stl_read_facet(fp, stl->stats.type, i, facet)) {
+	  	  		result = false;
+	  	  		break;
+	  	  	}
+			stl_facet_stats(stl, facet, first);
+			chunk.emplace_back(facet);
+			if (chunk.size() >= chunk_size) {
+				fn(chunk);
+				chunk.clear();
+			}
+	  	}
+	  	if (result && ! chunk.empty())
+	  		fn(chunk);
+	} catch (...) {
+		// fn() may throw, for example on cancellation.
+		fclose(fp);
+		throw;
+	}
+  	fclose(fp);
+  	stl->stats.size = stl->stats.max - stl->stats.min;
+  	stl->stats.bounding_diameter = stl->stats.size.norm();
+  	return result;
+}
+
 void stl_allocate(stl_file *stl) 
 {
   	//  Allocate memory for the entire .STL file.
@@ -1352,6 +1352,9 @@ mz_bool mz_zip_writer_add_staged_open(mz_zip_archive* pZip, mz_zip_writer_staged
     mz_uint64 max_size, const MZ_TIME_T* pFile_time, const void* pComment, mz_uint16 comment_size, mz_uint level_and_flags,
     const char* user_extra_data, mz_uint user_extra_data_len, const char* user_extra_data_central, mz_uint user_extra_data_central_len);
 mz_bool mz_zip_writer_add_staged_data(mz_zip_writer_staged_context* pContext, const char* pRead_buf, size_t n);
+/* Appends data, which was already deflated by the caller (possibly in parallel) into a raw deflate stream with tdefl_create_comp_flags_from_zip_params(level, -15, ...). */
+/* The deflated data must not reference any preceding data and it must end with TDEFL_FULL_FLUSH and without a final block. pRead_buf/n is the source data, it is needed for the CRC. */
+mz_bool mz_zip_writer_add_staged_deflated_data(mz_zip_writer_staged_context* pContext, const char* pRead_buf, size_t n, const void* pComp_buf, size_t comp_n);
 mz_bool mz_zip_writer_add_staged_finish(mz_zip_writer_staged_context* pContext);
 
 /* Adds a file to an archive by fully cloning the data from another archive. */
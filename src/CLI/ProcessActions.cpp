@@ -150,7 +150,7 @@ static std::string output_filepath(const Model& model, IO::ExportFormat format,
     return proposed_path.string();
 }
 
-static bool export_models(std::vector<Model>& models, IO::ExportFormat format, const std::string& cmdline_param)
+static bool export_models(std::vector<Model>& models, IO::ExportFormat format, const std::string& cmdline_param, int compression_level = -1)
 {
     for (Model& model : models) {
         const std::string path = output_filepath(model, format, cmdline_param);
@@ -158,7 +158,7 @@ static bool export_models(std::vector<Model>& models, IO::ExportFormat format, c
         switch (format) {
         case IO::OBJ: success = Slic3r::store_obj(path.c_str(), &model);          break;
         case IO::STL: success = Slic3r::store_stl(path.c_str(), &model, true);    break;
-        case IO::TMF: success = Slic3r::store_3mf(path.c_str(), &model, nullptr, false); break;
+        case IO::TMF: success = Slic3r::store_3mf(path.c_str(), &model, nullptr, false, nullptr, true, compression_level); break;
         default: assert(false); break;
         }
         if (success)
@@ -315,7 +315,12 @@ bool process_actions(Data& cli, const DynamicPrintConfig& print_config, std::vec
             return 1;
     }
     if (actions.has("export_3mf")) {
-        if (!export_models(models, IO::TMF, output))
+        const int compression_level = cli.misc_config.has("compression_level") ? cli.misc_config.opt_int("compression_level") : -1;
+        if (cli.misc_config.has("compression_level") && (compression_level < 1 || compression_level > 9)) {
+            boost::nowide::cerr << "error: --compression-level must be between 1 (fastest) and 9 (smallest), " << compression_level << " given." << std::endl;
+            return 1;
+        }
+        if (!export_models(models, IO::TMF, output, compression_level))
             return 1;
     }
 
@@ -15,7 +15,9 @@
 
 namespace Slic3r {
 
-static bool load_preset_bundle_from_datadir(PresetBundle& preset_bundle)
+// If system_presets_filter is not empty, only the named system presets, the system parents of the named user presets
+// and their parents are loaded from the vendor bundles, see PresetBundle::load_presets().
+static bool load_preset_bundle_from_datadir(PresetBundle& preset_bundle, std::set<std::string> system_presets_filter = {})
 {
     AppConfig app_config = AppConfig(AppConfig::EAppMode::Editor);
     if (!app_config.exists()) {
@@ -37,6 +39,7 @@ static bool load_preset_bundle_from_datadir(PresetBundle& preset_bundle)
     std::string delayed_error_load_presets;
     // Suppress the '- default -' presets.
     preset_bundle.set_default_suppressed(app_config.get_bool("no_defaults"));
+    preset_bundle.system_presets_filter = std::move(system_presets_filter);
     try {
         auto preset_substitutions = preset_bundle.load_presets(app_config, ForwardCompatibilitySubstitutionRule::EnableSystemSilent);
         if (!preset_substitutions.empty()) {
@@ -420,7 +423,7 @@ std::string get_json_print_filament_profiles(const std::string& printer_profile)
 bool load_full_print_config(const std::string& print_preset_name, const std::string& filament_preset_name, const std::string& printer_preset_name, DynamicPrintConfig& config)
 {
     PresetBundle preset_bundle;
-    if (!load_preset_bundle_from_datadir(preset_bundle)){
+    if (!load_preset_bundle_from_datadir(preset_bundle, { print_preset_name, filament_preset_name, printer_preset_name })){
         BOOST_LOG_TRIVIAL(error) << Slic3r::format("Failed to load data from the datadir '%1%'.", data_dir());
         return false;
     }
@@ -470,8 +473,11 @@ std::string load_full_print_config(const std::string& print_preset_name,
 
     // check preset bundle
 
+    std::set<std::string> system_presets_filter { print_preset_name, printer_preset_name };
+    system_presets_filter.insert(material_preset_names_in.begin(), material_preset_names_in.end());
+
     PresetBundle preset_bundle;
-    if (!load_preset_bundle_from_datadir(preset_bundle))
+    if (!load_preset_bundle_from_datadir(preset_bundle, std::move(system_presets_filter)))
         return Slic3r::format("Failed to load data from the datadir '%1%'.", data_dir());
 
     // check existance of required profiles
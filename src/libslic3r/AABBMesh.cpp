@@ -6,6 +6,7 @@
 
 #include <libslic3r/AABBTreeIndirect.hpp>
 #include <libslic3r/TriangleMesh.hpp>
+#include <libslic3r/Execution/ExecutionTBB.hpp>
 #include <igl/Hit.h>
 #include <algorithm>
 
@@ -20,8 +21,8 @@ namespace Slic3r {
 
 class AABBMesh::AABBImpl {
 private:
-    AABBTreeIndirect::Tree3f m_tree;
-    double                   m_triangle_ray_epsilon;
+    AABBTreeIndirect::WideTree3f m_tree;
+    double                       m_triangle_ray_epsilon;
 
 public:
     void init(const indexed_triangle_set &its, bool calculate_epsilon)
@@ -33,7 +34,7 @@ public:
             if (l > 0)
                 m_triangle_ray_epsilon = 0.000001 * l * l;
         }
-        m_tree = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(
+        m_tree = AABBTreeIndirect::build_wide_aabb_tree_over_indexed_triangle_set(
             its.vertices, its.indices);
     }
 
@@ -46,6 +47,15 @@ public:
                                                   m_tree, s, dir, hit, m_triangle_ray_epsilon);
     }
 
+    void intersect_rays(const indexed_triangle_set &its,
+                        tcb::span<const Vec3d>      sources,
+                        tcb::span<const Vec3d>      dirs,
+                        tcb::span<igl::Hit>         hits)
+    {
+        AABBTreeIndirect::intersect_rays_first_hit(its.vertices, its.indices,
+                                                   m_tree, sources, dirs, hits, m_triangle_ray_epsilon);
+    }
+
     void intersect_ray(const indexed_triangle_set &its,
                        const Vec3d &               s,
                        const Vec3d &               dir,
@@ -183,6 +193,55 @@ AABBMesh::query_ray_hit(const Vec3d &s, const Vec3d &dir) const
     return ret;
 }
 
+std::vector<AABBMesh::hit_result>
+AABBMesh::query_ray_hit(tcb::span<const Vec3d> sources,
+                        tcb::span<const Vec3d> dirs) const
+{
+    assert(sources.size() == dirs.size());
+
+    std::vector<hit_result> outs(sources.size(), hit_result(*this));
+
+#ifdef SLIC3R_HOLE_RAYCASTER
+    if (! m_holes.empty()) {
+        for (size_t i = 0; i < sources.size(); ++i)
+            outs[i] = query_ray_hit(sources[i], dirs[i]);
+
+        return outs;
+    }
+#endif
+
+    // Chunks of a few ray packets are the units of parallel work, a batch
+    // which fits into a single chunk is processed on the calling thread.
+    static constexpr size_t ChunkSize = 8 * AABBTreeIndirect::detail::RayPacketSize;
+
+    std::vector<igl::Hit> hits(sources.size());
+    size_t chunks = (sources.size() + ChunkSize - 1) / ChunkSize;
+
+    execution::for_each(ex_tbb, size_t(0), chunks,
+        [this, sources, dirs, &hits, &outs](size_t chunk) {
+            size_t from = chunk * ChunkSize;
+            size_t n    = std::min(ChunkSize, sources.size() - from);
+
+            m_aabb->intersect_rays(*m_tm, sources.subspan(from, n),
+                                   dirs.subspan(from, n),
+                                   tcb::span<igl::Hit>{hits}.subspan(from, n));
+
+            for (size_t i = from; i < from + n; ++i) {
+                assert(is_approx(dirs[i].norm(), 1.));
+                hit_result &ret = outs[i];
+                ret.m_t         = double(hits[i].t);
+                ret.m_dir       = dirs[i];
+                ret.m_source    = sources[i];
+                if (!std::isinf(hits[i].t) && !std::isnan(hits[i].t)) {
+                    ret.m_normal  = this->normal_by_face_id(hits[i].id);
+                    ret.m_face_id = hits[i].id;
+                }
+            }
+        });
+
+    return outs;
+}
+
 std::vector<AABBMesh::hit_result>
 AABBMesh::query_ray_hits(const Vec3d &s, const Vec3d &dir) const
 {
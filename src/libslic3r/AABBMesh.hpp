@@ -7,6 +7,7 @@
 
 #include <libslic3r/Point.hpp>
 #include <libslic3r/TriangleMesh.hpp>
+#include <tcbspan/span.hpp>
 #include <assert.h>
 #include <stddef.h>
 #include <memory>
@@ -125,6 +126,13 @@ public:
 
     // Casting a ray on the mesh, returns the distance where the hit occures.
     hit_result query_ray_hit(const Vec3d &s, const Vec3d &dir) const;
+
+    // Casting a batch of rays on the mesh, the i-th result belongs to the ray
+    // sources[i], dirs[i]. The rays are traversed in packets, which is faster
+    // than casting them one by one if the neighboring rays are coherent (e.g.
+    // samples around a beam). Large batches are processed in parallel.
+    std::vector<hit_result> query_ray_hit(tcb::span<const Vec3d> sources,
+                                          tcb::span<const Vec3d> dirs) const;
     
     // Casts a ray on the mesh and returns all hits
     std::vector<hit_result> query_ray_hits(const Vec3d &s, const Vec3d &dir) const;
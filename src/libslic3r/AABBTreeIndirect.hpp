@@ -11,14 +11,19 @@
 #define slic3r_AABBTreeIndirect_hpp_
 
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
 #include <limits>
 #include <type_traits>
 #include <vector>
 
 #include <Eigen/Geometry>
+#include <tcbspan/span.hpp>
 
 #include "BoundingBox.hpp"
 #include "Utils.hpp" // for next_highest_power_of_2()
+#include "Execution/ExecutionTBB.hpp"
 
 // Definition of the ray intersection hit structure.
 #include <igl/Hit.h>
@@ -222,6 +227,354 @@ using Tree3f = Tree<3, float>;
 using Tree2d = Tree<2, double>;
 using Tree3d = Tree<3, double>;
 
+// Wide AABB tree with AWidth (4 or 8) children per node, an alternative to Tree for large meshes,
+// where traversal of the binary Tree is bound by memory latency. The wide tree is shallower, all children
+// of a node are tested at once and the bounding boxes of the children are quantised to 8 bits relative
+// to the bounding box of their parent, so that a node of a 4-wide float tree occupies a single cache line.
+// The tree is built top-down using the Surface Area Heuristic (SAH) with binning, the subtrees are built
+// in parallel. As with Tree, each leaf references a single source entity.
+// The wide tree is queried by the same functions as Tree (intersect_ray_first_hit(), traverse() etc).
+template<int ANumDimensions, typename ACoordType, int AWidth = 4>
+class WideTree
+{
+public:
+    static constexpr int    NumDimensions = ANumDimensions;
+    static constexpr int    Width         = AWidth;
+    using                   CoordType     = ACoordType;
+    using                   VectorType    = Eigen::Matrix<CoordType, NumDimensions, 1, Eigen::DontAlign>;
+    using                   BoundingBox   = Eigen::AlignedBox<CoordType, NumDimensions>;
+
+    static_assert(Width == 4 || Width == 8, "Only 4-wide and 8-wide trees are supported.");
+    static_assert(std::is_floating_point<CoordType>::value, "Quantised bounding boxes require floating point coordinates.");
+
+    struct alignas(64) Node {
+        static constexpr int      Width       = AWidth;
+        // Reference to a child: 0 for an unused slot (the root node is never a child),
+        // index of an inner node or index of the source entity with leaf_bit set.
+        static constexpr uint32_t empty_child = 0;
+        static constexpr uint32_t leaf_bit    = uint32_t(1) << 31;
+
+        // Bounding box of the i-th child in dimension d spans
+        // <origin[d] + qmin[d][i] * scale[d], origin[d] + qmax[d][i] * scale[d]>.
+        // The quantised boxes are rounded outwards, thus they contain the exact bounding boxes.
+        std::array<CoordType, NumDimensions>                  origin;
+        std::array<CoordType, NumDimensions>                  scale;
+        std::array<std::array<uint8_t, Width>, NumDimensions> qmin;
+        std::array<std::array<uint8_t, Width>, NumDimensions> qmax;
+        std::array<uint32_t, Width>                           children {};
+
+        bool        is_used(int i)   const { return this->children[i] != empty_child; }
+        bool        is_leaf(int i)   const { return (this->children[i] & leaf_bit) != 0; }
+        bool        is_inner(int i)  const { return this->is_used(i) && ! this->is_leaf(i); }
+        // Index of the source entity referenced by a leaf child.
+        size_t      idx(int i)       const { assert(this->is_leaf(i)); return size_t(this->children[i] & ~leaf_bit); }
+        // Index of an inner child node.
+        size_t      child_idx(int i) const { assert(this->is_inner(i)); return size_t(this->children[i]); }
+        CoordType   min(int d, int i) const { return this->origin[d] + CoordType(this->qmin[d][i]) * this->scale[d]; }
+        CoordType   max(int d, int i) const { return this->origin[d] + CoordType(this->qmax[d][i]) * this->scale[d]; }
+        BoundingBox bbox(int i) const {
+            BoundingBox out;
+            for (int d = 0; d < NumDimensions; ++ d) {
+                out.min()(d) = this->min(d, i);
+                out.max()(d) = this->max(d, i);
+            }
+            return out;
+        }
+    };
+
+    void clear() { m_nodes.clear(); }
+
+    // SourceNode shall implement the same interface as required by Tree::build().
+    template<typename SourceNode>
+    void build(std::vector<SourceNode> &&input)
+    {
+        this->build_modify_input(input);
+        input.clear();
+    }
+
+    template<typename SourceNode>
+    void build(const std::vector<SourceNode> &input)
+    {
+        std::vector<SourceNode> copy(input);
+        this->build(std::move(copy));
+    }
+
+    template<typename SourceNode>
+    void build_modify_input(std::vector<SourceNode> &input)
+    {
+        if (input.empty()) {
+            clear();
+            return;
+        }
+        assert(input.size() < size_t(Node::leaf_bit));
+        Cluster root = make_cluster(input, 0, input.size());
+        m_bbox = root.bbox;
+        // Each inner node has at least two children, thus there are less inner nodes than entities.
+        // A subtree over n entities is built into its own block of n - 1 nodes, so that the subtrees
+        // may be built in parallel. The unused nodes are removed afterwards.
+        m_nodes.assign(std::max(input.size() - 1, size_t(1)), Node());
+        build_recursive(input, 0, root);
+        compact();
+    }
+
+    const std::vector<Node>&    nodes() const { return m_nodes; }
+    const Node&                 node(size_t idx) const { return m_nodes[idx]; }
+    bool                        empty() const { return m_nodes.empty(); }
+    // Bounding box of the root node.
+    const BoundingBox&          bbox() const { return m_bbox; }
+
+private:
+    // Subtrees over at least this many entities are built in parallel.
+    static constexpr size_t ParallelThreshold = 4096;
+    static constexpr int    NumBins           = 16;
+
+    struct Cluster {
+        size_t      begin;
+        size_t      end;
+        BoundingBox bbox;
+        // Bounding box of the centroids of the entities.
+        BoundingBox centroids;
+    };
+
+    template<typename SourceNode>
+    static BoundingBox range_bbox(const std::vector<SourceNode> &input, size_t begin, size_t end)
+    {
+        BoundingBox bbox(input[begin].bbox());
+        for (size_t i = begin + 1; i < end; ++ i)
+            bbox.extend(input[i].bbox());
+        return bbox;
+    }
+
+    template<typename SourceNode>
+    static Cluster make_cluster(const std::vector<SourceNode> &input, size_t begin, size_t end)
+    {
+        Cluster out { begin, end, BoundingBox(input[begin].bbox()), BoundingBox(input[begin].centroid(), input[begin].centroid()) };
+        for (size_t i = begin + 1; i < end; ++ i) {
+            out.bbox.extend(input[i].bbox());
+            out.centroids.extend(input[i].centroid());
+        }
+        return out;
+    }
+
+    // Half of the surface area (half of the perimeter in 2D) for the SAH cost.
+    static double half_area(const BoundingBox &bbox)
+    {
+        if (bbox.isEmpty())
+            return 0.;
+        Eigen::Matrix<double, NumDimensions, 1> d = bbox.sizes().template cast<double>();
+        if constexpr (NumDimensions == 3)
+            return d.x() * d.y() + d.y() * d.z() + d.z() * d.x();
+        else
+            return d.sum();
+    }
+
+    // Split a cluster into two by the SAH evaluated at NumBins bins along each axis, the entities
+    // are binned by their centroids. The bounding boxes of the two parts are collected from the bins.
+    template<typename SourceNode>
+    static void split_sah(std::vector<SourceNode> &input, Cluster &left, Cluster &right)
+    {
+        const size_t begin = left.begin;
+        const size_t end   = left.end;
+        assert(end - begin > 1);
+
+        struct Bin {
+            size_t      count = 0;
+            BoundingBox bbox;
+            BoundingBox centroids;
+        };
+        std::array<std::array<Bin, NumBins>, NumDimensions> bins;
+        std::array<double, NumDimensions>                   k;
+        for (int d = 0; d < NumDimensions; ++ d) {
+            const CoordType extent = left.centroids.max()(d) - left.centroids.min()(d);
+            k[d] = extent > 0 ? NumBins / double(extent) : 0.;
+        }
+        auto bin_idx = [&left, &k](const SourceNode &n, int d) {
+            return std::min(NumBins - 1, int(k[d] * double(n.centroid()(d) - left.centroids.min()(d))));
+        };
+        for (size_t i = begin; i < end; ++ i)
+            for (int d = 0; d < NumDimensions; ++ d)
+                if (k[d] > 0) {
+                    Bin &bin = bins[d][bin_idx(input[i], d)];
+                    ++ bin.count;
+                    bin.bbox.extend(input[i].bbox());
+                    bin.centroids.extend(input[i].centroid());
+                }
+
+        double best_cost  = std::numeric_limits<double>::max();
+        int    best_dim   = -1;
+        int    best_split = 0;
+        for (int d = 0; d < NumDimensions; ++ d)
+            if (k[d] > 0) {
+                // Sweep from the right to accumulate the costs of the right parts.
+                std::array<double, NumBins> right_cost;
+                BoundingBox                 acc;
+                size_t                      cnt = 0;
+                for (int split = NumBins - 1; split > 0; -- split) {
+                    acc.extend(bins[d][split].bbox);
+                    cnt += bins[d][split].count;
+                    right_cost[split] = cnt == 0 ? -1. : half_area(acc) * double(cnt);
+                }
+                acc.setEmpty();
+                cnt = 0;
+                for (int split = 1; split < NumBins; ++ split) {
+                    acc.extend(bins[d][split - 1].bbox);
+                    cnt += bins[d][split - 1].count;
+                    if (cnt > 0 && right_cost[split] >= 0.) {
+                        double cost = half_area(acc) * double(cnt) + right_cost[split];
+                        if (cost < best_cost) {
+                            best_cost  = cost;
+                            best_dim   = d;
+                            best_split = split;
+                        }
+                    }
+                }
+            }
+
+        if (best_dim == -1) {
+            // All the centroids coincide, split in halves.
+            size_t mid = (begin + end) / 2;
+            right = { mid, end, range_bbox(input, mid, end), left.centroids };
+            left  = { begin, mid, range_bbox(input, begin, mid), left.centroids };
+        } else {
+            size_t mid = std::partition(input.begin() + begin, input.begin() + end, [&bin_idx, best_dim, best_split](const SourceNode &n) {
+                return bin_idx(n, best_dim) < best_split;
+            }) - input.begin();
+            assert(mid > begin && mid < end);
+            right = { mid, end };
+            left.end = mid;
+            left.bbox.setEmpty();
+            left.centroids.setEmpty();
+            for (int bin = 0; bin < NumBins; ++ bin) {
+                Cluster &c = bin < best_split ? left : right;
+                c.bbox.extend(bins[best_dim][bin].bbox);
+                c.centroids.extend(bins[best_dim][bin].centroids);
+            }
+        }
+    }
+
+    // Set the quantisation frame of a node to the bounding box of its children and store the bounding box
+    // of the i-th child. Comparisons are done with a small tolerance to stay conservative even if the compiler
+    // evaluates the dequantisation in Node::min() / Node::max() with a different rounding.
+    static void set_frame(Node &node, const BoundingBox &bbox)
+    {
+        for (int d = 0; d < NumDimensions; ++ d) {
+            const CoordType origin = bbox.min()(d);
+            const CoordType tol    = tolerance(origin, bbox.max()(d));
+            CoordType       scale  = (bbox.max()(d) + tol - origin) / CoordType(255);
+            while (origin + CoordType(255) * scale < bbox.max()(d) + tol)
+                scale = std::nextafter(scale, std::numeric_limits<CoordType>::max());
+            node.origin[d] = origin;
+            node.scale[d]  = scale;
+        }
+    }
+
+    static CoordType tolerance(CoordType min, CoordType max)
+    {
+        return CoordType(8) * std::numeric_limits<CoordType>::epsilon() * std::max(std::abs(min), std::abs(max));
+    }
+
+    static void set_child_bbox(Node &node, int i, const BoundingBox &bbox)
+    {
+        for (int d = 0; d < NumDimensions; ++ d) {
+            const CoordType origin = node.origin[d];
+            const CoordType scale  = node.scale[d];
+            const CoordType tol    = tolerance(origin, origin + CoordType(255) * scale);
+            int qmin = 0;
+            int qmax = 255;
+            if (scale > 0) {
+                qmin = std::clamp(int(std::floor((bbox.min()(d) - origin) / scale)), 0, 255);
+                while (qmin > 0 && origin + CoordType(qmin) * scale > bbox.min()(d) - tol)
+                    -- qmin;
+                qmax = std::clamp(int(std::ceil((bbox.max()(d) - origin) / scale)), qmin, 255);
+                while (qmax < 255 && origin + CoordType(qmax) * scale < bbox.max()(d) + tol)
+                    ++ qmax;
+            }
+            node.qmin[d][i] = uint8_t(qmin);
+            node.qmax[d][i] = uint8_t(qmax);
+        }
+    }
+
+    // Build a subtree over a cluster of the input into a node at node_idx. Its subtrees are stored into the nodes
+    // following node_idx, each subtree over n entities occupying n - 1 nodes.
+    template<typename SourceNode>
+    void build_recursive(std::vector<SourceNode> &input, size_t node_idx, const Cluster &cluster)
+    {
+        const size_t begin = cluster.begin;
+        const size_t end   = cluster.end;
+        // Split the input into up to Width clusters, always splitting the cluster with the largest surface.
+        std::array<Cluster, Width> clusters;
+        int                        num_clusters = 1;
+        clusters.front() = cluster;
+        while (num_clusters < Width) {
+            int    isplit = -1;
+            double area   = -1.;
+            for (int i = 0; i < num_clusters; ++ i)
+                if (clusters[i].end - clusters[i].begin > 1 && half_area(clusters[i].bbox) > area) {
+                    isplit = i;
+                    area   = half_area(clusters[i].bbox);
+                }
+            if (isplit == -1)
+                break;
+            split_sah(input, clusters[isplit], clusters[num_clusters ++]);
+        }
+        std::sort(clusters.begin(), clusters.begin() + num_clusters, [](const Cluster &l, const Cluster &r) { return l.begin < r.begin; });
+
+        Node &node = m_nodes[node_idx];
+        set_frame(node, cluster.bbox);
+        std::array<size_t, Width> inner;
+        int                       num_inner = 0;
+        size_t                    next_idx  = node_idx + 1;
+        for (int i = 0; i < num_clusters; ++ i) {
+            const Cluster &c = clusters[i];
+            set_child_bbox(node, i, c.bbox);
+            if (c.end - c.begin == 1)
+                node.children[i] = uint32_t(input[c.begin].idx()) | Node::leaf_bit;
+            else {
+                node.children[i] = uint32_t(next_idx);
+                inner[num_inner ++] = i;
+                next_idx += c.end - c.begin - 1;
+            }
+        }
+        assert(next_idx <= node_idx + std::max(end - begin - 1, size_t(1)));
+
+        auto build_child = [this, &input, &clusters, &inner, &node](size_t i) {
+            build_recursive(input, node.children[inner[i]], clusters[inner[i]]);
+        };
+        if (end - begin >= ParallelThreshold)
+            execution::for_each(ex_tbb, size_t(0), size_t(num_inner), build_child);
+        else
+            for (int i = 0; i < num_inner; ++ i)
+                build_child(i);
+    }
+
+    // Remove the unused nodes, keeping the depth first order of the nodes.
+    void compact()
+    {
+        std::vector<uint32_t> new_idx(m_nodes.size(), 0);
+        size_t                cnt = 0;
+        for (size_t i = 0; i < m_nodes.size(); ++ i)
+            // The first slot of a used node is always occupied.
+            if (m_nodes[i].is_used(0)) {
+                new_idx[i] = uint32_t(cnt);
+                if (i != cnt)
+                    m_nodes[cnt] = m_nodes[i];
+                ++ cnt;
+            }
+        m_nodes.resize(cnt);
+        m_nodes.shrink_to_fit();
+        for (Node &node : m_nodes)
+            for (int i = 0; i < Width; ++ i)
+                if (node.is_inner(i))
+                    node.children[i] = new_idx[node.children[i]];
+    }
+
+    std::vector<Node> m_nodes;
+    BoundingBox       m_bbox;
+};
+
+using WideTree3f = WideTree<3, float>;
+using WideTree3d = WideTree<3, double>;
+
 // Wrap a 2D Slic3r own BoundingBox to be passed to Tree::build() and similar
 // to build an AABBTree over coord_t 2D bounding boxes.
 class BoundingBoxWrapper {
@@ -474,6 +827,200 @@ namespace detail {
 		}
 	}
 
+    // Number of rays traversing the AABB tree together in intersect_rays_first_hit().
+    static constexpr size_t RayPacketSize = 8;
+
+    // Rays of a packet stored as structure of arrays, so that the ray-box tests of the whole packet
+    // are compiled into SIMD instructions. The box tests are calculated in floats to process twice
+    // as many rays per instruction. A slab is hit at t = (coord - origin) * inv_dir.
+    struct RayPacket {
+        alignas(16) std::array<float, RayPacketSize> ix, iy, iz;
+        alignas(16) std::array<float, RayPacketSize> ox, oy, oz;
+        // Parameter of the closest hit found so far for each ray, rounded up.
+        alignas(16) std::array<float, RayPacketSize> tmax;
+        // The boxes are inflated by this value to make up for rounding to floats,
+        // so that the rounding may only produce false positives.
+        double margin = 0.;
+    };
+
+    // Ray-box test of the rays in the 'active' bit mask against a single box,
+    // the same slab test as ray_box_intersect_invdir() with t0 = 0 and t1 = tmax.
+    // Returns the bit mask of the rays hitting the box, tentry is set to the lowest
+    // entry parameter of these rays.
+    template<typename BoxType>
+    inline unsigned ray_packet_box_intersect(const RayPacket &packet, const BoxType &box, unsigned active, float &tentry)
+    {
+        const float minx = float(double(box.min().x()) - packet.margin);
+        const float miny = float(double(box.min().y()) - packet.margin);
+        const float minz = float(double(box.min().z()) - packet.margin);
+        const float maxx = float(double(box.max().x()) + packet.margin);
+        const float maxy = float(double(box.max().y()) + packet.margin);
+        const float maxz = float(double(box.max().z()) + packet.margin);
+
+        // No branches in this loop, so that it gets vectorized. The entry parameter is set to infinity
+        // for the rays missing the box.
+        alignas(16) std::array<float, RayPacketSize>   tentries;
+        alignas(16) std::array<int32_t, RayPacketSize> hit;
+        for (size_t i = 0; i < RayPacketSize; ++ i) {
+            float t1   = (minx - packet.ox[i]) * packet.ix[i];
+            float t2   = (maxx - packet.ox[i]) * packet.ix[i];
+            float tmin = std::min(t1, t2);
+            float tmax = std::max(t1, t2);
+            t1   = (miny - packet.oy[i]) * packet.iy[i];
+            t2   = (maxy - packet.oy[i]) * packet.iy[i];
+            tmin = std::max(tmin, std::min(t1, t2));
+            tmax = std::min(tmax, std::max(t1, t2));
+            t1   = (minz - packet.oz[i]) * packet.iz[i];
+            t2   = (maxz - packet.oz[i]) * packet.iz[i];
+            tmin = std::max(tmin, std::min(t1, t2));
+            tmax = std::min(tmax, std::max(t1, t2));
+            tmax = std::min(tmax, packet.tmax[i]);
+            hit[i]      = int32_t(tmin <= tmax) & int32_t(tmin < packet.tmax[i]) & int32_t(tmax > 0.f);
+            tentries[i] = hit[i] ? tmin : std::numeric_limits<float>::infinity();
+        }
+
+        unsigned mask = 0;
+        for (size_t i = 0; i < RayPacketSize; ++ i)
+            mask |= unsigned(hit[i]) << i;
+        mask &= active;
+
+        tentry = std::numeric_limits<float>::infinity();
+        for (size_t i = 0; i < RayPacketSize; ++ i)
+            if (mask & (1u << i))
+                tentry = std::min(tentry, tentries[i]);
+
+        return mask;
+    }
+
+    // Fill in a packet with up to RayPacketSize rays, tbest is set to the exact parameters of the closest hits.
+    template<typename VectorType, typename BoxType>
+    inline void init_ray_packet(RayPacket &packet, std::array<double, RayPacketSize> &tbest,
+                                tcb::span<const VectorType> origins, tcb::span<const VectorType> dirs, const BoxType &root)
+    {
+        assert(origins.size() <= RayPacketSize && dirs.size() == origins.size());
+        // Largest absolute coordinate of the boxes and the ray origins.
+        double maxabs = std::max(root.min().template cast<double>().cwiseAbs().maxCoeff(),
+                                 root.max().template cast<double>().cwiseAbs().maxCoeff());
+        for (size_t i = 0; i < RayPacketSize; ++ i) {
+            // Unused slots are copies of the first ray, they are never active.
+            size_t j = i < origins.size() ? i : 0;
+            Eigen::Vector3d o      = origins[j].template cast<double>();
+            // A zero direction component (axis aligned rays, such as vertical pillars and beams) has an infinite
+            // inverse. It is replaced by a huge finite value of the same sign: the slab test then yields 0 instead
+            // of NaN = 0 * inf for a ray starting at the slab, and a NaN would make the box a miss.
+            Eigen::Vector3d invdir = dirs[j].template cast<double>().cwiseInverse().cwiseMax(-1e30).cwiseMin(1e30);
+            packet.ix[i] = float(invdir.x()); packet.iy[i] = float(invdir.y()); packet.iz[i] = float(invdir.z());
+            packet.ox[i] = float(o.x());      packet.oy[i] = float(o.y());      packet.oz[i] = float(o.z());
+            packet.tmax[i] = std::numeric_limits<float>::infinity();
+            tbest[i]       = std::numeric_limits<double>::infinity();
+            maxabs         = std::max(maxabs, o.cwiseAbs().maxCoeff());
+        }
+        // The relative rounding error of the float slab test is a few float epsilons, the error in space is
+        // proportional to the magnitude of the coordinates involved.
+        packet.margin = 1e-6 * maxabs;
+    }
+
+    // Traverse the tree once for a packet of up to RayPacketSize rays. Compared to casting the rays
+    // one by one, the tree nodes are fetched and tested once for the whole packet, which pays off
+    // for coherent rays such as samples around a beam.
+    template<typename RayIntersectorType, typename VectorType>
+    static inline void intersect_ray_packet_first_hit(
+        const RayIntersectorType &ray_intersector,
+        tcb::span<const VectorType> origins,
+        tcb::span<const VectorType> dirs,
+        tcb::span<igl::Hit>         hits)
+    {
+        using TreeType = typename RayIntersectorType::TreeType;
+        const TreeType &tree = ray_intersector.tree;
+
+        assert(origins.size() <= RayPacketSize && dirs.size() == origins.size() && hits.size() == origins.size());
+
+        RayPacket packet;
+        // Exact parameters of the closest hits for the triangle tests.
+        std::array<double, RayPacketSize> tbest;
+        init_ray_packet(packet, tbest, origins, dirs, tree.node(0).bbox);
+
+        // Nodes to visit with the rays hitting them and their lowest entry parameter. The children
+        // are tested before being pushed, the nearer one is pushed last to be processed first.
+        // The depth of the tree is logarithmic in the number of primitives.
+        struct Entry { size_t node_idx; unsigned active; float tentry; };
+        std::array<Entry, 128> stack;
+        size_t top = 0;
+
+        float    tentry;
+        unsigned active = ray_packet_box_intersect(packet, tree.node(0).bbox, (1u << origins.size()) - 1, tentry);
+        if (active)
+            stack[top ++] = { size_t(0), active, tentry };
+
+        while (top > 0) {
+            const Entry entry = stack[-- top];
+            // Skip the rays, which found a closer hit since the node was pushed.
+            active = 0;
+            for (size_t i = 0; i < origins.size(); ++ i)
+                if ((entry.active & (1u << i)) && entry.tentry < packet.tmax[i])
+                    active |= 1u << i;
+            if (active == 0)
+                continue;
+
+            const auto &node = tree.node(entry.node_idx);
+            assert(node.is_valid());
+
+            if ((active & (active - 1)) == 0) {
+                // A single ray is left, it is faster to traverse the subtree with the single ray code.
+                size_t i = 0;
+                while (! (active & (1u << i)))
+                    ++ i;
+                auto single = RayIntersectorType {
+                    ray_intersector.vertices, ray_intersector.faces, tree,
+                    origins[i], dirs[i], VectorType(dirs[i].cwiseInverse()),
+                    ray_intersector.eps
+                };
+                igl::Hit hit;
+                using Scalar = typename VectorType::Scalar;
+                if (intersect_ray_recursive_first_hit(single, entry.node_idx, Scalar(tbest[i]), hit) && hit.t < tbest[i]) {
+                    hits[i]        = hit;
+                    tbest[i]       = hit.t;
+                    packet.tmax[i] = std::nextafter(hit.t, std::numeric_limits<float>::infinity());
+                }
+            } else if (node.is_leaf()) {
+                auto face = ray_intersector.faces[node.idx];
+                for (size_t i = 0; i < origins.size(); ++ i)
+                    if (active & (1u << i)) {
+                        double t, u, v;
+                        if (intersect_triangle(
+                                origins[i], dirs[i],
+                                ray_intersector.vertices[face(0)], ray_intersector.vertices[face(1)], ray_intersector.vertices[face(2)],
+                                t, u, v, ray_intersector.eps)
+                            && t > 0. && t < tbest[i]) {
+                            hits[i]        = igl::Hit { int(node.idx), -1, float(u), float(v), float(t) };
+                            tbest[i]       = t;
+                            packet.tmax[i] = std::nextafter(float(t), std::numeric_limits<float>::infinity());
+                        }
+                    }
+            } else {
+                // Left / right child node index.
+                size_t   left  = entry.node_idx * 2 + 1;
+                size_t   right = left + 1;
+                float    tleft, tright;
+                unsigned mleft  = ray_packet_box_intersect(packet, tree.node(left).bbox, active, tleft);
+                unsigned mright = ray_packet_box_intersect(packet, tree.node(right).bbox, active, tright);
+                assert(top + 2 <= stack.size());
+                if (mleft && mright) {
+                    if (tleft < tright) {
+                        stack[top ++] = { right, mright, tright };
+                        stack[top ++] = { left, mleft, tleft };
+                    } else {
+                        stack[top ++] = { left, mleft, tleft };
+                        stack[top ++] = { right, mright, tright };
+                    }
+                } else if (mleft)
+                    stack[top ++] = { left, mleft, tleft };
+                else if (mright)
+                    stack[top ++] = { right, mright, tright };
+            }
+        }
+    }
+
     // Real-time collision detection, Ericson, Chapter 5
     template<typename Vector>
     static inline Vector closest_point_to_triangle(const Vector &p, const Vector &a, const Vector &b, const Vector &c)
@@ -666,22 +1213,283 @@ namespace detail {
         }
     }
 
+    template<typename TreeType> struct IsWideTree : std::false_type {};
+    template<int NumDimensions, typename CoordType, int Width>
+    struct IsWideTree<WideTree<NumDimensions, CoordType, Width>> : std::true_type {};
+
+    // Ray-box tests of a ray against all children of a wide tree node, the same slab test as ray_box_intersect_invdir()
+    // with t0 = 0 and t1 = tmax. Returns the bit mask of the children hit, sorts the children hit by their entry
+    // parameter into order[0..n), n being the number of children hit.
+    template<typename NodeType, typename VectorType, typename Scalar>
+    inline int ray_wide_node_intersect(const NodeType &node, const VectorType &origin, const VectorType &invdir, Scalar tmax,
+                                       std::array<int, NodeType::Width> &order, std::array<Scalar, NodeType::Width> &tentries)
+    {
+        constexpr int Width = NodeType::Width;
+        // No branches in this loop, so that it gets vectorized.
+        std::array<int32_t, Width> hit;
+        for (int i = 0; i < Width; ++ i) {
+            Scalar t1   = (Scalar(node.min(0, i)) - origin.x()) * invdir.x();
+            Scalar t2   = (Scalar(node.max(0, i)) - origin.x()) * invdir.x();
+            Scalar tmin = std::min(t1, t2);
+            Scalar tend = std::max(t1, t2);
+            t1   = (Scalar(node.min(1, i)) - origin.y()) * invdir.y();
+            t2   = (Scalar(node.max(1, i)) - origin.y()) * invdir.y();
+            tmin = std::max(tmin, std::min(t1, t2));
+            tend = std::min(tend, std::max(t1, t2));
+            t1   = (Scalar(node.min(2, i)) - origin.z()) * invdir.z();
+            t2   = (Scalar(node.max(2, i)) - origin.z()) * invdir.z();
+            tmin = std::max(tmin, std::min(t1, t2));
+            tend = std::min(tend, std::max(t1, t2));
+            hit[i]      = int32_t(tmin <= tend) & int32_t(tmin < tmax) & int32_t(tend > Scalar(0));
+            tentries[i] = tmin;
+        }
+        int n = 0;
+        for (int i = 0; i < Width; ++ i)
+            if (hit[i] && node.is_used(i)) {
+                // Insertion sort by the entry parameter.
+                int j = n ++;
+                for (; j > 0 && tentries[order[j - 1]] > tentries[i]; -- j)
+                    order[j] = order[j - 1];
+                order[j] = i;
+            }
+        return n;
+    }
+
+    template<typename RayIntersectorType>
+    static inline bool intersect_ray_triangle(const RayIntersectorType &ray_intersector, size_t idx, igl::Hit &hit)
+    {
+        auto   face = ray_intersector.faces[idx];
+        double t, u, v;
+        if (intersect_triangle(
+                ray_intersector.origin, ray_intersector.dir,
+                ray_intersector.vertices[face(0)], ray_intersector.vertices[face(1)], ray_intersector.vertices[face(2)],
+                t, u, v, ray_intersector.eps)
+            && t > 0.) {
+            hit = igl::Hit { int(idx), -1, float(u), float(v), float(t) };
+            return true;
+        }
+        return false;
+    }
+
+    // Wide tree counterpart of intersect_ray_recursive_first_hit(). The children are visited front to back,
+    // the children behind the closest hit found so far are skipped.
+    template<typename RayIntersectorType, typename Scalar>
+    static inline bool intersect_ray_wide_first_hit(
+        const RayIntersectorType &ray_intersector,
+        size_t                    node_idx,
+        Scalar                   &min_t,
+        igl::Hit                 &hit)
+    {
+        using NodeType = typename RayIntersectorType::TreeType::Node;
+        const NodeType &node = ray_intersector.tree.node(node_idx);
+
+        std::array<int, NodeType::Width>    order;
+        std::array<Scalar, NodeType::Width> tentries;
+        int  n   = ray_wide_node_intersect(node, ray_intersector.origin, ray_intersector.invdir, min_t, order, tentries);
+        bool ret = false;
+        for (int k = 0; k < n; ++ k) {
+            int i = order[k];
+            if (! (tentries[i] < min_t))
+                break;
+            if (node.is_leaf(i)) {
+                igl::Hit leaf_hit;
+                if (intersect_ray_triangle(ray_intersector, node.idx(i), leaf_hit) && leaf_hit.t < min_t) {
+                    min_t = leaf_hit.t;
+                    hit   = leaf_hit;
+                    ret   = true;
+                }
+            } else if (intersect_ray_wide_first_hit(ray_intersector, node.child_idx(i), min_t, hit))
+                ret = true;
+        }
+        return ret;
+    }
+
+    // Wide tree counterpart of intersect_ray_recursive_all_hits().
+    template<typename RayIntersectorType>
+    static inline void intersect_ray_wide_all_hits(RayIntersectorType &ray_intersector, size_t node_idx)
+    {
+        using Scalar   = typename RayIntersectorType::VectorType::Scalar;
+        using NodeType = typename RayIntersectorType::TreeType::Node;
+        const NodeType &node = ray_intersector.tree.node(node_idx);
+
+        std::array<int, NodeType::Width>    order;
+        std::array<Scalar, NodeType::Width> tentries;
+        int n = ray_wide_node_intersect(node, ray_intersector.origin, ray_intersector.invdir,
+                                        std::numeric_limits<Scalar>::infinity(), order, tentries);
+        for (int k = 0; k < n; ++ k) {
+            int i = order[k];
+            if (node.is_leaf(i)) {
+                igl::Hit hit;
+                if (intersect_ray_triangle(ray_intersector, node.idx(i), hit))
+                    ray_intersector.hits.emplace_back(hit);
+            } else
+                intersect_ray_wide_all_hits(ray_intersector, node.child_idx(i));
+        }
+    }
+
+    // Wide tree counterpart of intersect_ray_packet_first_hit(). The children of a node are visited front to back
+    // by the rays of the packet hitting them, the subtree is traversed by the single ray code once a single ray is left.
+    template<typename RayIntersectorType, typename VectorType>
+    static inline void intersect_ray_packet_wide_first_hit(
+        const RayIntersectorType     &ray_intersector,
+        RayPacket                    &packet,
+        std::array<double, RayPacketSize> &tbest,
+        tcb::span<const VectorType>   origins,
+        tcb::span<const VectorType>   dirs,
+        tcb::span<igl::Hit>           hits,
+        size_t                        node_idx,
+        unsigned                      active)
+    {
+        using NodeType = typename RayIntersectorType::TreeType::Node;
+        using Scalar   = typename VectorType::Scalar;
+        constexpr int Width = NodeType::Width;
+        const NodeType &node = ray_intersector.tree.node(node_idx);
+
+        std::array<unsigned, Width> masks;
+        std::array<float, Width>    tentries;
+        std::array<int, Width>      order;
+        int                         n = 0;
+        for (int i = 0; i < Width; ++ i)
+            if (node.is_used(i) && (masks[i] = ray_packet_box_intersect(packet, node.bbox(i), active, tentries[i])) != 0) {
+                int j = n ++;
+                for (; j > 0 && tentries[order[j - 1]] > tentries[i]; -- j)
+                    order[j] = order[j - 1];
+                order[j] = i;
+            }
+
+        for (int k = 0; k < n; ++ k) {
+            int      i    = order[k];
+            // Skip the rays, which found a closer hit since the children were tested.
+            unsigned mask = 0;
+            for (size_t r = 0; r < origins.size(); ++ r)
+                if ((masks[i] & (1u << r)) && tentries[i] < packet.tmax[r])
+                    mask |= 1u << r;
+            if (mask == 0)
+                continue;
+            if (node.is_leaf(i)) {
+                auto face = ray_intersector.faces[node.idx(i)];
+                for (size_t r = 0; r < origins.size(); ++ r)
+                    if (mask & (1u << r)) {
+                        double t, u, v;
+                        if (intersect_triangle(
+                                origins[r], dirs[r],
+                                ray_intersector.vertices[face(0)], ray_intersector.vertices[face(1)], ray_intersector.vertices[face(2)],
+                                t, u, v, ray_intersector.eps)
+                            && t > 0. && t < tbest[r]) {
+                            hits[r]        = igl::Hit { int(node.idx(i)), -1, float(u), float(v), float(t) };
+                            tbest[r]       = t;
+                            packet.tmax[r] = std::nextafter(float(t), std::numeric_limits<float>::infinity());
+                        }
+                    }
+            } else if ((mask & (mask - 1)) == 0) {
+                // A single ray is left, it is faster to traverse the subtree with the single ray code.
+                size_t r = 0;
+                while (! (mask & (1u << r)))
+                    ++ r;
+                auto single = RayIntersectorType {
+                    ray_intersector.vertices, ray_intersector.faces, ray_intersector.tree,
+                    origins[r], dirs[r], VectorType(dirs[r].cwiseInverse()),
+                    ray_intersector.eps
+                };
+                igl::Hit hit;
+                Scalar   min_t = Scalar(tbest[r]);
+                if (intersect_ray_wide_first_hit(single, node.child_idx(i), min_t, hit) && hit.t < tbest[r]) {
+                    hits[r]        = hit;
+                    tbest[r]       = hit.t;
+                    packet.tmax[r] = std::nextafter(hit.t, std::numeric_limits<float>::infinity());
+                }
+            } else
+                intersect_ray_packet_wide_first_hit(ray_intersector, packet, tbest, origins, dirs, hits, node.child_idx(i), mask);
+        }
+    }
+
+    // Squared distance of a point to the i-th child bounding box of a wide tree node.
+    template<typename NodeType, typename VectorType>
+    inline typename VectorType::Scalar squared_distance_to_child(const NodeType &node, int i, const VectorType &point)
+    {
+        using Scalar = typename VectorType::Scalar;
+        Scalar out = 0;
+        for (int d = 0; d < VectorType::RowsAtCompileTime; ++ d) {
+            Scalar dist = std::max({ Scalar(node.min(d, i)) - point(d), point(d) - Scalar(node.max(d, i)), Scalar(0) });
+            out += dist * dist;
+        }
+        return out;
+    }
+
+    // Wide tree counterpart of squared_distance_to_indexed_primitives_recursive(). The children are visited
+    // from the closest one, the children further than the closest primitive found so far are skipped.
+    template<typename IndexedPrimitivesDistancerType, typename Scalar>
+    static inline void squared_distance_to_indexed_primitives_wide(
+        IndexedPrimitivesDistancerType &distancer,
+        size_t                          node_idx,
+        Scalar                         &up_sqr_d,
+        size_t                         &i_out,
+        Eigen::PlainObjectBase<typename IndexedPrimitivesDistancerType::VectorType> &c)
+    {
+        using Vector   = typename IndexedPrimitivesDistancerType::VectorType;
+        using NodeType = typename IndexedPrimitivesDistancerType::TreeType::Node;
+        constexpr int Width = NodeType::Width;
+        const NodeType &node = distancer.tree.node(node_idx);
+
+        std::array<Scalar, Width> dists;
+        std::array<int, Width>    order;
+        int                       n = 0;
+        for (int i = 0; i < Width; ++ i)
+            if (node.is_used(i) && (dists[i] = squared_distance_to_child(node, i, distancer.origin)) < up_sqr_d) {
+                int j = n ++;
+                for (; j > 0 && dists[order[j - 1]] > dists[i]; -- j)
+                    order[j] = order[j - 1];
+                order[j] = i;
+            }
+
+        for (int k = 0; k < n; ++ k) {
+            int i = order[k];
+            if (! (dists[i] < up_sqr_d))
+                break;
+            if (node.is_leaf(i)) {
+                Scalar sqr_dist;
+                Vector c_candidate = distancer.closest_point_to_origin(node.idx(i), sqr_dist);
+                if (sqr_dist < up_sqr_d) {
+                    i_out    = node.idx(i);
+                    c        = c_candidate;
+                    up_sqr_d = sqr_dist;
+                }
+            } else
+                squared_distance_to_indexed_primitives_wide(distancer, node.child_idx(i), up_sqr_d, i_out, c);
+        }
+    }
+
+    // Wide tree counterpart of indexed_primitives_within_distance_squared_recurisve().
+    template<typename IndexedPrimitivesDistancerType, typename Scalar>
+    static inline void indexed_primitives_within_distance_squared_wide(const IndexedPrimitivesDistancerType &distancer,
+                                                                       size_t                                node_idx,
+                                                                       Scalar                                squared_distance_limit,
+                                                                       std::vector<size_t>                  &found_primitives_indices)
+    {
+        const auto &node = distancer.tree.node(node_idx);
+        for (int i = 0; i < std::decay_t<decltype(node)>::Width; ++ i)
+            if (node.is_used(i) && squared_distance_to_child(node, i, distancer.origin) < squared_distance_limit) {
+                if (node.is_leaf(i)) {
+                    Scalar sqr_dist;
+                    distancer.closest_point_to_origin(node.idx(i), sqr_dist);
+                    if (sqr_dist < squared_distance_limit)
+                        found_primitives_indices.push_back(node.idx(i));
+                } else
+                    indexed_primitives_within_distance_squared_wide(distancer, node.child_idx(i), squared_distance_limit,
+                                                                    found_primitives_indices);
+            }
+    }
+
 } // namespace detail
 
-// Build a balanced AABB Tree over an indexed triangles set, balancing the tree
-// on centroids of the triangles.
-// Epsilon is applied to the bounding boxes of the AABB Tree to cope with numeric inaccuracies
-// during tree traversal.
-template<typename VertexType, typename IndexedFaceType>
-inline Tree<3, typename VertexType::Scalar> build_aabb_tree_over_indexed_triangle_set(
-	// Indexed triangle set - 3D vertices.
-	const std::vector<VertexType> 		&vertices, 
-	// Indexed triangle set - triangular faces, references to vertices.
+namespace detail {
+
+template<typename TreeType, typename VertexType, typename IndexedFaceType>
+inline TreeType build_tree_over_indexed_triangle_set(
+	const std::vector<VertexType> 		&vertices,
     const std::vector<IndexedFaceType> 	&faces,
-	//FIXME do we want to apply an epsilon?
-    const typename VertexType::Scalar 	 eps = 0)
+    const typename VertexType::Scalar 	 eps)
 {
-    using 				 TreeType 		= Tree<3, typename VertexType::Scalar>;
 //    using				 CoordType      = typename TreeType::CoordType;
     using 				 VectorType	    = typename TreeType::VectorType;
     using 				 BoundingBox 	= typename TreeType::BoundingBox;
@@ -720,6 +1528,37 @@ inline Tree<3, typename VertexType::Scalar> build_aabb_tree_over_indexed_triangl
 	return out;
 }
 
+} // namespace detail
+
+// Build a balanced AABB Tree over an indexed triangles set, balancing the tree
+// on centroids of the triangles.
+// Epsilon is applied to the bounding boxes of the AABB Tree to cope with numeric inaccuracies
+// during tree traversal.
+template<typename VertexType, typename IndexedFaceType>
+inline Tree<3, typename VertexType::Scalar> build_aabb_tree_over_indexed_triangle_set(
+	// Indexed triangle set - 3D vertices.
+	const std::vector<VertexType> 		&vertices, 
+	// Indexed triangle set - triangular faces, references to vertices.
+    const std::vector<IndexedFaceType> 	&faces,
+	//FIXME do we want to apply an epsilon?
+    const typename VertexType::Scalar 	 eps = 0)
+{
+    return detail::build_tree_over_indexed_triangle_set<Tree<3, typename VertexType::Scalar>>(vertices, faces, eps);
+}
+
+// Build a wide AABB Tree over an indexed triangles set using the Surface Area Heuristic.
+// The wide tree is queried by the same functions as the balanced tree, it is faster to query for large meshes.
+template<int Width = 4, typename VertexType, typename IndexedFaceType>
+inline WideTree<3, typename VertexType::Scalar, Width> build_wide_aabb_tree_over_indexed_triangle_set(
+	// Indexed triangle set - 3D vertices.
+	const std::vector<VertexType> 		&vertices,
+	// Indexed triangle set - triangular faces, references to vertices.
+    const std::vector<IndexedFaceType> 	&faces,
+    const typename VertexType::Scalar 	 eps = 0)
+{
+    return detail::build_tree_over_indexed_triangle_set<WideTree<3, typename VertexType::Scalar, Width>>(vertices, faces, eps);
+}
+
 // Find a first intersection of a ray with indexed triangle set.
 // Intersection test is calculated with the accuracy of VectorType::Scalar
 // even if the triangle mesh and the AABB Tree are built with floats.
@@ -746,8 +1585,12 @@ inline bool intersect_ray_first_hit(
         origin, dir, VectorType(dir.cwiseInverse()),
         eps
 	};
-	return ! tree.empty() && detail::intersect_ray_recursive_first_hit(
-        ray_intersector, size_t(0), std::numeric_limits<Scalar>::infinity(), hit);
+    if constexpr (detail::IsWideTree<TreeType>::value) {
+        Scalar min_t = std::numeric_limits<Scalar>::infinity();
+        return ! tree.empty() && detail::intersect_ray_wide_first_hit(ray_intersector, size_t(0), min_t, hit);
+    } else
+	    return ! tree.empty() && detail::intersect_ray_recursive_first_hit(
+            ray_intersector, size_t(0), std::numeric_limits<Scalar>::infinity(), hit);
 }
 
 // Find all intersections of a ray with indexed triangle set.
@@ -784,13 +1627,67 @@ inline bool intersect_ray_all_hits(
         ray_intersector.hits = std::move(hits);
         ray_intersector.hits.clear();
         ray_intersector.hits.reserve(8);
-		detail::intersect_ray_recursive_all_hits(ray_intersector, 0);
+        if constexpr (detail::IsWideTree<TreeType>::value)
+            detail::intersect_ray_wide_all_hits(ray_intersector, 0);
+        else
+		    detail::intersect_ray_recursive_all_hits(ray_intersector, 0);
 		hits = std::move(ray_intersector.hits);
 	    std::sort(hits.begin(), hits.end(), [](const auto &l, const auto &r) { return l.t < r.t; });
 	}
 	return ! hits.empty();
 }
 
+// Find the first intersections of a batch of rays with indexed triangle set.
+// The rays are traversed in packets of detail::RayPacketSize rays, which is faster than casting
+// them one by one if the rays of a packet are coherent.
+// hits[i] is set to the first intersection of the i-th ray, its id is -1 if the ray misses the mesh.
+// Intersection test is calculated with the accuracy of VectorType::Scalar
+// even if the triangle mesh and the AABB Tree are built with floats.
+template<typename VertexType, typename IndexedFaceType, typename TreeType, typename VectorType>
+inline void intersect_rays_first_hit(
+	// Indexed triangle set - 3D vertices.
+	const std::vector<VertexType> 		&vertices,
+	// Indexed triangle set - triangular faces, references to vertices.
+	const std::vector<IndexedFaceType> 	&faces,
+	// AABBTreeIndirect::Tree over vertices & faces, bounding boxes built with the accuracy of vertices.
+	const TreeType 						&tree,
+	// Origins of the rays.
+	tcb::span<const VectorType>			 origins,
+	// Directions of the rays.
+	tcb::span<const VectorType>			 dirs,
+	// First intersections of the rays with the indexed triangle set, the same size as origins.
+	tcb::span<igl::Hit>					 hits,
+	// Epsilon for the ray-triangle intersection, it should be proportional to an average triangle edge length.
+	const double 						 eps = 0.000001)
+{
+    assert(origins.size() == dirs.size() && origins.size() == hits.size());
+
+    for (igl::Hit &hit : hits)
+        hit = igl::Hit { -1, -1, 0.f, 0.f, std::numeric_limits<float>::infinity() };
+
+    if (tree.empty())
+        return;
+
+    // Only the references are used from the intersector, the rays are passed in the packets.
+    auto ray_intersector = detail::RayIntersector<VertexType, IndexedFaceType, TreeType, VectorType> {
+        vertices, faces, tree,
+        VectorType::Zero(), VectorType::Zero(), VectorType::Zero(),
+        eps
+    };
+
+    for (size_t i = 0; i < origins.size(); i += detail::RayPacketSize) {
+        size_t n = std::min(detail::RayPacketSize, origins.size() - i);
+        if constexpr (detail::IsWideTree<TreeType>::value) {
+            detail::RayPacket                         packet;
+            std::array<double, detail::RayPacketSize> tbest;
+            detail::init_ray_packet(packet, tbest, origins.subspan(i, n), dirs.subspan(i, n), tree.bbox());
+            detail::intersect_ray_packet_wide_first_hit(ray_intersector, packet, tbest, origins.subspan(i, n), dirs.subspan(i, n),
+                                                        hits.subspan(i, n), size_t(0), (1u << n) - 1);
+        } else
+            detail::intersect_ray_packet_first_hit(ray_intersector, origins.subspan(i, n), dirs.subspan(i, n), hits.subspan(i, n));
+    }
+}
+
 // Finding a closest triangle, its closest point and squared distance to the closest point
 // on a 3D indexed triangle set using a pre-built AABBTreeIndirect::Tree.
 // Closest point to triangle test will be performed with the accuracy of VectorType::Scalar
@@ -814,8 +1711,14 @@ inline typename VectorType::Scalar squared_distance_to_indexed_triangle_set(
     using Scalar = typename VectorType::Scalar;
     auto distancer = detail::IndexedTriangleSetDistancer<VertexType, IndexedFaceType, TreeType, VectorType>
         { vertices, faces, tree, point };
-    return tree.empty() ? Scalar(-1) : 
-    	detail::squared_distance_to_indexed_primitives_recursive(distancer, size_t(0), Scalar(0), std::numeric_limits<Scalar>::infinity(), hit_idx_out, hit_point_out);
+    if (tree.empty())
+        return Scalar(-1);
+    if constexpr (detail::IsWideTree<TreeType>::value) {
+        Scalar up_sqr_d = std::numeric_limits<Scalar>::infinity();
+        detail::squared_distance_to_indexed_primitives_wide(distancer, size_t(0), up_sqr_d, hit_idx_out, hit_point_out);
+        return up_sqr_d;
+    } else
+    	return detail::squared_distance_to_indexed_primitives_recursive(distancer, size_t(0), Scalar(0), std::numeric_limits<Scalar>::infinity(), hit_idx_out, hit_point_out);
 }
 
 // Decides if exists some triangle in defined radius on a 3D indexed triangle set using a pre-built AABBTreeIndirect::Tree.
@@ -847,7 +1750,11 @@ inline bool is_any_triangle_in_radius(
 		return false;
 	}
 
-	detail::squared_distance_to_indexed_primitives_recursive(distancer, size_t(0), Scalar(0), max_distance_squared, hit_idx, hit_point);
+    if constexpr (detail::IsWideTree<TreeType>::value) {
+        Scalar up_sqr_d = max_distance_squared;
+        detail::squared_distance_to_indexed_primitives_wide(distancer, size_t(0), up_sqr_d, hit_idx, hit_point);
+    } else
+	    detail::squared_distance_to_indexed_primitives_recursive(distancer, size_t(0), Scalar(0), max_distance_squared, hit_idx, hit_point);
 
     return hit_point.allFinite();
 }
@@ -875,7 +1782,10 @@ inline std::vector<size_t> all_triangles_in_radius(
 	}
 
 	std::vector<size_t> found_triangles{};
-	detail::indexed_primitives_within_distance_squared_recurisve(distancer, size_t(0), max_distance_squared, found_triangles);
+    if constexpr (detail::IsWideTree<TreeType>::value)
+        detail::indexed_primitives_within_distance_squared_wide(distancer, size_t(0), max_distance_squared, found_triangles);
+    else
+	    detail::indexed_primitives_within_distance_squared_recurisve(distancer, size_t(0), max_distance_squared, found_triangles);
 	return found_triangles;
 }
 
@@ -905,6 +1815,22 @@ void get_candidate_idxs(const TreeType& tree, const VectorType& v, std::vector<s
     return;
 }
 
+template<int Dims, typename T, int Width, typename VectorType>
+void get_candidate_idxs(const WideTree<Dims, T, Width>& tree, const VectorType& v, std::vector<size_t>& candidates, size_t node_idx = 0)
+{
+    if (tree.empty() || (node_idx == 0 && ! tree.bbox().contains(v)))
+        return;
+
+    const auto &node = tree.node(node_idx);
+    for (int i = 0; i < Width; ++ i)
+        if (node.is_used(i) && node.bbox(i).contains(v)) {
+            if (node.is_leaf(i))
+                candidates.push_back(node.idx(i));
+            else
+                get_candidate_idxs(tree, v, candidates, node.child_idx(i));
+        }
+}
+
 // Predicate: need to be specialized for intersections of different geomteries
 template<class G> struct Intersecting {};
 
@@ -974,6 +1900,30 @@ bool traverse_recurse(const Tree<Dims, T> &tree,
     }
 }
 
+// The predicates and callbacks of traverse() are written for the nodes of Tree,
+// they are passed the children of a wide tree node converted to Tree::Node.
+template<int Dims, typename T, int Width, typename Pred, typename Fn>
+bool traverse_recurse(const WideTree<Dims, T, Width> &tree,
+                      size_t                          idx,
+                      Pred &&                         pred,
+                      Fn &&                           callback)
+{
+    const auto                  &node = tree.node(idx);
+    typename Tree<Dims, T>::Node child;
+    for (int i = 0; i < Width; ++ i)
+        if (node.is_used(i)) {
+            child.idx  = node.is_leaf(i) ? node.idx(i) : size_t(Tree<Dims, T>::inner);
+            child.bbox = node.bbox(i);
+            if (! pred(child))
+                continue;
+            if (node.is_leaf(i) ? ! callback(child) :
+                ! traverse_recurse(tree, node.child_idx(i), std::forward<Pred>(pred), std::forward<Fn>(callback)))
+                // Stop traversal.
+                return false;
+        }
+    return true;
+}
+
 } // namespace detail
 
 // Tree traversal with a predicate. Example usage:
@@ -990,6 +1940,21 @@ void traverse(const Tree<Dims, T> &tree, Predicate &&pred, Fn &&callback)
                              std::forward<Fn>(callback));
 }
 
+// The bounding boxes of a wide tree passed to the predicate are the quantised ones, thus slightly larger
+// than the bounding boxes of the entities.
+template<int Dims, typename T, int Width, typename Predicate, typename Fn>
+void traverse(const WideTree<Dims, T, Width> &tree, Predicate &&pred, Fn &&callback)
+{
+    if (tree.empty()) return;
+
+    typename Tree<Dims, T>::Node root;
+    root.idx  = Tree<Dims, T>::inner;
+    root.bbox = tree.bbox();
+    if (pred(root))
+        detail::traverse_recurse(tree, size_t(0), std::forward<Predicate>(pred),
+                                 std::forward<Fn>(callback));
+}
+
 } // namespace AABBTreeIndirect
 } // namespace Slic3r
 
@@ -11,13 +11,18 @@
 #include "libslic3r/Geometry.hpp"
 #include "libslic3r/GCode/ThumbnailData.hpp"
 #include "libslic3r/Semver.hpp"
+#include "libslic3r/Thread.hpp"
 #include "libslic3r/Time.hpp"
 
 #include "libslic3r/I18N.hpp"
 
 #include "3mf.hpp"
 
+#include <atomic>
+#include <deque>
 #include <limits>
+#include <memory>
+#include <set>
 #include <stdexcept>
 #include <optional>
 #include <string_view>
@@ -36,6 +41,9 @@
 namespace pt = boost::property_tree;
 
 #include <expat.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
 #include <Eigen/Dense>
 #include <LocalesUtils.hpp>
 
@@ -258,6 +266,39 @@ int get_attribute_value_int(const char** attributes, unsigned int attributes_siz
     return value;
 }
 
+// Look up multiple attributes in a single pass over the attributes. Used by the handlers called for each vertex and triangle.
+// values[i] is set to the value of the attribute keys[i], or to nullptr if the attribute is missing.
+template<size_t N>
+void get_attribute_values_charptr(const char** attributes, unsigned int attributes_size, const char* const (&keys)[N], const char* (&values)[N])
+{
+    std::fill(std::begin(values), std::end(values), nullptr);
+    if ((attributes == nullptr) || (attributes_size == 0) || (attributes_size % 2 != 0))
+        return;
+
+    for (unsigned int a = 0; a < attributes_size; a += 2)
+        for (size_t i = 0; i < N; ++ i)
+            if (values[i] == nullptr && ::strcmp(attributes[a], keys[i]) == 0) {
+                values[i] = attributes[a + 1];
+                break;
+            }
+}
+
+float get_value_float(const char* text)
+{
+    float value = 0.0f;
+    if (text != nullptr)
+        fast_float::from_chars(text, text + strlen(text), value);
+    return value;
+}
+
+int get_value_int(const char* text)
+{
+    int value = 0;
+    if (text != nullptr)
+        boost::spirit::qi::parse(text, text + strlen(text), boost::spirit::qi::int_, value);
+    return value;
+}
+
 bool get_attribute_value_bool(const char** attributes, unsigned int attributes_size, const char* attribute_key)
 {
     const char* text = get_attribute_value_charptr(attributes, attributes_size, attribute_key);
@@ -640,7 +681,17 @@ namespace Slic3r {
         bool _handle_start_config_metadata(const char** attributes, unsigned int num_attributes);
         bool _handle_end_config_metadata();
 
+        // Volumes to be split out of the geometry of a single object.
+        struct ObjectVolumesToGenerate
+        {
+            ModelObject*                              object;
+            const Geometry*                           geometry;
+            const ObjectMetadata::VolumeMetadataList* volumes;
+        };
+
         bool _generate_volumes(ModelObject& object, const Geometry& geometry, const ObjectMetadata::VolumeMetadataList& volumes, ConfigSubstitutionContext& config_substitutions);
+        // Generate the volumes of multiple objects at once, building their meshes and painted facets in parallel.
+        bool _generate_volumes(const std::vector<ObjectVolumesToGenerate>& objects, ConfigSubstitutionContext& config_substitutions);
 
         // callbacks to parse the .rels file
         static void XMLCALL _handle_start_relationships_element(void *userData, const char *name, const char **attributes);
@@ -920,6 +971,9 @@ namespace Slic3r {
             }
         }
 
+        std::vector<ObjectVolumesToGenerate> objects_to_generate;
+        // Volume lists of the objects not saved by PrusaSlicer, referenced by objects_to_generate.
+        std::deque<ObjectMetadata::VolumeMetadataList> whole_geometry_volumes;
         for (const IdToModelObjectMap::value_type& object : m_objects) {
             if (object.second >= int(m_model->objects.size())) {
                 add_error("Unable to find object");
@@ -954,8 +1008,7 @@ namespace Slic3r {
                 model_object->sla_drain_holes = std::move(obj_drain_holes->second);
             }
 
-            ObjectMetadata::VolumeMetadataList volumes;
-            ObjectMetadata::VolumeMetadataList* volumes_ptr = nullptr;
+            const ObjectMetadata::VolumeMetadataList* volumes_ptr = nullptr;
 
             IdToMetadataMap::iterator obj_metadata = m_objects_metadata.find(object.first.second);
             if (obj_metadata != m_objects_metadata.end()) {
@@ -976,15 +1029,21 @@ namespace Slic3r {
                 // config data not found, this model was not saved using slic3r pe
 
                 // add the entire geometry as the single volume to generate
-                volumes.emplace_back(0, (int)obj_geometry->second.triangles.size() - 1);
+                whole_geometry_volumes.emplace_back(1, ObjectMetadata::VolumeMetadata(0, (int)obj_geometry->second.triangles.size() - 1));
 
                 // select as volumes
-                volumes_ptr = &volumes;
+                volumes_ptr = &whole_geometry_volumes.back();
             }
 
-            if (!_generate_volumes(*model_object, obj_geometry->second, *volumes_ptr, config_substitutions))
-                return false;
+            objects_to_generate.push_back({ model_object, &obj_geometry->second, volumes_ptr });
+        }
 
+        // Build the volumes of all objects at once, so that the meshes of all objects are built in parallel.
+        if (!_generate_volumes(objects_to_generate, config_substitutions))
+            return false;
+
+        for (const IdToModelObjectMap::value_type& object : m_objects) {
+            ModelObject* model_object = m_model->objects[object.second];
             // Apply cut information for object if any was loaded
             // m_cut_object_ids are indexed by a 1 based model object index.
             IdToCutObjectInfoMap::iterator cut_object_info = m_cut_object_infos.find(object.second + 1);
@@ -2073,10 +2132,13 @@ namespace Slic3r {
     {
         // appends the vertex coordinates
         // missing values are set equal to ZERO
+        static constexpr const char* keys[] = { X_ATTR, Y_ATTR, Z_ATTR };
+        const char* values[3];
+        get_attribute_values_charptr(attributes, num_attributes, keys, values);
         m_curr_object.geometry.vertices.emplace_back(
-            m_unit_factor * get_attribute_value_float(attributes, num_attributes, X_ATTR),
-            m_unit_factor * get_attribute_value_float(attributes, num_attributes, Y_ATTR),
-            m_unit_factor * get_attribute_value_float(attributes, num_attributes, Z_ATTR));
+            m_unit_factor * get_value_float(values[0]),
+            m_unit_factor * get_value_float(values[1]),
+            m_unit_factor * get_value_float(values[2]));
         return true;
     }
 
@@ -2108,24 +2170,22 @@ namespace Slic3r {
         // pid
         // see specifications
 
+        // MM segmentation data. Unfortunately, BambuStudio has changed the attribute name after they forked us,
+        // leading to https://github.com/prusa3d/PrusaSlicer/issues/12502. Let's try to load both keys if the usual
+        // one that PrusaSlicer uses is not present.
+        static constexpr const char* keys[] = { V1_ATTR, V2_ATTR, V3_ATTR, CUSTOM_SUPPORTS_ATTR, CUSTOM_SEAM_ATTR, FUZZY_SKIN_ATTR, MM_SEGMENTATION_ATTR, "paint_color" };
+        const char* values[8];
+        get_attribute_values_charptr(attributes, num_attributes, keys, values);
+
         // appends the triangle's vertices indices
         // missing values are set equal to ZERO
-        m_curr_object.geometry.triangles.emplace_back(
-            get_attribute_value_int(attributes, num_attributes, V1_ATTR),
-            get_attribute_value_int(attributes, num_attributes, V2_ATTR),
-            get_attribute_value_int(attributes, num_attributes, V3_ATTR));
-
-        m_curr_object.geometry.custom_supports.push_back(get_attribute_value_string(attributes, num_attributes, CUSTOM_SUPPORTS_ATTR));
-        m_curr_object.geometry.custom_seam.push_back(get_attribute_value_string(attributes, num_attributes, CUSTOM_SEAM_ATTR));
-        m_curr_object.geometry.fuzzy_skin.push_back(get_attribute_value_string(attributes, num_attributes, FUZZY_SKIN_ATTR));
+        m_curr_object.geometry.triangles.emplace_back(get_value_int(values[0]), get_value_int(values[1]), get_value_int(values[2]));
 
-        // Now load MM segmentation data. Unfortunately, BambuStudio has changed the attribute name after they forked us,
-        // leading to https://github.com/prusa3d/PrusaSlicer/issues/12502. Let's try to load both keys if the usual
-        // one that PrusaSlicer uses is not present.
-        std::string mm_segmentation_serialized = get_attribute_value_string(attributes, num_attributes, MM_SEGMENTATION_ATTR);
-        if (mm_segmentation_serialized.empty())
-            mm_segmentation_serialized = get_attribute_value_string(attributes, num_attributes, "paint_color");
-        m_curr_object.geometry.mm_segmentation.push_back(mm_segmentation_serialized);
+        auto value_string = [](const char* value) { return value != nullptr ? value : ""; };
+        m_curr_object.geometry.custom_supports.emplace_back(value_string(values[3]));
+        m_curr_object.geometry.custom_seam.emplace_back(value_string(values[4]));
+        m_curr_object.geometry.fuzzy_skin.emplace_back(value_string(values[5]));
+        m_curr_object.geometry.mm_segmentation.emplace_back(value_string(values[6] != nullptr && *values[6] != 0 ? values[6] : values[7]));
 
         return true;
     }
@@ -2540,48 +2600,73 @@ namespace Slic3r {
 
     bool _3MF_Importer::_generate_volumes(ModelObject& object, const Geometry& geometry, const ObjectMetadata::VolumeMetadataList& volumes, ConfigSubstitutionContext& config_substitutions)
     {
-        if (!object.volumes.empty()) {
-            add_error("Found invalid volumes count");
-            return false;
-        }
+        return _generate_volumes({ { &object, &geometry, &volumes } }, config_substitutions);
+    }
 
-        unsigned int geo_tri_count = (unsigned int)geometry.triangles.size();
-        unsigned int renamed_volumes_count = 0;
+    bool _3MF_Importer::_generate_volumes(const std::vector<ObjectVolumesToGenerate>& objects, ConfigSubstitutionContext& config_substitutions)
+    {
+        // Volumes of all the objects, in the order in which they will be added to their objects.
+        struct VolumeToGenerate
+        {
+            const ObjectVolumesToGenerate        *object;
+            const ObjectMetadata::VolumeMetadata *data;
+            // Instance transformation to be baked into the mesh.
+            std::optional<Transform3d>            bake_transformation;
+            TriangleMesh                          mesh;
+            ModelVolume                          *volume { nullptr };
+        };
+        std::vector<VolumeToGenerate> volumes_to_generate;
 
-        for (const ObjectMetadata::VolumeMetadata& volume_data : volumes) {
-            if (geo_tri_count <= volume_data.first_triangle_id || geo_tri_count <= volume_data.last_triangle_id || volume_data.last_triangle_id < volume_data.first_triangle_id) {
-                add_error("Found invalid triangle id");
+        // An object must not receive its volumes twice.
+        std::set<const ModelObject*> objects_seen;
+        for (const ObjectVolumesToGenerate& object : objects) {
+            if (!object.object->volumes.empty() || !objects_seen.insert(object.object).second) {
+                add_error("Found invalid volumes count");
                 return false;
             }
 
-            Transform3d volume_matrix_to_object = Transform3d::Identity();
-            bool        has_transform 		    = false;
-            // extract the volume transformation from the volume's metadata, if present
-            for (const Metadata& metadata : volume_data.metadata) {
-                if (metadata.key == MATRIX_KEY) {
-                    volume_matrix_to_object = Slic3r::Geometry::transform3d_from_string(metadata.value);
-                    has_transform 			= ! volume_matrix_to_object.isApprox(Transform3d::Identity(), 1e-10);
-                    break;
+            unsigned int geo_tri_count = (unsigned int)object.geometry->triangles.size();
+            for (const ObjectMetadata::VolumeMetadata& volume_data : *object.volumes) {
+                if (geo_tri_count <= volume_data.first_triangle_id || geo_tri_count <= volume_data.last_triangle_id || volume_data.last_triangle_id < volume_data.first_triangle_id) {
+                    add_error("Found invalid triangle id");
+                    return false;
                 }
+                volumes_to_generate.push_back({ &object, &volume_data });
+                if (m_version == 0 && object.object->instances.size() == 1 && &volume_data == &object.volumes->front())
+                    // if the 3mf was not produced by PrusaSlicer and there is only one instance,
+                    // bake the transformation into the geometry to allow the reload from disk command
+                    // to work properly. The instance transformation is reset to identity after the first volume.
+                    //FIXME do the mesh fixing?
+                    volumes_to_generate.back().bake_transformation = object.object->instances.front()->get_transformation().get_matrix();
             }
+        }
 
-            // splits volume out of imported geometry
-            indexed_triangle_set its;
-            its.indices.assign(geometry.triangles.begin() + volume_data.first_triangle_id, geometry.triangles.begin() + volume_data.last_triangle_id + 1);
-            const size_t triangles_count = its.indices.size();
-            if (triangles_count == 0) {
-                add_error("An empty triangle mesh found");
-                return false;
-            }
+        // PrusaSlicer 2.4.0-alpha2 contained a bug, where all vertices of a single object were saved for each volume the object contained.
+        // Remove the vertices, that are not referenced by any face.
+        const bool compactify_vertices = m_prusaslicer_generator_version &&
+            *m_prusaslicer_generator_version >= *Semver::parse("2.4.0-alpha1") &&
+            *m_prusaslicer_generator_version < *Semver::parse("2.4.0-alpha3");
+
+        // Split the meshes out of the imported geometries in parallel.
+        std::atomic<bool> invalid_vertex_id { false };
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, volumes_to_generate.size()),
+            [&volumes_to_generate, &invalid_vertex_id, compactify_vertices](const tbb::blocked_range<size_t>& range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i) {
+                VolumeToGenerate& volume_to_generate = volumes_to_generate[i];
+                const Geometry& geometry = *volume_to_generate.object->geometry;
+                const ObjectMetadata::VolumeMetadata& volume_data = *volume_to_generate.data;
+
+                // splits volume out of imported geometry
+                indexed_triangle_set its;
+                its.indices.assign(geometry.triangles.begin() + volume_data.first_triangle_id, geometry.triangles.begin() + volume_data.last_triangle_id + 1);
 
-            {
                 int min_id = its.indices.front()[0];
                 int max_id = min_id;
                 for (const Vec3i& face : its.indices) {
                     for (const int tri_id : face) {
                         if (tri_id < 0 || tri_id >= int(geometry.vertices.size())) {
-                            add_error("Found invalid vertex id");
-                            return false;
+                            invalid_vertex_id = true;
+                            return;
                         }
                         min_id = std::min(min_id, tri_id);
                         max_id = std::max(max_id, tri_id);
@@ -2590,59 +2675,55 @@ namespace Slic3r {
                 its.vertices.assign(geometry.vertices.begin() + min_id, geometry.vertices.begin() + max_id + 1);
 
                 // rebase indices to the current vertices list
-                for (Vec3i& face : its.indices)
-                    for (int& tri_id : face)
-                        tri_id -= min_id;
+                if (min_id > 0)
+                    for (Vec3i& face : its.indices)
+                        face -= Vec3i(min_id, min_id, min_id);
+
+                if (compactify_vertices)
+                    its_compactify_vertices(its, true);
+
+                volume_to_generate.mesh = TriangleMesh(std::move(its), volume_data.mesh_stats);
+                if (volume_to_generate.bake_transformation)
+                    volume_to_generate.mesh.transform(*volume_to_generate.bake_transformation, false);
+                if (volume_to_generate.mesh.volume() < 0)
+                    volume_to_generate.mesh.flip_triangles();
             }
+        });
+        if (invalid_vertex_id) {
+            add_error("Found invalid vertex id");
+            return false;
+        }
 
-            if (m_prusaslicer_generator_version && 
-                *m_prusaslicer_generator_version >= *Semver::parse("2.4.0-alpha1") &&
-                *m_prusaslicer_generator_version < *Semver::parse("2.4.0-alpha3"))
-                // PrusaSlicer 2.4.0-alpha2 contained a bug, where all vertices of a single object were saved for each volume the object contained.
-                // Remove the vertices, that are not referenced by any face.
-                its_compactify_vertices(its, true);
-
-            TriangleMesh triangle_mesh(std::move(its), volume_data.mesh_stats);
-
-            if (m_version == 0) {
-                // if the 3mf was not produced by PrusaSlicer and there is only one instance,
-                // bake the transformation into the geometry to allow the reload from disk command
-                // to work properly
-                if (object.instances.size() == 1) {
-                    triangle_mesh.transform(object.instances.front()->get_transformation().get_matrix(), false);
-                    object.instances.front()->set_transformation(Slic3r::Geometry::Transformation());
-                    //FIXME do the mesh fixing?
+        // Add the volumes to their objects and apply their metadata. ModelVolumes receive their unique IDs here, thus sequentially.
+        const ObjectVolumesToGenerate* last_object = nullptr;
+        unsigned int renamed_volumes_count = 0;
+        for (VolumeToGenerate& volume_to_generate : volumes_to_generate) {
+            ModelObject& object = *volume_to_generate.object->object;
+            const ObjectMetadata::VolumeMetadata& volume_data = *volume_to_generate.data;
+            if (volume_to_generate.object != last_object) {
+                last_object = volume_to_generate.object;
+                renamed_volumes_count = 0;
+            }
+            if (volume_to_generate.bake_transformation)
+                object.instances.front()->set_transformation(Slic3r::Geometry::Transformation());
+
+            Transform3d volume_matrix_to_object = Transform3d::Identity();
+            bool        has_transform 		    = false;
+            // extract the volume transformation from the volume's metadata, if present
+            for (const Metadata& metadata : volume_data.metadata) {
+                if (metadata.key == MATRIX_KEY) {
+                    volume_matrix_to_object = Slic3r::Geometry::transform3d_from_string(metadata.value);
+                    has_transform 			= ! volume_matrix_to_object.isApprox(Transform3d::Identity(), 1e-10);
+                    break;
                 }
             }
-            if (triangle_mesh.volume() < 0)
-                triangle_mesh.flip_triangles();
 
-			ModelVolume* volume = object.add_volume(std::move(triangle_mesh));
+			ModelVolume* volume = object.add_volume(std::move(volume_to_generate.mesh));
+            volume_to_generate.volume = volume;
             // stores the volume matrix taken from the metadata, if present
             if (has_transform)
                 volume->source.transform = Slic3r::Geometry::Transformation(volume_matrix_to_object);
 
-            // recreate custom supports, seam, mm segmentation and fuzzy skin from previously loaded attribute
-            volume->supported_facets.reserve(triangles_count);
-            volume->seam_facets.reserve(triangles_count);
-            volume->mm_segmentation_facets.reserve(triangles_count);
-            volume->fuzzy_skin_facets.reserve(triangles_count);
-            for (size_t i=0; i<triangles_count; ++i) {
-                size_t index = volume_data.first_triangle_id + i;
-                assert(index < geometry.custom_supports.size());
-                assert(index < geometry.custom_seam.size());
-                assert(index < geometry.mm_segmentation.size());
-
-                volume->supported_facets.set_triangle_from_string(i, geometry.custom_supports[index]);
-                volume->seam_facets.set_triangle_from_string(i, geometry.custom_seam[index]);
-                volume->mm_segmentation_facets.set_triangle_from_string(i, geometry.mm_segmentation[index]);
-                volume->fuzzy_skin_facets.set_triangle_from_string(i, geometry.fuzzy_skin[index]);
-            }
-            volume->supported_facets.shrink_to_fit();
-            volume->seam_facets.shrink_to_fit();
-            volume->mm_segmentation_facets.shrink_to_fit();
-            volume->fuzzy_skin_facets.shrink_to_fit();
-
             if (auto &es = volume_data.shape_configuration; es.has_value())
                 volume->emboss_shape = std::move(es);            
             if (auto &tc = volume_data.text_configuration; tc.has_value())
@@ -2687,6 +2768,36 @@ namespace Slic3r {
             }
         }
 
+        // recreate custom supports, seam, mm segmentation and fuzzy skin from previously loaded attribute
+        // The painted facets of the volumes are independent, deserialize them in parallel.
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, volumes_to_generate.size()), [&volumes_to_generate](const tbb::blocked_range<size_t>& range) {
+            for (size_t volume_idx = range.begin(); volume_idx < range.end(); ++ volume_idx) {
+                const Geometry& geometry = *volumes_to_generate[volume_idx].object->geometry;
+                const ObjectMetadata::VolumeMetadata& volume_data = *volumes_to_generate[volume_idx].data;
+                ModelVolume* volume = volumes_to_generate[volume_idx].volume;
+                const int triangles_count = int(volume_data.last_triangle_id - volume_data.first_triangle_id + 1);
+                volume->supported_facets.reserve(triangles_count);
+                volume->seam_facets.reserve(triangles_count);
+                volume->mm_segmentation_facets.reserve(triangles_count);
+                volume->fuzzy_skin_facets.reserve(triangles_count);
+                for (int i = 0; i < triangles_count; ++ i) {
+                    size_t index = volume_data.first_triangle_id + i;
+                    assert(index < geometry.custom_supports.size());
+                    assert(index < geometry.custom_seam.size());
+                    assert(index < geometry.mm_segmentation.size());
+
+                    volume->supported_facets.set_triangle_from_string(i, geometry.custom_supports[index]);
+                    volume->seam_facets.set_triangle_from_string(i, geometry.custom_seam[index]);
+                    volume->mm_segmentation_facets.set_triangle_from_string(i, geometry.mm_segmentation[index]);
+                    volume->fuzzy_skin_facets.set_triangle_from_string(i, geometry.fuzzy_skin[index]);
+                }
+                volume->supported_facets.shrink_to_fit();
+                volume->seam_facets.shrink_to_fit();
+                volume->mm_segmentation_facets.shrink_to_fit();
+                volume->fuzzy_skin_facets.shrink_to_fit();
+            }
+        });
+
         return true;
     }
 
@@ -2773,9 +2884,11 @@ namespace Slic3r {
 
         bool m_fullpath_sources{ true };
         bool m_zip64 { true };
+        // Compression level of the zip entries, 1 (fastest) to 9 (smallest) or MZ_DEFAULT_COMPRESSION.
+        int  m_compression_level { MZ_DEFAULT_COMPRESSION };
 
     public:
-        bool save_model_to_file(const std::string& filename, Model& model, const DynamicPrintConfig* config, bool fullpath_sources, const ThumbnailData* thumbnail_data, bool zip64);
+        bool save_model_to_file(const std::string& filename, Model& model, const DynamicPrintConfig* config, bool fullpath_sources, const ThumbnailData* thumbnail_data, bool zip64, int compression_level);
         static void add_transformation(std::stringstream &stream, const Transform3d &tr);
     private:
         void _publish(Model &model);
@@ -2798,11 +2911,12 @@ namespace Slic3r {
         bool _add_wipe_tower_information_file_to_archive( mz_zip_archive& archive, Model& model);
     };
 
-    bool _3MF_Exporter::save_model_to_file(const std::string& filename, Model& model, const DynamicPrintConfig* config, bool fullpath_sources, const ThumbnailData* thumbnail_data, bool zip64)
+    bool _3MF_Exporter::save_model_to_file(const std::string& filename, Model& model, const DynamicPrintConfig* config, bool fullpath_sources, const ThumbnailData* thumbnail_data, bool zip64, int compression_level)
     {
         clear_errors();
         m_fullpath_sources = fullpath_sources;
         m_zip64 = zip64;
+        m_compression_level = compression_level;
         return _save_model_to_file(filename, model, config, thumbnail_data);
     }
 
@@ -2955,7 +3069,7 @@ namespace Slic3r {
 
         std::string out = stream.str();
 
-        if (!mz_zip_writer_add_mem(&archive, CONTENT_TYPES_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, CONTENT_TYPES_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add content types file to archive");
             return false;
         }
@@ -2970,7 +3084,7 @@ namespace Slic3r {
         size_t png_size = 0;
         void* png_data = tdefl_write_image_to_png_file_in_memory_ex((const void*)thumbnail_data.pixels.data(), thumbnail_data.width, thumbnail_data.height, 4, &png_size, MZ_DEFAULT_LEVEL, 1);
         if (png_data != nullptr) {
-            res = mz_zip_writer_add_mem(&archive, THUMBNAIL_FILE.c_str(), (const void*)png_data, png_size, MZ_DEFAULT_COMPRESSION);
+            res = mz_zip_writer_add_mem(&archive, THUMBNAIL_FILE.c_str(), (const void*)png_data, png_size, m_compression_level);
             mz_free(png_data);
         }
 
@@ -2991,7 +3105,7 @@ namespace Slic3r {
 
         std::string out = stream.str();
 
-        if (!mz_zip_writer_add_mem(&archive, RELATIONSHIPS_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, RELATIONSHIPS_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add relationships file to archive");
             return false;
         }
@@ -3021,7 +3135,7 @@ namespace Slic3r {
                 // Maximum expected 3MF file size is 4GB-1. This is a workaround for interoperability with Windows 10 3D model fixing API, see
                 // GH issue #6193.
                 (uint64_t(1) << 32) - 1,
-            nullptr, nullptr, 0, MZ_DEFAULT_COMPRESSION, nullptr, 0, nullptr, 0)) {
+            nullptr, nullptr, 0, m_compression_level, nullptr, 0, nullptr, 0)) {
             add_error("Unable to add model file to archive");
             return false;
         }
@@ -3176,26 +3290,69 @@ namespace Slic3r {
     using coordinate_type_scientific = boost::spirit::karma::real_generator<float, coordinate_policy_scientific<float>>;
 #endif // EXPORT_3MF_USE_SPIRIT_KARMA_FP
 
+    // Number of vertices or triangles formatted into a single chunk of the model file.
+    // The chunks are formatted and deflated in parallel, a window of chunks at a time, and written to the archive in order.
+    static constexpr const size_t EXPORT_3MF_CHUNK_SIZE = 16384;
+
+    // Deflate a chunk of the model file independently of the other chunks, so that the chunks may be compressed in parallel.
+    // The output is terminated by a full flush: it is byte aligned, not final and it does not reference the preceding data,
+    // thus the chunks may be spliced into the deflate stream of a staged zip entry with mz_zip_writer_add_staged_deflated_data().
+    static bool deflate_chunk(const std::string &in, int compression_level, std::string &out)
+    {
+        out.clear();
+        std::unique_ptr<tdefl_compressor> compressor(new tdefl_compressor);
+        auto put_buf = [](const void *buf, int len, void *user) -> mz_bool {
+            static_cast<std::string*>(user)->append(static_cast<const char*>(buf), size_t(len));
+            return MZ_TRUE;
+        };
+        return tdefl_init(compressor.get(), put_buf, &out, tdefl_create_comp_flags_from_zip_params(compression_level, -15, MZ_DEFAULT_STRATEGY)) == TDEFL_STATUS_OKAY &&
+               tdefl_compress_buffer(compressor.get(), in.data(), in.size(), TDEFL_FULL_FLUSH) == TDEFL_STATUS_OKAY;
+    }
+
     bool _3MF_Exporter::_add_mesh_to_object_stream(mz_zip_writer_staged_context &context, ModelObject& object, VolumeToOffsetsMap& volumes_offsets)
     {
-        std::string output_buffer;
-        output_buffer += "   <";
-        output_buffer += MESH_TAG;
-        output_buffer += ">\n    <";
-        output_buffer += VERTICES_TAG;
-        output_buffer += ">\n";
-
-        auto flush = [this, &output_buffer, &context](bool force = false) {
-            if ((force && ! output_buffer.empty()) || output_buffer.size() >= 65536 * 16) {
-                if (! mz_zip_writer_add_staged_data(&context, output_buffer.data(), output_buffer.size())) {
-                    add_error("Error during writing or compression");
-                    return false;
-                }
-                output_buffer.clear();
-            }
-            return true;
+        // Range of vertices or triangles of a single volume to be formatted into a single chunk.
+        struct MeshChunk {
+            const ModelVolume *volume;
+            const Offsets     *offsets;
+            bool               triangles;
+            size_t             begin;
+            size_t             end;
         };
 
+        // Calculate the offsets of all volumes first, so that the vertices and triangles could be formatted out of order.
+        std::vector<MeshChunk> chunks;
+        unsigned int vertices_count  = 0;
+        unsigned int triangles_count = 0;
+        for (ModelVolume* volume : object.volumes) {
+            if (volume == nullptr)
+                continue;
+
+            const indexed_triangle_set &its = volume->mesh().its;
+            if (its.vertices.empty()) {
+                add_error("Found invalid mesh");
+                return false;
+            }
+
+            Offsets &offsets = volumes_offsets.insert({ volume, Offsets(vertices_count) }).first->second;
+            vertices_count += (int)its.vertices.size();
+            // updates triangle offsets
+            offsets.first_triangle_id = triangles_count;
+            triangles_count += (int)its.indices.size();
+            offsets.last_triangle_id = triangles_count - 1;
+
+            for (size_t i = 0; i < its.vertices.size(); i += EXPORT_3MF_CHUNK_SIZE)
+                chunks.push_back({ volume, &offsets, false, i, std::min(i + EXPORT_3MF_CHUNK_SIZE, its.vertices.size()) });
+        }
+        // Triangles are stored after all the vertices of all the volumes.
+        const size_t first_triangle_chunk = chunks.size();
+        for (size_t vertex_chunk = 0; vertex_chunk < first_triangle_chunk; ++ vertex_chunk)
+            if (const MeshChunk &chunk = chunks[vertex_chunk]; chunk.begin == 0) {
+                const size_t num_triangles = chunk.volume->mesh().its.indices.size();
+                for (size_t i = 0; i < num_triangles; i += EXPORT_3MF_CHUNK_SIZE)
+                    chunks.push_back({ chunk.volume, chunk.offsets, true, i, std::min(i + EXPORT_3MF_CHUNK_SIZE, num_triangles) });
+            }
+
         auto format_coordinate = [](float f, char *buf) -> char* {
             assert(is_decimal_separator_point());
 #if EXPORT_3MF_USE_SPIRIT_KARMA_FP
@@ -3226,25 +3383,12 @@ namespace Slic3r {
 #endif
         };
 
-        char buf[256];
-        unsigned int vertices_count = 0;
-        for (ModelVolume* volume : object.volumes) {
-            if (volume == nullptr)
-                continue;
-
-            volumes_offsets.insert({ volume, Offsets(vertices_count) });
-
-            const indexed_triangle_set &its = volume->mesh().its;
-            if (its.vertices.empty()) {
-                add_error("Found invalid mesh");
-                return false;
-            }
-
-            vertices_count += (int)its.vertices.size();
-
-            const Transform3d& matrix = volume->get_matrix();
-            for (const auto& vertex: its.vertices) {
-                Vec3f v = (matrix * vertex.cast<double>()).cast<float>();
+        auto format_vertices = [&format_coordinate](const MeshChunk &chunk, std::string &output_buffer) {
+            char buf[256];
+            const indexed_triangle_set &its    = chunk.volume->mesh().its;
+            const Transform3d          &matrix = chunk.volume->get_matrix();
+            for (size_t i = chunk.begin; i < chunk.end; ++ i) {
+                Vec3f v = (matrix * its.vertices[i].cast<double>()).cast<float>();
                 char *ptr = buf;
                 boost::spirit::karma::generate(ptr, boost::spirit::lit("     <") << VERTEX_TAG << " x=\"");
                 ptr = format_coordinate(v.x(), ptr);
@@ -3253,101 +3397,97 @@ namespace Slic3r {
                 boost::spirit::karma::generate(ptr, "\" z=\"");
                 ptr = format_coordinate(v.z(), ptr);
                 boost::spirit::karma::generate(ptr, "\"/>\n");
-                *ptr = '\0';
-                output_buffer += buf;
-                if (! flush())
-                    return false;
+                output_buffer.append(buf, ptr);
             }
-        }
-
-        output_buffer += "    </";
-        output_buffer += VERTICES_TAG;
-        output_buffer += ">\n    <";
-        output_buffer += TRIANGLES_TAG;
-        output_buffer += ">\n";
-
-        unsigned int triangles_count = 0;
-        for (ModelVolume* volume : object.volumes) {
-            if (volume == nullptr)
-                continue;
-
-            bool is_left_handed = volume->is_left_handed();
-            VolumeToOffsetsMap::iterator volume_it = volumes_offsets.find(volume);
-            assert(volume_it != volumes_offsets.end());
-
-            const indexed_triangle_set &its = volume->mesh().its;
-
-            // updates triangle offsets
-            volume_it->second.first_triangle_id = triangles_count;
-            triangles_count += (int)its.indices.size();
-            volume_it->second.last_triangle_id = triangles_count - 1;
-
-            for (int i = 0; i < int(its.indices.size()); ++ i) {
-                {
-                    const Vec3i &idx = its.indices[i];
-                    char *ptr = buf;
-                    boost::spirit::karma::generate(ptr, boost::spirit::lit("     <") << TRIANGLE_TAG <<
-                        " v1=\"" << boost::spirit::int_ <<
-                        "\" v2=\"" << boost::spirit::int_ <<
-                        "\" v3=\"" << boost::spirit::int_ << "\"",
-                        idx[is_left_handed ? 2 : 0] + volume_it->second.first_vertex_id,
-                        idx[1] + volume_it->second.first_vertex_id,
-                        idx[is_left_handed ? 0 : 2] + volume_it->second.first_vertex_id);
-                    *ptr = '\0';
-                    output_buffer += buf;
-                }
+        };
 
-                std::string custom_supports_data_string = volume->supported_facets.get_triangle_as_string(i);
-                if (! custom_supports_data_string.empty()) {
+        auto format_triangles = [](const MeshChunk &chunk, std::string &output_buffer) {
+            char buf[256];
+            const ModelVolume          *volume         = chunk.volume;
+            const indexed_triangle_set &its            = volume->mesh().its;
+            const bool                  is_left_handed = volume->is_left_handed();
+            const unsigned int          first_vertex_id = chunk.offsets->first_vertex_id;
+            auto append_attribute = [&output_buffer](const char *attr, const std::string &value) {
+                if (! value.empty()) {
                     output_buffer += " ";
-                    output_buffer += CUSTOM_SUPPORTS_ATTR;
+                    output_buffer += attr;
                     output_buffer += "=\"";
-                    output_buffer += custom_supports_data_string;
+                    output_buffer += value;
                     output_buffer += "\"";
                 }
+            };
+            for (int i = int(chunk.begin); i < int(chunk.end); ++ i) {
+                const Vec3i &idx = its.indices[i];
+                char *ptr = buf;
+                boost::spirit::karma::generate(ptr, boost::spirit::lit("     <") << TRIANGLE_TAG <<
+                    " v1=\"" << boost::spirit::int_ <<
+                    "\" v2=\"" << boost::spirit::int_ <<
+                    "\" v3=\"" << boost::spirit::int_ << "\"",
+                    idx[is_left_handed ? 2 : 0] + first_vertex_id,
+                    idx[1] + first_vertex_id,
+                    idx[is_left_handed ? 0 : 2] + first_vertex_id);
+                output_buffer.append(buf, ptr);
+                append_attribute(CUSTOM_SUPPORTS_ATTR, volume->supported_facets.get_triangle_as_string(i));
+                append_attribute(CUSTOM_SEAM_ATTR, volume->seam_facets.get_triangle_as_string(i));
+                append_attribute(MM_SEGMENTATION_ATTR, volume->mm_segmentation_facets.get_triangle_as_string(i));
+                append_attribute(FUZZY_SKIN_ATTR, volume->fuzzy_skin_facets.get_triangle_as_string(i));
+                output_buffer += "/>\n";
+            }
+        };
 
-                std::string custom_seam_data_string = volume->seam_facets.get_triangle_as_string(i);
-                if (! custom_seam_data_string.empty()) {
-                    output_buffer += " ";
-                    output_buffer += CUSTOM_SEAM_ATTR;
-                    output_buffer += "=\"";
-                    output_buffer += custom_seam_data_string;
-                    output_buffer += "\"";
-                }
+        auto add_data = [this, &context](const std::string &data) {
+            if (! data.empty() && ! mz_zip_writer_add_staged_data(&context, data.data(), data.size())) {
+                add_error("Error during writing or compression");
+                return false;
+            }
+            return true;
+        };
 
-                std::string mm_painting_data_string = volume->mm_segmentation_facets.get_triangle_as_string(i);
-                if (! mm_painting_data_string.empty()) {
-                    output_buffer += " ";
-                    output_buffer += MM_SEGMENTATION_ATTR;
-                    output_buffer += "=\"";
-                    output_buffer += mm_painting_data_string;
-                    output_buffer += "\"";
-                }
+        if (! add_data(std::string("   <") + MESH_TAG + ">\n    <" + VERTICES_TAG + ">\n"))
+            return false;
 
-                std::string fuzzy_skin_data_string = volume->fuzzy_skin_facets.get_triangle_as_string(i);
-                if (!fuzzy_skin_data_string.empty()) {
-                    output_buffer += " ";
-                    output_buffer += FUZZY_SKIN_ATTR;
-                    output_buffer += "=\"";
-                    output_buffer += fuzzy_skin_data_string;
-                    output_buffer += "\"";
+        // Format and deflate a window of chunks in parallel, then write them in order. Only the window is held in memory.
+        struct ChunkData {
+            std::string text;
+            std::string deflated;
+            bool        deflate_ok { false };
+        };
+        std::vector<ChunkData> window(std::min(chunks.size(), size_t(2 * tbb::this_task_arena::max_concurrency())));
+        // Sets "C" locales for the TBB worker threads formatting the coordinates.
+        TBBLocalesSetter locales_setter;
+        for (size_t window_begin = 0; window_begin < chunks.size(); window_begin += window.size()) {
+            const size_t window_end = std::min(window_begin + window.size(), chunks.size());
+            tbb::parallel_for(tbb::blocked_range<size_t>(window_begin, window_end, 1),
+                [this, &chunks, &window, window_begin, &format_vertices, &format_triangles](const tbb::blocked_range<size_t> &range) {
+                for (size_t chunk_idx = range.begin(); chunk_idx < range.end(); ++ chunk_idx) {
+                    const MeshChunk &chunk = chunks[chunk_idx];
+                    ChunkData       &data  = window[chunk_idx - window_begin];
+                    data.text.clear();
+                    if (chunk.triangles)
+                        format_triangles(chunk, data.text);
+                    else
+                        format_vertices(chunk, data.text);
+                    data.deflate_ok = deflate_chunk(data.text, m_compression_level, data.deflated);
                 }
-
-                output_buffer += "/>\n";
-
-                if (! flush())
+            });
+            for (size_t chunk_idx = window_begin; chunk_idx < window_end; ++ chunk_idx) {
+                if (chunk_idx == first_triangle_chunk &&
+                    ! add_data(std::string("    </") + VERTICES_TAG + ">\n    <" + TRIANGLES_TAG + ">\n"))
+                    return false;
+                const ChunkData &data = window[chunk_idx - window_begin];
+                if (! data.deflate_ok || ! mz_zip_writer_add_staged_deflated_data(&context, data.text.data(), data.text.size(), data.deflated.data(), data.deflated.size())) {
+                    add_error("Error during writing or compression");
                     return false;
+                }
             }
         }
 
-        output_buffer += "    </";
-        output_buffer += TRIANGLES_TAG;
-        output_buffer += ">\n   </";
-        output_buffer += MESH_TAG;
-        output_buffer += ">\n";
-
-        // Force flush.
-        return flush(true);
+        std::string footer;
+        if (first_triangle_chunk == chunks.size())
+            // No triangles at all.
+            footer = std::string("    </") + VERTICES_TAG + ">\n    <" + TRIANGLES_TAG + ">\n";
+        footer += std::string("    </") + TRIANGLES_TAG + ">\n   </" + MESH_TAG + ">\n";
+        return add_data(footer);
     }
 
     void _3MF_Exporter::add_transformation(std::stringstream &stream, const Transform3d &tr)
@@ -3435,7 +3575,7 @@ namespace Slic3r {
         }
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, CUT_INFORMATION_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, CUT_INFORMATION_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add cut information file to archive");
                 return false;
             }
@@ -3469,7 +3609,7 @@ namespace Slic3r {
         }
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, LAYER_HEIGHTS_PROFILE_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, LAYER_HEIGHTS_PROFILE_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add layer heights profile file to archive");
                 return false;
             }
@@ -3527,7 +3667,7 @@ namespace Slic3r {
         }
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, LAYER_CONFIG_RANGES_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, LAYER_CONFIG_RANGES_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add layer heights profile file to archive");
                 return false;
             }
@@ -3575,7 +3715,7 @@ namespace Slic3r {
             // Adds version header at the beginning:
             out = std::string("support_points_format_version=") + std::to_string(support_points_format_version) + std::string("\n") + out;
 
-            if (!mz_zip_writer_add_mem(&archive, SLA_SUPPORT_POINTS_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, SLA_SUPPORT_POINTS_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add sla support points file to archive");
                 return false;
             }
@@ -3626,7 +3766,7 @@ namespace Slic3r {
             // Adds version header at the beginning:
             out = std::string("drain_holes_format_version=") + std::to_string(drain_holes_format_version) + std::string("\n") + out;
             
-            if (!mz_zip_writer_add_mem(&archive, SLA_DRAIN_HOLES_FILE.c_str(), static_cast<const void*>(out.data()), out.length(), mz_uint(MZ_DEFAULT_COMPRESSION))) {
+            if (!mz_zip_writer_add_mem(&archive, SLA_DRAIN_HOLES_FILE.c_str(), static_cast<const void*>(out.data()), out.length(), mz_uint(m_compression_level))) {
                 add_error("Unable to add sla support points file to archive");
                 return false;
             }
@@ -3669,7 +3809,7 @@ namespace Slic3r {
         }
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, PRINT_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, PRINT_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add print config file to archive");
                 return false;
             }
@@ -3804,7 +3944,7 @@ namespace Slic3r {
 
         std::string out = stream.str();
 
-        if (!mz_zip_writer_add_mem(&archive, MODEL_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, MODEL_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add model config file to archive");
             return false;
         }
@@ -3864,7 +4004,7 @@ bool _3MF_Exporter::_add_custom_gcode_per_print_z_file_to_archive( mz_zip_archiv
     } 
 
     if (!out.empty()) {
-        if (!mz_zip_writer_add_mem(&archive, CUSTOM_GCODE_PER_PRINT_Z_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, CUSTOM_GCODE_PER_PRINT_Z_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add custom Gcodes per print_z file to archive");
             return false;
         }
@@ -3900,7 +4040,7 @@ bool _3MF_Exporter::_add_wipe_tower_information_file_to_archive( mz_zip_archive&
     boost::replace_all(out, "><", ">\n<");
     
     if (!out.empty()) {
-        if (!mz_zip_writer_add_mem(&archive, WIPE_TOWER_INFORMATION_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, WIPE_TOWER_INFORMATION_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add wipe tower information file to archive");
             return false;
         }
@@ -4011,7 +4151,7 @@ bool load_3mf(
     return res;
 }
 
-bool store_3mf(const char* path, Model* model, const DynamicPrintConfig* config, bool fullpath_sources, const ThumbnailData* thumbnail_data, bool zip64)
+bool store_3mf(const char* path, Model* model, const DynamicPrintConfig* config, bool fullpath_sources, const ThumbnailData* thumbnail_data, bool zip64, int compression_level)
 {
     // All export should use "C" locales for number formatting.
     CNumericLocalesSetter locales_setter;
@@ -4020,7 +4160,7 @@ bool store_3mf(const char* path, Model* model, const DynamicPrintConfig* config,
         return false;
 
     _3MF_Exporter exporter;
-    bool res = exporter.save_model_to_file(path, *model, config, fullpath_sources, thumbnail_data, zip64);
+    bool res = exporter.save_model_to_file(path, *model, config, fullpath_sources, thumbnail_data, zip64, compression_level);
     if (!res)
         exporter.log_errors();
 
@@ -46,8 +46,6 @@
 #define PREV_H 168
 #define PREV_DPI 42
 
-#define LAYER_SIZE_ESTIMATE (32 * 1024)
-
 namespace Slic3r {
 
 static void anycubicsla_get_pixel_span(const std::uint8_t* ptr, const std::uint8_t* end,
@@ -509,18 +507,19 @@ static void anycubicsla_write_layer(std::ofstream &out, anycubicsla_format_layer
 }
 
 void AnycubicSLAArchive::export_print(const std::string     fname,
-                               const SLAPrint       &print,
-                               const ThumbnailsList &thumbnails,
-                               const std::string    &/*projectname*/)
+                               const SLAPrint        &print,
+                               const ThumbnailsList  &thumbnails,
+                               const std::string     &/*projectname*/,
+                               const LayerProgressFn &progressfn)
 {
-    std::uint32_t layer_count = m_layers.size();
+    std::uint32_t layer_count = print.print_layers().size();
 
     anycubicsla_format_intro         intro = {};
     anycubicsla_format_header        header = {};
     anycubicsla_format_preview       preview = {};
     anycubicsla_format_layers_header layers_header = {};
     anycubicsla_format_misc          misc = {};
-    std::vector<uint8_t>      layer_images;
+    std::vector<anycubicsla_format_layer> layers(layer_count);
     std::uint32_t             image_offset;
 
     assert(m_version == ANYCUBIC_SLA_FORMAT_VERSION_1);
@@ -550,12 +549,13 @@ void AnycubicSLAArchive::export_print(const std::string     fname,
         layers_header.layer_count = layer_count;
         anycubicsla_write_layers_header(out, layers_header);
 
-        //layers
-        layer_images.reserve(layer_count * LAYER_SIZE_ESTIMATE);
+        // Stream the rle encoded layer images into the image area as soon as they are ready,
+        // the layer records preceding the images are written once all the image sizes are known.
+        const std::streampos layers_pos = out.tellp();
+        out.seekp(intro.image_data_offset);
         image_offset = intro.image_data_offset;
-        size_t i = 0;
-        for (const sla::EncodedRaster &rst : m_layers) {
-            anycubicsla_format_layer l;
+        write_layers(print, [&](size_t i, const sla::EncodedRaster &rst) {
+            anycubicsla_format_layer &l = layers[i];
             std::memset(&l, 0, sizeof(l));
             l.image_offset = image_offset;
             l.image_size = rst.size();
@@ -571,15 +571,11 @@ void AnycubicSLAArchive::export_print(const std::string     fname,
                 l.lift_speed_mms = header.lift_speed_mms;
             }
             image_offset += l.image_size;
+            out.write(reinterpret_cast<const char*>(rst.data()), rst.size());
+        }, progressfn);
+        out.seekp(layers_pos);
+        for (anycubicsla_format_layer &l : layers)
             anycubicsla_write_layer(out, l);
-            // add the rle encoded layer image into the buffer
-            const char* img_start = reinterpret_cast<const char*>(rst.data());
-            const char* img_end = img_start + rst.size();
-            std::copy(img_start, img_end, std::back_inserter(layer_images));
-            i++;
-        }
-        const char* img_buffer = reinterpret_cast<const char*>(layer_images.data());
-        out.write(img_buffer, layer_images.size());
         out.close();
     } catch(std::exception& e) {
         BOOST_LOG_TRIVIAL(error) << e.what();
@@ -54,9 +54,10 @@ public:
         m_cfg(std::move(cfg)), m_version(version) {}
 
     void export_print(const std::string     fname,
-                      const SLAPrint       &print,
-                      const ThumbnailsList &thumbnails,
-                      const std::string    &projectname = "") override;
+                      const SLAPrint        &print,
+                      const ThumbnailsList  &thumbnails,
+                      const std::string     &projectname = "",
+                      const LayerProgressFn &progressfn  = {}) override;
 };
 
 inline Slic3r::ArchiveEntry anycubic_sla_format_versioned(const char *fileformat, const char *desc, uint16_t version)
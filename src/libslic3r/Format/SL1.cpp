@@ -299,10 +299,11 @@ static void write_thumbnail(Zipper &zipper, const ThumbnailData &data)
     }
 }
 
-void SL1Archive::export_print(Zipper               &zipper,
-                              const SLAPrint       &print,
-                              const ThumbnailsList &thumbnails,
-                              const std::string    &prjname)
+void SL1Archive::export_print(Zipper                &zipper,
+                              const SLAPrint        &print,
+                              const ThumbnailsList  &thumbnails,
+                              const std::string     &prjname,
+                              const LayerProgressFn &progressfn)
 {
     std::string project =
         prjname.empty() ?
@@ -325,14 +326,12 @@ void SL1Archive::export_print(Zipper               &zipper,
         zipper.add_entry("config.json");
         zipper << to_json(print, iniconf);
 
-        size_t i = 0;
-        for (const sla::EncodedRaster &rst : m_layers) {
-
-            std::string imgname = project + string_printf("%.5d", i++) + "." +
+        write_layers(print, [&zipper, &project](size_t i, const sla::EncodedRaster &rst) {
+            std::string imgname = project + string_printf("%.5d", i) + "." +
                                   rst.extension();
 
             zipper.add_entry(imgname.c_str(), rst.data(), rst.size());
-        }
+        }, progressfn);
 
         for (const ThumbnailData& data : thumbnails)
             if (data.is_valid())
@@ -347,13 +346,14 @@ void SL1Archive::export_print(Zipper               &zipper,
 }
 
 void SL1Archive::export_print(const std::string     fname,
-                              const SLAPrint       &print,
-                              const ThumbnailsList &thumbnails,
-                              const std::string    &prjname)
+                              const SLAPrint        &print,
+                              const ThumbnailsList  &thumbnails,
+                              const std::string     &prjname,
+                              const LayerProgressFn &progressfn)
 {
     Zipper zipper{fname, Zipper::FAST_COMPRESSION};
 
-    export_print(zipper, print, thumbnails, prjname);
+    export_print(zipper, print, thumbnails, prjname, progressfn);
 }
 
 } // namespace Slic3r
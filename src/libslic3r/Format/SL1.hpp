@@ -26,9 +26,10 @@ protected:
     const SLAPrinterConfig & cfg() const { return m_cfg; }
 
     void export_print(Zipper &,
-                      const SLAPrint       &print,
-                      const ThumbnailsList &thumbnails,
-                      const std::string    &projectname);
+                      const SLAPrint        &print,
+                      const ThumbnailsList  &thumbnails,
+                      const std::string     &projectname,
+                      const LayerProgressFn &progressfn);
 
 public:
 
@@ -37,9 +38,10 @@ public:
     explicit SL1Archive(SLAPrinterConfig &&cfg): m_cfg(std::move(cfg)) {}
 
     void export_print(const std::string     fname,
-                      const SLAPrint       &print,
-                      const ThumbnailsList &thumbnails,
-                      const std::string    &projectname = "") override;
+                      const SLAPrint        &print,
+                      const ThumbnailsList  &thumbnails,
+                      const std::string     &projectname = "",
+                      const LayerProgressFn &progressfn  = {}) override;
 };
 
 class SL1Reader: public SLAArchiveReader {
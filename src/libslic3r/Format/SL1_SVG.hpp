@@ -31,9 +31,10 @@ protected:
 public:
 
     void export_print(const std::string     fname,
-                      const SLAPrint       &print,
-                      const ThumbnailsList &thumbnails,
-                      const std::string    &projectname = "") override;
+                      const SLAPrint        &print,
+                      const ThumbnailsList  &thumbnails,
+                      const std::string     &projectname = "",
+                      const LayerProgressFn &progressfn  = {}) override;
 
     using SL1Archive::SL1Archive;
 };
@@ -5,8 +5,24 @@
 ///|/
 #include "SLAArchiveWriter.hpp"
 
+#include <utility>
+
 #include "SLAArchiveFormatRegistry.hpp"
 #include "libslic3r/PrintConfig.hpp"
+#include "libslic3r/SLAPrint.hpp"
+
+// Intel redesigned some TBB interface considerably when merging TBB with their oneAPI set of libraries, see GH #7332.
+#if ! defined(TBB_VERSION_MAJOR)
+    #include <tbb/version.h>
+#endif
+#if TBB_VERSION_MAJOR >= 2021
+    #include <tbb/parallel_pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter_mode;
+#else
+    #include <tbb/pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter;
+#endif
+#include <tbb/task_arena.h>
 
 namespace Slic3r {
 
@@ -22,4 +38,38 @@ SLAArchiveWriter::create(const std::string &archtype, const SLAPrinterConfig &cf
     return ret;
 }
 
+void SLAArchiveWriter::write_layers(const SLAPrint &print, const LayerWriteFn &writefn, const LayerProgressFn &progressfn) const
+{
+    const std::vector<SLAPrint::PrintLayer> &layers = print.print_layers();
+
+    size_t next_layer = 0;
+    const auto generator = tbb::make_filter<void, size_t>(slic3r_tbb_filtermode::serial_in_order,
+        [&layers, &print, &next_layer](tbb::flow_control &fc) -> size_t {
+            if (next_layer == layers.size() || print.canceled()) {
+                fc.stop();
+                return 0;
+            }
+            return next_layer ++;
+        });
+    const auto rasterizer = tbb::make_filter<size_t, std::pair<size_t, sla::EncodedRaster>>(slic3r_tbb_filtermode::parallel,
+        [this, &layers](size_t idx) -> std::pair<size_t, sla::EncodedRaster> {
+            auto rst = create_raster();
+            for (const ExPolygon &poly : layers[idx].transformed_slices())
+                rst->draw(poly);
+            return { idx, rst->encode(get_encoder()) };
+        });
+    const auto writer = tbb::make_filter<std::pair<size_t, sla::EncodedRaster>, void>(slic3r_tbb_filtermode::serial_in_order,
+        [&writefn, &progressfn, &layers](const std::pair<size_t, sla::EncodedRaster> &layer) {
+            writefn(layer.first, layer.second);
+            if (progressfn)
+                progressfn(layer.first + 1, layers.size());
+        });
+
+    // The number of tokens bounds the number of rasters being drawn or waiting to be written.
+    tbb::parallel_pipeline(2 * size_t(tbb::this_task_arena::max_concurrency()), generator & rasterizer & writer);
+
+    if (print.canceled())
+        throw CanceledException();
+}
+
 } // namespace Slic3r
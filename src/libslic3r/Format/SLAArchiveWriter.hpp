@@ -10,9 +10,9 @@
 #include <memory>
 #include <string>
 #include <cstddef>
+#include <functional>
 
 #include "libslic3r/SLA/RasterBase.hpp"
-#include "libslic3r/Execution/ExecutionTBB.hpp"
 #include "libslic3r/GCode/ThumbnailData.hpp"
 #include "libslic3r/Execution/Execution.hpp"
 
@@ -22,42 +22,32 @@ class SLAPrint;
 class SLAPrinterConfig;
 
 class SLAArchiveWriter {
-protected:
-    std::vector<sla::EncodedRaster> m_layers;
+public:
+    // Called with the number of layers written so far and the total number of layers.
+    using LayerProgressFn = std::function<void(size_t, size_t)>;
 
+protected:
     virtual std::unique_ptr<sla::RasterBase> create_raster() const = 0;
     virtual sla::RasterEncoder get_encoder() const = 0;
 
+    // Rasterize and encode the layers of the print in parallel and pass them
+    // to writefn in the order of layers, each as soon as all the preceding
+    // layers were written. Only a bounded number of encoded layers (given by
+    // the pipeline depth) is held in memory at any time, independently of the
+    // number of layers. Throws CanceledException if the print was canceled.
+    // progressfn is called after each layer was written.
+    using LayerWriteFn = std::function<void(size_t, const sla::EncodedRaster &)>;
+    void write_layers(const SLAPrint &print, const LayerWriteFn &writefn, const LayerProgressFn &progressfn) const;
+
 public:
     virtual ~SLAArchiveWriter() = default;
 
-    // Fn have to be thread safe: void(sla::RasterBase& raster, size_t lyrid);
-    template<class Fn, class CancelFn, class EP = ExecutionTBB>
-    void draw_layers(
-        size_t     layer_num,
-        Fn &&      drawfn,
-        CancelFn cancelfn = []() { return false; },
-        const EP & ep       = {})
-    {
-        m_layers.resize(layer_num);
-        execution::for_each(
-            ep, size_t(0), m_layers.size(),
-            [this, &drawfn, &cancelfn](size_t idx) {
-                if (cancelfn()) return;
-
-                sla::EncodedRaster &enc = m_layers[idx];
-                auto                rst = create_raster();
-                drawfn(*rst, idx);
-                enc = rst->encode(get_encoder());
-            },
-            execution::max_concurrency(ep));
-    }
-
     // Export the print into an archive using the provided filename.
     virtual void export_print(const std::string     fname,
                               const SLAPrint       &print,
                               const ThumbnailsList &thumbnails,
-                              const std::string    &projectname = "") = 0;
+                              const std::string    &projectname = "",
+                              const LayerProgressFn &progressfn  = {}) = 0;
 
     // Factory method to create an archiver instance
     static std::unique_ptr<SLAArchiveWriter> create(
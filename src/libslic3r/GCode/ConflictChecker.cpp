@@ -6,10 +6,11 @@
 #include "ConflictChecker.hpp"
 
 #include <oneapi/tbb/blocked_range.h>
-#include <oneapi/tbb/concurrent_vector.h>
 #include <oneapi/tbb/parallel_for.h>
+#include <atomic>
 #include <map>
 #include <functional>
+#include <tuple>
 #include <cmath>
 #include <cstdint>
 #include <algorithm>
@@ -34,8 +35,9 @@ inline constexpr int64_t RasteYDistance = scale_(1);
 
 inline IndexPair point_map_grid_index(const Point &pt, int64_t xdist, int64_t ydist)
 {
-    auto x = pt.x() / xdist;
-    auto y = pt.y() / ydist;
+    // Round down, line_rasterization() expects the cells to be half open intervals also for negative coordinates.
+    auto x = int64_t(std::floor(double(pt.x()) / double(xdist)));
+    auto y = int64_t(std::floor(double(pt.y()) / double(ydist)));
     return std::make_pair(x, y);
 }
 
@@ -189,13 +191,33 @@ static std::vector<ExtrusionPaths> getFakeExtrusionPathsFromWipeTower(const Wipe
 
 
 
-void LinesBucketQueue::emplace_back_bucket(std::vector<ExtrusionPaths> &&paths, const void *objPtr, Points offsets)
+LinesBucket::LinesBucket(std::vector<ExtrusionPathRefs> &&paths, int id, Points offsets) :
+    _piles(std::move(paths)), _pileBBoxes(_piles.size()), _id(id), _offsets(std::move(offsets))
+{
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, _piles.size()), [this](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i < range.end(); ++i)
+            for (const ExtrusionPath *path : _piles[i])
+                // Merged point by point, so that the bounding box of a single straight line is defined as well.
+                for (const Point &pt : path->polyline.points)
+                    _pileBBoxes[i].merge(pt);
+    });
+}
+
+BoundingBox LinesBucket::bbox() const
+{
+    BoundingBox bbox;
+    for (const BoundingBox &pileBBox : _pileBBoxes)
+        bbox.merge(pileBBox);
+    return bbox;
+}
+
+void LinesBucketQueue::emplace_back_bucket(std::vector<ExtrusionPathRefs> &&paths, const void *objPtr, Points offsets)
 {
     if (_objsPtrToId.find(objPtr) == _objsPtrToId.end()) {
         _objsPtrToId.insert({objPtr, _objsPtrToId.size()});
         _idToObjsPtr.insert({_objsPtrToId.size() - 1, objPtr});
     }
-    _buckets.emplace_back(std::move(paths), _objsPtrToId[objPtr], offsets);
+    _buckets.emplace_back(std::move(paths), _objsPtrToId[objPtr], std::move(offsets));
 }
 
 void LinesBucketQueue::build_queue()
@@ -205,6 +227,27 @@ void LinesBucketQueue::build_queue()
         _pq.push(&bucket);
 }
 
+bool LinesBucketQueue::bboxesOverlap() const
+{
+    // Bounding boxes of the instances over all layers, the object and its support share the id.
+    std::map<std::pair<int, int>, BoundingBox> instBBoxes;
+    for (const LinesBucket &bucket : _buckets) {
+        BoundingBox bbox = bucket.bbox();
+        if (! bbox.defined)
+            continue;
+        for (int i = 0; i < (int)bucket.offsets().size(); ++i) {
+            BoundingBox shifted = bbox;
+            shifted.translate(bucket.offsets()[i]);
+            instBBoxes[{bucket.id(), i}].merge(shifted);
+        }
+    }
+    for (auto it1 = instBBoxes.begin(); it1 != instBBoxes.end(); ++it1)
+        for (auto it2 = std::next(it1); it2 != instBBoxes.end(); ++it2)
+            if (it1->second.overlap(it2->second))
+                return true;
+    return false;
+}
+
 double LinesBucketQueue::removeLowests()
 {
     auto lowest = _pq.top();
@@ -225,80 +268,164 @@ double LinesBucketQueue::removeLowests()
     return curHeight;
 }
 
-LineWithIDs LinesBucketQueue::getCurLines() const
+LinesBucketPiles LinesBucketQueue::getCurPiles() const
 {
-    LineWithIDs lines;
-    for (const LinesBucket &bucket : _buckets) {
-        if (bucket.valid()) {
-            LineWithIDs tmpLines = bucket.curLines();
-            lines.insert(lines.end(), tmpLines.begin(), tmpLines.end());
-        }
-    }
-    return lines;
+    LinesBucketPiles piles;
+    for (const LinesBucket &bucket : _buckets)
+        if (bucket.valid() && ! bucket.pile(bucket.curPileIdx()).empty())
+            piles.push_back({ &bucket, bucket.curPileIdx() });
+    return piles;
 }
 
-void getExtrusionPathsFromEntity(const ExtrusionEntityCollection *entity, ExtrusionPaths &paths)
+void getExtrusionPathsFromEntity(const ExtrusionEntityCollection *entity, ExtrusionPathRefs &paths)
 {
-    std::function<void(const ExtrusionEntityCollection *, ExtrusionPaths &)> getExtrusionPathImpl = [&](const ExtrusionEntityCollection *entity, ExtrusionPaths &paths) {
-        for (auto entityPtr : entity->entities) {
-            if (const ExtrusionEntityCollection *collection = dynamic_cast<ExtrusionEntityCollection *>(entityPtr)) {
-                getExtrusionPathImpl(collection, paths);
-            } else if (const ExtrusionPath *path = dynamic_cast<ExtrusionPath *>(entityPtr)) {
-                paths.push_back(*path);
-            } else if (const ExtrusionMultiPath *multipath = dynamic_cast<ExtrusionMultiPath *>(entityPtr)) {
-                for (const ExtrusionPath &path : multipath->paths) { paths.push_back(path); }
-            } else if (const ExtrusionLoop *loop = dynamic_cast<ExtrusionLoop *>(entityPtr)) {
-                for (const ExtrusionPath &path : loop->paths) { paths.push_back(path); }
-            }
+    for (const ExtrusionEntity *entityPtr : entity->entities) {
+        if (const ExtrusionEntityCollection *collection = dynamic_cast<const ExtrusionEntityCollection *>(entityPtr)) {
+            getExtrusionPathsFromEntity(collection, paths);
+        } else if (const ExtrusionPath *path = dynamic_cast<const ExtrusionPath *>(entityPtr)) {
+            paths.push_back(path);
+        } else if (const ExtrusionMultiPath *multipath = dynamic_cast<const ExtrusionMultiPath *>(entityPtr)) {
+            for (const ExtrusionPath &path : multipath->paths) { paths.push_back(&path); }
+        } else if (const ExtrusionLoop *loop = dynamic_cast<const ExtrusionLoop *>(entityPtr)) {
+            for (const ExtrusionPath &path : loop->paths) { paths.push_back(&path); }
         }
-    };
-    getExtrusionPathImpl(entity, paths);
+    }
 }
 
-ExtrusionPaths getExtrusionPathsFromLayer(LayerRegionPtrs layerRegionPtrs)
+ExtrusionPathRefs getExtrusionPathsFromLayer(const LayerRegionPtrs &layerRegionPtrs)
 {
-    ExtrusionPaths paths;
-    for (auto regionPtr : layerRegionPtrs) {
+    ExtrusionPathRefs paths;
+    for (const LayerRegion *regionPtr : layerRegionPtrs) {
         getExtrusionPathsFromEntity(&regionPtr->perimeters(), paths);
         if (!regionPtr->perimeters().empty()) { getExtrusionPathsFromEntity(&regionPtr->fills(), paths); }
     }
     return paths;
 }
 
-ExtrusionPaths getExtrusionPathsFromSupportLayer(const SupportLayer *supportLayer)
+ExtrusionPathRefs getExtrusionPathsFromSupportLayer(const SupportLayer *supportLayer)
 {
-    ExtrusionPaths paths;
+    ExtrusionPathRefs paths;
     getExtrusionPathsFromEntity(&supportLayer->support_fills, paths);
     return paths;
 }
 
-std::pair<std::vector<ExtrusionPaths>, std::vector<ExtrusionPaths>> getAllLayersExtrusionPathsFromObject(const PrintObject *obj)
+std::pair<std::vector<ExtrusionPathRefs>, std::vector<ExtrusionPathRefs>> getAllLayersExtrusionPathsFromObject(const PrintObject *obj)
 {
-    std::vector<ExtrusionPaths> objPaths, supportPaths;
-
-    for (auto layerPtr : obj->layers()) { objPaths.push_back(getExtrusionPathsFromLayer(layerPtr->regions())); }
+    std::vector<ExtrusionPathRefs> objPaths(obj->layers().size()), supportPaths(obj->support_layers().size());
 
-    for (auto supportLayerPtr : obj->support_layers()) { supportPaths.push_back(getExtrusionPathsFromSupportLayer(supportLayerPtr)); }
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, objPaths.size()), [obj, &objPaths](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i < range.end(); ++i)
+            objPaths[i] = getExtrusionPathsFromLayer(obj->get_layer(int(i))->regions());
+    });
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, supportPaths.size()), [obj, &supportPaths](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i < range.end(); ++i)
+            supportPaths[i] = getExtrusionPathsFromSupportLayer(obj->support_layers()[i]);
+    });
 
     return {std::move(objPaths), std::move(supportPaths)};
 }
 
+LineWithIDs ConflictChecker::get_candidate_lines(const LinesBucketPiles &piles)
+{
+    // Bounding boxes of the instances in this layer, the object and its support share the id.
+    struct InstanceBBox
+    {
+        int         obj_id;
+        int         inst_id;
+        BoundingBox bbox;
+    };
+    std::vector<InstanceBBox> instBBoxes;
+    auto find_inst = [&instBBoxes](int obj_id, int inst_id) {
+        return std::find_if(instBBoxes.begin(), instBBoxes.end(),
+                            [obj_id, inst_id](const InstanceBBox &ib) { return ib.obj_id == obj_id && ib.inst_id == inst_id; });
+    };
+    for (const LinesBucketPile &pile : piles) {
+        const BoundingBox &pileBBox = pile.bucket->pileBBox(pile.pileIdx);
+        if (! pileBBox.defined)
+            continue;
+        for (int i = 0; i < (int)pile.bucket->offsets().size(); ++i) {
+            BoundingBox shifted = pileBBox;
+            shifted.translate(pile.bucket->offsets()[i]);
+            if (auto it = find_inst(pile.bucket->id(), i); it == instBBoxes.end())
+                instBBoxes.push_back({ pile.bucket->id(), i, shifted });
+            else
+                it->bbox.merge(shifted);
+        }
+    }
+
+    LineWithIDs              lines;
+    std::vector<BoundingBox> others;
+    for (const LinesBucketPile &pile : piles) {
+        const int id = pile.bucket->id();
+        if (! pile.bucket->pileBBox(pile.pileIdx).defined)
+            continue;
+        for (int i = 0; i < (int)pile.bucket->offsets().size(); ++i) {
+            const BoundingBox &own = find_inst(id, i)->bbox;
+            others.clear();
+            for (const InstanceBBox &ib : instBBoxes)
+                if ((ib.obj_id != id || ib.inst_id != i) && ib.bbox.overlap(own))
+                    others.push_back(ib.bbox);
+            if (others.empty())
+                continue;
+
+            const Point &offset = pile.bucket->offsets()[i];
+            for (const ExtrusionPath *path : pile.bucket->pile(pile.pileIdx)) {
+                const Points &pts = path->polyline.points;
+                for (size_t j = 1; j < pts.size(); ++j) {
+                    Line        line(pts[j - 1] + offset, pts[j] + offset);
+                    BoundingBox lineBBox;
+                    lineBBox.merge(line.a);
+                    lineBBox.merge(line.b);
+                    if (std::any_of(others.begin(), others.end(), [&lineBBox](const BoundingBox &bbox) { return bbox.overlap(lineBBox); }))
+                        lines.emplace_back(line, id, i, path->role());
+                }
+            }
+        }
+    }
+    return lines;
+}
+
 ConflictComputeOpt ConflictChecker::find_inter_of_lines(const LineWithIDs &lines)
 {
     using namespace RasterizationImpl;
-    std::map<IndexPair, std::vector<int>> indexToLine;
-
-    for (int i = 0; i < (int)lines.size(); ++i) {
-        const LineWithID &l1      = lines[i];
-        auto              indexes = line_rasterization(l1._line);
-        for (auto index : indexes) {
-            const auto &possibleIntersectIdxs = indexToLine[index];
-            for (auto possibleIntersectIdx : possibleIntersectIdxs) {
-                const LineWithID &l2 = lines[possibleIntersectIdx];
-                if (auto interRes = line_intersect(l1, l2); interRes.has_value()) { return interRes; }
-            }
-            indexToLine[index].push_back(i);
+
+    // Cells of a uniform grid crossed by the lines. After sorting, the lines crossing the same cell are adjacent
+    // and grouped by instance, thus only the lines of different instances are tested against each other.
+    struct CellLine
+    {
+        IndexPair cell;
+        int       obj_id;
+        int       inst_id;
+        int       line_idx;
+
+        bool same_instance(const CellLine &rhs) const { return obj_id == rhs.obj_id && inst_id == rhs.inst_id; }
+        bool operator<(const CellLine &rhs) const
+        {
+            return std::tie(cell, obj_id, inst_id, line_idx) < std::tie(rhs.cell, rhs.obj_id, rhs.inst_id, rhs.line_idx);
         }
+    };
+    std::vector<CellLine> cells;
+    cells.reserve(lines.size() * 2);
+    for (int i = 0; i < (int)lines.size(); ++i)
+        for (const IndexPair &index : line_rasterization(lines[i]._line))
+            cells.push_back({ index, lines[i]._obj_id, lines[i]._inst_id, i });
+    std::sort(cells.begin(), cells.end());
+
+    for (size_t cellBegin = 0; cellBegin < cells.size();) {
+        size_t cellEnd = cellBegin + 1;
+        while (cellEnd < cells.size() && cells[cellEnd].cell == cells[cellBegin].cell)
+            ++cellEnd;
+        for (size_t instBegin = cellBegin; instBegin < cellEnd;) {
+            size_t instEnd = instBegin + 1;
+            while (instEnd < cellEnd && cells[instEnd].same_instance(cells[instBegin]))
+                ++instEnd;
+            for (size_t i = instBegin; i < instEnd; ++i)
+                for (size_t j = instEnd; j < cellEnd; ++j)
+                    if (auto interRes = line_intersect(lines[cells[i].line_idx], lines[cells[j].line_idx]); interRes.has_value())
+                        return interRes;
+            instBegin = instEnd;
+        }
+        cellBegin = cellEnd;
     }
     return {};
 }
@@ -318,14 +445,23 @@ ConflictResultOpt ConflictChecker::find_inter_of_lines_in_diff_objs(SpanOfConstP
     int wtptr = 0;
 
     LinesBucketQueue conflictQueue;
+    // The fake wipe tower paths are referenced by the queue.
+    std::vector<ExtrusionPaths> wtpaths;
     if (! wipe_tower_data.z_and_depth_pairs.empty()) {
         // The wipe tower is being generated.
         const Vec2d plate_origin = Vec2d::Zero();
-        std::vector<ExtrusionPaths> wtpaths = getFakeExtrusionPathsFromWipeTower(wipe_tower_data);
-        conflictQueue.emplace_back_bucket(std::move(wtpaths), &wtptr, Points{Point(plate_origin)});
+        wtpaths = getFakeExtrusionPathsFromWipeTower(wipe_tower_data);
+        std::vector<ExtrusionPathRefs> wtrefs;
+        wtrefs.reserve(wtpaths.size());
+        for (const ExtrusionPaths &layer : wtpaths) {
+            wtrefs.emplace_back();
+            for (const ExtrusionPath &path : layer)
+                wtrefs.back().push_back(&path);
+        }
+        conflictQueue.emplace_back_bucket(std::move(wtrefs), &wtptr, Points{Point(plate_origin)});
     }
     for (const PrintObject *obj : objs) {
-        std::pair<std::vector<ExtrusionPaths>, std::vector<ExtrusionPaths>> layers = getAllLayersExtrusionPathsFromObject(obj);
+        std::pair<std::vector<ExtrusionPathRefs>, std::vector<ExtrusionPathRefs>> layers = getAllLayersExtrusionPathsFromObject(obj);
 
         Points instances_shifts;
         for (const PrintInstance& inst : obj->instances())
@@ -334,39 +470,44 @@ ConflictResultOpt ConflictChecker::find_inter_of_lines_in_diff_objs(SpanOfConstP
         conflictQueue.emplace_back_bucket(std::move(layers.first), obj, instances_shifts);
         conflictQueue.emplace_back_bucket(std::move(layers.second), obj, instances_shifts);
     }
+
+    // Instances (and the wipe tower) far from each other cannot conflict in any layer.
+    if (! conflictQueue.bboxesOverlap())
+        return {};
+
     conflictQueue.build_queue();
 
-    std::vector<LineWithIDs> layersLines;
-    std::vector<double>      heights;
+    std::vector<LinesBucketPiles> layersPiles;
+    std::vector<double>           heights;
     while (conflictQueue.valid()) {
-        LineWithIDs lines     = conflictQueue.getCurLines();
-        double      curHeight = conflictQueue.removeLowests();
+        LinesBucketPiles piles     = conflictQueue.getCurPiles();
+        double           curHeight = conflictQueue.removeLowests();
         heights.push_back(curHeight);
-        layersLines.push_back(std::move(lines));
+        layersPiles.push_back(std::move(piles));
     }
 
-    bool                                   find = false;
-    tbb::concurrent_vector<std::pair<ConflictComputeResult,double>> conflict;
-
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, layersLines.size()), [&](tbb::blocked_range<size_t> range) {
-        for (size_t i = range.begin(); i < range.end(); i++) {
-            auto interRes = find_inter_of_lines(layersLines[i]);
-            if (interRes.has_value()) {
-                find = true;
-                conflict.emplace_back(*interRes, heights[i]);
+    // Only the lowest conflict is reported, layers above an already found conflict are skipped.
+    std::vector<ConflictComputeOpt> conflicts(layersPiles.size());
+    std::atomic<size_t>             lowestConflict { layersPiles.size() };
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, layersPiles.size()), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i < range.end() && i < lowestConflict.load(std::memory_order_relaxed); ++i) {
+            if (layersPiles[i].size() < 2 && (layersPiles[i].empty() || layersPiles[i].front().bucket->offsets().size() < 2))
+                // A single instance cannot conflict with itself.
+                continue;
+            conflicts[i] = find_inter_of_lines(get_candidate_lines(layersPiles[i]));
+            if (conflicts[i].has_value()) {
+                size_t lowest = lowestConflict.load();
+                while (i < lowest && ! lowestConflict.compare_exchange_weak(lowest, i)) ;
                 break;
             }
         }
     });
 
-    if (find) {
-        std::sort(conflict.begin(), conflict.end(), [](const std::pair<ConflictComputeResult, double>& i1, const std::pair<ConflictComputeResult, double>& i2) {
-            return i1.second < i2.second;
-        });
-
-        const void *ptr1           = conflictQueue.idToObjsPtr(conflict[0].first._obj1);
-        const void *ptr2           = conflictQueue.idToObjsPtr(conflict[0].first._obj2);
-        double      conflictHeight = conflict[0].second;
+    if (size_t idx = lowestConflict.load(); idx < layersPiles.size()) {
+        const void *ptr1           = conflictQueue.idToObjsPtr(conflicts[idx]->_obj1);
+        const void *ptr2           = conflictQueue.idToObjsPtr(conflicts[idx]->_obj2);
+        double      conflictHeight = heights[idx];
         if (ptr1 == &wtptr || ptr2 == &wtptr) {
             assert(! wipe_tower_data.z_and_depth_pairs.empty());
             if (ptr2 == &wtptr) { std::swap(ptr1, ptr2); }
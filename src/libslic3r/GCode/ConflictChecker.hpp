@@ -13,6 +13,7 @@
 #include <string>
 #include <utility>
 
+#include "libslic3r/BoundingBox.hpp"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/ExtrusionEntity.hpp"
 #include "libslic3r/ExtrusionRole.hpp"
@@ -38,49 +39,58 @@ struct LineWithID
 
 using LineWithIDs = std::vector<LineWithID>;
 
+// Extrusion paths referenced from the layers of a PrintObject (or from the fake wipe tower layers), they are not copied.
+using ExtrusionPathRefs = std::vector<const ExtrusionPath *>;
+
 class LinesBucket
 {
 private:
     double   _curHeight  = 0.0;
     unsigned _curPileIdx = 0;
 
-    std::vector<ExtrusionPaths> _piles;
-    int                         _id;
-    Points                      _offsets;
+    std::vector<ExtrusionPathRefs> _piles;
+    // Bounding boxes of the piles, not shifted by the instance offsets.
+    std::vector<BoundingBox>       _pileBBoxes;
+    int                            _id;
+    Points                         _offsets;
 
 public:
-    LinesBucket(std::vector<ExtrusionPaths> &&paths, int id, Points offsets) : _piles(paths), _id(id), _offsets(offsets) {}
+    LinesBucket(std::vector<ExtrusionPathRefs> &&paths, int id, Points offsets);
     LinesBucket(LinesBucket &&) = default;
 
     bool valid() const { return _curPileIdx < _piles.size(); }
     void raise()
     {
         if (valid()) {
-            if (_piles[_curPileIdx].empty() == false) { _curHeight += _piles[_curPileIdx].front().height(); }
+            if (_piles[_curPileIdx].empty() == false) { _curHeight += _piles[_curPileIdx].front()->height(); }
             _curPileIdx++;
         }
     }
-    double      curHeight() const { return _curHeight; }
-    LineWithIDs curLines() const
-    {
-        LineWithIDs lines;
-        for (const ExtrusionPath &path : _piles[_curPileIdx]) {
-            Polyline check_polyline;
-            for (int i = 0; i < (int)_offsets.size(); ++i) {
-                check_polyline = path.polyline;
-                check_polyline.translate(_offsets[i]);
-                Lines tmpLines = check_polyline.lines();
-                for (const Line& line : tmpLines) { lines.emplace_back(line, _id, i, path.role()); }
-            }
-        }
-        return lines;
-    }
+    double   curHeight() const { return _curHeight; }
+    unsigned curPileIdx() const { return _curPileIdx; }
+    int      id() const { return _id; }
+
+    const Points            &offsets() const { return _offsets; }
+    const ExtrusionPathRefs &pile(unsigned idx) const { return _piles[idx]; }
+    const BoundingBox       &pileBBox(unsigned idx) const { return _pileBBoxes[idx]; }
+    // Bounding box of all the piles, not shifted by the instance offsets.
+    BoundingBox              bbox() const;
 
     friend bool operator>(const LinesBucket &left, const LinesBucket &right) { return left._curHeight > right._curHeight; }
     friend bool operator<(const LinesBucket &left, const LinesBucket &right) { return left._curHeight < right._curHeight; }
     friend bool operator==(const LinesBucket &left, const LinesBucket &right) { return left._curHeight == right._curHeight; }
 };
 
+// A single layer of a LinesBucket.
+struct LinesBucketPile
+{
+    const LinesBucket *bucket;
+    unsigned           pileIdx;
+};
+
+// Layers of all the buckets printed at the same height.
+using LinesBucketPiles = std::vector<LinesBucketPile>;
+
 struct LinesBucketPtrComp
 {
     bool operator()(const LinesBucket *left, const LinesBucket *right) { return *left > *right; }
@@ -95,7 +105,7 @@ private:
     std::map<const void *, int>                                                        _objsPtrToId;
 
 public:
-    void        emplace_back_bucket(std::vector<ExtrusionPaths> &&paths, const void *objPtr, Points offset);
+    void        emplace_back_bucket(std::vector<ExtrusionPathRefs> &&paths, const void *objPtr, Points offset);
     void        build_queue();
     bool        valid() const { return _pq.empty() == false; }
     const void *idToObjsPtr(int id)
@@ -105,17 +115,19 @@ public:
         else
             return nullptr;
     }
-    double      removeLowests();
-    LineWithIDs getCurLines() const;
+    // Returns true if the bounding boxes of two different instances overlap, otherwise no conflict is possible.
+    bool             bboxesOverlap() const;
+    double           removeLowests();
+    LinesBucketPiles getCurPiles() const;
 };
 
-void getExtrusionPathsFromEntity(const ExtrusionEntityCollection *entity, ExtrusionPaths &paths);
+void getExtrusionPathsFromEntity(const ExtrusionEntityCollection *entity, ExtrusionPathRefs &paths);
 
-ExtrusionPaths getExtrusionPathsFromLayer(LayerRegionPtrs layerRegionPtrs);
+ExtrusionPathRefs getExtrusionPathsFromLayer(const LayerRegionPtrs &layerRegionPtrs);
 
-ExtrusionPaths getExtrusionPathsFromSupportLayer(SupportLayer *supportLayer);
+ExtrusionPathRefs getExtrusionPathsFromSupportLayer(const SupportLayer *supportLayer);
 
-std::pair<std::vector<ExtrusionPaths>, std::vector<ExtrusionPaths>> getAllLayersExtrusionPathsFromObject(PrintObject *obj);
+std::pair<std::vector<ExtrusionPathRefs>, std::vector<ExtrusionPathRefs>> getAllLayersExtrusionPathsFromObject(const PrintObject *obj);
 
 struct ConflictComputeResult
 {
@@ -133,6 +145,9 @@ using ConflictObjName = std::optional<std::pair<std::string, std::string>>;
 struct ConflictChecker
 {
     static ConflictResultOpt  find_inter_of_lines_in_diff_objs(SpanOfConstPtrs<PrintObject> objs, const WipeTowerData& wtd);
+    // Lines of a single layer, which may intersect a line of another instance in the same layer.
+    // Lines outside of the bounding boxes of the other instances are skipped.
+    static LineWithIDs        get_candidate_lines(const LinesBucketPiles &piles);
     static ConflictComputeOpt find_inter_of_lines(const LineWithIDs &lines);
     static ConflictComputeOpt line_intersect(const LineWithID &l1, const LineWithID &l2);
 };
@@ -5,12 +5,11 @@
 #include "FindReplace.hpp"
 
 #include <boost/algorithm/string/replace.hpp>
-#include <boost/algorithm/string/find.hpp>
-#include <boost/range/iterator_range_core.hpp>
+#include <algorithm>
+#include <cassert>
 #include <cctype> // isalpha
 #include <exception>
 #include <iterator>
-#include <tuple>
 #include <utility>
 #include <cstring>
 
@@ -35,6 +34,154 @@ const void unescape_extended_search_mode(std::string &s)
 // \u: The hexadecimal representation of a two-byte character, made of 4 digits in the 0-9, A-F/a-f range.
 }
 
+static inline unsigned char fold_case(const char c)
+{
+    return (unsigned char)std::toupper((unsigned char)c);
+}
+
+static bool equal_case_insensitive(const char *a, const char *b, const size_t len)
+{
+    for (size_t i = 0; i < len; ++ i)
+        if (fold_case(a[i]) != fold_case(b[i]))
+            return false;
+    return true;
+}
+
+// Could occurrences of the two strings in a text share any character? Case insensitive, thus conservative.
+// True if one string contains the other or if a suffix of one string is a prefix of the other.
+static bool strings_may_overlap(const std::string &a, const std::string &b)
+{
+    if (a.empty() || b.empty())
+        return false;
+    for (size_t i = 0; i < a.size(); ++ i)
+        if (equal_case_insensitive(a.data() + i, b.data(), std::min(a.size() - i, b.size())))
+            return true;
+    for (size_t i = 1; i < b.size(); ++ i)
+        if (equal_case_insensitive(b.data() + i, a.data(), std::min(b.size() - i, a.size())))
+            return true;
+    return false;
+}
+
+// Does the replacement keep the alphanumeric class of the characters at both ends of the match?
+// Then the replacement does not change the outcome of a whole word test of a neighboring match.
+static bool preserves_word_boundaries(const std::string &pattern, const std::string &format)
+{
+    return ! pattern.empty() && ! format.empty() &&
+        bool(std::isalnum(pattern.front())) == bool(std::isalnum(format.front())) &&
+        bool(std::isalnum(pattern.back()))  == bool(std::isalnum(format.back()));
+}
+
+// Could the plain text substitution substitutions[next] be applied in the same pass as substitutions[first, next)?
+// When applied one after the other, a substitution sees the text modified by the preceding ones. The single pass
+// produces the same result if the next pattern can neither overlap a preceding pattern nor a text it was replaced with,
+// if no preceding replacement joins the text around it by deleting the match, and if the preceding replacements
+// don't change a whole word test of the next pattern.
+bool GCodeFindReplace::can_join_plain_batch(const std::vector<Substitution> &substitutions, const size_t first, const size_t next)
+{
+    const Substitution &s = substitutions[next];
+    for (size_t i = first; i < next; ++ i) {
+        const Substitution &prev = substitutions[i];
+        if (prev.format.empty() ||
+            strings_may_overlap(prev.plain_pattern, s.plain_pattern) ||
+            strings_may_overlap(prev.format, s.plain_pattern) ||
+            (s.whole_word && ! preserves_word_boundaries(prev.plain_pattern, prev.format)))
+            return false;
+    }
+    return true;
+}
+
+void GCodeFindReplace::PlainTextBatch::build(const std::vector<Substitution> &substitutions)
+{
+    // Build a trie of case folded patterns. State 0 is the root, thus transition to state 0 marks a missing edge.
+    transitions.assign(256, 0);
+    match.assign(1, -1);
+    for (size_t i = this->first; i < this->last; ++ i) {
+        const Substitution &substitution = substitutions[i];
+        if (substitution.plain_pattern.empty() || (substitution.whole_word && substitution.plain_pattern == substitution.format))
+            // Nothing to replace.
+            continue;
+        uint32_t state = 0;
+        for (const char c : substitution.plain_pattern) {
+            uint32_t &next = transitions[state * 256 + fold_case(c)];
+            if (next == 0) {
+                next = uint32_t(match.size());
+                match.emplace_back(-1);
+                transitions.resize(transitions.size() + 256, 0);
+            }
+            // transitions may have been reallocated.
+            state = transitions[state * 256 + fold_case(c)];
+        }
+        // A repeated pattern would overlap with itself, thus it is never part of the same batch.
+        assert(match[state] == -1);
+        match[state] = int32_t(i);
+    }
+
+    // Resolve the failure links breadth first, turning the trie into a complete automaton.
+    const size_t          num_states = match.size();
+    std::vector<uint32_t> failure(num_states, 0);
+    std::vector<uint32_t> queue;
+    queue.reserve(num_states);
+    match_link.assign(num_states, 0);
+    for (size_t c = 0; c < 256; ++ c)
+        if (uint32_t child = transitions[c]; child != 0)
+            queue.emplace_back(child);
+    for (size_t i = 0; i < queue.size(); ++ i) {
+        const uint32_t state = queue[i];
+        for (size_t c = 0; c < 256; ++ c) {
+            uint32_t &next = transitions[state * 256 + c];
+            const uint32_t next_failure = transitions[failure[state] * 256 + c];
+            if (next == 0)
+                next = next_failure;
+            else {
+                failure[next]    = next_failure;
+                match_link[next] = match[next_failure] != -1 ? next_failure : match_link[next_failure];
+                queue.emplace_back(next);
+            }
+        }
+    }
+}
+
+void GCodeFindReplace::PlainTextBatch::apply(const std::vector<Substitution> &substitutions, const std::string &in, std::string &out) const
+{
+    struct Hit {
+        size_t begin;
+        size_t end;
+        size_t substitution;
+    };
+    std::vector<Hit> hits;
+    // Each substitution replaces non-overlapping matches from left to right.
+    std::vector<size_t> next_allowed(this->last - this->first, 0);
+
+    uint32_t state = 0;
+    for (size_t pos = 0; pos < in.size(); ++ pos) {
+        state = transitions[state * 256 + fold_case(in[pos])];
+        for (uint32_t matched = match[state] != -1 ? state : match_link[state]; matched != 0; matched = match_link[matched]) {
+            const size_t        idx          = size_t(match[matched]);
+            const Substitution &substitution = substitutions[idx];
+            const size_t        end          = pos + 1;
+            const size_t        begin        = end - substitution.plain_pattern.size();
+            if (begin < next_allowed[idx - this->first] ||
+                (! substitution.case_insensitive && memcmp(in.data() + begin, substitution.plain_pattern.data(), substitution.plain_pattern.size()) != 0))
+                continue;
+            next_allowed[idx - this->first] = end;
+            if (substitution.whole_word && ! ((begin == 0 || ! std::isalnum(in[begin - 1])) && (end == in.size() || ! std::isalnum(in[end]))))
+                continue;
+            hits.push_back({ begin, end, idx });
+        }
+    }
+
+    // Patterns of a batch don't overlap, thus the hits are sorted and disjoint.
+    out.reserve(in.size());
+    size_t k = 0;
+    for (const Hit &hit : hits) {
+        assert(hit.begin >= k);
+        out.append(in, k, hit.begin - k);
+        out.append(substitutions[hit.substitution].format);
+        k = hit.end;
+    }
+    out.append(in, k, in.size() - k);
+}
+
 GCodeFindReplace::GCodeFindReplace(const std::vector<std::string> &gcode_substitutions)
 {
     if ((gcode_substitutions.size() % 4) != 0)
@@ -66,6 +213,21 @@ GCodeFindReplace::GCodeFindReplace(const std::vector<std::string> &gcode_substit
         }
         m_substitutions.emplace_back(std::move(out));
     }
+
+    // Group consecutive plain text substitutions, which do not interact, to be applied in a single pass.
+    for (size_t i = 0; i < m_substitutions.size(); ++ i) {
+        Substitution &substitution = m_substitutions[i];
+        if (substitution.regexp)
+            continue;
+        if (m_plain_batches.empty() || m_plain_batches.back().last != i || ! can_join_plain_batch(m_substitutions, m_plain_batches.back().first, i)) {
+            m_plain_batches.emplace_back();
+            m_plain_batches.back().first = i;
+        }
+        m_plain_batches.back().last = i + 1;
+        substitution.batch_idx = m_plain_batches.size() - 1;
+    }
+    for (PlainTextBatch &batch : m_plain_batches)
+        batch.build(m_substitutions);
 }
 
 class ToStringIterator 
@@ -95,29 +257,6 @@ private:
     std::string *m_data;
 };
 
-template<typename FindFn>
-static void find_and_replace_whole_word(std::string &inout, const std::string &match, const std::string &replace, FindFn find_fn)
-{
-    if (! match.empty() && inout.size() >= match.size() && match != replace) {
-        std::string out;
-        auto [i, j] = find_fn(inout, 0, match);
-        size_t k = 0;
-        for (; i != std::string::npos; std::tie(i, j) = find_fn(inout, i, match)) {
-            if ((i == 0 || ! std::isalnum(inout[i - 1])) && (j == inout.size() || ! std::isalnum(inout[j]))) {
-                out.reserve(inout.size());
-                out.append(inout, k, i - k);
-                out.append(replace);
-                i = k = j;
-            } else
-                i += match.size();
-        }
-        if (k > 0) {
-            out.append(inout, k, inout.size() - k);
-            inout.swap(out);
-        }
-    }
-}
-
 std::string GCodeFindReplace::process_layer(const std::string &ain)
 {
     std::string out;
@@ -125,41 +264,23 @@ std::string GCodeFindReplace::process_layer(const std::string &ain)
     std::string temp;
     temp.reserve(in->size());
 
-    for (const Substitution &substitution : m_substitutions) {
+    for (size_t i = 0; i < m_substitutions.size();) {
+        const Substitution &substitution = m_substitutions[i];
+        temp.clear();
         if (substitution.regexp) {
-            temp.clear();
             temp.reserve(in->size());
             boost::regex_replace(ToStringIterator(temp), in->begin(), in->end(),
                 substitution.regexp_pattern, substitution.format, 
                 (substitution.single_line ? boost::match_single_line | boost::match_default : boost::match_not_dot_newline | boost::match_default) | boost::format_all);
-            std::swap(out, temp);
+            ++ i;
         } else {
-            if (in == &ain)
-                out = ain;
-            // Plain substitution
-            if (substitution.case_insensitive) {
-                if (substitution.whole_word)
-                    find_and_replace_whole_word(out, substitution.plain_pattern, substitution.format,
-                        [](const std::string &str, size_t start_pos, const std::string &match) {
-                            auto begin = str.begin() + start_pos;
-                            boost::iterator_range<std::string::const_iterator> r1(begin, str.end());
-                            boost::iterator_range<std::string::const_iterator> r2(match.begin(), match.end());
-                            auto res = boost::ifind_first(r1, r2);
-                            return res ? std::make_pair(size_t(res.begin() - str.begin()), size_t(res.end() - str.begin())) : std::make_pair(std::string::npos, std::string::npos);
-                        });
-                else
-                    boost::ireplace_all(out, substitution.plain_pattern, substitution.format);
-            } else {
-                if (substitution.whole_word)
-                    find_and_replace_whole_word(out, substitution.plain_pattern, substitution.format,
-                        [](const std::string &str, size_t start_pos, const std::string &match) { 
-                            size_t pos = str.find(match, start_pos);
-                            return std::make_pair(pos, pos + (pos == std::string::npos ? 0 : match.size()));
-                        });
-                else
-                    boost::replace_all(out, substitution.plain_pattern, substitution.format);
-            }
+            // Plain substitutions, all substitutions of a batch in a single pass.
+            const PlainTextBatch &batch = m_plain_batches[substitution.batch_idx];
+            assert(batch.first == i);
+            batch.apply(m_substitutions, *in, temp);
+            i = batch.last;
         }
+        std::swap(out, temp);
         in = &out;
     }
 
@@ -9,6 +9,7 @@
 #include <boost/regex/v5/regex.hpp>
 #include <string>
 #include <vector>
+#include <cstdint>
 
 #include "../PrintConfig.hpp"
 
@@ -33,8 +34,30 @@ private:
         bool            whole_word { false };
         // Valid for regexp only. Equivalent to Perl's /s modifier.
         bool            single_line { false };
+        // Valid for plain text only. Index into m_plain_batches.
+        size_t          batch_idx { 0 };
     };
     std::vector<Substitution> m_substitutions;
+
+    // A run of consecutive plain text substitutions m_substitutions[first, last), which are independent of each other,
+    // thus they produce the same result when applied in a single pass as when applied one after the other.
+    // The patterns are compiled into a single Aho-Corasick automaton, matching case insensitively.
+    struct PlainTextBatch {
+        size_t                  first { 0 };
+        size_t                  last  { 0 };
+        // Transition table of the automaton with failure links resolved, 256 entries per state.
+        std::vector<uint32_t>   transitions;
+        // Per state: index of the substitution whose pattern ends at this state, or -1.
+        std::vector<int32_t>    match;
+        // Per state: closest state on the failure chain with a match, or 0 if there is none.
+        std::vector<uint32_t>   match_link;
+
+        void build(const std::vector<Substitution> &substitutions);
+        void apply(const std::vector<Substitution> &substitutions, const std::string &in, std::string &out) const;
+    };
+    std::vector<PlainTextBatch> m_plain_batches;
+
+    static bool can_join_plain_batch(const std::vector<Substitution> &substitutions, size_t first, size_t next);
 };
 
 }
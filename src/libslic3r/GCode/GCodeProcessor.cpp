@@ -5,6 +5,7 @@
 ///|/#include "libslic3r/libslic3r.h"
 #include "libslic3r/Utils.hpp"
 #include "libslic3r/Print.hpp"
+#include "libslic3r/Thread.hpp"
 #include <LocalesUtils.hpp>
 #include "libslic3r/format.hpp"
 #include "libslic3r/I18N.hpp"
@@ -19,6 +20,7 @@
 #include <boost/algorithm/string/split.hpp>
 #include <boost/nowide/fstream.hpp>
 #include <boost/nowide/cstdio.hpp>
+#include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 
 #include <float.h>
@@ -30,6 +32,9 @@
 #endif
 
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 
 static const float DEFAULT_TOOLPATH_WIDTH = 0.4f;
 static const float DEFAULT_TOOLPATH_HEIGHT = 0.2f;
@@ -1067,6 +1072,7 @@ void GCodeProcessor::reset()
 
     m_result.reset();
     m_result.id = ++s_result_id;
+    m_streamed_lines.reset();
 
     m_use_volumetric_e = false;
     m_last_default_color_id = 0;
@@ -1355,10 +1361,55 @@ void GCodeProcessor::initialize(const std::string& filename)
     // process gcode
     m_result.filename = filename;
     m_result.id = ++s_result_id;
+    m_streamed_lines.reset();
+}
+
+// Is the line (without the trailing '\n') possibly modified by GCodeProcessor::post_process()?
+static bool is_post_processed_line(const std::string_view line)
+{
+    if (line.size() < 2 || line.front() != ';')
+        return false;
+    if (line[1] == '_') {
+        for (GCodeProcessor::ETags tag : { GCodeProcessor::ETags::First_Line_M73_Placeholder, GCodeProcessor::ETags::Last_Line_M73_Placeholder,
+                                           GCodeProcessor::ETags::Estimated_Printing_Time_Placeholder })
+            if (boost::starts_with(line.substr(1), GCodeProcessor::reserved_tag(tag)))
+                return true;
+        return false;
+    }
+    for (const std::string *mask : { &PrintStatistics::FilamentUsedMmMask, &PrintStatistics::FilamentUsedGMask, &PrintStatistics::TotalFilamentUsedGMask,
+                                     &PrintStatistics::FilamentUsedCm3Mask, &PrintStatistics::FilamentCostMask, &PrintStatistics::TotalFilamentCostMask })
+        if (boost::starts_with(line, *mask))
+            return true;
+    return false;
+}
+
+void GCodeProcessor::StreamedLines::append(const std::string& buffer)
+{
+    // Long enough for the placeholders and the filament statistics masks.
+    static const size_t max_head_length = 64;
+    for (size_t begin = 0; begin < buffer.size();) {
+        const size_t end = std::min(buffer.find('\n', begin), buffer.size());
+        if (current_line_head.size() < max_head_length)
+            current_line_head.append(buffer, begin, std::min(end - begin, max_head_length - current_line_head.size()));
+        // post_process() splits lines at '\r' and replaces "\r\n" with '\n'.
+        current_line_has_cr |= std::find(buffer.begin() + begin, buffer.begin() + end, '\r') != buffer.begin() + end;
+        if (end == buffer.size())
+            break;
+        if (first_modified_line == size_t(-1) && (current_line_has_cr || is_post_processed_line(current_line_head)))
+            first_modified_line = lines_ends.size();
+        lines_ends.emplace_back(size + end + 1);
+        current_line_head.clear();
+        current_line_has_cr = false;
+        begin = end + 1;
+    }
+    size += buffer.size();
 }
 
 void GCodeProcessor::process_buffer(const std::string &buffer)
 {
+    if (post_process_tail_only())
+        m_streamed_lines.append(buffer);
+
     //FIXME maybe cache GCodeLine gline to be over multiple parse_buffer() invocations.
     m_parser.parse_buffer(buffer, [this](GCodeReader&, const GCodeReader::GCodeLine& line) { 
         this->process_gcode_line(line, false);
@@ -3700,12 +3751,54 @@ void GCodeProcessor::process_T(const std::string_view command)
     }
 }
 
+// Overwrite the content of file path starting at position pos with the content of file tail_path, then remove tail_path.
+static void replace_file_tail(const std::string& path, size_t pos, const std::string& tail_path)
+{
+    size_t size = pos;
+    {
+        FilePtr in{ boost::nowide::fopen(tail_path.c_str(), "rb") };
+        FilePtr out{ boost::nowide::fopen(path.c_str(), "r+b") };
+        if (in.f == nullptr || out.f == nullptr || ::fseek(out.f, long(pos), SEEK_SET) != 0)
+            throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nCannot open file for writing.\n"));
+        std::vector<char> buffer(65536 * 10, 0);
+        while (size_t cnt_read = ::fread(buffer.data(), 1, buffer.size(), in.f)) {
+            ::fwrite(buffer.data(), 1, cnt_read, out.f);
+            if (::ferror(out.f))
+                throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nIs the disk full?\n"));
+            size += cnt_read;
+        }
+        if (::ferror(in.f))
+            throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nError while reading from file.\n"));
+    }
+    boost::system::error_code ec;
+    boost::filesystem::resize_file(boost::filesystem::path(path), size, ec);
+    if (ec)
+        throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nCannot resize file ") + path + ": " + ec.message() + "\n");
+    boost::nowide::remove(tail_path.c_str());
+}
+
 void GCodeProcessor::post_process()
 {
     FilePtr in{ boost::nowide::fopen(m_result.filename.c_str(), "rb") };
     if (in.f == nullptr)
         throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nCannot open file for reading.\n"));
 
+    // If only the lines at the end of the G-code are modified, the lines in front of them are not rewritten:
+    // Just the tail is post-processed into the temporary file, which then overwrites the tail of the original file.
+    size_t tail_line = 0;
+    size_t tail_pos  = 0;
+    if (post_process_tail_only()) {
+        const size_t line = m_streamed_lines.tail_begin_line();
+        const size_t pos  = (line == 0) ? 0 : m_streamed_lines.lines_ends[line - 1];
+        // Don't bother if the tail is not substantially shorter than the file.
+        if (pos > m_streamed_lines.size / 2 && pos <= size_t(std::numeric_limits<long>::max()) &&
+            ::fseek(in.f, 0, SEEK_END) == 0 && size_t(::ftell(in.f)) == m_streamed_lines.size && ::fseek(in.f, long(pos), SEEK_SET) == 0) {
+            tail_line = line;
+            tail_pos  = pos;
+        } else
+            ::rewind(in.f);
+    }
+
     // temporary file to contain modified gcode
     std::string out_path = m_result.filename + ".postprocess";
     FilePtr out{ boost::nowide::fopen(out_path.c_str(), "wb") };
@@ -3824,6 +3917,99 @@ void GCodeProcessor::post_process()
         last_exported_stop[i] = time_in_minutes(m_time_processor.machines[i].time);
     }
 
+    // Helper class feeding the binarizer from a worker thread, so that the encoding and compression of the gcode blocks
+    // overlaps with reading and processing of the text gcode. The binarizer is only accessed by the worker thread
+    // between the calls to initialize() and finalize().
+    class BinarizerWorker
+    {
+    public:
+        explicit BinarizerWorker(bgcode::binarize::Binarizer& binarizer) : m_binarizer(binarizer) {
+            m_thread = create_thread([this]() { this->run(); });
+        }
+        ~BinarizerWorker() {
+            // Exception thrown while exporting, drop the queued gcode.
+            {
+                std::scoped_lock<std::mutex> lock(m_mutex);
+                m_queue.clear();
+            }
+            this->stop();
+        }
+
+        // Blocks if the worker thread lags behind by more than m_max_queued_blocks.
+        void append(std::string&& gcode) {
+            if (gcode.empty())
+                return;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cond_not_full.wait(lock, [this]() { return m_queue.size() < m_max_queued_blocks || m_failed; });
+                if (m_failed)
+                    throw Slic3r::RuntimeError("Error while sending gcode to the binarizer.");
+                m_queue.emplace_back(std::move(gcode));
+            }
+            m_cond_not_empty.notify_one();
+        }
+
+        // Waits until all the gcode was passed to the binarizer.
+        void finish() {
+            this->stop();
+            if (m_failed)
+                throw Slic3r::RuntimeError("Error while sending gcode to the binarizer.");
+        }
+
+    private:
+        void stop() {
+            {
+                std::scoped_lock<std::mutex> lock(m_mutex);
+                m_finished = true;
+            }
+            m_cond_not_empty.notify_one();
+            if (m_thread.joinable())
+                m_thread.join();
+        }
+
+        void run() {
+            for (;;) {
+                std::string gcode;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_cond_not_empty.wait(lock, [this]() { return !m_queue.empty() || m_finished; });
+                    if (m_queue.empty())
+                        return;
+                    gcode = std::move(m_queue.front());
+                    m_queue.pop_front();
+                }
+                m_cond_not_full.notify_one();
+                bool success = false;
+                try {
+                    success = m_binarizer.append_gcode(gcode) == bgcode::core::EResult::Success;
+                } catch (const std::exception& ex) {
+                    // An exception must not escape the worker thread (e.g. std::bad_alloc), it is reported by append() or finish().
+                    BOOST_LOG_TRIVIAL(error) << "Error while sending gcode to the binarizer: " << ex.what();
+                } catch (...) {
+                    BOOST_LOG_TRIVIAL(error) << "Unknown error while sending gcode to the binarizer.";
+                }
+                if (!success) {
+                    {
+                        std::scoped_lock<std::mutex> lock(m_mutex);
+                        m_failed = true;
+                    }
+                    m_cond_not_full.notify_one();
+                    return;
+                }
+            }
+        }
+
+        bgcode::binarize::Binarizer& m_binarizer;
+        boost::thread                m_thread;
+        std::mutex                   m_mutex;
+        std::condition_variable      m_cond_not_empty;
+        std::condition_variable      m_cond_not_full;
+        std::deque<std::string>      m_queue;
+        const size_t                 m_max_queued_blocks{ 16 };
+        bool                         m_finished{ false };
+        bool                         m_failed{ false };
+    };
+
     // Helper class to modify and export gcode to file
     class ExportLines
     {
@@ -3898,15 +4084,16 @@ void GCodeProcessor::post_process()
         size_t m_times_cache_id{ 0 };
         size_t m_out_file_pos{ 0 };
 
-        bgcode::binarize::Binarizer& m_binarizer;
+        // nullptr if exporting text gcode
+        BinarizerWorker* m_binarizer_worker;
 
     public:
-        ExportLines(bgcode::binarize::Binarizer& binarizer, EWriteType type,
+        ExportLines(BinarizerWorker* binarizer_worker, EWriteType type,
             const std::array<TimeMachine, static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count)>& machines)
 #ifndef NDEBUG
-        : m_statistics(*this), m_binarizer(binarizer), m_write_type(type), m_machines(machines) {}
+        : m_statistics(*this), m_binarizer_worker(binarizer_worker), m_write_type(type), m_machines(machines) {}
 #else
-        : m_binarizer(binarizer), m_write_type(type), m_machines(machines) {}
+        : m_binarizer_worker(binarizer_worker), m_write_type(type), m_machines(machines) {}
 #endif // NDEBUG
 
         // return: number of internal G1 lines (from G2/G3 splitting) processed
@@ -4052,10 +4239,8 @@ void GCodeProcessor::post_process()
                 }
             }
 
-            if (m_binarizer.is_enabled()) {
-                if (m_binarizer.append_gcode(out_string) != bgcode::core::EResult::Success)
-                    throw Slic3r::RuntimeError("Error while sending gcode to the binarizer.");
-            }
+            if (m_binarizer_worker != nullptr)
+                m_binarizer_worker->append(std::move(out_string));
             else {
                 write_to_file(out, out_string, result, out_path);
                 update_lines_ends_and_out_file_pos(out_string, result.lines_ends.front(), &m_out_file_pos);
@@ -4075,10 +4260,8 @@ void GCodeProcessor::post_process()
             m_statistics.remove_all_lines();
 #endif // NDEBUG
 
-            if (m_binarizer.is_enabled()) {
-                if (m_binarizer.append_gcode(out_string) != bgcode::core::EResult::Success)
-                    throw Slic3r::RuntimeError("Error while sending gcode to the binarizer.");
-            }
+            if (m_binarizer_worker != nullptr)
+                m_binarizer_worker->append(std::move(out_string));
             else {
                 write_to_file(out, out_string, result, out_path);
                 update_lines_ends_and_out_file_pos(out_string, result.lines_ends.front(), &m_out_file_pos);
@@ -4097,23 +4280,32 @@ void GCodeProcessor::post_process()
         }
 
         size_t get_size() const { return m_size; }
+        // If only the tail of the file is post-processed, the lines in front of it are kept unchanged:
+        // Continue the numbering of the exported lines and their position in the output file after them.
+        void set_tail_begin(size_t line_id, size_t pos) {
+            assert(m_added_lines_counter == 0 && m_gcode_lines_map.empty());
+            m_added_lines_counter = line_id;
+            m_gcode_lines_map.push_back({ line_id, line_id });
+            m_out_file_pos = pos;
+        }
 
     private:
         void write_to_file(FilePtr& out, const std::string& out_string, GCodeProcessorResult& result, const std::string& out_path) {
             if (!out_string.empty()) {
-                if (!m_binarizer.is_enabled()) {
-                    fwrite((const void*)out_string.c_str(), 1, out_string.length(), out.f);
-                    if (ferror(out.f)) {
-                        out.close();
-                        boost::nowide::remove(out_path.c_str());
-                        throw Slic3r::RuntimeError("GCode processor post process export failed.\nIs the disk full?");
-                    }
+                fwrite((const void*)out_string.c_str(), 1, out_string.length(), out.f);
+                if (ferror(out.f)) {
+                    out.close();
+                    boost::nowide::remove(out_path.c_str());
+                    throw Slic3r::RuntimeError("GCode processor post process export failed.\nIs the disk full?");
                 }
             }
         }
     };
 
-    ExportLines export_lines(m_binarizer, m_result.backtrace_enabled ? ExportLines::EWriteType::ByTime : ExportLines::EWriteType::BySize,
+    std::unique_ptr<BinarizerWorker> binarizer_worker;
+    if (m_binarizer.is_enabled())
+        binarizer_worker = std::make_unique<BinarizerWorker>(m_binarizer);
+    ExportLines export_lines(binarizer_worker.get(), m_result.backtrace_enabled ? ExportLines::EWriteType::ByTime : ExportLines::EWriteType::BySize,
         m_time_processor.machines);
 
     // replace placeholder lines with the proper final value
@@ -4347,8 +4539,15 @@ void GCodeProcessor::post_process()
 
     m_result.lines_ends.clear();
     m_result.lines_ends.emplace_back(std::vector<size_t>());
+    if (tail_line > 0) {
+        // Lines in front of the tail are exported unchanged.
+        m_result.lines_ends.front() = std::move(m_streamed_lines.lines_ends);
+        m_result.lines_ends.front().resize(tail_line);
+        export_lines.set_tail_begin(tail_line, tail_pos);
+    }
+    m_streamed_lines.reset();
 
-    unsigned int line_id = 0;
+    unsigned int line_id = (unsigned int)tail_line;
     // Backtrace data for Tx gcode lines
     static const ExportLines::Backtrace backtrace_T = { 120.0f, 10 };
     // In case there are multiple sources of backtracing, keeps track of the longest backtrack time needed
@@ -4429,6 +4628,7 @@ void GCodeProcessor::post_process()
     export_lines.flush(out, m_result, out_path);
 
     if (m_binarizer.is_enabled()) {
+        binarizer_worker->finish();
         if (m_binarizer.finalize() != bgcode::core::EResult::Success)
             throw Slic3r::RuntimeError("Error while finalizing the gcode binarizer.");
     }
@@ -4450,7 +4650,9 @@ void GCodeProcessor::post_process()
     else
         export_lines.synchronize_moves(m_result);
 
-    if (rename_file(out_path, result_filename))
+    if (tail_pos > 0)
+        replace_file_tail(result_filename, tail_pos, out_path);
+    else if (rename_file(out_path, result_filename))
         throw Slic3r::RuntimeError(std::string("Failed to rename the output G-code file from ") + out_path + " to " + result_filename + '\n' +
             "Is " + out_path + " locked?" + '\n');
 }
@@ -486,6 +486,28 @@ namespace Slic3r {
         bgcode::binarize::Binarizer m_binarizer;
         static bgcode::binarize::BinarizerConfig s_binarizer_config;
 
+        // Lines of the G-code exported through process_buffer(). If the post-processing does not insert lines
+        // based on the estimated times, it only modifies the placeholders and statistics at the end of the G-code
+        // and post_process() rewrites just the tail of the file starting with the first modified line.
+        struct StreamedLines
+        {
+            // Ends of the lines exported so far, as GCodeProcessorResult::lines_ends.
+            std::vector<size_t> lines_ends;
+            // Index of the first line modified by post_process(), -1 if there is no such line.
+            size_t first_modified_line{ size_t(-1) };
+            // Size of the exported G-code.
+            size_t size{ 0 };
+            // Beginning of the line being exported, long enough to detect lines modified by post_process().
+            std::string current_line_head;
+            bool current_line_has_cr{ false };
+
+            void reset() { *this = StreamedLines(); }
+            void append(const std::string& buffer);
+            // Index of the first line, which post_process() has to rewrite.
+            size_t tail_begin_line() const { return std::min(first_modified_line, lines_ends.size()); }
+        };
+        StreamedLines m_streamed_lines;
+
         EUnits m_units;
         EPositioningType m_global_positioning_type;
         EPositioningType m_e_local_positioning_type;
@@ -749,6 +771,11 @@ namespace Slic3r {
         // 1) add remaining time lines M73 and update moves' gcode ids accordingly
         // 2) update used filament data
         void post_process();
+        // Post-processing modifies the lines at the end of the G-code only: No remaining time lines M73,
+        // no backtraced lines M104 and text G-code.
+        bool post_process_tail_only() const {
+            return !m_binarizer.is_enabled() && !m_time_processor.export_remaining_time_enabled && !m_result.backtrace_enabled;
+        }
 
         void store_move_vertex(EMoveType type, bool internal_only = false);
 
@@ -12,6 +12,7 @@
 #include <limits>
 #include <cctype>
 #include <cstdlib>
+#include <string_view>
 
 #include "libslic3r/PrintConfig.hpp"
 #include "libslic3r/GCode.hpp"
@@ -211,7 +212,7 @@ LayerResult PressureEqualizer::process_layer(LayerResult &&input)
     m_gcode_lines.erase(m_gcode_lines.begin(), m_gcode_lines.begin() + int(next_layer_first_idx));
 
     if (output_buffer_length > 0)
-        prev_layer_result->gcode = std::string(output_buffer.data());
+        prev_layer_result->gcode.assign(output_buffer.data(), output_buffer_length);
 
     assert(!input.nop_layer_result || m_layer_results.empty());
     LayerResult out = *prev_layer_result;
@@ -268,8 +269,8 @@ static inline float parse_float(const char *&line, const size_t line_length)
 
 bool PressureEqualizer::process_line(const char *line, const char *line_end, GCodeLine &buf)
 {
-    const size_t len = line_end - line;
-    const std::string str_line(line, line_end);
+    const size_t           len = line_end - line;
+    const std::string_view str_line(line, len);
     if (strncmp(line, EXTRUSION_ROLE_TAG.data(), EXTRUSION_ROLE_TAG.length()) == 0) {
         line += EXTRUSION_ROLE_TAG.length();
         int role = atoi(line);
@@ -304,8 +305,8 @@ bool PressureEqualizer::process_line(const char *line, const char *line_end, GCo
     buf.extrusion_role  = m_current_extrusion_role;
     buf.perimeter_index = m_current_perimeter_index;
 
-    const bool found_extrude_set_speed_tag = boost::contains(str_line, EXTRUDE_SET_SPEED_TAG);
-    const bool found_extrude_end_tag = boost::contains(str_line, EXTRUDE_END_TAG);
+    const bool found_extrude_set_speed_tag = str_line.find(EXTRUDE_SET_SPEED_TAG) != std::string_view::npos;
+    const bool found_extrude_end_tag       = str_line.find(EXTRUDE_END_TAG) != std::string_view::npos;
     assert(!found_extrude_set_speed_tag || !found_extrude_end_tag);
 
     if (found_extrude_set_speed_tag)
@@ -367,10 +368,9 @@ bool PressureEqualizer::process_line(const char *line, const char *line_end, GCo
             if (m_current_extrusion_role == GCodeExtrusionRole::ExternalPerimeter) {
                 m_current_perimeter_index = 0;
             } else if (m_current_extrusion_role == GCodeExtrusionRole::Perimeter) {
-                auto internal_perimeter_it_range = boost::find_last(str_line, INTERNAL_PERIMETER_TAG);
-                if (!internal_perimeter_it_range.empty()) {
+                if (const size_t internal_perimeter_pos = str_line.rfind(INTERNAL_PERIMETER_TAG); internal_perimeter_pos != std::string_view::npos) {
                     uint16_t    perimetr_index = 0;
-                    const char* start_ptr      = str_line.data() + std::distance(str_line.begin(), internal_perimeter_it_range.end());
+                    const char* start_ptr      = str_line.data() + internal_perimeter_pos + INTERNAL_PERIMETER_TAG.size();
                     const char* end_ptr        = str_line.data() + str_line.size();
                     const auto  res            = std::from_chars(start_ptr, end_ptr,perimetr_index);
                     if (res.ec == std::errc()) {
@@ -498,6 +498,9 @@ bool PressureEqualizer::process_line(const char *line, const char *line_end, GCo
 
     buf.extruder_id = m_current_extruder;
     memcpy(buf.pos_end, m_current_pos, sizeof(float)*5);
+    // The segment geometry and its feedrate don't change until the line is emitted, so calculate
+    // the square root of the segment length just once instead of inside the look-back window.
+    buf.volumetric_extrusion_rate_ramp = 2 * buf.volumetric_extrusion_rate * buf.dist_xyz();
 #ifdef PRESSURE_EQUALIZER_DEBUG
     ++line_idx;
 #endif
@@ -647,9 +650,12 @@ void PressureEqualizer::adjust_volumetric_rate(const size_t first_line_idx, cons
         // Nothing to do, the last move is not extruding.
         return;
 
-    std::array<float, size_t(GCodeExtrusionRole::Count)> feedrate_per_extrusion_role{};
-    feedrate_per_extrusion_role.fill(std::numeric_limits<float>::max());
-    feedrate_per_extrusion_role[int(m_gcode_lines[line_idx].extrusion_role)] = m_gcode_lines[line_idx].volumetric_extrusion_rate_start;
+    // Only the extrusion role of the last line is being tracked: the limiter starts with the volumetric rate
+    // of the last line, and the rate of any other extrusion role is never seeded, thus it stays unlimited.
+    // GCodeExtrusionRole::None is never limited.
+    const GCodeExtrusionRole role = m_gcode_lines[line_idx].extrusion_role;
+    const ExtrusionRateSlope &rate_slopes = m_max_volumetric_extrusion_rate_slopes[size_t(role)];
+    float rate_limit = m_gcode_lines[line_idx].volumetric_extrusion_rate_start;
 
     while (line_idx != first_line_idx) {
         size_t idx_prev = line_idx - 1;
@@ -667,48 +673,47 @@ void PressureEqualizer::adjust_volumetric_rate(const size_t first_line_idx, cons
         line_idx        = idx_prev;
         GCodeLine &line = m_gcode_lines[line_idx];
 
-        for (size_t iRole = 1; iRole < size_t(GCodeExtrusionRole::Count); ++ iRole) {
-            const float &rate_slope = m_max_volumetric_extrusion_rate_slopes[iRole].negative;
-            if (rate_slope == 0 || feedrate_per_extrusion_role[iRole] == std::numeric_limits<float>::max())
-                continue; // The negative rate is unlimited or the rate for GCodeExtrusionRole iRole is unlimited.
-
-            float rate_end = feedrate_per_extrusion_role[iRole];
-            if (iRole == size_t(line.extrusion_role) && rate_succ < rate_end)
-                // Limit by the succeeding volumetric flow rate.
-                rate_end = rate_succ;
-
-            // Don't alter the flow rate for these extrusion types.
-            if (!line.adjustable_flow || line.extrusion_role == GCodeExtrusionRole::BridgeInfill || line.extrusion_role == GCodeExtrusionRole::Ironing) {
-                rate_end = line.volumetric_extrusion_rate_end;
-            } else if (line.volumetric_extrusion_rate_end > rate_end) {
-                line.volumetric_extrusion_rate_end = rate_end;
+        const float rate_slope = rate_slopes.negative;
+        if (role == GCodeExtrusionRole::None || rate_slope == 0)
+            continue; // The negative rate is unlimited.
+
+        float rate_end = rate_limit;
+        if (role == line.extrusion_role && rate_succ < rate_end)
+            // Limit by the succeeding volumetric flow rate.
+            rate_end = rate_succ;
+
+        // Don't alter the flow rate for these extrusion types.
+        if (!line.adjustable_flow || line.extrusion_role == GCodeExtrusionRole::BridgeInfill || line.extrusion_role == GCodeExtrusionRole::Ironing) {
+            rate_end = line.volumetric_extrusion_rate_end;
+        } else if (line.volumetric_extrusion_rate_end > rate_end) {
+            line.volumetric_extrusion_rate_end = rate_end;
+            line.max_volumetric_extrusion_rate_slope_negative = rate_slope;
+            line.modified = true;
+        } else if (role == line.extrusion_role) {
+            rate_end = line.volumetric_extrusion_rate_end;
+        } else {
+            // Use the original, 'floating' extrusion rate as a starting point for the limiter.
+        }
+
+        if (line.adjustable_flow) {
+            float rate_start = sqrt(rate_end * rate_end + line.volumetric_extrusion_rate_ramp * rate_slope / line.feedrate());
+            if (rate_start < line.volumetric_extrusion_rate_start) {
+                // Limit the volumetric extrusion rate at the start of this segment due to a segment
+                // of the tracked extrusion role, which will be extruded in the future.
+                line.volumetric_extrusion_rate_start = rate_start;
                 line.max_volumetric_extrusion_rate_slope_negative = rate_slope;
                 line.modified = true;
-            } else if (iRole == size_t(line.extrusion_role)) {
-                rate_end = line.volumetric_extrusion_rate_end;
-            } else {
-                // Use the original, 'floating' extrusion rate as a starting point for the limiter.
             }
-
-            if (line.adjustable_flow) {
-                float rate_start = sqrt(rate_end * rate_end + 2 * line.volumetric_extrusion_rate * line.dist_xyz() * rate_slope / line.feedrate());
-                if (rate_start < line.volumetric_extrusion_rate_start) {
-                    // Limit the volumetric extrusion rate at the start of this segment due to a segment
-                    // of ExtrusionType iRole, which will be extruded in the future.
-                    line.volumetric_extrusion_rate_start = rate_start;
-                    line.max_volumetric_extrusion_rate_slope_negative = rate_slope;
-                    line.modified = true;
-                }
-            }
-
-            // Don't store feed rate for ironing.
-            if (line.extrusion_role != GCodeExtrusionRole::Ironing)
-                feedrate_per_extrusion_role[iRole] = line.volumetric_extrusion_rate_start;
         }
+
+        // Don't store feed rate for ironing.
+        if (line.extrusion_role != GCodeExtrusionRole::Ironing)
+            rate_limit = line.volumetric_extrusion_rate_start;
     }
 
-    feedrate_per_extrusion_role.fill(std::numeric_limits<float>::max());
-    feedrate_per_extrusion_role[size_t(m_gcode_lines[line_idx].extrusion_role)] = m_gcode_lines[line_idx].volumetric_extrusion_rate_end;
+    const GCodeExtrusionRole role_forward = m_gcode_lines[line_idx].extrusion_role;
+    const ExtrusionRateSlope &rate_slopes_forward = m_max_volumetric_extrusion_rate_slopes[size_t(role_forward)];
+    rate_limit = m_gcode_lines[line_idx].volumetric_extrusion_rate_end;
 
     assert(m_gcode_lines[line_idx].extruding());
     while (line_idx != last_line_idx) {
@@ -726,42 +731,40 @@ void PressureEqualizer::adjust_volumetric_rate(const size_t first_line_idx, cons
         line_idx = idx_next;
         GCodeLine &line = m_gcode_lines[line_idx];
 
-        for (size_t iRole = 1; iRole < size_t(GCodeExtrusionRole::Count); ++ iRole) {
-            const float &rate_slope = m_max_volumetric_extrusion_rate_slopes[iRole].positive;
-            if (rate_slope == 0 || feedrate_per_extrusion_role[iRole] == std::numeric_limits<float>::max())
-                continue; // The positive rate is unlimited or the rate for GCodeExtrusionRole iRole is unlimited.
-
-            float rate_start = feedrate_per_extrusion_role[iRole];
-            // Don't alter the flow rate for these extrusion types.
-            if (!line.adjustable_flow || line.extrusion_role == GCodeExtrusionRole::BridgeInfill || line.extrusion_role == GCodeExtrusionRole::Ironing) {
-                rate_start = line.volumetric_extrusion_rate_start;
-            } else if (iRole == size_t(line.extrusion_role) && rate_prec < rate_start)
-                rate_start = rate_prec;
-            if (line.volumetric_extrusion_rate_start > rate_start) {
-                line.volumetric_extrusion_rate_start = rate_start;
-                line.max_volumetric_extrusion_rate_slope_positive = rate_slope;
-                line.modified = true;
-            } else if (iRole == size_t(line.extrusion_role)) {
-                rate_start = line.volumetric_extrusion_rate_start;
-            } else {
-                // Use the original, 'floating' extrusion rate as a starting point for the limiter.
-            }
+        const float rate_slope = rate_slopes_forward.positive;
+        if (role_forward == GCodeExtrusionRole::None || rate_slope == 0)
+            continue; // The positive rate is unlimited.
+
+        float rate_start = rate_limit;
+        // Don't alter the flow rate for these extrusion types.
+        if (!line.adjustable_flow || line.extrusion_role == GCodeExtrusionRole::BridgeInfill || line.extrusion_role == GCodeExtrusionRole::Ironing) {
+            rate_start = line.volumetric_extrusion_rate_start;
+        } else if (role_forward == line.extrusion_role && rate_prec < rate_start)
+            rate_start = rate_prec;
+        if (line.volumetric_extrusion_rate_start > rate_start) {
+            line.volumetric_extrusion_rate_start = rate_start;
+            line.max_volumetric_extrusion_rate_slope_positive = rate_slope;
+            line.modified = true;
+        } else if (role_forward == line.extrusion_role) {
+            rate_start = line.volumetric_extrusion_rate_start;
+        } else {
+            // Use the original, 'floating' extrusion rate as a starting point for the limiter.
+        }
 
-            if (line.adjustable_flow) {
-                float rate_end = sqrt(rate_start * rate_start + 2 * line.volumetric_extrusion_rate * line.dist_xyz() * rate_slope / line.feedrate());
-                if (rate_end < line.volumetric_extrusion_rate_end) {
-                    // Limit the volumetric extrusion rate at the start of this segment due to a segment
-                    // of ExtrusionType iRole, which was extruded before.
-                    line.volumetric_extrusion_rate_end                = rate_end;
-                    line.max_volumetric_extrusion_rate_slope_positive = rate_slope;
-                    line.modified                                     = true;
-                }
+        if (line.adjustable_flow) {
+            float rate_end = sqrt(rate_start * rate_start + line.volumetric_extrusion_rate_ramp * rate_slope / line.feedrate());
+            if (rate_end < line.volumetric_extrusion_rate_end) {
+                // Limit the volumetric extrusion rate at the start of this segment due to a segment
+                // of the tracked extrusion role, which was extruded before.
+                line.volumetric_extrusion_rate_end                = rate_end;
+                line.max_volumetric_extrusion_rate_slope_positive = rate_slope;
+                line.modified                                     = true;
             }
-
-            // Don't store feed rate for ironing
-            if (line.extrusion_role != GCodeExtrusionRole::Ironing)
-                feedrate_per_extrusion_role[iRole] = line.volumetric_extrusion_rate_end;
         }
+
+        // Don't store feed rate for ironing
+        if (line.extrusion_role != GCodeExtrusionRole::Ironing)
+            rate_limit = line.volumetric_extrusion_rate_end;
     }
 }
 
@@ -808,7 +811,7 @@ inline void PressureEqualizer::push_to_output(const char *text, const size_t len
     output_buffer[output_buffer_length] = 0;
 }
 
-inline bool is_just_line_with_extrude_set_speed_tag(const std::string &line)
+inline bool is_just_line_with_extrude_set_speed_tag(const std::string_view line)
 {
     if (line.empty() && !boost::starts_with(line, "G1 ") && !boost::ends_with(line, EXTRUDE_SET_SPEED_TAG))
         return false;
@@ -833,8 +836,8 @@ void PressureEqualizer::push_line_to_output(const size_t line_idx, float new_fee
 
     const GCodeLine &line = m_gcode_lines[line_idx];
     if (line_idx > 0 && output_buffer_length > 0) {
-        const std::string prev_line_str = std::string(output_buffer.begin() + int(this->output_buffer_prev_length),
-                                                      output_buffer.begin() + int(this->output_buffer_length) + 1);
+        const std::string_view prev_line_str(output_buffer.data() + this->output_buffer_prev_length,
+                                             this->output_buffer_length - this->output_buffer_prev_length + 1);
         if (is_just_line_with_extrude_set_speed_tag(prev_line_str))
             this->output_buffer_length = this->output_buffer_prev_length; // Remove the last line because it only sets the speed for an empty block of g-code lines, so it is useless.
         else
@@ -175,6 +175,8 @@ private:
         float       volumetric_extrusion_rate_start;
         // Volumetric extrusion rate at the end of this segment.
         float       volumetric_extrusion_rate_end;
+        // 2 * volumetric_extrusion_rate * dist_xyz(), invariant while the volumetric rate slope is being limited.
+        float       volumetric_extrusion_rate_ramp = 0.f;
 
         // Volumetric extrusion rate slope limiting this segment.
         // If set to zero, the slope is unlimited.
@@ -70,17 +70,49 @@ unsigned int LayerTools::solid_infill_extruder(const PrintRegion &region) const
 
 // Returns a zero based extruder this eec should be printed with, according to PrintRegion config or extruder_override if overriden.
 unsigned int LayerTools::extruder(const ExtrusionEntityCollection &extrusions, const PrintRegion &region) const
+{
+	return this->extruder(LayerRegionToolsUsage::extruder(extrusions), region);
+}
+
+unsigned int LayerTools::extruder(LayerRegionToolsUsage::Extruder extruder, const PrintRegion &region) const
 {
 	assert(region.config().perimeter_extruder.value > 0);
 	assert(region.config().infill_extruder.value > 0);
 	assert(region.config().solid_infill_extruder.value > 0);
 	// 1 based extruder ID.
-	unsigned int extruder = this->extruder_override == 0 ?
-	    (extrusions.role().is_infill() ?
-	    	(extrusions.entities.front()->role().is_solid_infill() ? region.config().solid_infill_extruder : region.config().infill_extruder) :
+	unsigned int extruder_id = this->extruder_override == 0 ?
+	    (extruder == LayerRegionToolsUsage::SolidInfill ? region.config().solid_infill_extruder.value :
+	     extruder == LayerRegionToolsUsage::Infill      ? region.config().infill_extruder.value :
 			region.config().perimeter_extruder.value) :
 		this->extruder_override;
-	return (extruder == 0) ? 0 : extruder - 1;
+	return (extruder_id == 0) ? 0 : extruder_id - 1;
+}
+
+LayerRegionToolsUsage::Extruder LayerRegionToolsUsage::extruder(const ExtrusionEntityCollection &extrusions)
+{
+    return extrusions.role().is_infill() ?
+        (extrusions.entities.front()->role().is_solid_infill() ? SolidInfill : Infill) :
+        Perimeter;
+}
+
+LayerRegionToolsUsage LayerRegionToolsUsage::collect(const LayerRegion &layerm)
+{
+    LayerRegionToolsUsage out;
+    for (const ExtrusionEntity *ee : layerm.perimeters()) {
+        const auto &eec = dynamic_cast<const ExtrusionEntityCollection&>(*ee);
+        out.perimeters |= bit(extruder(eec), eec.role() == ExtrusionRole::InternalInfill);
+    }
+    for (const ExtrusionEntity *ee : layerm.fills()) {
+        // fill represents infill extrusions of a single island.
+        const auto &fill = dynamic_cast<const ExtrusionEntityCollection&>(*ee);
+        ExtrusionRole role = fill.entities.empty() ? ExtrusionRole::None : fill.entities.front()->role();
+        if (role.is_solid_infill())
+            out.has_solid_infill = true;
+        else if (role != ExtrusionRole::None)
+            out.has_infill = true;
+        out.fills |= bit(extruder(fill), fill.role() == ExtrusionRole::InternalInfill);
+    }
+    return out;
 }
 
 static double calc_max_layer_height(const PrintConfig &config, double max_object_layer_height)
@@ -217,21 +249,37 @@ void ToolOrdering::initialize_layers(std::vector<coordf_t> &zs)
     }
 }
 
-// Decides whether this entity could be overridden
-[[nodiscard]] static bool is_overriddable(const ExtrusionEntityCollection& eec, const LayerTools& lt, const PrintConfig& print_config, const PrintObject& object, const PrintRegion& region)
+// Decides whether an entity printed by the extruder of the region could be overridden
+[[nodiscard]] static bool is_overriddable(LayerRegionToolsUsage::Extruder extruder, bool internal_infill, const LayerTools& lt, const PrintConfig& print_config, const PrintObject& object, const PrintRegion& region)
 {
-    if (print_config.filament_soluble.get_at(lt.extruder(eec, region)))
+    if (print_config.filament_soluble.get_at(lt.extruder(extruder, region)))
         return false;
 
     if (object.config().wipe_into_objects)
         return true;
 
-    if (!region.config().wipe_into_infill || eec.role() != ExtrusionRole::InternalInfill)
+    if (!region.config().wipe_into_infill || !internal_infill)
         return false;
 
     return true;
 }
 
+// Decides whether this entity could be overridden
+[[nodiscard]] static bool is_overriddable(const ExtrusionEntityCollection& eec, const LayerTools& lt, const PrintConfig& print_config, const PrintObject& object, const PrintRegion& region)
+{
+    return is_overriddable(LayerRegionToolsUsage::extruder(eec), eec.role() == ExtrusionRole::InternalInfill, lt, print_config, object, region);
+}
+
+// Calls fn(overriddable) for each kind of the extrusion collections marked in the LayerRegionToolsUsage perimeters / fills mask.
+template<typename Fn>
+static void for_each_usage(uint8_t mask, const LayerTools& lt, const PrintConfig& print_config, const PrintObject& object, const PrintRegion& region, Fn &&fn)
+{
+    for (auto extruder : { LayerRegionToolsUsage::Perimeter, LayerRegionToolsUsage::Infill, LayerRegionToolsUsage::SolidInfill })
+        for (bool internal_infill : { false, true })
+            if (mask & LayerRegionToolsUsage::bit(extruder, internal_infill))
+                fn(is_overriddable(extruder, internal_infill, lt, print_config, object, region));
+}
+
 // Collect extruders reuqired to print layers.
 void ToolOrdering::collect_extruders(
     const PrintObject                                  &object,
@@ -239,9 +287,12 @@ void ToolOrdering::collect_extruders(
     const std::vector<std::pair<double, unsigned int>> &per_layer_color_changes
 ) {
     // Collect the support extruders.
-    for (auto support_layer : object.support_layers()) {
+    // The extrusions of the object are summarized in parallel and cached by the PrintObject.
+    const std::vector<ExtrusionRole> &support_roles = object.support_layers_tools_usage();
+    for (size_t support_layer_idx = 0; support_layer_idx < object.support_layers().size(); ++ support_layer_idx) {
+        const SupportLayer *support_layer = object.support_layers()[support_layer_idx];
         LayerTools   &layer_tools = this->tools_for_layer(support_layer->print_z);
-        ExtrusionRole role = support_layer->support_fills.role();
+        ExtrusionRole role = support_roles[support_layer_idx];
         bool         has_support        = role == ExtrusionRole::Mixed || role == ExtrusionRole::SupportMaterial;
         bool         has_interface      = role == ExtrusionRole::Mixed || role == ExtrusionRole::SupportMaterialInterface;
         unsigned int extruder_support   = object.config().support_material_extruder.value;
@@ -261,7 +312,9 @@ void ToolOrdering::collect_extruders(
     std::vector<std::pair<double, unsigned int>>::const_iterator it_per_layer_color_changes = per_layer_color_changes.begin();
 
     // Collect the object extruders.
-    for (auto layer : object.layers()) {
+    const std::vector<std::vector<LayerRegionToolsUsage>> &layers_usage = object.layers_tools_usage();
+    for (size_t layer_idx = 0; layer_idx < object.layers().size(); ++ layer_idx) {
+        const Layer *layer = object.layers()[layer_idx];
         LayerTools &layer_tools = this->tools_for_layer(layer->print_z);
 
         // Override extruder with the next 
@@ -281,19 +334,22 @@ void ToolOrdering::collect_extruders(
         }
 
         // What extruders are required to print this object layer?
-        for (const LayerRegion *layerm : layer->regions()) {
-            const PrintRegion &region = layerm->region();
+        for (size_t region_idx = 0; region_idx < layer->regions().size(); ++ region_idx) {
+            const PrintRegion           &region = layer->regions()[region_idx]->region();
+            const LayerRegionToolsUsage &usage  = layers_usage[layer_idx][region_idx];
 
-            if (! layerm->perimeters().empty()) {
+            if (usage.perimeters) {
                 bool something_nonoverriddable = true;
 
                 if (m_print_config_ptr) { // in this case complete_objects is false (see ToolOrdering constructors)
                     something_nonoverriddable = false;
-                    for (const ExtrusionEntity *eec : layerm->perimeters()) // let's check if there are nonoverriddable entities
-                        if (is_overriddable(dynamic_cast<const ExtrusionEntityCollection&>(*eec), layer_tools, *m_print_config_ptr, object, region))
+                    // let's check if there are nonoverriddable entities
+                    for_each_usage(usage.perimeters, layer_tools, *m_print_config_ptr, object, region, [&layer_tools, &something_nonoverriddable](bool overriddable) {
+                        if (overriddable)
                             layer_tools.wiping_extrusions_nonconst().set_something_overridable();
                         else
                             something_nonoverriddable = true;
+                    });
                 }
 
                 if (something_nonoverriddable)
@@ -302,25 +358,16 @@ void ToolOrdering::collect_extruders(
                 layer_tools.has_object = true;
             }
 
-            bool has_infill       = false;
-            bool has_solid_infill = false;
+            bool has_infill       = usage.has_infill;
+            bool has_solid_infill = usage.has_solid_infill;
             bool something_nonoverriddable = false;
-            for (const ExtrusionEntity *ee : layerm->fills()) {
-                // fill represents infill extrusions of a single island.
-                const auto *fill = dynamic_cast<const ExtrusionEntityCollection*>(ee);
-                ExtrusionRole role = fill->entities.empty() ? ExtrusionRole::None : fill->entities.front()->role();
-                if (role.is_solid_infill())
-                    has_solid_infill = true;
-                else if (role != ExtrusionRole::None)
-                    has_infill = true;
-
-                if (m_print_config_ptr) {
-                    if (is_overriddable(*fill, layer_tools, *m_print_config_ptr, object, region))
+            if (m_print_config_ptr)
+                for_each_usage(usage.fills, layer_tools, *m_print_config_ptr, object, region, [&layer_tools, &something_nonoverriddable](bool overriddable) {
+                    if (overriddable)
                         layer_tools.wiping_extrusions_nonconst().set_something_overridable();
                     else
                         something_nonoverriddable = true;
-                }
-            }
+                });
 
             if (something_nonoverriddable || !m_print_config_ptr) {
             	if (extruder_override == 0) {
@@ -19,6 +19,7 @@
 #include <cinttypes>
 
 #include "libslic3r/libslic3r.h"
+#include "libslic3r/ExtrusionRole.hpp"
 #include "libslic3r/PrintConfig.hpp"
 
 namespace Slic3r {
@@ -34,6 +35,30 @@ struct Item;
 class PrintRegion;
 class ExtrusionEntity;
 class ExtrusionEntityCollection;
+class LayerRegion;
+
+// Summary of the extrusions of a LayerRegion required to collect the extruders printing it, see ToolOrdering::collect_extruders().
+// Collecting it walks all the extrusions of the region, therefore it is cached by PrintObject until the extrusions are invalidated.
+struct LayerRegionToolsUsage
+{
+    // Extruder of the region printing an extrusion collection.
+    enum Extruder : uint8_t {
+        Perimeter,
+        Infill,
+        SolidInfill,
+    };
+
+    // Bit of the perimeters / fills masks: Set if there is an extrusion collection printed by the extruder,
+    // internal_infill is true if the role of the collection is ExtrusionRole::InternalInfill.
+    static constexpr uint8_t bit(Extruder extruder, bool internal_infill) { return uint8_t(1u << (2 * unsigned(extruder) + unsigned(internal_infill))); }
+    static Extruder          extruder(const ExtrusionEntityCollection &extrusions);
+    static LayerRegionToolsUsage collect(const LayerRegion &layerm);
+
+    uint8_t perimeters       = 0;
+    uint8_t fills            = 0;
+    bool    has_infill       = false;
+    bool    has_solid_infill = false;
+};
 
 // Object of this class holds information about whether an extrusion is printed immediately
 // after a toolchange (as part of infill/perimeter wiping) or not. One extrusion can be a part
@@ -101,6 +126,7 @@ public:
     unsigned int solid_infill_extruder(const PrintRegion &region) const;
 	// Returns a zero based extruder this eec should be printed with, according to PrintRegion config or extruder_override if overriden.
 	unsigned int extruder(const ExtrusionEntityCollection &extrusions, const PrintRegion &region) const;
+	unsigned int extruder(LayerRegionToolsUsage::Extruder extruder, const PrintRegion &region) const;
 
     coordf_t 					print_z	= 0.;
     bool 						has_object = false;
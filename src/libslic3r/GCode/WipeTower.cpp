@@ -14,6 +14,7 @@
 #include <numeric>
 #include <memory>
 #include <sstream>
+#include <tuple>
 #include <cstdio>
 #include <cstdlib>
 
@@ -89,6 +90,10 @@ public:
 
     WipeTowerWriter& 			 set_position(const Vec2f &pos) { m_current_pos = pos; return *this; }
 
+	// Only track the position, feedrate, extrusions and the filament consumption, don't format the coordinates into G-code.
+	// Used by the planning passes, which are only interested in the extrusions.
+	WipeTowerWriter&			 set_dry_run(bool dry_run) { m_dry_run = dry_run; return *this; }
+
     WipeTowerWriter&				 set_initial_tool(size_t tool) { m_current_tool = tool; return *this; }
 
 	WipeTowerWriter&				 set_z(float z) 
@@ -464,6 +469,7 @@ private:
 	float 		  m_layer_height;
 	float 	  	  m_extrusion_flow;
 	bool		  m_preview_suppressed;
+	bool		  m_dry_run = false;
 	std::string   m_gcode;
 	std::vector<WipeTower::Extrusion> m_extrusions;
 	float         m_elapsed_time;
@@ -480,26 +486,28 @@ private:
 	std::string   set_format_X(float x)
     {
         m_current_pos.x() = x;
-        return " X" + Slic3r::float_to_string_decimal_point(x, 3);
+        return m_dry_run ? std::string() : " X" + Slic3r::float_to_string_decimal_point(x, 3);
 	}
 
 	std::string   set_format_Y(float y) {
         m_current_pos.y() = y;
-        return " Y" + Slic3r::float_to_string_decimal_point(y, 3);
+        return m_dry_run ? std::string() : " Y" + Slic3r::float_to_string_decimal_point(y, 3);
 	}
 
 	std::string   set_format_Z(float z) {
-        return " Z" + Slic3r::float_to_string_decimal_point(z, 3);
+        return m_dry_run ? std::string() : " Z" + Slic3r::float_to_string_decimal_point(z, 3);
 	}
 
 	std::string   set_format_E(float e) {
-        return " E" + Slic3r::float_to_string_decimal_point(e, 4);
+        return m_dry_run ? std::string() : " E" + Slic3r::float_to_string_decimal_point(e, 4);
 	}
 
 	std::string   set_format_F(float f) {
+        m_current_feedrate = f;
+        if (m_dry_run)
+            return {};
         char buf[64];
         sprintf(buf, " F%d", int(floor(f + 0.5f)));
-        m_current_feedrate = f;
         return buf;
 	}
 
@@ -816,7 +824,8 @@ WipeTower::ToolChangeResult WipeTower::tool_change(size_t tool)
                                     : m_wipe_tower_depth-m_perimeter_width));
 
 	WipeTowerWriter writer(m_layer_height, m_perimeter_width, m_gcode_flavor, m_filpar);
-	writer.set_extrusion_flow(m_extrusion_flow)
+	writer.set_dry_run(m_dry_run)
+		.set_extrusion_flow(m_extrusion_flow)
 		.set_z(m_z_pos)
 		.set_initial_tool(m_current_tool)
         .set_y_shift(m_y_shift + (tool!=(unsigned int)(-1) && (m_current_shape == SHAPE_REVERSED) ? m_layer_info->depth - m_layer_info->toolchanges_depth(): 0.f))
@@ -1235,7 +1244,8 @@ WipeTower::ToolChangeResult WipeTower::finish_layer()
     size_t old_tool = m_current_tool;
 
 	WipeTowerWriter writer(m_layer_height, m_perimeter_width, m_gcode_flavor, m_filpar);
-	writer.set_extrusion_flow(m_extrusion_flow)
+	writer.set_dry_run(m_dry_run)
+		.set_extrusion_flow(m_extrusion_flow)
 		.set_z(m_z_pos)
 		.set_initial_tool(m_current_tool)
         .set_y_shift(m_y_shift - (m_current_shape == SHAPE_REVERSED ? m_layer_info->toolchanges_depth() : 0.f));
@@ -1625,6 +1635,16 @@ void WipeTower::save_on_last_wipe()
 }
 
 
+// Values of the plan adjusted by save_on_last_wipe(), the remaining values of the plan are derived from them by plan_tower().
+std::vector<std::pair<float, float>> WipeTower::plan_depths_and_volumes() const
+{
+    std::vector<std::pair<float, float>> out;
+    for (const WipeTowerInfo &layer : m_plan)
+        for (const WipeTowerInfo::ToolChange &toolchange : layer.tool_changes)
+            out.emplace_back(toolchange.required_depth, toolchange.wipe_volume);
+    return out;
+}
+
 // Return index of first toolchange that switches to non-soluble extruder
 // ot -1 if there is no such toolchange.
 int WipeTower::first_toolchange_to_nonsoluble(
@@ -1657,16 +1677,29 @@ static WipeTower::ToolChangeResult merge_tcr(WipeTower::ToolChangeResult& first,
 
 // Processes vector m_plan and calls respective functions to generate G-code for the wipe tower
 // Resulting ToolChangeResults are appended into vector "result"
-void WipeTower::generate(std::vector<std::vector<WipeTower::ToolChangeResult>> &result)
+void WipeTower::generate(std::vector<std::vector<WipeTower::ToolChangeResult>> &result, bool stop_planning_early)
 {
 	if (m_plan.empty())
         return;
 
 	plan_tower();
+    // The planning passes only need the extrusions of finish_layer(), skip formatting of the G-code.
+    // A pass depends on the plan and on the state left by the previous pass (the current tool, the fill direction,
+    // the wipe shape and the counters), which is also the state the final pass starts with. Stop as soon as a pass
+    // changes neither of them, the following passes would repeat it exactly.
+    auto carried_state = [this]() {
+        return std::make_tuple(m_current_tool, m_left_to_right, m_current_shape, m_num_layer_changes, m_num_tool_changes);
+    };
+    m_dry_run = stop_planning_early;
     for (int i = 0; i<5; ++i) {
+        std::vector<std::pair<float, float>> depths_and_volumes = plan_depths_and_volumes();
+        auto state = carried_state();
         save_on_last_wipe();
         plan_tower();
+        if (stop_planning_early && plan_depths_and_volumes() == depths_and_volumes && carried_state() == state)
+            break;
     }
+    m_dry_run = false;
 
     m_layer_info = m_plan.begin();
     m_current_height = 0.f;
@@ -155,7 +155,8 @@ public:
     void plan_toolchange(float z_par, float layer_height_par, unsigned int old_tool, unsigned int new_tool, float wipe_volume = 0.f);
 
 	// Iterates through prepared m_plan, generates ToolChangeResults and appends them to "result"
-	void generate(std::vector<std::vector<ToolChangeResult>> &result);
+	// The planning passes stop as soon as they converge, all of them are run if stop_planning_early is false (used by the tests).
+	void generate(std::vector<std::vector<ToolChangeResult>> &result, bool stop_planning_early = true);
 
     float get_depth() const { return m_wipe_tower_depth; }
 	std::vector<std::pair<float, float>> get_z_and_depth_pairs() const;
@@ -334,6 +335,7 @@ private:
 
 	float           m_depth_traversed = 0.f; // Current y position at the wipe tower.
     bool            m_current_layer_finished = false;
+    bool            m_dry_run = false; // Planning pass, the G-code of the toolchanges and of the layers is not formatted.
 	bool 			m_left_to_right   = true;
 	float			m_extra_flow      = 1.f;
 	float			m_extra_spacing_wipe    = 1.f;
@@ -397,6 +399,9 @@ private:
     int first_toolchange_to_nonsoluble(
             const std::vector<WipeTowerInfo::ToolChange>& tool_changes) const;
 
+    // Required depths and wipe volumes of all toolchanges in m_plan, to detect that save_on_last_wipe() converged.
+    std::vector<std::pair<float, float>> plan_depths_and_volumes() const;
+
 	void toolchange_Unload(
 		WipeTowerWriter &writer,
 		const box_coordinates  &cleaning_box, 
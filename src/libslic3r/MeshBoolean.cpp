@@ -4,6 +4,7 @@
 ///|/
 #include "Exception.hpp"
 #include "MeshBoolean.hpp"
+#include "MeshBooleanFast.hpp"
 #include "libslic3r/TriangleMesh.hpp"
 #include "libslic3r/TryCatchSignal.hpp"
 #include "libslic3r/Point.hpp"
@@ -14,6 +15,7 @@
 #include <igl/copyleft/cgal/mesh_boolean.h> // IWYU pragma: keep
 #include <igl/MeshBooleanType.h>
 #include <boost/property_map/property_map.hpp>
+#include <boost/log/trivial.hpp>
 
 #undef L
 
@@ -246,6 +248,7 @@ template<class Op> void _cgal_do(Op &&op, CGALMesh &A, CGALMesh &B)
         throw Slic3r::RuntimeError("CGAL mesh boolean operation failed.");
 }
 
+// No fast path here, it would round the double precision CGAL meshes to float after each operation.
 void minus(CGALMesh &A, CGALMesh &B) { _cgal_do(_cgal_diff, A, B); }
 void plus(CGALMesh &A, CGALMesh &B) { _cgal_do(_cgal_union, A, B); }
 void intersect(CGALMesh &A, CGALMesh &B) { _cgal_do(_cgal_intersection, A, B); }
@@ -255,8 +258,12 @@ bool does_self_intersect(const CGALMesh &mesh) { return CGALProc::does_self_inte
 // Now the public functions for TriangleMesh input:
 // /////////////////////////////////////////////////////////////////////////////
 
-template<class Op> void _mesh_boolean_do(Op &&op, indexed_triangle_set &A, const indexed_triangle_set &B)
+template<class Op> void _mesh_boolean_do(Op &&op, fast::BooleanOperation fast_op, indexed_triangle_set &A, const indexed_triangle_set &B)
 {
+    if (fast::mesh_boolean(A, B, fast_op))
+        return;
+    BOOST_LOG_TRIVIAL(debug) << "Fast mesh boolean failed, falling back to CGAL";
+
     CGALMesh meshA;
     CGALMesh meshB;
     triangle_mesh_to_cgal(A.vertices, A.indices, meshA.m);
@@ -267,8 +274,14 @@ template<class Op> void _mesh_boolean_do(Op &&op, indexed_triangle_set &A, const
     A = cgal_to_indexed_triangle_set(meshA.m);
 }
 
-template<class Op> void _mesh_boolean_do(Op &&op, TriangleMesh &A, const TriangleMesh &B)
+template<class Op> void _mesh_boolean_do(Op &&op, fast::BooleanOperation fast_op, TriangleMesh &A, const TriangleMesh &B)
 {
+    if (fast::mesh_boolean(A.its, B.its, fast_op)) {
+        A = TriangleMesh(std::move(A.its));
+        return;
+    }
+    BOOST_LOG_TRIVIAL(debug) << "Fast mesh boolean failed, falling back to CGAL";
+
     CGALMesh meshA;
     CGALMesh meshB;
     triangle_mesh_to_cgal(A.its.vertices, A.its.indices, meshA.m);
@@ -281,32 +294,32 @@ template<class Op> void _mesh_boolean_do(Op &&op, TriangleMesh &A, const Triangl
 
 void minus(TriangleMesh &A, const TriangleMesh &B)
 {
-    _mesh_boolean_do(_cgal_diff, A, B);
+    _mesh_boolean_do(_cgal_diff, fast::BooleanOperation::Difference, A, B);
 }
 
 void plus(TriangleMesh &A, const TriangleMesh &B)
 {
-    _mesh_boolean_do(_cgal_union, A, B);
+    _mesh_boolean_do(_cgal_union, fast::BooleanOperation::Union, A, B);
 }
 
 void intersect(TriangleMesh &A, const TriangleMesh &B)
 {
-    _mesh_boolean_do(_cgal_intersection, A, B);
+    _mesh_boolean_do(_cgal_intersection, fast::BooleanOperation::Intersection, A, B);
 }
 
 void minus(indexed_triangle_set &A, const indexed_triangle_set &B)
 {
-    _mesh_boolean_do(_cgal_diff, A, B);
+    _mesh_boolean_do(_cgal_diff, fast::BooleanOperation::Difference, A, B);
 }
 
 void plus(indexed_triangle_set &A, const indexed_triangle_set &B)
 {
-    _mesh_boolean_do(_cgal_union, A, B);
+    _mesh_boolean_do(_cgal_union, fast::BooleanOperation::Union, A, B);
 }
 
 void intersect(indexed_triangle_set &A, const indexed_triangle_set &B)
 {
-    _mesh_boolean_do(_cgal_intersection, A, B);
+    _mesh_boolean_do(_cgal_intersection, fast::BooleanOperation::Intersection, A, B);
 }
 
 bool does_self_intersect(const TriangleMesh &mesh)
@@ -0,0 +1,863 @@
+///|/ Copyright (c) Prusa Research 2024
+///|/
+///|/ PrusaSlicer is released under the terms of the AGPLv3 or higher
+///|/
+#include "MeshBooleanFast.hpp"
+
+#include <glu-libtess.h>
+#include <boost/log/trivial.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "AABBTreeIndirect.hpp"
+#include "Point.hpp"
+
+namespace Slic3r {
+namespace MeshBoolean {
+namespace fast {
+
+namespace {
+
+// Sign of the volume of the tetrahedron (a, b, c, d), see orient3d() of [Shewchuk: Adaptive Precision Floating-Point
+// Arithmetic and Fast Robust Geometric Predicates, 1997]. Only the static filter is evaluated, zero is returned
+// both for coplanar points and for the configurations too close to be certified in double precision.
+int orient3d(const Vec3d &a, const Vec3d &b, const Vec3d &c, const Vec3d &d)
+{
+    const double adx = a.x() - d.x(), bdx = b.x() - d.x(), cdx = c.x() - d.x();
+    const double ady = a.y() - d.y(), bdy = b.y() - d.y(), cdy = c.y() - d.y();
+    const double adz = a.z() - d.z(), bdz = b.z() - d.z(), cdz = c.z() - d.z();
+    const double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+    const double cdxady = cdx * ady, adxcdy = adx * cdy;
+    const double adxbdy = adx * bdy, bdxady = bdx * ady;
+    const double det = adz * (bdxcdy - cdxbdy) + bdz * (cdxady - adxcdy) + cdz * (adxbdy - bdxady);
+    const double permanent = (std::abs(bdxcdy) + std::abs(cdxbdy)) * std::abs(adz)
+                           + (std::abs(cdxady) + std::abs(adxcdy)) * std::abs(bdz)
+                           + (std::abs(adxbdy) + std::abs(bdxady)) * std::abs(cdz);
+    // (7 + 56 epsilon) epsilon
+    const double errbound = 7.7715611723761027e-16 * permanent;
+    return det > errbound ? 1 : det < - errbound ? -1 : 0;
+}
+
+// Sign of the area of the triangle (a, b, c), positive if counter-clockwise, zero if it could not be certified.
+int orient2d(const Vec2d &a, const Vec2d &b, const Vec2d &c)
+{
+    const double detleft  = (a.x() - c.x()) * (b.y() - c.y());
+    const double detright = (a.y() - c.y()) * (b.x() - c.x());
+    const double det      = detleft - detright;
+    // (3 + 16 epsilon) epsilon
+    const double errbound = 3.3306690738754716e-16 * (std::abs(detleft) + std::abs(detright));
+    return det > errbound ? 1 : det < - errbound ? -1 : 0;
+}
+
+using Triangle = std::array<Vec3d, 3>;
+
+struct Mesh
+{
+    explicit Mesh(const indexed_triangle_set &its) : its(its) {}
+
+    const indexed_triangle_set &its;
+    // Index of the edge (vertex i, vertex (i + 1) % 3) of a facet.
+    std::vector<Vec3i>          facet_edges;
+    // End points of an edge, the smaller vertex index first.
+    std::vector<Vec2i>          edges;
+    AABBTreeIndirect::Tree3f    tree;
+
+    Vec3d    vertex(int idx) const { return its.vertices[idx].cast<double>(); }
+    Triangle triangle(int facet) const {
+        const stl_triangle_vertex_indices &f = its.indices[facet];
+        return { vertex(f(0)), vertex(f(1)), vertex(f(2)) };
+    }
+    Eigen::AlignedBox<float, 3> bbox(int facet) const {
+        const stl_triangle_vertex_indices &f = its.indices[facet];
+        Eigen::AlignedBox<float, 3> out(its.vertices[f(0)]);
+        out.extend(its.vertices[f(1)]);
+        out.extend(its.vertices[f(2)]);
+        return out;
+    }
+};
+
+// Index the edges of a mesh. Returns false if the mesh is not a closed oriented manifold,
+// that is if an edge is not shared by exactly two facets traversing it in opposite directions.
+bool build_edges(const std::vector<stl_triangle_vertex_indices> &facets, std::vector<Vec3i> &facet_edges, std::vector<Vec2i> &edges)
+{
+    struct HalfEdge {
+        int  a, b;
+        int  facet_edge;
+        bool forward;
+    };
+    std::vector<HalfEdge> half_edges(facets.size() * 3);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, facets.size()), [&facets, &half_edges](const tbb::blocked_range<size_t> &range) {
+        for (size_t facet = range.begin(); facet < range.end(); ++ facet)
+            for (int i = 0; i < 3; ++ i) {
+                const int v0 = facets[facet](i);
+                const int v1 = facets[facet]((i + 1) % 3);
+                half_edges[facet * 3 + i] = { std::min(v0, v1), std::max(v0, v1), int(facet * 3 + i), v0 < v1 };
+            }
+    });
+    tbb::parallel_sort(half_edges.begin(), half_edges.end(), [](const HalfEdge &l, const HalfEdge &r) {
+        return l.a < r.a || (l.a == r.a && (l.b < r.b || (l.b == r.b && l.facet_edge < r.facet_edge)));
+    });
+
+    facet_edges.assign(facets.size(), Vec3i(-1, -1, -1));
+    edges.clear();
+    edges.reserve(half_edges.size() / 2);
+    for (size_t i = 0; i < half_edges.size(); i += 2) {
+        const HalfEdge &he = half_edges[i];
+        if (he.a == he.b || i + 1 == half_edges.size())
+            return false;
+        const HalfEdge &he2 = half_edges[i + 1];
+        if (he2.a != he.a || he2.b != he.b || he2.forward == he.forward ||
+            (i + 2 < half_edges.size() && half_edges[i + 2].a == he.a && half_edges[i + 2].b == he.b))
+            return false;
+        const int edge = int(edges.size());
+        facet_edges[he.facet_edge / 3](he.facet_edge % 3)   = edge;
+        facet_edges[he2.facet_edge / 3](he2.facet_edge % 3) = edge;
+        edges.emplace_back(he.a, he.b);
+    }
+    return true;
+}
+
+// Projection of a triangle to the coordinate plane most parallel to it.
+struct Projection
+{
+    explicit Projection(const Triangle &t) {
+        const Vec3d n = (t[1] - t[0]).cross(t[2] - t[0]).cwiseAbs();
+        const int axis = n.x() > n.y() ? (n.x() > n.z() ? 0 : 2) : (n.y() > n.z() ? 1 : 2);
+        x = (axis + 1) % 3;
+        y = (axis + 2) % 3;
+    }
+    Vec2d operator()(const Vec3d &v) const { return { v[x], v[y] }; }
+    int x, y;
+};
+
+// Is there an edge of the triangle t with orientation o, which strictly separates all the points pts from t?
+bool separated_by_edge(const std::array<Vec2d, 3> &t, int o, const Vec2d *pts, size_t num_pts)
+{
+    for (int i = 0; i < 3; ++ i) {
+        bool separated = true;
+        for (size_t k = 0; k < num_pts && separated; ++ k)
+            separated = orient2d(t[i], t[(i + 1) % 3], pts[k]) == - o;
+        if (separated)
+            return true;
+    }
+    return false;
+}
+
+enum class Contact {
+    None,
+    // An edge crossing the interior of a facet.
+    Crossing,
+    // Touching or coplanar facets, an edge passing through an edge or a vertex, or a configuration
+    // the predicates could not decide.
+    Degenerate,
+};
+
+// Contact of the edge (p, q) lying in the plane of the triangle t.
+Contact coplanar_edge_triangle_contact(const Vec3d &p, const Vec3d &q, const Triangle &t)
+{
+    const Projection           proj(t);
+    const std::array<Vec2d, 3> t2 { proj(t[0]), proj(t[1]), proj(t[2]) };
+    const std::array<Vec2d, 2> e2 { proj(p), proj(q) };
+    const int                  o = orient2d(t2[0], t2[1], t2[2]);
+    if (o == 0)
+        return Contact::Degenerate;
+    if (separated_by_edge(t2, o, e2.data(), 2))
+        return Contact::None;
+    const int s0 = orient2d(e2[0], e2[1], t2[0]);
+    return s0 != 0 && s0 == orient2d(e2[0], e2[1], t2[1]) && s0 == orient2d(e2[0], e2[1], t2[2]) ? Contact::None : Contact::Degenerate;
+}
+
+// Contact of coplanar triangles.
+Contact coplanar_triangles_contact(const Triangle &a, const Triangle &b)
+{
+    const Projection           proj(a);
+    const std::array<Vec2d, 3> a2 { proj(a[0]), proj(a[1]), proj(a[2]) };
+    const std::array<Vec2d, 3> b2 { proj(b[0]), proj(b[1]), proj(b[2]) };
+    const int                  oa = orient2d(a2[0], a2[1], a2[2]);
+    const int                  ob = orient2d(b2[0], b2[1], b2[2]);
+    return oa != 0 && ob != 0 && (separated_by_edge(a2, oa, b2.data(), 3) || separated_by_edge(b2, ob, a2.data(), 3)) ?
+        Contact::None : Contact::Degenerate;
+}
+
+// Contact of the edge (p, q) with the triangle t, sp and sq are the orientations of p and q relative to the plane of t.
+Contact edge_triangle_contact(const Vec3d &p, const Vec3d &q, int sp, int sq, const Triangle &t)
+{
+    if (sp == sq && sp != 0)
+        return Contact::None;
+    if (sp == 0 && sq == 0)
+        return coplanar_edge_triangle_contact(p, q, t);
+    const int s0 = orient3d(p, q, t[0], t[1]);
+    const int s1 = orient3d(p, q, t[1], t[2]);
+    const int s2 = orient3d(p, q, t[2], t[0]);
+    if ((s0 > 0 || s1 > 0 || s2 > 0) && (s0 < 0 || s1 < 0 || s2 < 0))
+        // The line of the edge passes beside the triangle.
+        return Contact::None;
+    // The line passes through the triangle, either through its interior or through its boundary.
+    // If an end point lies in the plane of the triangle, the edge touches the triangle.
+    return s0 == 0 || s1 == 0 || s2 == 0 || sp == 0 || sq == 0 ? Contact::Degenerate : Contact::Crossing;
+}
+
+// Intersection point of an edge of one mesh with a facet of the other mesh.
+struct PointKey
+{
+    // 0: edge of A crossing a facet of B, 1: edge of B crossing a facet of A.
+    int mesh;
+    int edge;
+    int facet;
+
+    friend bool operator==(const PointKey &l, const PointKey &r) { return l.mesh == r.mesh && l.edge == r.edge && l.facet == r.facet; }
+    friend bool operator<(const PointKey &l, const PointKey &r) {
+        return l.mesh < r.mesh || (l.mesh == r.mesh && (l.edge < r.edge || (l.edge == r.edge && l.facet < r.facet)));
+    }
+};
+
+// Intersect the facet fa of mesh ma with the facet fb of mesh mb. If the facets cross, their intersection is a segment
+// between two points, each of them an intersection of an edge of one facet with the other facet.
+// All the predicates are evaluated with the end points of an edge ordered by their indices, thus the result for an edge
+// and a facet does not depend on which of the two facets sharing the edge is tested.
+Contact intersect_facets(const Mesh &ma, int fa, const Mesh &mb, int fb, std::array<PointKey, 2> &points)
+{
+    const Triangle ta = ma.triangle(fa);
+    const Triangle tb = mb.triangle(fb);
+    std::array<int, 3> sa, sb;
+    for (int i = 0; i < 3; ++ i)
+        sb[i] = orient3d(ta[0], ta[1], ta[2], tb[i]);
+    if (sb[0] == sb[1] && sb[1] == sb[2])
+        return sb[0] == 0 ? coplanar_triangles_contact(ta, tb) : Contact::None;
+    for (int i = 0; i < 3; ++ i)
+        sa[i] = orient3d(tb[0], tb[1], tb[2], ta[i]);
+    if (sa[0] == sa[1] && sa[1] == sa[2])
+        return sa[0] == 0 ? Contact::Degenerate : Contact::None;
+
+    int num_points = 0;
+    auto edges_crossing = [&num_points, &points](const Mesh &m, int facet, const Triangle &t, const std::array<int, 3> &s,
+                                                 const Triangle &other, int mesh_id, int other_facet) {
+        for (int i = 0; i < 3; ++ i) {
+            const int edge = m.facet_edges[facet](i);
+            int       i0   = i;
+            int       i1   = (i + 1) % 3;
+            if (m.its.indices[facet](i0) != m.edges[edge].x())
+                std::swap(i0, i1);
+            switch (edge_triangle_contact(t[i0], t[i1], s[i0], s[i1], other)) {
+            case Contact::None:
+                break;
+            case Contact::Crossing:
+                if (num_points == 2)
+                    return false;
+                points[num_points ++] = { mesh_id, edge, other_facet };
+                break;
+            case Contact::Degenerate:
+                return false;
+            }
+        }
+        return true;
+    };
+    if (! edges_crossing(ma, fa, ta, sa, tb, 0, fb) || ! edges_crossing(mb, fb, tb, sb, ta, 1, fa))
+        return Contact::Degenerate;
+    return num_points == 0 ? Contact::None : num_points == 2 ? Contact::Crossing : Contact::Degenerate;
+}
+
+// Returns true if one of the facets intersects or touches another facet of the mesh not sharing a vertex with it,
+// or if the predicates could not tell.
+bool may_self_intersect(const Mesh &mesh, const std::vector<int> &facets)
+{
+    std::atomic<bool> found { false };
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, facets.size()), [&mesh, &facets, &found](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i < range.end() && ! found; ++ i) {
+            const int                          facet = facets[i];
+            const stl_triangle_vertex_indices &f     = mesh.its.indices[facet];
+            AABBTreeIndirect::traverse(mesh.tree, AABBTreeIndirect::intersecting(mesh.bbox(facet)), [&](const auto &node) {
+                const stl_triangle_vertex_indices &g = mesh.its.indices[node.idx];
+                for (int j = 0; j < 3; ++ j)
+                    if (g(j) == f(0) || g(j) == f(1) || g(j) == f(2))
+                        return true;
+                std::array<PointKey, 2> points;
+                if (intersect_facets(mesh, facet, mesh, int(node.idx), points) == Contact::None)
+                    return true;
+                found = true;
+                return false;
+            });
+        }
+    });
+    return found;
+}
+
+// Segment of an intersection curve, the end points are indices into Arrangement::points.
+struct Cut
+{
+    int                facet_a;
+    int                facet_b;
+    std::array<int, 2> points;
+};
+
+struct Arrangement
+{
+    std::array<const Mesh*, 2> meshes;
+    std::vector<PointKey>      keys;
+    std::vector<Vec3d>         points;
+    // Parameter of the intersection point along its edge, starting at the end point with the smaller index.
+    std::vector<double>        params;
+    std::vector<Cut>           cuts;
+
+    // Vertices of both meshes and the intersection points are indexed into a common array.
+    int vertex_idx(int mesh, int idx) const { return mesh == 0 ? idx : int(meshes[0]->its.vertices.size()) + idx; }
+    int point_idx(int idx) const { return int(meshes[0]->its.vertices.size() + meshes[1]->its.vertices.size()) + idx; }
+};
+
+class FacetTesselator
+{
+public:
+    FacetTesselator() : m_tesselator(gluNewTess()) {
+        gluTessCallback(m_tesselator, GLU_TESS_BEGIN_DATA,     (_GLUfuncptr)tessBeginCB);
+        gluTessCallback(m_tesselator, GLU_TESS_VERTEX_DATA,    (_GLUfuncptr)tessVertexCB);
+        // Registering the edge flag callback makes the tesselator to emit independent triangles only.
+        gluTessCallback(m_tesselator, GLU_TESS_EDGE_FLAG_DATA, (_GLUfuncptr)tessEdgeFlagCB);
+        gluTessCallback(m_tesselator, GLU_TESS_COMBINE_DATA,   (_GLUfuncptr)tessCombineCB);
+        gluTessCallback(m_tesselator, GLU_TESS_ERROR_DATA,     (_GLUfuncptr)tessErrorCB);
+        gluTessNormal(m_tesselator, 0., 0., 1.);
+    }
+    ~FacetTesselator() { gluDeleteTess(m_tesselator); }
+    FacetTesselator(const FacetTesselator&) = delete;
+    FacetTesselator& operator=(const FacetTesselator&) = delete;
+
+    // Triangulate a polygon with holes given by contours of indices into pts. Triangles are emitted counter-clockwise.
+    // Returns false if the contours intersect.
+    bool triangulate(const std::vector<Vec2d> &pts, const std::vector<const std::vector<int>*> &contours, std::vector<Vec3i> &out)
+    {
+        m_coords.clear();
+        for (const Vec2d &pt : pts) {
+            m_coords.emplace_back(pt.x());
+            m_coords.emplace_back(pt.y());
+            m_coords.emplace_back(0.);
+        }
+        m_failed = false;
+        m_num_points = 0;
+        m_out = &out;
+        gluTessBeginPolygon(m_tesselator, (void*)this);
+        for (const std::vector<int> *contour : contours) {
+            gluTessBeginContour(m_tesselator);
+            for (int idx : *contour)
+                gluTessVertex(m_tesselator, &m_coords[idx * 3], &m_coords[idx * 3]);
+            gluTessEndContour(m_tesselator);
+        }
+        gluTessEndPolygon(m_tesselator);
+        m_out = nullptr;
+        return ! m_failed && m_num_points == 0;
+    }
+
+private:
+    static void tessBeginCB(GLenum which, void *polygonData)                  { if (which != GL_TRIANGLES) reinterpret_cast<FacetTesselator*>(polygonData)->m_failed = true; }
+    static void tessVertexCB(const GLvoid *data, void *polygonData)           { reinterpret_cast<FacetTesselator*>(polygonData)->tessVertex((const GLdouble*)data); }
+    static void tessEdgeFlagCB(GLboolean /* flag */, void * /* polygonData */) {}
+    static void tessCombineCB(const GLdouble /* newVertex */[3], const GLdouble * /* neighborVertex */[4], const GLfloat /* neighborWeight */[4], GLdouble **outData, void *polygonData)
+    {
+        // The contours intersect, which they shall not.
+        auto *self = reinterpret_cast<FacetTesselator*>(polygonData);
+        self->m_failed = true;
+        *outData = self->m_coords.data();
+    }
+    static void tessErrorCB(GLenum /* errorCode */, void *polygonData)        { reinterpret_cast<FacetTesselator*>(polygonData)->m_failed = true; }
+
+    void tessVertex(const GLdouble *data)
+    {
+        m_triangle[m_num_points ++] = int((data - m_coords.data()) / 3);
+        if (m_num_points == 3) {
+            m_out->emplace_back(m_triangle[0], m_triangle[1], m_triangle[2]);
+            m_num_points = 0;
+        }
+    }
+
+    GLUtesselator       *m_tesselator;
+    std::vector<GLdouble> m_coords;
+    std::vector<Vec3i>  *m_out { nullptr };
+    std::array<int, 3>   m_triangle;
+    int                  m_num_points { 0 };
+    bool                 m_failed { false };
+};
+
+struct DisjointSets
+{
+    explicit DisjointSets(size_t size) : parent(size) { std::iota(parent.begin(), parent.end(), 0); }
+    int find(int i) {
+        while (parent[i] != i)
+            i = parent[i] = parent[parent[i]];
+        return i;
+    }
+    void unite(int i, int j) {
+        i = find(i);
+        j = find(j);
+        if (i != j)
+            parent[std::max(i, j)] = std::min(i, j);
+    }
+    std::vector<int> parent;
+};
+
+// Split a facet of a mesh by the cuts crossing it into triangles, indexed into the common vertex array of the arrangement.
+// The cuts and the facet edges form a planar graph, its faces are traced and triangulated. A closed loop of cuts not touching
+// the facet edges forms a hole in the face surrounding it. Returns false if the graph is not consistent.
+bool split_facet(const Arrangement &arr, int mesh_id, int facet, const std::vector<int> &cuts, FacetTesselator &tesselator, std::vector<Vec3i> &out)
+{
+    const Mesh                        &mesh = *arr.meshes[mesh_id];
+    const stl_triangle_vertex_indices &f    = mesh.its.indices[facet];
+    const Triangle                     t    = mesh.triangle(facet);
+    const Projection                   proj(t);
+
+    // Local vertices: the facet corners first, then the intersection points.
+    std::vector<int>   vertices { arr.vertex_idx(mesh_id, f(0)), arr.vertex_idx(mesh_id, f(1)), arr.vertex_idx(mesh_id, f(2)) };
+    std::vector<Vec2d> pts { proj(t[0]), proj(t[1]), proj(t[2]) };
+    std::vector<Vec2i> edges;
+    std::array<std::vector<int>, 3> edge_points;
+    auto local_point = [&](int point) {
+        const int idx = arr.point_idx(point);
+        if (auto it = std::find(vertices.begin() + 3, vertices.end(), idx); it != vertices.end())
+            return int(it - vertices.begin());
+        vertices.emplace_back(idx);
+        pts.emplace_back(proj(arr.points[point]));
+        const PointKey &key = arr.keys[point];
+        if (key.mesh == mesh_id) {
+            // Intersection of an edge of this facet.
+            int i = 0;
+            for (; i < 3 && mesh.facet_edges[facet](i) != key.edge; ++ i) ;
+            if (i == 3)
+                return -1;
+            edge_points[i].emplace_back(point);
+        }
+        return int(vertices.size() - 1);
+    };
+    for (int cut : cuts) {
+        const int p0 = local_point(arr.cuts[cut].points[0]);
+        const int p1 = local_point(arr.cuts[cut].points[1]);
+        if (p0 == -1 || p1 == -1 || p0 == p1)
+            return false;
+        edges.emplace_back(p0, p1);
+    }
+    if (orient2d(pts[0], pts[1], pts[2]) < 0)
+        // Keep the facet counter-clockwise in the projection.
+        for (Vec2d &pt : pts)
+            std::swap(pt.x(), pt.y());
+
+    // Facet boundary split at the intersection points, ordered along the edges by their parameters.
+    std::vector<int> boundary;
+    for (int i = 0; i < 3; ++ i) {
+        boundary.emplace_back(i);
+        std::vector<int> &on_edge = edge_points[i];
+        std::sort(on_edge.begin(), on_edge.end(), [&arr](int l, int r) { return arr.params[l] < arr.params[r]; });
+        if (f(i) != mesh.edges[mesh.facet_edges[facet](i)].x())
+            std::reverse(on_edge.begin(), on_edge.end());
+        for (int point : on_edge)
+            boundary.emplace_back(int(std::find(vertices.begin() + 3, vertices.end(), arr.point_idx(point)) - vertices.begin()));
+    }
+    for (size_t i = 0; i < boundary.size(); ++ i)
+        edges.emplace_back(boundary[i], boundary[(i + 1) % boundary.size()]);
+
+    // Neighbors of each vertex sorted counter-clockwise.
+    const size_t num_vertices = vertices.size();
+    std::vector<std::vector<int>> neighbors(num_vertices);
+    DisjointSets components(num_vertices);
+    for (const Vec2i &e : edges) {
+        neighbors[e.x()].emplace_back(e.y());
+        neighbors[e.y()].emplace_back(e.x());
+        components.unite(e.x(), e.y());
+    }
+    for (size_t v = 0; v < num_vertices; ++ v) {
+        std::vector<int> &nbrs = neighbors[v];
+        // Corners have two neighbors, points on the facet edges three, interior points two.
+        const size_t expected = v < 3 ? 2 : arr.keys[vertices[v] - arr.point_idx(0)].mesh == mesh_id ? 3 : 2;
+        if (nbrs.size() != expected)
+            return false;
+        const Vec2d &o = pts[v];
+        auto upper = [&o](const Vec2d &d) { return d.y() > 0 || (d.y() == 0 && d.x() > 0); };
+        std::sort(nbrs.begin(), nbrs.end(), [&](int l, int r) {
+            const Vec2d dl = pts[l] - o;
+            const Vec2d dr = pts[r] - o;
+            const bool  ul = upper(dl);
+            const bool  ur = upper(dr);
+            return ul != ur ? ul : cross2(dl, dr) > 0;
+        });
+    }
+
+    // Trace the faces of the planar graph, the bounded faces counter-clockwise.
+    struct Cycle {
+        std::vector<int> vertices;
+        double           area;
+        int              component;
+    };
+    std::vector<Cycle> cycles;
+    std::vector<std::vector<bool>> visited(num_vertices);
+    for (size_t v = 0; v < num_vertices; ++ v)
+        visited[v].assign(neighbors[v].size(), false);
+    for (size_t v0 = 0; v0 < num_vertices; ++ v0)
+        for (size_t i0 = 0; i0 < neighbors[v0].size(); ++ i0)
+            if (! visited[v0][i0]) {
+                Cycle cycle { {}, 0., components.find(int(v0)) };
+                int v = int(v0);
+                int i = int(i0);
+                while (! visited[v][i]) {
+                    visited[v][i] = true;
+                    cycle.vertices.emplace_back(v);
+                    const int u = neighbors[v][i];
+                    cycle.area += cross2(pts[v], pts[u]);
+                    // Turn to the first edge clockwise from the edge back.
+                    const std::vector<int> &nbrs = neighbors[u];
+                    const int j = int(std::find(nbrs.begin(), nbrs.end(), v) - nbrs.begin());
+                    i = (j + int(nbrs.size()) - 1) % int(nbrs.size());
+                    v = u;
+                }
+                if (v != int(v0) || cycle.vertices.size() < 3)
+                    return false;
+                cycles.emplace_back(std::move(cycle));
+            }
+
+    // The clockwise cycle of the component containing the facet corners is the facet boundary, the other clockwise cycles
+    // are holes in the faces surrounding them.
+    const int facet_component = components.find(0);
+    std::vector<std::vector<const std::vector<int>*>> faces(cycles.size());
+    for (size_t i = 0; i < cycles.size(); ++ i)
+        if (cycles[i].area > 0)
+            faces[i].emplace_back(&cycles[i].vertices);
+    for (const Cycle &hole : cycles)
+        if (hole.area < 0 && hole.component != facet_component) {
+            const Vec2d &pt   = pts[hole.vertices.front()];
+            int          best = -1;
+            for (size_t i = 0; i < cycles.size(); ++ i) {
+                const Cycle &face = cycles[i];
+                if (face.area > 0 && face.component != hole.component && (best == -1 || face.area < cycles[best].area)) {
+                    // Point in polygon by the crossing number.
+                    bool inside = false;
+                    for (size_t j = 0, k = face.vertices.size() - 1; j < face.vertices.size(); k = j ++) {
+                        const Vec2d &a = pts[face.vertices[j]];
+                        const Vec2d &b = pts[face.vertices[k]];
+                        if ((a.y() > pt.y()) != (b.y() > pt.y()) && pt.x() < a.x() + (b.x() - a.x()) * (pt.y() - a.y()) / (b.y() - a.y()))
+                            inside = ! inside;
+                    }
+                    if (inside)
+                        best = int(i);
+                }
+            }
+            if (best == -1)
+                return false;
+            faces[best].emplace_back(&hole.vertices);
+        }
+
+    std::vector<Vec3i> triangles;
+    for (const std::vector<const std::vector<int>*> &face : faces)
+        if (! face.empty() && ! tesselator.triangulate(pts, face, triangles))
+            return false;
+    for (const Vec3i &tr : triangles)
+        out.emplace_back(vertices[tr(0)], vertices[tr(1)], vertices[tr(2)]);
+    return true;
+}
+
+// Is the point inside a closed mesh? Parity of the hits of a ray, the ray is discarded if it passes close to an edge
+// of the mesh. Returns -1 if none of the rays gave a reliable answer.
+int is_inside(const Mesh &mesh, const Vec3d &pt)
+{
+    static const std::array<Vec3d, 4> directions {
+        Vec3d(0.5773502691896258, 0.5773502691896258, 0.5773502691896258),
+        Vec3d(-0.2672612419124244, 0.5345224838248488, -0.8017837257372732),
+        Vec3d(0.8164965809277261, -0.4082482904638631, 0.4082482904638631),
+        Vec3d(-0.4242640687119285, -0.5656854249492381, 0.7071067811865476),
+    };
+    std::vector<igl::Hit> hits;
+    for (const Vec3d &dir : directions) {
+        AABBTreeIndirect::intersect_ray_all_hits(mesh.its.vertices, mesh.its.indices, mesh.tree, pt, dir, hits, 0.);
+        bool reliable = true;
+        for (const igl::Hit &hit : hits)
+            if (std::min({ hit.u, hit.v, 1.f - hit.u - hit.v }) < 1e-5f) {
+                reliable = false;
+                break;
+            }
+        if (reliable)
+            return int(hits.size() % 2);
+    }
+    return -1;
+}
+
+// Generalized winding number of a closed mesh around the point [Jacobson et al. 2013], sum of the solid angles of the facets.
+double winding_number(const Mesh &mesh, const Vec3d &pt)
+{
+    double sum = 0.;
+    for (const stl_triangle_vertex_indices &f : mesh.its.indices) {
+        const Vec3d  a  = mesh.vertex(f(0)) - pt;
+        const Vec3d  b  = mesh.vertex(f(1)) - pt;
+        const Vec3d  c  = mesh.vertex(f(2)) - pt;
+        const double la = a.norm(), lb = b.norm(), lc = c.norm();
+        sum += 2. * std::atan2(a.dot(b.cross(c)), la * lb * lc + a.dot(b) * lc + b.dot(c) * la + c.dot(a) * lb);
+    }
+    return sum / (4. * PI);
+}
+
+// Split the triangles of a mesh into patches bounded by the intersection curves and classify each patch as inside or outside
+// of the other mesh. Returns false if the triangles do not form a closed manifold.
+bool classify_patches(const Arrangement &arr, const std::vector<Vec3i> &triangles, const std::vector<Vec3d> &vertices,
+                      const Mesh &other, const std::vector<std::pair<int, int>> &cut_edges, std::vector<bool> &inside)
+{
+    struct HalfEdge {
+        int a, b;
+        int triangle;
+    };
+    std::vector<HalfEdge> half_edges(triangles.size() * 3);
+    for (size_t i = 0; i < triangles.size(); ++ i)
+        for (int j = 0; j < 3; ++ j) {
+            const int v0 = triangles[i](j);
+            const int v1 = triangles[i]((j + 1) % 3);
+            half_edges[i * 3 + j] = { std::min(v0, v1), std::max(v0, v1), int(i) };
+        }
+    tbb::parallel_sort(half_edges.begin(), half_edges.end(), [](const HalfEdge &l, const HalfEdge &r) {
+        return l.a < r.a || (l.a == r.a && (l.b < r.b || (l.b == r.b && l.triangle < r.triangle)));
+    });
+    DisjointSets patches(triangles.size());
+    const int    first_point = arr.point_idx(0);
+    for (size_t i = 0; i < half_edges.size(); i += 2) {
+        const HalfEdge &he = half_edges[i];
+        if (i + 1 == half_edges.size() || half_edges[i + 1].a != he.a || half_edges[i + 1].b != he.b ||
+            (i + 2 < half_edges.size() && half_edges[i + 2].a == he.a && half_edges[i + 2].b == he.b))
+            return false;
+        if (he.a < first_point || ! std::binary_search(cut_edges.begin(), cut_edges.end(), std::make_pair(he.a, he.b)))
+            patches.unite(he.triangle, half_edges[i + 1].triangle);
+    }
+
+    // Classify the biggest triangle of each patch, its centroid is the farthest from the intersection curves.
+    std::vector<int> patch_of(triangles.size());
+    std::vector<int> representatives;
+    std::vector<double> areas;
+    for (size_t i = 0; i < triangles.size(); ++ i) {
+        const int root = patches.find(int(i));
+        const Vec3i &tr = triangles[i];
+        const double area = (vertices[tr(1)] - vertices[tr(0)]).cross(vertices[tr(2)] - vertices[tr(0)]).squaredNorm();
+        if (root == int(i)) {
+            patch_of[i] = int(representatives.size());
+            representatives.emplace_back(int(i));
+            areas.emplace_back(area);
+        } else {
+            const int patch = patch_of[i] = patch_of[root];
+            if (area > areas[patch]) {
+                areas[patch] = area;
+                representatives[patch] = int(i);
+            }
+        }
+    }
+    std::vector<int> patch_inside(representatives.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, representatives.size()), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t patch = range.begin(); patch < range.end(); ++ patch) {
+            const Vec3i &tr       = triangles[representatives[patch]];
+            const Vec3d  centroid = (vertices[tr(0)] + vertices[tr(1)] + vertices[tr(2)]) / 3.;
+            int          in       = is_inside(other, centroid);
+            patch_inside[patch]   = in == -1 ? winding_number(other, centroid) > 0.5 : in;
+        }
+    });
+    inside.assign(triangles.size(), false);
+    for (size_t i = 0; i < triangles.size(); ++ i)
+        inside[i] = patch_inside[patch_of[i]] != 0;
+    return true;
+}
+
+bool fail(const char *reason)
+{
+    BOOST_LOG_TRIVIAL(debug) << "MeshBoolean::fast::mesh_boolean: " << reason;
+    return false;
+}
+
+} // namespace
+
+bool mesh_boolean(indexed_triangle_set &A, const indexed_triangle_set &B, BooleanOperation op)
+{
+    if (A.indices.empty() || B.indices.empty()) {
+        if (op == BooleanOperation::Intersection)
+            A.clear();
+        else if (op == BooleanOperation::Union && A.indices.empty())
+            A = B;
+        return true;
+    }
+
+    std::array<Mesh, 2> meshes { Mesh(A), Mesh(B) };
+    for (Mesh &mesh : meshes) {
+        if (! build_edges(mesh.its.indices, mesh.facet_edges, mesh.edges))
+            return fail("the input is not a closed oriented manifold");
+        mesh.tree = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(mesh.its.vertices, mesh.its.indices);
+    }
+    const Mesh &mesh_a = meshes.front();
+    const Mesh &mesh_b = meshes.back();
+
+    // Intersect the pairs of facets with overlapping bounding boxes.
+    struct CutKeys {
+        int                     facet_b;
+        std::array<PointKey, 2> points;
+    };
+    std::vector<std::vector<CutKeys>> cuts_of_facet(A.indices.size());
+    std::atomic<bool>                 degenerate { false };
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, A.indices.size()), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t facet = range.begin(); facet < range.end() && ! degenerate; ++ facet)
+            AABBTreeIndirect::traverse(mesh_b.tree, AABBTreeIndirect::intersecting(mesh_a.bbox(int(facet))), [&](const auto &node) {
+                std::array<PointKey, 2> points;
+                switch (intersect_facets(mesh_a, int(facet), mesh_b, int(node.idx), points)) {
+                case Contact::None:
+                    break;
+                case Contact::Crossing:
+                    cuts_of_facet[facet].push_back({ int(node.idx), points });
+                    break;
+                case Contact::Degenerate:
+                    degenerate = true;
+                    return false;
+                }
+                return true;
+            });
+    });
+    if (degenerate)
+        return fail("degenerate intersection");
+
+    // Like the CGAL corefinement, only the facets along the intersection curves are checked for self intersections.
+    {
+        std::array<std::vector<int>, 2> cut_facets;
+        for (size_t facet = 0; facet < cuts_of_facet.size(); ++ facet)
+            if (! cuts_of_facet[facet].empty()) {
+                cut_facets[0].emplace_back(int(facet));
+                for (const CutKeys &cut : cuts_of_facet[facet])
+                    cut_facets[1].emplace_back(cut.facet_b);
+            }
+        sort_remove_duplicates(cut_facets[1]);
+        for (int mesh_id = 0; mesh_id < 2; ++ mesh_id)
+            if (may_self_intersect(meshes[mesh_id], cut_facets[mesh_id]))
+                return fail("the input may self intersect");
+    }
+
+    // Index the intersection points, calculate their positions.
+    Arrangement arr;
+    arr.meshes = { &mesh_a, &mesh_b };
+    for (const std::vector<CutKeys> &cuts : cuts_of_facet)
+        for (const CutKeys &cut : cuts)
+            arr.keys.insert(arr.keys.end(), cut.points.begin(), cut.points.end());
+    tbb::parallel_sort(arr.keys.begin(), arr.keys.end());
+    arr.keys.erase(std::unique(arr.keys.begin(), arr.keys.end()), arr.keys.end());
+    auto point_of_key = [&arr](const PointKey &key) { return int(std::lower_bound(arr.keys.begin(), arr.keys.end(), key) - arr.keys.begin()); };
+    for (size_t facet = 0; facet < cuts_of_facet.size(); ++ facet)
+        for (const CutKeys &cut : cuts_of_facet[facet])
+            arr.cuts.push_back({ int(facet), cut.facet_b, { point_of_key(cut.points[0]), point_of_key(cut.points[1]) } });
+    cuts_of_facet = {};
+    arr.points.assign(arr.keys.size(), Vec3d::Zero());
+    arr.params.assign(arr.keys.size(), 0.);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, arr.keys.size()), [&arr, &meshes](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i < range.end(); ++ i) {
+            const PointKey &key  = arr.keys[i];
+            const Mesh     &edge_mesh = meshes[key.mesh];
+            const Vec3d     p    = edge_mesh.vertex(edge_mesh.edges[key.edge].x());
+            const Vec3d     q    = edge_mesh.vertex(edge_mesh.edges[key.edge].y());
+            const Triangle  t    = meshes[1 - key.mesh].triangle(key.facet);
+            const Vec3d     n    = (t[1] - t[0]).cross(t[2] - t[0]);
+            const double    dp   = n.dot(p - t[0]);
+            const double    dq   = n.dot(q - t[0]);
+            const double    s    = dp == dq ? 0.5 : std::clamp(dp / (dp - dq), 0., 1.);
+            arr.points[i] = p + s * (q - p);
+            arr.params[i] = s;
+        }
+    });
+
+    // Common vertex array of both meshes and the intersection points.
+    std::vector<Vec3d> vertices;
+    vertices.reserve(A.vertices.size() + B.vertices.size() + arr.points.size());
+    for (const stl_vertex &v : A.vertices)
+        vertices.emplace_back(v.cast<double>());
+    for (const stl_vertex &v : B.vertices)
+        vertices.emplace_back(v.cast<double>());
+    vertices.insert(vertices.end(), arr.points.begin(), arr.points.end());
+    std::vector<std::pair<int, int>> cut_edges;
+    cut_edges.reserve(arr.cuts.size());
+    for (const Cut &cut : arr.cuts) {
+        const int p0 = arr.point_idx(cut.points[0]);
+        const int p1 = arr.point_idx(cut.points[1]);
+        cut_edges.emplace_back(std::min(p0, p1), std::max(p0, p1));
+    }
+    std::sort(cut_edges.begin(), cut_edges.end());
+
+    // Split the facets crossed by the intersection curves, classify the patches of both meshes.
+    std::array<std::vector<Vec3i>, 2> triangles;
+    std::array<std::vector<bool>, 2>  inside;
+    for (int mesh_id = 0; mesh_id < 2; ++ mesh_id) {
+        const Mesh &mesh = meshes[mesh_id];
+        // Cuts grouped by the facets of this mesh.
+        std::vector<int> cuts(arr.cuts.size());
+        std::iota(cuts.begin(), cuts.end(), 0);
+        auto facet_of = [&arr, mesh_id](int cut) { return mesh_id == 0 ? arr.cuts[cut].facet_a : arr.cuts[cut].facet_b; };
+        std::stable_sort(cuts.begin(), cuts.end(), [&facet_of](int l, int r) { return facet_of(l) < facet_of(r); });
+        std::vector<std::pair<size_t, size_t>> cut_facets;
+        for (size_t i = 0; i < cuts.size();) {
+            size_t j = i;
+            for (; j < cuts.size() && facet_of(cuts[j]) == facet_of(cuts[i]); ++ j) ;
+            cut_facets.emplace_back(i, j);
+            i = j;
+        }
+        std::vector<std::vector<Vec3i>> split(cut_facets.size());
+        std::atomic<bool> failed { false };
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, cut_facets.size()), [&](const tbb::blocked_range<size_t> &range) {
+            FacetTesselator  tesselator;
+            std::vector<int> facet_cuts;
+            for (size_t i = range.begin(); i < range.end() && ! failed; ++ i) {
+                facet_cuts.assign(cuts.begin() + cut_facets[i].first, cuts.begin() + cut_facets[i].second);
+                if (! split_facet(arr, mesh_id, facet_of(facet_cuts.front()), facet_cuts, tesselator, split[i]))
+                    failed = true;
+            }
+        });
+        if (failed)
+            return fail("failed to split the intersected facets");
+
+        std::vector<Vec3i> &out = triangles[mesh_id];
+        out.reserve(mesh.its.indices.size() + cuts.size() * 4);
+        size_t next_split = 0;
+        for (size_t facet = 0; facet < mesh.its.indices.size(); ++ facet)
+            if (next_split < cut_facets.size() && facet_of(cuts[cut_facets[next_split].first]) == int(facet)) {
+                out.insert(out.end(), split[next_split].begin(), split[next_split].end());
+                ++ next_split;
+            } else {
+                const stl_triangle_vertex_indices &f = mesh.its.indices[facet];
+                out.emplace_back(arr.vertex_idx(mesh_id, f(0)), arr.vertex_idx(mesh_id, f(1)), arr.vertex_idx(mesh_id, f(2)));
+            }
+        if (! classify_patches(arr, out, vertices, meshes[1 - mesh_id], cut_edges, inside[mesh_id]))
+            return fail("the split facets do not form a closed manifold");
+    }
+
+    // Collect the patches to keep, compactify the vertices.
+    indexed_triangle_set result;
+    std::vector<int>     vertex_map(vertices.size(), -1);
+    for (int mesh_id = 0; mesh_id < 2; ++ mesh_id) {
+        const bool keep_inside = op == BooleanOperation::Intersection || (op == BooleanOperation::Difference && mesh_id == 1);
+        const bool flip        = op == BooleanOperation::Difference && mesh_id == 1;
+        for (size_t i = 0; i < triangles[mesh_id].size(); ++ i)
+            if (inside[mesh_id][i] == keep_inside) {
+                Vec3i tr = triangles[mesh_id][i];
+                for (int j = 0; j < 3; ++ j) {
+                    int &v = vertex_map[tr(j)];
+                    if (v == -1) {
+                        v = int(result.vertices.size());
+                        result.vertices.emplace_back(vertices[tr(j)].cast<float>());
+                    }
+                    tr(j) = v;
+                }
+                if (flip)
+                    std::swap(tr(1), tr(2));
+                result.indices.emplace_back(tr);
+            }
+    }
+
+    std::vector<Vec3i> facet_edges;
+    std::vector<Vec2i> edges;
+    if (! result.indices.empty() && ! build_edges(result.indices, facet_edges, edges))
+        return fail("the result is not a closed oriented manifold");
+
+    BOOST_LOG_TRIVIAL(debug) << "MeshBoolean::fast::mesh_boolean: " << A.indices.size() << " and " << B.indices.size() << " facets, "
+        << arr.cuts.size() << " intersection segments, " << result.indices.size() << " facets of the result";
+    A = std::move(result);
+    return true;
+}
+
+} // namespace fast
+} // namespace MeshBoolean
+} // namespace Slic3r
@@ -0,0 +1,37 @@
+///|/ Copyright (c) Prusa Research 2024
+///|/
+///|/ PrusaSlicer is released under the terms of the AGPLv3 or higher
+///|/
+#ifndef slic3r_MeshBooleanFast_hpp_
+#define slic3r_MeshBooleanFast_hpp_
+
+#include <admesh/stl.h>
+
+namespace Slic3r {
+namespace MeshBoolean {
+namespace fast {
+
+enum class BooleanOperation {
+    Union,
+    Difference,
+    Intersection,
+};
+
+// Mesh boolean of two closed, consistently oriented and not self intersecting meshes, computed on indexed_triangle_set
+// without exact constructions: Triangle pairs are intersected in parallel using an AABB tree of B and filtered
+// floating point orientation predicates, the intersected facets are retriangulated, the patches bounded by
+// the intersection curves are classified by ray casting and the patches to keep are stitched together.
+// The predicates only certify signs, the configurations they cannot decide are not resolved: coplanar or touching facets,
+// intersection curves passing through vertices or edges, open input or self intersections along the intersection curves.
+// In that case false is returned and A is left untouched, the caller shall fall back to the exact CGAL corefinement.
+bool mesh_boolean(indexed_triangle_set &A, const indexed_triangle_set &B, BooleanOperation op);
+
+inline bool minus(indexed_triangle_set &A, const indexed_triangle_set &B)     { return mesh_boolean(A, B, BooleanOperation::Difference); }
+inline bool plus(indexed_triangle_set &A, const indexed_triangle_set &B)      { return mesh_boolean(A, B, BooleanOperation::Union); }
+inline bool intersect(indexed_triangle_set &A, const indexed_triangle_set &B) { return mesh_boolean(A, B, BooleanOperation::Intersection); }
+
+} // namespace fast
+} // namespace MeshBoolean
+} // namespace Slic3r
+
+#endif // slic3r_MeshBooleanFast_hpp_
@@ -0,0 +1,300 @@
+///|/ Copyright (c) Prusa Research 2024
+///|/
+///|/ PrusaSlicer is released under the terms of the AGPLv3 or higher
+///|/
+#include "MeshOutOfCore.hpp"
+
+#include <oneapi/tbb/blocked_range.h>
+#include <oneapi/tbb/parallel_for.h>
+#include <boost/container_hash/hash.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/cstdio.hpp>
+#include <Eigen/SVD>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "admesh/stl.h"
+#include "libslic3r/Exception.hpp"
+#include "libslic3r/TriangleMesh.hpp"
+#include "libslic3r/Utils.hpp"
+#include "libslic3r/format.hpp"
+#include "libslic3r/libslic3r.h"
+
+namespace Slic3r {
+
+static inline int slab_id(float z, float slab_height)
+{
+    return int(std::floor(z / slab_height));
+}
+
+OutOfCoreMesh::OutOfCoreMesh(const std::string &stl_path, const Params &params, std::function<void()> throw_on_cancel) :
+    m_slab_height(params.slab_height)
+{
+    if (! (m_slab_height > 0.f))
+        throw Slic3r::InvalidArgument("OutOfCoreMesh: Slab height has to be positive");
+
+    boost::filesystem::path dir = params.temp_dir.empty() ? boost::filesystem::temp_directory_path() : boost::filesystem::path(params.temp_dir);
+    dir /= boost::filesystem::unique_path("slabs-%%%%-%%%%-%%%%-%%%%");
+    boost::filesystem::create_directories(dir);
+    m_dir = dir.string();
+
+    try {
+        std::map<int, size_t> slab_facets;
+        stl_file              stl;
+        bool ok = stl_read_chunks(&stl, stl_path.c_str(), params.chunk_facets, [&](std::vector<stl_facet> &facets) {
+            throw_on_cancel();
+            // Vertices of the facets of this chunk sorted into slabs, keyed by slab id.
+            // Released when the chunk is written, so that the memory used does not grow with the slab count.
+            std::map<int, std::vector<stl_vertex>> chunk_slabs;
+            for (const stl_facet &facet : facets) {
+                float min_z = std::min(facet.vertex[0].z(), std::min(facet.vertex[1].z(), facet.vertex[2].z()));
+                float max_z = std::max(facet.vertex[0].z(), std::max(facet.vertex[1].z(), facet.vertex[2].z()));
+                // Facets close to a slab boundary are stored with both slabs to be robust against rounding
+                // of the slicing planes transformed into the mesh coordinate system.
+                for (int id = slab_id(min_z - float(EPSILON), m_slab_height); id <= slab_id(max_z + float(EPSILON), m_slab_height); ++ id) {
+                    std::vector<stl_vertex> &vertices = chunk_slabs[id];
+                    vertices.insert(vertices.end(), facet.vertex, facet.vertex + 3);
+                }
+            }
+            // Append the chunk to the slab files, only a single slab file is open at a time.
+            for (const auto &[id, vertices] : chunk_slabs) {
+                std::string path    = this->slab_path(id);
+                FILE       *file    = boost::nowide::fopen(path.c_str(), "ab");
+                bool        written = file != nullptr && ::fwrite(vertices.data(), sizeof(stl_vertex), vertices.size(), file) == vertices.size();
+                if (file != nullptr && ::fclose(file) != 0)
+                    written = false;
+                if (! written)
+                    throw Slic3r::RuntimeError(format("Failed to write mesh slab %1%", path));
+                slab_facets[id] += vertices.size() / 3;
+            }
+        });
+        if (! ok)
+            throw Slic3r::RuntimeError(format("Failed to read STL file %1%", stl_path));
+
+        m_facets_count = stl.stats.number_of_facets;
+        if (m_facets_count > 0)
+            m_bbox = BoundingBoxf3(stl.stats.min.cast<double>(), stl.stats.max.cast<double>());
+        m_slabs.reserve(slab_facets.size());
+        for (const auto &[id, facets] : slab_facets)
+            m_slabs.push_back({ id, facets });
+        BOOST_LOG_TRIVIAL(debug) << "OutOfCoreMesh: " << m_facets_count << " facets of " << stl_path << " sorted into " << m_slabs.size() << " slabs";
+    } catch (...) {
+        boost::system::error_code ec;
+        boost::filesystem::remove_all(m_dir, ec);
+        throw;
+    }
+}
+
+OutOfCoreMesh::~OutOfCoreMesh()
+{
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(m_dir, ec);
+    if (ec)
+        BOOST_LOG_TRIVIAL(error) << "OutOfCoreMesh: Failed to remove mesh slabs " << m_dir << ": " << ec.message();
+}
+
+std::string OutOfCoreMesh::slab_path(int id) const
+{
+    return (boost::filesystem::path(m_dir) / ("slab" + std::to_string(id) + ".bin")).string();
+}
+
+int OutOfCoreMesh::slab_idx(float z) const
+{
+    int  id = slab_id(z, m_slab_height);
+    auto it = std::lower_bound(m_slabs.begin(), m_slabs.end(), id, [](const Slab &slab, int id) { return slab.id < id; });
+    return it != m_slabs.end() && it->id == id ? int(it - m_slabs.begin()) : -1;
+}
+
+indexed_triangle_set OutOfCoreMesh::load_slab(size_t idx) const
+{
+    const Slab          &slab = m_slabs[idx];
+    std::string          path = this->slab_path(slab.id);
+    indexed_triangle_set its;
+    its.vertices.assign(slab.facets * 3, stl_vertex());
+    FilePtr file{ boost::nowide::fopen(path.c_str(), "rb") };
+    if (file.f == nullptr || ::fread(its.vertices.data(), sizeof(stl_vertex), its.vertices.size(), file.f) != its.vertices.size())
+        throw Slic3r::RuntimeError(format("Failed to read mesh slab %1%", path));
+    its.indices.reserve(slab.facets);
+    for (int i = 0; i < int(slab.facets); ++ i)
+        its.indices.emplace_back(3 * i, 3 * i + 1, 3 * i + 2);
+    its_merge_vertices(its);
+    return its;
+}
+
+std::vector<ExPolygons> slice_mesh_ex(
+    const OutOfCoreMesh              &mesh,
+    const std::vector<float>         &zs,
+    const MeshSlicingParamsEx        &params,
+    std::function<void()>             throw_on_cancel)
+{
+    const Transform3d &trafo = params.trafo;
+    if (std::abs(trafo(2, 0)) > 1e-12 || std::abs(trafo(2, 1)) > 1e-12 || std::abs(trafo(2, 2)) < 1e-12)
+        throw Slic3r::InvalidArgument("Slicing of an out of core mesh: The transformation must not tilt the mesh");
+
+    // Sort the slicing planes into slabs. The transformed Z depends on Z only, thus a slicing plane
+    // is sliced with all the facets crossing it, when it is sliced with the slab containing it.
+    std::vector<std::vector<size_t>> slab_layers(mesh.slabs_count());
+    for (size_t layer_id = 0; layer_id < zs.size(); ++ layer_id)
+        if (int idx = mesh.slab_idx(float((zs[layer_id] - trafo(2, 3)) / trafo(2, 2))); idx != -1)
+            slab_layers[idx].emplace_back(layer_id);
+
+    std::vector<ExPolygons> out(zs.size());
+    std::vector<float>      slab_zs;
+    for (size_t idx = 0; idx < mesh.slabs_count(); ++ idx) {
+        const std::vector<size_t> &layers = slab_layers[idx];
+        if (layers.empty())
+            continue;
+        throw_on_cancel();
+        slab_zs.clear();
+        for (size_t layer_id : layers)
+            slab_zs.emplace_back(zs[layer_id]);
+        MeshSlicingParamsEx slab_params = params;
+        if (params.slicing_mode_normal_below_layer > 0)
+            slab_params.slicing_mode_normal_below_layer = std::lower_bound(layers.begin(), layers.end(), params.slicing_mode_normal_below_layer) - layers.begin();
+        std::vector<ExPolygons> slices = slice_mesh_ex(mesh.load_slab(idx), slab_zs, slab_params, throw_on_cancel);
+        for (size_t i = 0; i < layers.size(); ++ i)
+            out[layers[i]] = std::move(slices[i]);
+    }
+    return out;
+}
+
+namespace {
+
+struct CellHash {
+    size_t operator()(const Vec3i &cell) const { return boost::hash_range(cell.data(), cell.data() + 3); }
+};
+
+// Quadric error metric, upper triangle of the symmetric 4x4 matrix.
+using Quadric = std::array<double, 10>;
+
+struct Cell
+{
+    Vec3i   key;
+    Quadric q {};
+    Vec3d   sum_vertices { Vec3d::Zero() };
+    size_t  num_vertices { 0 };
+};
+
+// Position minimizing the quadric error inside the cell.
+// Singular directions of the quadric (flat or cylindrical regions) are resolved by the average of the cell vertices.
+Vec3f cell_vertex(const Cell &cell, float cell_size)
+{
+    const Quadric &q = cell.q;
+    Eigen::Matrix3d A;
+    A << q[0], q[1], q[2],
+         q[1], q[4], q[5],
+         q[2], q[5], q[7];
+    Vec3d b(q[3], q[6], q[8]);
+    Vec3d avg = cell.sum_vertices / double(cell.num_vertices);
+    Eigen::JacobiSVD<Eigen::Matrix3d> svd(A, Eigen::ComputeFullU | Eigen::ComputeFullV);
+    Vec3d sigma = svd.singularValues();
+    Vec3d sigma_inv = Vec3d::Zero();
+    for (int i = 0; i < 3; ++ i)
+        if (sigma(i) > 1e-3 * sigma(0))
+            sigma_inv(i) = 1. / sigma(i);
+    Vec3d x = avg + svd.matrixV() * sigma_inv.asDiagonal() * svd.matrixU().transpose() * (- b - A * avg);
+    // Keep the vertex inside its cell to avoid spikes.
+    Vec3d cell_min = cell.key.cast<double>() * double(cell_size);
+    return x.cwiseMax(cell_min).cwiseMin(cell_min + Vec3d::Constant(cell_size)).cast<float>();
+}
+
+} // namespace
+
+indexed_triangle_set its_simplify_stl_out_of_core(
+    const std::string                &stl_path,
+    float                             cell_size,
+    size_t                            chunk_facets,
+    std::function<void()>             throw_on_cancel)
+{
+    if (! (cell_size > 0.f))
+        throw Slic3r::InvalidArgument("its_simplify_stl_out_of_core: Cell size has to be positive");
+
+    std::unordered_map<Vec3i, int, CellHash>  cell_map;
+    std::vector<Cell>                         cells;
+    std::unordered_set<Vec3i, CellHash>       triangle_set;
+    indexed_triangle_set                      out;
+
+    struct FacetQuadric {
+        std::array<Vec3i, 3> cells;
+        Quadric              q;
+    };
+    std::vector<FacetQuadric> facet_quadrics;
+
+    stl_file stl;
+    bool ok = stl_read_chunks(&stl, stl_path.c_str(), chunk_facets, [&](std::vector<stl_facet> &facets) {
+        throw_on_cancel();
+        // Quadrics of the facets weighted by their area and the cells of their vertices.
+        facet_quadrics.resize(facets.size());
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, facets.size()), [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i) {
+                const stl_facet &facet = facets[i];
+                FacetQuadric    &fq    = facet_quadrics[i];
+                for (int j = 0; j < 3; ++ j)
+                    fq.cells[j] = (facet.vertex[j] / cell_size).array().floor().cast<int>();
+                Vec3d  v0     = facet.vertex[0].cast<double>();
+                Vec3d  n      = (facet.vertex[1].cast<double>() - v0).cross(facet.vertex[2].cast<double>() - v0);
+                double area2  = n.norm();
+                fq.q.fill(0.);
+                if (area2 > 0.) {
+                    n /= area2;
+                    double d    = - n.dot(v0);
+                    double area = 0.5 * area2;
+                    fq.q = { area * n.x() * n.x(), area * n.x() * n.y(), area * n.x() * n.z(), area * n.x() * d,
+                                                   area * n.y() * n.y(), area * n.y() * n.z(), area * n.y() * d,
+                                                                         area * n.z() * n.z(), area * n.z() * d,
+                                                                                               area * d * d };
+                }
+            }
+        });
+        // Accumulate the quadrics into the cells, keep the facets spanning three cells.
+        for (size_t i = 0; i < facets.size(); ++ i) {
+            const FacetQuadric &fq = facet_quadrics[i];
+            Vec3i triangle;
+            for (int j = 0; j < 3; ++ j) {
+                auto [it, inserted] = cell_map.try_emplace(fq.cells[j], int(cells.size()));
+                if (inserted)
+                    cells.push_back({ fq.cells[j] });
+                Cell &cell = cells[it->second];
+                for (size_t k = 0; k < cell.q.size(); ++ k)
+                    cell.q[k] += fq.q[k];
+                cell.sum_vertices += facets[i].vertex[j].cast<double>();
+                ++ cell.num_vertices;
+                triangle[j] = it->second;
+            }
+            if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0])
+                continue;
+            // Rotate the lowest index first to detect duplicate triangles.
+            if (triangle[1] < triangle[0] && triangle[1] < triangle[2])
+                triangle = Vec3i(triangle[1], triangle[2], triangle[0]);
+            else if (triangle[2] < triangle[0] && triangle[2] < triangle[1])
+                triangle = Vec3i(triangle[2], triangle[0], triangle[1]);
+            if (triangle_set.insert(triangle).second)
+                out.indices.emplace_back(triangle);
+        }
+    });
+    if (! ok)
+        throw Slic3r::RuntimeError(format("Failed to read STL file %1%", stl_path));
+    triangle_set = {};
+    cell_map     = {};
+
+    throw_on_cancel();
+    out.vertices.assign(cells.size(), stl_vertex());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, cells.size()), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i < range.end(); ++ i)
+            out.vertices[i] = cell_vertex(cells[i], cell_size);
+    });
+    // Remove the cells not referenced by any triangle.
+    its_compactify_vertices(out);
+    BOOST_LOG_TRIVIAL(debug) << "its_simplify_stl_out_of_core: " << stl.stats.number_of_facets << " facets of " << stl_path << " simplified to " << out.indices.size();
+    return out;
+}
+
+} // namespace Slic3r
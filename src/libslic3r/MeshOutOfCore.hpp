@@ -0,0 +1,97 @@
+///|/ Copyright (c) Prusa Research 2024
+///|/
+///|/ PrusaSlicer is released under the terms of the AGPLv3 or higher
+///|/
+#ifndef slic3r_MeshOutOfCore_hpp_
+#define slic3r_MeshOutOfCore_hpp_
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "BoundingBox.hpp"
+#include "ExPolygon.hpp"
+#include "TriangleMeshSlicer.hpp"
+
+struct indexed_triangle_set;
+
+namespace Slic3r {
+
+// Facets of an STL file too big to be loaded into memory at once.
+// The file is read in chunks, the facets are distributed into horizontal slabs stored in temporary files
+// and the slabs are loaded one by one. The facets are not repaired, only the equal vertices are merged on load.
+class OutOfCoreMesh
+{
+public:
+    struct Params {
+        // Count of facets read from the STL file at once.
+        size_t      chunk_facets { 1 << 20 };
+        // Height of a slab, unscaled.
+        float       slab_height  { 10.f };
+        // Directory to create the slab files in, system temporary directory if empty.
+        std::string temp_dir;
+    };
+
+    // Throws Slic3r::RuntimeError if the STL file could not be read or the slabs could not be written.
+    OutOfCoreMesh(const std::string &stl_path, const Params &params, std::function<void()> throw_on_cancel = []{});
+    explicit OutOfCoreMesh(const std::string &stl_path) : OutOfCoreMesh(stl_path, Params{}) {}
+    OutOfCoreMesh(const OutOfCoreMesh &) = delete;
+    OutOfCoreMesh& operator=(const OutOfCoreMesh &) = delete;
+    // Removes the slab files.
+    ~OutOfCoreMesh();
+
+    size_t               facets_count() const { return m_facets_count; }
+    const BoundingBoxf3& bounding_box() const { return m_bbox; }
+
+    // Slabs are sorted by Z. Each slab stores facets touching its Z range <min_z, max_z>,
+    // facets spanning several slabs are stored with each of them.
+    size_t               slabs_count() const { return m_slabs.size(); }
+    float                slab_min_z(size_t idx) const { return m_slabs[idx].id * m_slab_height; }
+    float                slab_max_z(size_t idx) const { return (m_slabs[idx].id + 1) * m_slab_height; }
+    size_t               slab_facets_count(size_t idx) const { return m_slabs[idx].facets; }
+    // Index of the slab containing plane z, -1 if there is no facet around z.
+    int                  slab_idx(float z) const;
+    // Load facets of a slab, equal vertices are merged. Throws Slic3r::RuntimeError if the slab could not be read.
+    indexed_triangle_set load_slab(size_t idx) const;
+
+private:
+    struct Slab {
+        int         id     { 0 };
+        size_t      facets { 0 };
+    };
+
+    std::string        slab_path(int id) const;
+
+    std::string        m_dir;
+    float              m_slab_height;
+    std::vector<Slab>  m_slabs;
+    size_t             m_facets_count { 0 };
+    BoundingBoxf3      m_bbox;
+};
+
+// Slice the out of core mesh slab by slab, only a single slab is kept in memory at a time.
+// The result is the same as of slice_mesh_ex() of the whole mesh. params.trafo shall not tilt the mesh,
+// that is the transformed Z shall depend on Z only, otherwise Slic3r::InvalidArgument is thrown.
+std::vector<ExPolygons> slice_mesh_ex(
+    const OutOfCoreMesh              &mesh,
+    const std::vector<float>         &zs,
+    const MeshSlicingParamsEx        &params,
+    std::function<void()>             throw_on_cancel = []{});
+
+// Simplify a huge STL file in a single streaming pass by clustering its vertices into a regular grid of cubes
+// [Lindstrom: Out-of-Core Simplification of Large Polygonal Models, 2000]. Quadric error metrics of the facets are accumulated
+// per cell, each cell is represented by a single vertex minimizing the error, facets collapsed into less than three cells are dropped.
+// Memory is proportional to the count of the occupied cells and of the output triangles, not to the size of the input.
+// Throws Slic3r::RuntimeError if the STL file could not be read.
+indexed_triangle_set its_simplify_stl_out_of_core(
+    const std::string                &stl_path,
+    // Edge of a grid cell, unscaled.
+    float                             cell_size,
+    // Count of facets read from the STL file at once.
+    size_t                            chunk_facets    = 1 << 20,
+    std::function<void()>             throw_on_cancel = []{});
+
+} // namespace Slic3r
+
+#endif // slic3r_MeshOutOfCore_hpp_
@@ -258,6 +258,24 @@ VoxelGridPtr redistance_grid(const VoxelGrid &vgrid, float iso)
     return ret;
 }
 
+VoxelGridPtr resample_grid(const VoxelGrid &vgrid,
+                           float            voxel_scale,
+                           float            ext_range,
+                           float            int_range)
+{
+    auto tr = openvdb::math::Transform::createLinearTransform(1. / voxel_scale);
+    auto new_grid = openvdb::tools::levelSetRebuild(vgrid.grid, 0.f, ext_range,
+                                                    int_range, tr.get());
+
+    auto ret = make_voxelgrid(std::move(*new_grid));
+
+    // Copies the metadata and overwrites the voxel_scale
+    ret->grid.insertMeta(*vgrid.grid.deepCopyMeta());
+    ret->grid.insertMeta("voxel_scale", openvdb::FloatMetadata(voxel_scale));
+
+    return ret;
+}
+
 void grid_union(VoxelGrid &grid, VoxelGrid &arg)
 {
     openvdb::tools::csgUnion(grid.grid, arg.grid);
@@ -300,6 +318,16 @@ float get_voxel_scale(const VoxelGrid &vgrid)
     return scale;
 }
 
+size_t get_active_voxel_count(const VoxelGrid &vgrid)
+{
+    return size_t(vgrid.grid.activeVoxelCount());
+}
+
+size_t get_memory_usage(const VoxelGrid &vgrid)
+{
+    return size_t(vgrid.grid.memUsage());
+}
+
 VoxelGridPtr clone(const VoxelGrid &grid)
 {
     return make_voxelgrid(grid);
@@ -31,6 +31,11 @@ double get_distance_raw(const Vec3f &p, const VoxelGrid &interior);
 
 float get_voxel_scale(const VoxelGrid &grid);
 
+size_t get_active_voxel_count(const VoxelGrid &grid);
+
+// Memory occupied by the grid in bytes
+size_t get_memory_usage(const VoxelGrid &grid);
+
 VoxelGridPtr clone(const VoxelGrid &grid);
 
 class MeshToGridParams {
@@ -81,6 +86,13 @@ VoxelGridPtr redistance_grid(const VoxelGrid &grid,
                              float            ext_range,
                              float            int_range);
 
+// Rebuild the level set of the zero isosurface with a different voxel_scale.
+// The band widths are in voxels of the new grid.
+VoxelGridPtr resample_grid(const VoxelGrid &grid,
+                           float            voxel_scale,
+                           float            ext_range = 3.f,
+                           float            int_range = 3.f);
+
 void rescale_grid(VoxelGrid &grid, float scale);
 
 void grid_union(VoxelGrid &grid, VoxelGrid &arg);
@@ -608,6 +608,7 @@ static std::vector<std::string> s_Preset_sla_print_options {
     "support_points_density_relative",
     "slice_closing_radius",
     "slicing_mode",
+    "slice_level_csg",
     "pad_enable",
     "pad_wall_thickness",
     "pad_wall_height",
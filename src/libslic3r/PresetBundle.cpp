@@ -16,10 +16,14 @@
 #include <algorithm>
 #include <set>
 #include <fstream>
+#include <sstream>
+#include <unordered_map>
 #include <unordered_set>
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/clamp.hpp>
+#include <boost/crc.hpp>
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/trim.hpp>
 
 #include <boost/nowide/cstdio.hpp>
 #include <boost/nowide/fstream.hpp>
@@ -30,6 +34,10 @@
 
 #include <LibBGCode/core/core.hpp>
 
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+
 // Store the print/filament/printer presets into a "presets" subdirectory of the Slic3rPE config dir.
 // This breaks compatibility with the upstream Slic3r if the --datadir is used to switch between the two versions.
 // #define SLIC3R_PROFILE_USE_PRESETS_SUBDIR
@@ -131,6 +139,7 @@ PresetBundle& PresetBundle::operator=(const PresetBundle &rhs)
     project_config      = rhs.project_config;
     vendors             = rhs.vendors;
     obsolete_presets    = rhs.obsolete_presets;
+    system_presets_filter = rhs.system_presets_filter;
 
     // Adjust Preset::vendor pointers to point to the copied vendors map.
     prints       .update_vendor_ptrs_after_copy(this->vendors);
@@ -288,14 +297,38 @@ void PresetBundle::import_newer_configs(const std::string& from)
     }
 }
 
+// The user presets are always loaded completely, but the system presets only if named by system_presets_filter.
+// Add the presets, which the user presets named by system_presets_filter inherit from, to system_presets_filter,
+// so that the user presets may be loaded with their system parents. The parents of the system presets
+// are then resolved by read_configbundle_subset().
+static void add_user_presets_parents(const std::string &dir_user_presets, std::set<std::string> &system_presets_filter)
+{
+    std::vector<std::string> queue(system_presets_filter.begin(), system_presets_filter.end());
+    while (! queue.empty()) {
+        const std::string name = std::move(queue.back());
+        queue.pop_back();
+        for (const char *section : { "print", "filament", "sla_print", "sla_material", "printer" }) {
+            const boost::filesystem::path path = (boost::filesystem::path(dir_user_presets) / section / (name + ".ini")).make_preferred();
+            if (! boost::filesystem::exists(path))
+                continue;
+            try {
+                boost::property_tree::ptree tree;
+                boost::nowide::ifstream     ifs(path.string());
+                boost::property_tree::read_ini(ifs, tree);
+                ConfigOptionString inherits;
+                inherits.deserialize(tree.get<std::string>("inherits", std::string()));
+                if (! inherits.value.empty() && system_presets_filter.insert(inherits.value).second)
+                    queue.emplace_back(inherits.value);
+            } catch (const std::exception &ex) {
+                BOOST_LOG_TRIVIAL(error) << "Failed reading the parent of user preset " << path.string() << ": " << ex.what();
+            }
+        }
+    }
+}
+
 PresetsConfigSubstitutions PresetBundle::load_presets(AppConfig &config, ForwardCompatibilitySubstitutionRule substitution_rule, 
                                                       const PresetPreferences& preferred_selection/* = PresetPreferences()*/)
 {
-    // First load the vendor specific system presets.
-    PresetsConfigSubstitutions substitutions;
-    std::string errors_cummulative;
-    std::tie(substitutions, errors_cummulative) = this->load_system_presets(substitution_rule);
-
     const std::string& dir_user_presets = data_dir()
 #ifdef SLIC3R_PROFILE_USE_PRESETS_SUBDIR
         // Store the print/filament/printer presets into a "presets" directory.
@@ -305,6 +338,14 @@ PresetsConfigSubstitutions PresetBundle::load_presets(AppConfig &config, Forward
 #endif
         ;
 
+    if (! this->system_presets_filter.empty())
+        add_user_presets_parents(dir_user_presets, this->system_presets_filter);
+
+    // First load the vendor specific system presets.
+    PresetsConfigSubstitutions substitutions;
+    std::string errors_cummulative;
+    std::tie(substitutions, errors_cummulative) = this->load_system_presets(substitution_rule);
+
     try {
         this->prints.load_presets(dir_user_presets, "print", substitutions, substitution_rule);
     } catch (const std::runtime_error &err) {
@@ -376,6 +417,7 @@ std::pair<PresetsConfigSubstitutions, std::string> PresetBundle::load_system_pre
                     // Load the other vendor configs, merge them with this PresetBundle.
                     // Report duplicate profiles.
                     PresetBundle other;
+                    other.system_presets_filter = this->system_presets_filter;
                     append(substitutions, other.load_configbundle(dir_entry.path().string(), PresetBundle::LoadSystem, compatibility_rule).first);
                     std::vector<std::string> duplicates = this->merge_presets(std::move(other));
                     if (! duplicates.empty()) {
@@ -1420,6 +1462,279 @@ static void flatten_configbundle_hierarchy(boost::property_tree::ptree &tree, co
     flatten_configbundle_hierarchy(tree, "printer",         preset_bundle ? preset_bundle->printers.system_preset_names()      : std::vector<std::string>());
 }
 
+// Binary snapshot of a flattened and parsed system config bundle.
+// Loading the vendor config bundles (INI parsing, resolving the inheritance and deserializing thousands of options
+// from their text representation) dominates the application start. The snapshot stores the flattened bundle
+// with the preset sections replaced by their parsed configs, whose options are stored by their serialization_key_ordinal.
+// The snapshot is only valid for the same source file (path, size, modification time and CRC32), the same version
+// of PrusaSlicer and the same layout of print_config_def, otherwise the config bundle is loaded from the INI file.
+// The header is followed by the payload (the flattened tree and the parsed configs), whose length and CRC32 are stored
+// in the header, so that a truncated or otherwise damaged snapshot is detected before it is deserialized.
+static constexpr const uint32_t CONFIG_BUNDLE_SNAPSHOT_VERSION = 2;
+
+struct ConfigBundleSnapshotHeader
+{
+    uint32_t    format_version { CONFIG_BUNDLE_SNAPSHOT_VERSION };
+    std::string app_version { SLIC3R_VERSION };
+    uint32_t    config_def_crc { 0 };
+    std::string source_path;
+    uint64_t    source_size { 0 };
+    int64_t     source_mtime { 0 };
+    uint32_t    source_crc { 0 };
+    uint64_t    payload_size { 0 };
+    uint32_t    payload_crc { 0 };
+
+    // Is the snapshot with this header valid for the config bundle described by rhs? The payload is not compared.
+    bool matches(const ConfigBundleSnapshotHeader &rhs) const {
+        return format_version == rhs.format_version && app_version == rhs.app_version && config_def_crc == rhs.config_def_crc &&
+               source_path == rhs.source_path && source_size == rhs.source_size && source_mtime == rhs.source_mtime && source_crc == rhs.source_crc;
+    }
+
+    template<class Archive> void serialize(Archive &ar) {
+        ar(format_version, app_version, config_def_crc, source_path, source_size, source_mtime, source_crc, payload_size, payload_crc);
+    }
+};
+
+// Sections of a config bundle, which are parsed into a DynamicPrintConfig by load_configbundle().
+static bool is_config_bundle_preset_section(const std::string &section_name)
+{
+    return boost::starts_with(section_name, "print:") || boost::starts_with(section_name, "filament:") ||
+           boost::starts_with(section_name, "sla_print:") || boost::starts_with(section_name, "sla_material:") ||
+           boost::starts_with(section_name, "printer:");
+}
+
+// Fingerprint of the option keys, types and serialization ordinals, which the snapshot depends on.
+static uint32_t print_config_def_crc()
+{
+    static const uint32_t crc = []() {
+        boost::crc_32_type crc;
+        for (const auto &[ordinal, optdef] : print_config_def.by_serialization_key_ordinal) {
+            const uint64_t data[3] = { uint64_t(ordinal), uint64_t(optdef->type), uint64_t(optdef->nullable) };
+            crc.process_bytes(data, sizeof(data));
+            crc.process_bytes(optdef->opt_key.data(), optdef->opt_key.size());
+        }
+        return crc.checksum();
+    }();
+    return crc;
+}
+
+static ConfigBundleSnapshotHeader config_bundle_snapshot_header(const std::string &path)
+{
+    ConfigBundleSnapshotHeader header;
+    header.config_def_crc = print_config_def_crc();
+    header.source_path    = boost::filesystem::absolute(path).string();
+    header.source_size    = boost::filesystem::file_size(path);
+    header.source_mtime   = int64_t(boost::filesystem::last_write_time(path));
+    boost::crc_32_type crc;
+    boost::nowide::ifstream ifs(path, std::ios::binary);
+    std::vector<char> buffer(65536);
+    while (ifs.read(buffer.data(), buffer.size()) || ifs.gcount() > 0)
+        crc.process_bytes(buffer.data(), size_t(ifs.gcount()));
+    header.source_crc     = crc.checksum();
+    return header;
+}
+
+// Config bundles of the same name are loaded from resources/profiles, vendor and cache/vendor,
+// thus the snapshot name contains a hash of the absolute path of the config bundle.
+static boost::filesystem::path config_bundle_snapshot_path(const std::string &path)
+{
+    const std::string source_path = boost::filesystem::absolute(path).string();
+    boost::crc_32_type crc;
+    crc.process_bytes(source_path.data(), source_path.size());
+    char hash[16];
+    sprintf(hash, "-%08x", unsigned(crc.checksum()));
+    return (boost::filesystem::path(data_dir()) / "cache" / "config_bundles" / (boost::filesystem::path(path).stem().string() + hash + ".cereal")).make_preferred();
+}
+
+// Load the flattened config bundle tree and the parsed configs of its preset sections.
+// Returns false if the snapshot does not exist or it is not valid for the config bundle described by header.
+static bool load_config_bundle_snapshot(const boost::filesystem::path &snapshot_path, const ConfigBundleSnapshotHeader &header,
+    boost::property_tree::ptree &tree, std::vector<DynamicPrintConfig> &configs)
+{
+    if (! boost::filesystem::exists(snapshot_path))
+        return false;
+    try {
+        boost::nowide::ifstream ifs(snapshot_path.string(), std::ios::binary);
+        ConfigBundleSnapshotHeader snapshot_header;
+        {
+            cereal::BinaryInputArchive archive(ifs);
+            archive(snapshot_header);
+        }
+        if (! snapshot_header.matches(header))
+            return false;
+        // Verify the payload before deserializing any of it.
+        if (snapshot_header.payload_size > boost::filesystem::file_size(snapshot_path)) {
+            BOOST_LOG_TRIVIAL(error) << "Config bundle snapshot " << snapshot_path.string() << " is truncated";
+            return false;
+        }
+        std::string payload(size_t(snapshot_header.payload_size), '\0');
+        boost::crc_32_type crc;
+        if (ifs.read(payload.data(), payload.size()))
+            crc.process_bytes(payload.data(), payload.size());
+        if (! ifs || crc.checksum() != snapshot_header.payload_crc) {
+            BOOST_LOG_TRIVIAL(error) << "Config bundle snapshot " << snapshot_path.string() << " is damaged";
+            return false;
+        }
+        std::istringstream iss(std::move(payload));
+        cereal::BinaryInputArchive archive(iss);
+        size_t num_sections;
+        archive(num_sections);
+        for (size_t i = 0; i < num_sections; ++ i) {
+            std::string name, data;
+            size_t      num_keys;
+            archive(name, data, num_keys);
+            boost::property_tree::ptree &section = tree.push_back(std::make_pair(name, boost::property_tree::ptree(data)))->second;
+            for (size_t j = 0; j < num_keys; ++ j) {
+                std::string key, value;
+                archive(key, value);
+                section.push_back(std::make_pair(key, boost::property_tree::ptree(value)));
+            }
+        }
+        archive(configs);
+    } catch (const std::exception &ex) {
+        BOOST_LOG_TRIVIAL(error) << "Failed loading config bundle snapshot " << snapshot_path.string() << ": " << ex.what();
+        tree.clear();
+        configs.clear();
+        return false;
+    }
+    return true;
+}
+
+// Save the flattened config bundle tree with the preset sections stripped down to "alias" and "renamed_from",
+// and the parsed configs of the preset sections.
+static void save_config_bundle_snapshot(const boost::filesystem::path &snapshot_path, const ConfigBundleSnapshotHeader &header,
+    const boost::property_tree::ptree &tree, const std::vector<DynamicPrintConfig> &configs)
+{
+    // Unique name of the temporary file, so that concurrently running instances do not write into the same file.
+    const boost::filesystem::path tmp_path = snapshot_path.parent_path() / boost::filesystem::unique_path(snapshot_path.filename().string() + ".%%%%-%%%%-%%%%.tmp");
+    try {
+        boost::filesystem::create_directories(snapshot_path.parent_path());
+        std::ostringstream payload;
+        {
+            cereal::BinaryOutputArchive archive(payload);
+            archive(tree.size());
+            for (const auto &section : tree) {
+                const bool preset_section = is_config_bundle_preset_section(section.first);
+                size_t     num_keys       = 0;
+                for (const auto &kvp : section.second)
+                    if (! preset_section || kvp.first == "alias" || kvp.first == "renamed_from")
+                        ++ num_keys;
+                archive(section.first, section.second.data(), num_keys);
+                for (const auto &kvp : section.second)
+                    if (! preset_section || kvp.first == "alias" || kvp.first == "renamed_from")
+                        archive(kvp.first, kvp.second.data());
+            }
+            archive(configs);
+        }
+        const std::string payload_data = payload.str();
+        ConfigBundleSnapshotHeader snapshot_header = header;
+        snapshot_header.payload_size = payload_data.size();
+        boost::crc_32_type crc;
+        crc.process_bytes(payload_data.data(), payload_data.size());
+        snapshot_header.payload_crc = crc.checksum();
+        {
+            boost::nowide::ofstream ofs(tmp_path.string(), std::ios::binary);
+            {
+                cereal::BinaryOutputArchive archive(ofs);
+                archive(snapshot_header);
+            }
+            ofs.write(payload_data.data(), payload_data.size());
+            if (! ofs)
+                throw Slic3r::RuntimeError("Write error");
+        }
+        boost::filesystem::rename(tmp_path, snapshot_path);
+    } catch (const std::exception &ex) {
+        BOOST_LOG_TRIVIAL(error) << "Failed saving config bundle snapshot " << snapshot_path.string() << ": " << ex.what();
+        boost::system::error_code ec;
+        boost::filesystem::remove(tmp_path, ec);
+    }
+}
+
+// Read a subset of a system config bundle into tree: The sections, which are not print / filament / printer presets,
+// the presets named in preset_names and the presets they inherit from. The rest of the file is only scanned
+// for the section headers, it is neither parsed nor flattened.
+static void read_configbundle_subset(std::istream &is, const std::set<std::string> &preset_names, boost::property_tree::ptree &tree)
+{
+    const std::string data { std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>() };
+
+    // Index the sections by their offsets. The keys above the first section header belong to the root of the tree.
+    struct Section {
+        std::string name;
+        size_t      begin;
+        size_t      end;
+    };
+    std::vector<Section> sections;
+    size_t               root_end = data.size();
+    for (size_t line_begin = 0; line_begin < data.size();) {
+        size_t line_end = std::min(data.find('\n', line_begin), data.size());
+        size_t i        = data.find_first_not_of(" \t\r", line_begin);
+        if (i < line_end && data[i] == '[') {
+            if (size_t j = data.find(']', i); j < line_end) {
+                (sections.empty() ? root_end : sections.back().end) = line_begin;
+                sections.push_back({ boost::trim_copy(data.substr(i + 1, j - i - 1)), line_begin, data.size() });
+            }
+        }
+        line_begin = line_end + 1;
+    }
+
+    // Value of a key of a section, without running the INI parser over the section.
+    auto section_value = [&data](const Section &section, const std::string &key) {
+        size_t line_begin = std::min(data.find('\n', section.begin), section.end);
+        while (line_begin < section.end) {
+            ++ line_begin;
+            size_t line_end = std::min(data.find('\n', line_begin), section.end);
+            if (size_t eq = data.find('=', line_begin); eq < line_end && boost::trim_copy(data.substr(line_begin, eq - line_begin)) == key)
+                return boost::trim_copy(data.substr(eq + 1, line_end - eq - 1));
+            line_begin = line_end;
+        }
+        return std::string();
+    };
+
+    // Select the requested presets, then follow their inheritance chains.
+    std::unordered_map<std::string, size_t> preset_sections;
+    std::vector<char>                       selected(sections.size(), false);
+    std::vector<size_t>                     queue;
+    for (size_t i = 0; i < sections.size(); ++ i) {
+        const std::string &name = sections[i].name;
+        if (is_config_bundle_preset_section(name)) {
+            preset_sections.emplace(name, i);
+            std::string preset_name = name.substr(name.find(':') + 1);
+            // Filament presets of a templates profile are loaded with the " @Template" suffix.
+            if (preset_names.find(preset_name) != preset_names.end() || preset_names.find(preset_name + " @Template") != preset_names.end())
+                queue.emplace_back(i);
+        } else
+            selected[i] = true;
+    }
+    while (! queue.empty()) {
+        const size_t idx = queue.back();
+        queue.pop_back();
+        if (selected[idx])
+            continue;
+        selected[idx] = true;
+        std::vector<std::string> inherits;
+        if (Slic3r::unescape_strings_cstyle(section_value(sections[idx], "inherits"), inherits)) {
+            const std::string group = sections[idx].name.substr(0, sections[idx].name.find(':') + 1);
+            for (const std::string &parent : inherits)
+                if (auto it = preset_sections.find(group + parent); it != preset_sections.end())
+                    queue.emplace_back(it->second);
+        }
+    }
+
+    std::string subset = data.substr(0, root_end);
+    for (size_t i = 0; i < sections.size(); ++ i)
+        if (selected[i])
+            subset.append(data, sections[i].begin, sections[i].end - sections[i].begin);
+    try {
+        std::istringstream iss(subset);
+        boost::property_tree::read_ini(iss, tree);
+    } catch (const boost::property_tree::ini_parser::ini_parser_error &) {
+        // Parse the complete file to report the error at the right line.
+        tree.clear();
+        std::istringstream iss(data);
+        boost::property_tree::read_ini(iss, tree);
+    }
+}
+
 // Load a config bundle file, into presets and store the loaded presets into separate files
 // of the local configuration directory.
 std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_configbundle(
@@ -1434,12 +1749,34 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_configbundle(
         this->reset(flags.has(LoadConfigBundleAttribute::SaveImported));
 
     // 1) Read the complete config file into a boost::property_tree.
+    // A system config bundle is loaded from its binary snapshot if the snapshot is up to date.
     namespace pt = boost::property_tree;
     pt::ptree tree;
-    {
+    // If system_presets_filter is set, only the filtered presets of a system config bundle are loaded, see read_configbundle_subset().
+    const bool                      load_subset  = flags.has(LoadConfigBundleAttribute::LoadSystem) && ! this->system_presets_filter.empty();
+    const bool                      use_snapshot = flags.has(LoadConfigBundleAttribute::LoadSystem) && ! flags.has(LoadConfigBundleAttribute::LoadVendorOnly) && ! load_subset;
+    ConfigBundleSnapshotHeader      snapshot_header;
+    boost::filesystem::path         snapshot_path;
+    // Parsed configs of the preset sections, either loaded from the snapshot or collected to be saved into the snapshot.
+    std::vector<DynamicPrintConfig> snapshot_configs;
+    bool                            snapshot_loaded = false;
+    if (use_snapshot) {
+        try {
+            snapshot_header = config_bundle_snapshot_header(path);
+            snapshot_path   = config_bundle_snapshot_path(path);
+            snapshot_loaded = load_config_bundle_snapshot(snapshot_path, snapshot_header, tree, snapshot_configs);
+        } catch (const std::exception &ex) {
+            BOOST_LOG_TRIVIAL(error) << "Failed validating config bundle snapshot for \"" << path << "\": " << ex.what();
+            snapshot_path.clear();
+        }
+    }
+    if (! snapshot_loaded) {
         boost::nowide::ifstream ifs(path);
         try {
-            pt::read_ini(ifs, tree);
+            if (load_subset)
+                read_configbundle_subset(ifs, this->system_presets_filter, tree);
+            else
+                pt::read_ini(ifs, tree);
         } catch (const boost::property_tree::ini_parser::ini_parser_error &err) {
             throw Slic3r::RuntimeError(format("Failed loading config bundle \"%1%\"\nError: \"%2%\" at line %3%", path, err.message(), err.line()).c_str());
         }
@@ -1463,7 +1800,9 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_configbundle(
 
     // 1.5) Flatten the config bundle by applying the inheritance rules. Internal profiles (with names starting with '*') are removed.
     // If loading a user config bundle, do not flatten with the system profiles, but keep the "inherits" flag intact.
-    flatten_configbundle_hierarchy(tree, flags.has(LoadConfigBundleAttribute::LoadSystem) ? nullptr : this);
+    // The snapshot stores the flattened config bundle.
+    if (! snapshot_loaded)
+        flatten_configbundle_hierarchy(tree, flags.has(LoadConfigBundleAttribute::LoadSystem) ? nullptr : this);
 
     // 2) Parse the property_tree, extract the active preset names and the profiles, save them into local config files.
     // Parse the obsolete preset names, to be deleted when upgrading from the old configuration structure.
@@ -1481,6 +1820,7 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_configbundle(
     std::string              active_physical_printer;
     size_t                   presets_loaded = 0;
     size_t                   ph_printers_loaded = 0;
+    size_t                   preset_sections = 0;
 
     for (const auto &section : tree) {
         PresetCollection         *presets = nullptr;
@@ -1573,18 +1913,22 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_configbundle(
                         config.set_deserialize(kvp.first, kvp.second.data(), substitution_context);
                     }
                 };
-                if (presets == &this->printers) {
-                    // Select the default config based on the printer_technology field extracted from kvp.
-                    DynamicPrintConfig config_src;
-                    parse_config_section(config_src);
-                    default_config = &presets->default_preset_for(config_src).config;
-                    config = *default_config;
-                    config.apply(config_src);
-                } else {
-                    default_config = &presets->default_preset().config;
-                    config = *default_config;
-                    parse_config_section(config);
+                // Parse the section first, then apply it over the default config, so that the parsed section may be stored into the snapshot.
+                // If loaded from the snapshot, only "alias" and "renamed_from" are left in the section, the rest comes parsed.
+                DynamicPrintConfig config_src;
+                if (snapshot_loaded) {
+                    if (preset_sections >= snapshot_configs.size())
+                        throw ConfigurationError("Config bundle snapshot is inconsistent");
+                    config_src = std::move(snapshot_configs[preset_sections]);
                 }
+                parse_config_section(config_src);
+                if (! snapshot_loaded && ! snapshot_path.empty())
+                    snapshot_configs.emplace_back(config_src);
+                ++ preset_sections;
+                // Select the default printer config based on the printer_technology field extracted from kvp.
+                default_config = presets == &this->printers ? &presets->default_preset_for(config_src).config : &presets->default_preset().config;
+                config = *default_config;
+                config.apply(config_src);
             } catch (const ConfigurationError &e) {
                 throw ConfigurationError(format("Invalid configuration bundle \"%1%\", section [%2%]: ", path, section.first) + e.what());
             }
@@ -1734,6 +2078,10 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_configbundle(
         }
     }
 
+    // Save the snapshot of a system config bundle, unless some values had to be substituted, which would not be reported when loading from the snapshot.
+    if (! snapshot_loaded && ! snapshot_path.empty() && substitutions.empty())
+        save_config_bundle_snapshot(snapshot_path, snapshot_header, tree, snapshot_configs);
+
     // 3) Activate the presets and physical printer if any exists.
     if (! flags.has(LoadConfigBundleAttribute::LoadSystem)) {
         if (! active_print.empty()) 
@@ -110,6 +110,12 @@ public:
 
     std::set<std::string>       tmp_installed_presets;
 
+    // Lazy loading of the system presets for headless runs, which only need a few profiles.
+    // If not empty, only the system presets of these names and the presets they inherit from are loaded
+    // from the vendor config bundles, the other sections of the vendor config bundles are not parsed at all.
+    // load_presets() adds the presets, which the user presets of these names inherit from.
+    std::set<std::string>       system_presets_filter;
+
     bool                        has_defauls_only() const 
         { return prints.has_defaults_only() && filaments.has_defaults_only() && printers.has_defaults_only(); }
 
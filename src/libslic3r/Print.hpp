@@ -332,6 +332,11 @@ public:
     SupportLayer*   add_support_layer(int id, int interface_id, coordf_t height, coordf_t print_z);
     SupportLayerPtrs::iterator insert_support_layer(SupportLayerPtrs::iterator pos, size_t id, size_t interface_id, coordf_t height, coordf_t print_z, coordf_t slice_z);
     void            delete_support_layer(int idx);
+
+    // Summary of the extrusions per layer and region, and the roles of the support extrusions per support layer, used by ToolOrdering.
+    // Collected in parallel on the first call and cached until the extrusions are invalidated.
+    const std::vector<std::vector<LayerRegionToolsUsage>>& layers_tools_usage() const;
+    const std::vector<ExtrusionRole>&                      support_layers_tools_usage() const;
     
     // Initialize the layer_height_profile from the model_object's layer_height_profile, from model_object's layer height table, or from slicing parameters.
     // Returns true, if the layer_height_profile was changed.
@@ -454,6 +459,10 @@ private:
 
     std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> m_adaptive_fill_octrees;
     FillLightning::GeneratorPtr m_lightning_generator;
+
+    // Caches of layers_tools_usage() and support_layers_tools_usage().
+    mutable std::optional<std::vector<std::vector<LayerRegionToolsUsage>>> m_layers_tools_usage;
+    mutable std::optional<std::vector<ExtrusionRole>>                      m_support_layers_tools_usage;
 };
 
 
@@ -232,6 +232,39 @@ static bool custom_per_printz_gcodes_tool_changes_differ(
 	return false;
 }
 
+// Iterate over the pairs of options with equal keys of a static and of a dynamic config, call fn(key, static_opt, dynamic_opt).
+// Both key lists are sorted, thus they are merged in a single pass instead of looking up each option by its name.
+template<typename StaticConfigType, typename Fn>
+static void static_dynamic_config_iterate(const StaticConfigType &lhs, const DynamicConfig &rhs, Fn fn)
+{
+    const t_config_option_keys &keys = lhs.keys_ref();
+    auto                        it   = rhs.cbegin();
+    for (size_t i = 0; i < keys.size() && it != rhs.cend();)
+        if (keys[i] < it->first)
+            ++ i;
+        else if (it->first < keys[i])
+            ++ it;
+        else {
+            assert(lhs.optptr_by_key_idx(i) == lhs.option(keys[i]));
+            fn(keys[i], lhs.optptr_by_key_idx(i), it->second.get());
+            ++ i;
+            ++ it;
+        }
+}
+
+// Returns options differing in the static and in the dynamic config, ignoring options not present in both configs.
+// Equivalent to ConfigBase::diff(), without the lookups by name.
+template<typename StaticConfigType>
+static t_config_option_keys static_dynamic_config_diff(const StaticConfigType &lhs, const DynamicConfig &rhs)
+{
+    t_config_option_keys diff;
+    static_dynamic_config_iterate(lhs, rhs, [&diff](const t_config_option_key &opt_key, const ConfigOption *opt_old, const ConfigOption *opt_new) {
+        if (*opt_old != *opt_new)
+            diff.emplace_back(opt_key);
+    });
+    return diff;
+}
+
 // Collect changes to print config, account for overrides of extruder retract values by filament presets.
 static t_config_option_keys print_config_diffs(
     const PrintConfig        &current_config,
@@ -241,14 +274,10 @@ static t_config_option_keys print_config_diffs(
     const std::vector<std::string> &extruder_retract_keys = print_config_def.extruder_retract_keys();
     const std::string               filament_prefix       = "filament_";
     t_config_option_keys            print_diff;
-    for (const t_config_option_key &opt_key : current_config.keys()) {
-        const ConfigOption *opt_old = current_config.option(opt_key);
+    // Options missing in new_full_config are skipped.
+    //FIXME This may happen when executing some test cases.
+    static_dynamic_config_iterate(current_config, new_full_config, [&](const t_config_option_key &opt_key, const ConfigOption *opt_old, const ConfigOption *opt_new) {
         assert(opt_old != nullptr);
-        const ConfigOption *opt_new = new_full_config.option(opt_key);
-        // assert(opt_new != nullptr);
-        if (opt_new == nullptr)
-            //FIXME This may happen when executing some test cases.
-            continue;
         const ConfigOption *opt_new_filament = std::binary_search(extruder_retract_keys.begin(), extruder_retract_keys.end(), opt_key) ? new_full_config.option(filament_prefix + opt_key) : nullptr;
         if (opt_new_filament != nullptr && ! opt_new_filament->is_nil()) {
             // An extruder retract override is available at some of the filament presets.
@@ -267,7 +296,7 @@ static t_config_option_keys print_config_diffs(
             }
         } else if (*opt_new != *opt_old)
             print_diff.emplace_back(opt_key);
-    }
+    });
 
     return print_diff;
 }
@@ -276,11 +305,13 @@ static t_config_option_keys print_config_diffs(
 static t_config_option_keys full_print_config_diffs(const DynamicPrintConfig &current_full_config, const DynamicPrintConfig &new_full_config)
 {
     t_config_option_keys full_config_diff;
-    for (const t_config_option_key &opt_key : new_full_config.keys()) {
-        const ConfigOption *opt_old = current_full_config.option(opt_key);
-        const ConfigOption *opt_new = new_full_config.option(opt_key);
-        if (opt_old == nullptr || *opt_new != *opt_old)
-            full_config_diff.emplace_back(opt_key);
+    // Merge the two sorted option maps.
+    auto it_old = current_full_config.cbegin();
+    for (auto it_new = new_full_config.cbegin(); it_new != new_full_config.cend(); ++ it_new) {
+        while (it_old != current_full_config.cend() && it_old->first < it_new->first)
+            ++ it_old;
+        if (it_old == current_full_config.cend() || it_old->first != it_new->first || *it_new->second != *it_old->second)
+            full_config_diff.emplace_back(it_new->first);
     }
     return full_config_diff;
 }
@@ -1090,8 +1121,8 @@ Print::ApplyStatus Print::apply(const Model &model, DynamicPrintConfig new_full_
         full_config_diff.clear();
 
     // Collect changes to object and region configs.
-    t_config_option_keys object_diff      = m_default_object_config.diff(new_full_config);
-    t_config_option_keys region_diff      = m_default_region_config.diff(new_full_config);
+    t_config_option_keys object_diff      = static_dynamic_config_diff(m_default_object_config, new_full_config);
+    t_config_option_keys region_diff      = static_dynamic_config_diff(m_default_region_config, new_full_config);
 
     // Check if the print config change will produce any warnings.
     validate_print_config_change(m_config, new_full_config, warnings);
@@ -4802,6 +4802,17 @@ void PrintConfigDef::init_sla_params()
     def->mode = comExpert;
     def->set_default_value(new ConfigOptionFloat(2.0));
 
+    def = this->add("slice_level_csg", coBool);
+    def->label = L("Slice level booleans");
+    def->category = L("Advanced");
+    def->tooltip = L(
+        "Negative volumes, the hollowed interior and the drain holes are subtracted "
+        "from the slices only, no 3D booleans of the meshes are calculated. This is "
+        "much faster for objects with many holes or negative volumes. The preview "
+        "and the supports are then generated from a mesh reconstructed from the slices.");
+    def->mode = comExpert;
+    def->set_default_value(new ConfigOptionBool(false));
+
     def = this->add("material_print_speed", coEnum);
     def->label = L("Print speed");
     def->tooltip = L(
@@ -5976,6 +5987,13 @@ CLIMiscConfigDef::CLIMiscConfigDef()
     def->tooltip = L("Sets the maximum number of threads the slicing process will use. If not defined, it will be decided automatically.");
     def->min = 1;
 
+    def = this->add("compression_level", coInt);
+    def->label = L("3MF compression level");
+    def->tooltip = L("Sets the compression level of exported 3MF files from 1 (fastest) to 9 (smallest). "
+        "If not defined, the default level 6 is used.");
+    def->min = 1;
+    def->max = 9;
+
     def = this->add("loglevel", coInt);
     def->label = L("Logging level");
     def->tooltip = L("Sets logging sensitivity. 0:fatal, 1:error, 2:warning, 3:info, 4:debug, 5:trace\n"
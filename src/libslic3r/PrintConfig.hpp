@@ -398,6 +398,8 @@ public:
     const ConfigDef*    def() const override { return &print_config_def; }
     // Reference to the cached list of keys.
     virtual const t_config_option_keys& keys_ref() const = 0;
+    // Option stored under keys_ref()[idx], resolved without a lookup by name.
+    virtual const ConfigOption*         optptr_by_key_idx(size_t idx) const = 0;
 
 protected:
     // Verify whether the opt_key has not been obsoleted or renamed.
@@ -447,6 +449,13 @@ protected:
             return (it == m_map_name_to_offset.end()) ? nullptr : reinterpret_cast<const ConfigOption*>((const char*)owner + it->second);
         }
 
+        // Option stored under keys()[idx].
+        const ConfigOption* optptr(size_t idx, const T *owner) const
+        {
+            assert(idx < m_offsets.size());
+            return reinterpret_cast<const ConfigOption*>((const char*)owner + m_offsets[idx]);
+        }
+
         const std::vector<std::string>& keys()      const { return m_keys; }
         const T&                        defaults()  const { return *m_defaults; }
 
@@ -459,6 +468,8 @@ protected:
             m_defaults = defaults;
             m_keys.clear();
             m_keys.reserve(m_map_name_to_offset.size());
+            m_offsets.clear();
+            m_offsets.reserve(m_map_name_to_offset.size());
             for (const auto &kvp : defs->options) {
                 // Find the option given the option name kvp.first by an offset from (char*)m_defaults.
                 ConfigOption *opt = this->optptr(kvp.first, m_defaults);
@@ -466,6 +477,7 @@ protected:
                     // This option is not defined by the ConfigBase of type T.
                     continue;
                 m_keys.emplace_back(kvp.first);
+                m_offsets.emplace_back((const char*)opt - (const char*)m_defaults);
                 const ConfigOptionDef *def = defs->get(kvp.first);
                 assert(def != nullptr);
                 if (def->default_value)
@@ -475,7 +487,10 @@ protected:
 
     private:
         T                                  *m_defaults;
+        // Sorted, as they are collected from ConfigDef::options.
         std::vector<std::string>            m_keys;
+        // Offsets of the options named m_keys.
+        std::vector<ptrdiff_t>              m_offsets;
     };
 };
 
@@ -490,6 +505,7 @@ public: \
     /* Overrides ConfigBase::keys(). Collect names of all configuration values maintained by this configuration store. */ \
     t_config_option_keys     keys() const override { return s_cache_##CLASS_NAME.keys(); } \
     const t_config_option_keys& keys_ref() const override { return s_cache_##CLASS_NAME.keys(); } \
+    const ConfigOption*      optptr_by_key_idx(size_t idx) const override { return s_cache_##CLASS_NAME.optptr(idx, this); } \
     static const CLASS_NAME& defaults() { assert(s_cache_##CLASS_NAME.initialized()); return s_cache_##CLASS_NAME.defaults(); } \
 private: \
     friend int print_config_static_initializer(); \
@@ -1040,6 +1056,10 @@ PRINT_CONFIG_CLASS_DEFINE(
     ((ConfigOptionFloat, slice_closing_radius))
     ((ConfigOptionEnum<SlicingMode>, slicing_mode))
 
+    // Negative volumes, hollowing interior and drill holes are only evaluated
+    // on the slices, no mesh booleans are performed.
+    ((ConfigOptionBool, slice_level_csg))
+
     // Enabling or disabling support creation
     ((ConfigOptionBool,  supports_enable))
 
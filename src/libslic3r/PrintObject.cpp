@@ -677,11 +677,13 @@ void PrintObject::clear_layers()
     for (Layer *l : m_layers)
         delete l;
     m_layers.clear();
+    m_layers_tools_usage.reset();
 }
 
 Layer* PrintObject::add_layer(int id, coordf_t height, coordf_t print_z, coordf_t slice_z)
 {
     m_layers.emplace_back(new Layer(id, this, height, print_z, slice_z));
+    m_layers_tools_usage.reset();
     return m_layers.back();
 }
 
@@ -690,19 +692,52 @@ void PrintObject::clear_support_layers()
     for (Layer *l : m_support_layers)
         delete l;
     m_support_layers.clear();
+    m_support_layers_tools_usage.reset();
 }
 
 SupportLayer* PrintObject::add_support_layer(int id, int interface_id, coordf_t height, coordf_t print_z)
 {
     m_support_layers.emplace_back(new SupportLayer(id, interface_id, this, height, print_z, -1));
+    m_support_layers_tools_usage.reset();
     return m_support_layers.back();
 }
 
 SupportLayerPtrs::iterator PrintObject::insert_support_layer(SupportLayerPtrs::iterator pos, size_t id, size_t interface_id, coordf_t height, coordf_t print_z, coordf_t slice_z)
 {
+    m_support_layers_tools_usage.reset();
     return m_support_layers.insert(pos, new SupportLayer(id, interface_id, this, height, print_z, slice_z));
 }
 
+const std::vector<std::vector<LayerRegionToolsUsage>>& PrintObject::layers_tools_usage() const
+{
+    if (! m_layers_tools_usage) {
+        std::vector<std::vector<LayerRegionToolsUsage>> usage(m_layers.size());
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, m_layers.size()), [this, &usage](const tbb::blocked_range<size_t> &range) {
+            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+                const Layer &layer = *m_layers[layer_idx];
+                usage[layer_idx].reserve(layer.regions().size());
+                for (const LayerRegion *layerm : layer.regions())
+                    usage[layer_idx].emplace_back(LayerRegionToolsUsage::collect(*layerm));
+            }
+        });
+        m_layers_tools_usage = std::move(usage);
+    }
+    return *m_layers_tools_usage;
+}
+
+const std::vector<ExtrusionRole>& PrintObject::support_layers_tools_usage() const
+{
+    if (! m_support_layers_tools_usage) {
+        std::vector<ExtrusionRole> roles(m_support_layers.size(), ExtrusionRole::None);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, m_support_layers.size()), [this, &roles](const tbb::blocked_range<size_t> &range) {
+            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx)
+                roles[layer_idx] = m_support_layers[layer_idx]->support_fills.role();
+        });
+        m_support_layers_tools_usage = std::move(roles);
+    }
+    return *m_support_layers_tools_usage;
+}
+
 // Called by Print::apply().
 // This method only accepts PrintObjectConfig and PrintRegionConfig option keys.
 bool PrintObject::invalidate_state_by_config_options(
@@ -959,6 +994,12 @@ bool PrintObject::invalidate_state_by_config_options(
 bool PrintObject::invalidate_step(PrintObjectStep step)
 {
 	bool invalidated = Inherited::invalidate_step(step);
+
+    // The extrusions summarized for the tool ordering will be regenerated.
+    if (step == posSlice || step == posPerimeters || step == posPrepareInfill || step == posInfill || step == posIroning)
+        m_layers_tools_usage.reset();
+    if (step == posSlice || step == posSupportMaterial)
+        m_support_layers_tools_usage.reset();
     
     // propagate to dependent steps
     if (step == posPerimeters) {
@@ -997,6 +1038,8 @@ bool PrintObject::invalidate_all_steps()
     bool result = Inherited::invalidate_all_steps() | m_print->invalidate_all_steps();
 	// Then reset some of the depending values.
 	m_slicing_params.valid = false;
+    m_layers_tools_usage.reset();
+    m_support_layers_tools_usage.reset();
 	return result;
 }
 
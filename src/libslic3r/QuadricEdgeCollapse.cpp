@@ -6,13 +6,16 @@
 
 #include <oneapi/tbb/blocked_range.h>
 #include <oneapi/tbb/parallel_for.h>
+#include <oneapi/tbb/parallel_sort.h>
 #include <tuple>
 #include <optional>
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cmath>
 #include <iterator>
 #include <limits>
+#include <numeric>
 #include <utility>
 #include <vector>
 #include <cassert>
@@ -121,6 +124,17 @@ namespace QuadricEdgeCollapse {
     };
     using CopyEdgeInfos = std::vector<CopyEdgeInfo>;
 
+    // edge selected for collapse by the parallel simplification
+    struct Collapse {
+        uint32_t ti0 = 0, ti1 = 0; // triangles removed by the collapse
+        uint32_t vi0 = 0, vi1 = 0; // vertex vi1 is merged into vertex vi0, vi0 < vi1
+        Vec3f new_vertex;
+        float error = 0.f;
+        Collapse() = default;
+        bool is_valid() const { return ti0 != ti1; }
+    };
+    using Collapses = std::vector<Collapse>;
+
     Vec3d create_normal(const Triangle &triangle, const Vertices &vertices);
     std::array<Vec3d,3> create_vertices(uint32_t id_v1, uint32_t id_v2, const Vertices &vertices);
     std::array<double, 3> vertices_error(const SymMat &q, const std::array<Vec3d, 3> &vertices);
@@ -145,12 +159,30 @@ namespace QuadricEdgeCollapse {
     // find edge with smallest error in triangle
     Vec3d calculate_3errors(const Triangle &t, const Vertices &vertices, const VertexInfos &v_infos);
     Error calculate_error(uint32_t ti, const Triangle& t,const Vertices &vertices, const VertexInfos& v_infos, unsigned char& min_index);
+    // select edge with next bigger error when the edge with minimal error can't be collapsed
+    void select_next_edge(Error &e, TriangleInfo &t_info, const Triangle &t, const Vertices &vertices,
+                          const VertexInfos &v_infos, float maximal_error);
     void remove_triangle(EdgeInfos &e_infos, VertexInfo &v_info, uint32_t ti);
     void change_neighbors(EdgeInfos &e_infos, VertexInfos &v_infos, uint32_t ti0, uint32_t ti1,
                           uint32_t vi0, uint32_t vi1, uint32_t vi_top0,
                           const Triangle &t1, CopyEdgeInfos& infos, EdgeInfos &e_infos1);
     void compact(const VertexInfos &v_infos, const TriangleInfos &t_infos, const EdgeInfos &e_infos, indexed_triangle_set &its);
 
+    // Parallel simplification
+    // Check the collapse of the minimal error edge of triangle ti0 without modification of the neighbors,
+    // neighbors are used as a buffer for a copy of the both vertices neighborhoods.
+    bool create_collapse(uint32_t ti0, const indexed_triangle_set &its, const TriangleInfos &t_infos,
+                         const VertexInfos &v_infos, const EdgeInfos &e_infos, EdgeInfos &neighbors, Collapse &collapse);
+    // Call fn for each vertex of triangles around both vertices of the collapsed edge
+    template<typename Fn>
+    void for_each_neighbor_vertex(const Collapse &c, const VertexInfos &v_infos, const EdgeInfos &e_infos,
+                                  const Indices &indices, Fn &&fn);
+    // Recreate vertex neighbors after the collapses of one round.
+    // merged[vi] is the vertex merged into the vertex vi, merged[vi] == vi for the removed vertex,
+    // merged is reset to no_merge.
+    void rebuild_neighbors(const TriangleInfos &t_infos, VertexInfos &v_infos, EdgeInfos &e_infos,
+                           std::vector<uint32_t> &merged, uint32_t no_merge);
+
 #ifdef EXPENSIVE_DEBUG_CHECKS
     void store_surround(const char *obj_filename, size_t triangle_index, int depth, const indexed_triangle_set &its,
                         const VertexInfos &v_infos, const EdgeInfos &e_infos);
@@ -278,25 +310,7 @@ void Slic3r::its_quadric_edge_collapse(
             is_flipped(new_vertex0, ti0, ti1, v_info0, t_infos, e_infos, its) ||
             is_flipped(new_vertex0, ti0, ti1, v_info1, t_infos, e_infos, its)) {
             // try other triangle's edge
-            Vec3d errors = calculate_3errors(t0, its.vertices, v_infos);
-            Vec3i ord = (errors[0] < errors[1]) ? 
-                ((errors[0] < errors[2])? 
-                    ((errors[1] < errors[2]) ? Vec3i(0, 1, 2) : Vec3i(0, 2, 1)) :
-                    Vec3i(2, 0, 1)):
-                ((errors[1] < errors[2])?
-                    ((errors[0] < errors[2]) ? Vec3i(1, 0, 2) : Vec3i(1, 2, 0)) :
-                    Vec3i(2, 1, 0));
-            if (t_info0.min_index == ord[0]) { 
-                t_info0.min_index = ord[1];
-                e.value = errors[t_info0.min_index];
-            } else if (t_info0.min_index == ord[1]) {
-                t_info0.min_index = ord[2];
-                e.value = errors[t_info0.min_index];
-            } else {
-                // error is changed when surround edge is reduced
-                t_info0.min_index = 3; // bad index -> invalidate
-                e.value           = maximal_error;
-            }
+            select_next_edge(e, t_info0, t0, its.vertices, v_infos, maximal_error);
             // IMPROVE: check mpq top if it is ti1 with same edge
             mpq.push(e);
             continue;
@@ -362,6 +376,208 @@ void Slic3r::its_quadric_edge_collapse(
     if (max_error != nullptr) *max_error = last_collapsed_error;
 }
 
+void Slic3r::its_quadric_edge_collapse_parallel(
+    indexed_triangle_set &                   its,
+    uint32_t                                 triangle_count,
+    float *                                  max_error,
+    std::function<void(void)>                throw_on_cancel,
+    std::function<void(int)>                 status_fn,
+    const QuadricEdgeCollapseParallelConfig &config)
+{
+    // check input
+    if (triangle_count >= its.indices.size()) return;
+    float maximal_error = (max_error == nullptr)? std::numeric_limits<float>::max() : *max_error;
+    if (maximal_error <= 0.f) return;
+    if (throw_on_cancel == nullptr) throw_on_cancel = []() {};
+    if (status_fn == nullptr) status_fn = [](int) {};
+    float    batch_ratio          = std::clamp(config.batch_ratio, 0.f, 1.f);
+    uint32_t max_selection_passes = std::max(config.max_selection_passes, uint32_t(1));
+
+    StatusFn init_status_fn = [&](int percent) {
+        float n_percent = percent * status_init_size / 100.f;
+        status_fn(static_cast<int>(std::round(n_percent)));
+    };
+
+    TriangleInfos t_infos; // only normals with information about deleted triangle
+    VertexInfos   v_infos;
+    EdgeInfos     e_infos;
+    Errors        errors;
+    std::tie(t_infos, v_infos, e_infos, errors) = init(its, throw_on_cancel, init_status_fn);
+    throw_on_cancel();
+    status_fn(status_init_size);
+
+    uint32_t actual_triangle_count = its.indices.size();
+    uint32_t count_triangle_to_reduce = actual_triangle_count - triangle_count;
+    auto increase_status = [&]() { 
+        double reduced = (actual_triangle_count - triangle_count) /
+                         (double) count_triangle_to_reduce;
+        double status = status_init_size + (100 - status_init_size) *
+                        (1. - reduced);            
+        status_fn(static_cast<int>(std::round(status)));
+    };
+
+    // Owner of the vertex during selection of the independent collapses is the collapse with the lowest rank
+    // touching the vertex neighborhood. Rank is the index of the collapse shifted by one,
+    // zero locks the neighborhood of the already selected collapse.
+    const uint32_t free_vertex   = std::numeric_limits<uint32_t>::max();
+    const uint32_t locked_vertex = 0;
+    std::vector<std::atomic<uint32_t>> owners(its.vertices.size());
+    auto set_owner = [&owners](uint32_t vi, uint32_t rank) {
+        uint32_t owner = owners[vi].load(std::memory_order_relaxed);
+        while (rank < owner && !owners[vi].compare_exchange_weak(owner, rank, std::memory_order_relaxed));
+    };
+    // vertex merged into the vertex by collapse in the actual round
+    std::vector<uint32_t> merged(its.vertices.size(), free_vertex);
+
+    Errors                candidates;
+    Collapses             collapses;
+    std::vector<uint32_t> active, next_active, selected;
+    auto less = [](const Error &e1, const Error &e2) -> bool {
+        return e1.value < e2.value || (e1.value == e2.value && e1.triangle_index < e2.triangle_index);
+    };
+
+    float max_collapsed_error = 0.f;
+    while (actual_triangle_count > triangle_count) {
+        throw_on_cancel();
+
+        // the lowest errors of triangles
+        candidates.clear();
+        for (const Error &e : errors)
+            if (!t_infos[e.triangle_index].is_deleted() && e.value < maximal_error)
+                candidates.push_back(e);
+        if (candidates.empty()) break;
+        size_t batch_size = std::clamp<size_t>(
+            static_cast<size_t>(std::ceil(batch_ratio * candidates.size())), 1, candidates.size());
+        if (batch_size < candidates.size())
+            std::nth_element(candidates.begin(), candidates.begin() + batch_size, candidates.end(), less);
+        candidates.resize(batch_size);
+        tbb::parallel_sort(candidates.begin(), candidates.end(), less);
+
+        // check collapses, triangles with edge which can't be collapsed try other edge in next round
+        collapses.assign(batch_size, Collapse());
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, batch_size),
+        [&](const tbb::blocked_range<size_t> &range) {
+            EdgeInfos neighbors;
+            neighbors.reserve(2 * max_triangle_count_for_one_vertex);
+            for (size_t i = range.begin(); i < range.end(); ++i) {
+                uint32_t ti0 = candidates[i].triangle_index;
+                if (create_collapse(ti0, its, t_infos, v_infos, e_infos, neighbors, collapses[i])) {
+                    collapses[i].error = candidates[i].value;
+                    continue;
+                }
+                select_next_edge(errors[ti0], t_infos[ti0], its.indices[ti0], its.vertices, v_infos, maximal_error);
+            }
+        }); // END parallel for
+        collapses.erase(std::remove_if(collapses.begin(), collapses.end(),
+                                       [](const Collapse &c) { return !c.is_valid(); }),
+                        collapses.end());
+
+        // select independent collapses, the collapse with lower error has priority
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, owners.size()),
+        [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t vi = range.begin(); vi < range.end(); ++vi)
+                owners[vi].store(free_vertex, std::memory_order_relaxed);
+        }); // END parallel for
+        active.resize(collapses.size());
+        std::iota(active.begin(), active.end(), 0);
+        selected.clear();
+        for (uint32_t pass = 0; pass < max_selection_passes && !active.empty(); ++pass) {
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, active.size()),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i < range.end(); ++i) {
+                    uint32_t rank = active[i] + 1;
+                    for_each_neighbor_vertex(collapses[active[i]], v_infos, e_infos, its.indices,
+                                             [&](uint32_t vi) { set_owner(vi, rank); });
+                }
+            }); // END parallel for
+            // Collapse owning both of its vertices is not in the neighborhood of any other owning collapse.
+            size_t selected_begin = selected.size();
+            for (uint32_t ci : active) {
+                const Collapse &c = collapses[ci];
+                if (owners[c.vi0].load(std::memory_order_relaxed) == ci + 1 &&
+                    owners[c.vi1].load(std::memory_order_relaxed) == ci + 1)
+                    selected.push_back(ci);
+            }
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, active.size()),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i < range.end(); ++i)
+                    for_each_neighbor_vertex(collapses[active[i]], v_infos, e_infos, its.indices, [&](uint32_t vi) {
+                        if (owners[vi].load(std::memory_order_relaxed) != locked_vertex)
+                            owners[vi].store(free_vertex, std::memory_order_relaxed);
+                    });
+            }); // END parallel for
+            tbb::parallel_for(tbb::blocked_range<size_t>(selected_begin, selected.size()),
+            [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i < range.end(); ++i)
+                    for_each_neighbor_vertex(collapses[selected[i]], v_infos, e_infos, its.indices, [&](uint32_t vi) {
+                        owners[vi].store(locked_vertex, std::memory_order_relaxed);
+                    });
+            }); // END parallel for
+            // collapses touching the locked neighborhood have to wait for next round
+            next_active.clear();
+            for (uint32_t ci : active) {
+                const Collapse &c = collapses[ci];
+                if (owners[c.vi0].load(std::memory_order_relaxed) != locked_vertex &&
+                    owners[c.vi1].load(std::memory_order_relaxed) != locked_vertex)
+                    next_active.push_back(ci);
+            }
+            std::swap(active, next_active);
+        }
+        // do not reduce under wanted triangle count
+        std::sort(selected.begin(), selected.end());
+        size_t max_collapse_count = (actual_triangle_count - triangle_count + 1) / 2;
+        if (selected.size() > max_collapse_count) selected.resize(max_collapse_count);
+
+        // collapse, neighborhoods of the selected collapses do not share any triangle
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, selected.size()),
+        [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++i) {
+                const Collapse &c = collapses[selected[i]];
+                VertexInfo &v_info0 = v_infos[c.vi0];
+                const VertexInfo &v_info1 = v_infos[c.vi1];
+                uint32_t v_info1_end = v_info1.start + v_info1.count;
+                for (uint32_t di = v_info1.start; di < v_info1_end; ++di) {
+                    const EdgeInfo &e_info = e_infos[di];
+                    if (e_info.t_index == c.ti0 || e_info.t_index == c.ti1) continue;
+                    its.indices[e_info.t_index][e_info.edge] = c.vi0; // change index
+                }
+                v_info0.q += v_info1.q;
+                its.vertices[c.vi0] = c.new_vertex;
+                t_infos[c.ti0].set_deleted();
+                t_infos[c.ti1].set_deleted();
+                merged[c.vi0] = c.vi1;
+                merged[c.vi1] = c.vi1;
+
+                // fix errors of triangles around new vertex
+                for (uint32_t vi : {c.vi0, c.vi1}) {
+                    const VertexInfo &v_info = v_infos[vi];
+                    uint32_t v_info_end = v_info.start + v_info.count;
+                    for (uint32_t di = v_info.start; di < v_info_end; ++di) {
+                        uint32_t ti = e_infos[di].t_index;
+                        if (ti == c.ti0 || ti == c.ti1) continue;
+                        TriangleInfo &t_info = t_infos[ti];
+                        t_info.n = create_normal(its.indices[ti], its.vertices).cast<float>(); // recalc normals
+                        errors[ti] = calculate_error(ti, its.indices[ti], its.vertices, v_infos, t_info.min_index);
+                    }
+                }
+            }
+        }); // END parallel for
+        for (uint32_t ci : selected)
+            max_collapsed_error = std::max(max_collapsed_error, collapses[ci].error);
+        actual_triangle_count -= 2 * selected.size();
+
+        rebuild_neighbors(t_infos, v_infos, e_infos, merged, free_vertex);
+        increase_status();
+#ifdef EXPENSIVE_DEBUG_CHECKS
+        assert(check_neighbors(its, t_infos, v_infos, e_infos));
+#endif // EXPENSIVE_DEBUG_CHECKS
+    }
+
+    // compact triangle
+    compact(v_infos, t_infos, e_infos, its);
+    if (max_error != nullptr) *max_error = max_collapsed_error;
+}
+
 Vec3d QuadricEdgeCollapse::create_normal(const Triangle &triangle,
                                          const Vertices &vertices)
 {
@@ -743,6 +959,34 @@ Error QuadricEdgeCollapse::calculate_error(uint32_t           ti,
     return Error(static_cast<float>(error[min_index]), ti);    
 }
 
+void QuadricEdgeCollapse::select_next_edge(Error &             e,
+                                           TriangleInfo &      t_info,
+                                           const Triangle &    t,
+                                           const Vertices &    vertices,
+                                           const VertexInfos & v_infos,
+                                           float               maximal_error)
+{
+    Vec3d errors = calculate_3errors(t, vertices, v_infos);
+    Vec3i ord = (errors[0] < errors[1]) ? 
+        ((errors[0] < errors[2])? 
+            ((errors[1] < errors[2]) ? Vec3i(0, 1, 2) : Vec3i(0, 2, 1)) :
+            Vec3i(2, 0, 1)):
+        ((errors[1] < errors[2])?
+            ((errors[0] < errors[2]) ? Vec3i(1, 0, 2) : Vec3i(1, 2, 0)) :
+            Vec3i(2, 1, 0));
+    if (t_info.min_index == ord[0]) { 
+        t_info.min_index = ord[1];
+        e.value = errors[t_info.min_index];
+    } else if (t_info.min_index == ord[1]) {
+        t_info.min_index = ord[2];
+        e.value = errors[t_info.min_index];
+    } else {
+        // error is changed when surround edge is reduced
+        t_info.min_index = 3; // bad index -> invalidate
+        e.value          = maximal_error;
+    }
+}
+
 void QuadricEdgeCollapse::remove_triangle(EdgeInfos & e_infos,
                                           VertexInfo &v_info,
                                           uint32_t      ti)
@@ -879,6 +1123,135 @@ void QuadricEdgeCollapse::compact(const VertexInfos &   v_infos,
     its.indices.erase(its.indices.begin() + ti_new, its.indices.end());
 }
 
+bool QuadricEdgeCollapse::create_collapse(uint32_t                    ti0,
+                                          const indexed_triangle_set &its,
+                                          const TriangleInfos &       t_infos,
+                                          const VertexInfos &         v_infos,
+                                          const EdgeInfos &           e_infos,
+                                          EdgeInfos &                 neighbors,
+                                          Collapse &                  collapse)
+{
+    const TriangleInfo &t_info0 = t_infos[ti0];
+    assert(t_info0.min_index < 3);
+    const Triangle &t0 = its.indices[ti0];
+    uint32_t vi0 = t0[t_info0.min_index];
+    uint32_t vi1 = t0[(t_info0.min_index + 1) % 3];
+    if (vi0 > vi1) std::swap(vi0, vi1);
+    const VertexInfo &v_info0 = v_infos[vi0];
+    const VertexInfo &v_info1 = v_infos[vi1];
+    assert(!v_info0.is_deleted() && !v_info1.is_deleted());
+
+    auto ti1_opt = (v_info0.count < v_info1.count)?
+        find_triangle_index1(vi1, v_info0, ti0, e_infos, its.indices) :
+        find_triangle_index1(vi0, v_info1, ti0, e_infos, its.indices) ;
+    if (!ti1_opt.has_value()) return false; // edge has only one triangle
+    uint32_t ti1 = *ti1_opt;
+
+    // Copy of both neighborhoods with triangles ti0 and ti1 at the end, as the serial collapse reorders them in place.
+    neighbors.assign(e_infos.begin() + v_info0.start, e_infos.begin() + v_info0.start + v_info0.count);
+    neighbors.insert(neighbors.end(), e_infos.begin() + v_info1.start, e_infos.begin() + v_info1.start + v_info1.count);
+    VertexInfo n_info0, n_info1;
+    n_info0.start = 0;
+    n_info0.count = v_info0.count;
+    n_info1.start = v_info0.count;
+    n_info1.count = v_info1.count;
+    reorder_edges(neighbors, n_info0, ti0, ti1);
+    reorder_edges(neighbors, n_info1, ti0, ti1);
+
+    SymMat q(v_info0.q);
+    q += v_info1.q;
+    Vec3f new_vertex0 = calculate_vertex(vi0, vi1, q, its.vertices);
+    if (degenerate(vi0, ti0, ti1, n_info1, neighbors, its.indices) ||
+        degenerate(vi1, ti0, ti1, n_info0, neighbors, its.indices) ||
+        create_no_volume(vi0, vi1, ti0, ti1, n_info0, n_info1, neighbors, its.indices) ||
+        is_flipped(new_vertex0, ti0, ti1, n_info0, t_infos, neighbors, its) ||
+        is_flipped(new_vertex0, ti0, ti1, n_info1, t_infos, neighbors, its))
+        return false;
+
+    collapse.ti0        = ti0;
+    collapse.ti1        = ti1;
+    collapse.vi0        = vi0;
+    collapse.vi1        = vi1;
+    collapse.new_vertex = new_vertex0;
+    return true;
+}
+
+template<typename Fn>
+void QuadricEdgeCollapse::for_each_neighbor_vertex(const Collapse &   c,
+                                                   const VertexInfos &v_infos,
+                                                   const EdgeInfos &  e_infos,
+                                                   const Indices &    indices,
+                                                   Fn &&              fn)
+{
+    for (uint32_t vi : {c.vi0, c.vi1}) {
+        const VertexInfo &v_info = v_infos[vi];
+        uint32_t v_info_end = v_info.start + v_info.count;
+        for (uint32_t di = v_info.start; di < v_info_end; ++di) {
+            const Triangle &t = indices[e_infos[di].t_index];
+            fn(static_cast<uint32_t>(t[0]));
+            fn(static_cast<uint32_t>(t[1]));
+            fn(static_cast<uint32_t>(t[2]));
+        }
+    }
+}
+
+void QuadricEdgeCollapse::rebuild_neighbors(const TriangleInfos &  t_infos,
+                                            VertexInfos &          v_infos,
+                                            EdgeInfos &            e_infos,
+                                            std::vector<uint32_t> &merged,
+                                            uint32_t               no_merge)
+{
+    auto count_alive = [&](const VertexInfo &v_info) {
+        uint32_t count = 0;
+        uint32_t v_info_end = v_info.start + v_info.count;
+        for (uint32_t di = v_info.start; di < v_info_end; ++di)
+            if (!t_infos[e_infos[di].t_index].is_deleted()) ++count;
+        return count;
+    };
+    std::vector<uint32_t> counts(v_infos.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, v_infos.size()),
+    [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t vi = range.begin(); vi < range.end(); ++vi) {
+            uint32_t mvi = merged[vi];
+            if (mvi == vi) continue; // removed vertex
+            counts[vi] = count_alive(v_infos[vi]);
+            if (mvi != no_merge) counts[vi] += count_alive(v_infos[mvi]);
+        }
+    }); // END parallel for
+
+    std::vector<uint32_t> starts(v_infos.size());
+    uint32_t triangle_start = 0;
+    for (size_t vi = 0; vi < v_infos.size(); ++vi) {
+        starts[vi] = triangle_start;
+        triangle_start += counts[vi];
+    }
+
+    EdgeInfos e_infos_new(triangle_start);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, v_infos.size()),
+    [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t vi = range.begin(); vi < range.end(); ++vi) {
+            uint32_t mvi = merged[vi];
+            if (mvi == vi) continue; // removed vertex
+            uint32_t ei = starts[vi];
+            auto copy_alive = [&](const VertexInfo &v_info) {
+                uint32_t v_info_end = v_info.start + v_info.count;
+                for (uint32_t di = v_info.start; di < v_info_end; ++di)
+                    if (!t_infos[e_infos[di].t_index].is_deleted()) e_infos_new[ei++] = e_infos[di];
+            };
+            copy_alive(v_infos[vi]);
+            if (mvi != no_merge) copy_alive(v_infos[mvi]);
+            assert(ei == starts[vi] + counts[vi]);
+        }
+    }); // END parallel for
+
+    for (size_t vi = 0; vi < v_infos.size(); ++vi) {
+        v_infos[vi].start = starts[vi];
+        v_infos[vi].count = counts[vi];
+        merged[vi]        = no_merge;
+    }
+    e_infos = std::move(e_infos_new);
+}
+
 #ifdef EXPENSIVE_DEBUG_CHECKS
 
 // store triangle surrounding to file
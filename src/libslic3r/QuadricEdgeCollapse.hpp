@@ -36,6 +36,39 @@ void its_quadric_edge_collapse(
     std::function<void(void)> throw_on_cancel = nullptr,
     std::function<void(int)>  statusfn        = nullptr);
 
+// Configuration of the parallel simplification
+struct QuadricEdgeCollapseParallelConfig
+{
+    // Portion of the lowest error edges considered for collapse in one round, range (0 .. 1].
+    // Smaller portion follows the order of the serial algorithm more closely (better quality, more rounds),
+    // bigger portion collapses more edges in one round (faster, edges with bigger error may be collapsed sooner).
+    float batch_ratio = 0.1f;
+    // Maximal count of passes selecting the independent set of edges in one round.
+    uint32_t max_selection_passes = 8;
+};
+
+/// <summary>
+/// Simplify mesh by Quadric metric in parallel.
+/// In each round, a maximal independent set of the lowest error edges is collapsed in parallel,
+/// neighborhoods of the collapsed edges do not share any triangle.
+/// Each collapse is validated the same way as by the serial its_quadric_edge_collapse().
+/// </summary>
+/// <param name="its">IN/OUT triangle mesh to be simplified.</param>
+/// <param name="triangle_count">Wanted triangle count.</param>
+/// <param name="max_error">Maximal Quadric for reduce.
+/// When nullptr then max float is used
+/// Output: Biggest error of the collapsed edges</param>
+/// <param name="throw_on_cancel">Could stop process of calculation.</param>
+/// <param name="statusfn">Give a feed back to user about progress. Values 1 - 100</param>
+/// <param name="config">Trade off between quality and speed.</param>
+void its_quadric_edge_collapse_parallel(
+    indexed_triangle_set &                   its,
+    uint32_t                                 triangle_count  = 0,
+    float *                                  max_error       = nullptr,
+    std::function<void(void)>                throw_on_cancel = nullptr,
+    std::function<void(int)>                 statusfn        = nullptr,
+    const QuadricEdgeCollapseParallelConfig &config          = {});
+
 } // namespace Slic3r
 #endif // slic3r_quadric_edge_collapse_hpp_
 
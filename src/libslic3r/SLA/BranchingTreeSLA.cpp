@@ -24,6 +24,7 @@
 #include "libslic3r/Execution/Execution.hpp"
 #include "libslic3r/Execution/ExecutionSeq.hpp"
 #include "libslic3r/Point.hpp"
+#include "libslic3r/SLA/PinheadCache.hpp"
 #include "libslic3r/SLA/SupportTree.hpp"
 #include "libslic3r/SLA/SupportTreeBuilder.hpp"
 #include "libslic3r/libslic3r.h"
@@ -379,9 +380,22 @@ void create_branching_tree(SupportTreeBuilder &builder, const SupportableMesh &s
     std::vector<std::optional<Head>> heads(nondup_idx.size());
     auto leafs = reserve_vector<branchingtree::Node>(nondup_idx.size());
 
+    // Reuse the pinheads calculated by the previous support tree generation.
+    std::vector<size_t> uncached;
+    for (size_t i = 0; i < nondup_idx.size(); ++i) {
+        const std::optional<Head> *cached = sm.pinhead_cache ? sm.pinhead_cache->find(sm.pts[nondup_idx[i]]) : nullptr;
+        if (cached == nullptr)
+            uncached.emplace_back(i);
+        else if (*cached) {
+            heads[i] = **cached;
+            heads[i]->id = long(nondup_idx[i]);
+        }
+    }
+
     execution::for_each(
-        ex_tbb, size_t(0), nondup_idx.size(),
-        [&sm, &heads, &nondup_idx, &builder](size_t i) {
+        ex_tbb, size_t(0), uncached.size(),
+        [&sm, &heads, &nondup_idx, &uncached, &builder](size_t j) {
+            size_t i = uncached[j];
             if (!builder.ctl().stopcondition())
                 heads[i] = calculate_pinhead_placement(ex_seq, sm, nondup_idx[i]);
         },
@@ -391,6 +405,10 @@ void create_branching_tree(SupportTreeBuilder &builder, const SupportableMesh &s
     if (builder.ctl().stopcondition())
         return;
 
+    if (sm.pinhead_cache)
+        for (size_t i = 0; i < nondup_idx.size(); ++i)
+            sm.pinhead_cache->store(sm.pts[nondup_idx[i]], heads[i]);
+
     for (auto &h : heads)
         if (h && h->is_valid()) {
             leafs.emplace_back(h->junction_point().cast<float>(), h->r_back_mm);
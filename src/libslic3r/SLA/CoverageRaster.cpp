@@ -0,0 +1,259 @@
+///|/ Copyright (c) Prusa Research 2024
+///|/
+///|/ PrusaSlicer is released under the terms of the AGPLv3 or higher
+///|/
+#include <libslic3r/SLA/CoverageRaster.hpp>
+
+#include <cassert>
+
+namespace Slic3r { namespace sla {
+
+namespace {
+
+// Number of raster rows accumulated at once. The accumulation buffer spans the width of the polygon's bounding box.
+constexpr int BAND_HEIGHT = 32;
+
+// Polygon edge in pixel coordinates, oriented upwards (y0 < y1). dir keeps the winding of the original edge.
+struct CoverageEdge {
+    float x0, y0, x1, y1;
+    float dir;
+};
+
+// Columns of a row touched by the edges, inclusive.
+using CellSpans = std::vector<std::pair<int, int>>;
+
+// Add the signed area covered by the part of the edge inside the rows <band_y0, band_y1) into the accumulation buffer,
+// starting at row band_y0 and column bx0. The edge is expected to be clipped to the buffer horizontally.
+void accumulate_edge(const CoverageEdge &e, float *acc, size_t stride, int bx0, int band_y0, int band_y1, std::vector<CellSpans> &spans)
+{
+    const float ys = std::max(e.y0, float(band_y0));
+    const float ye = std::min(e.y1, float(band_y1));
+    if (ys >= ye)
+        return;
+
+    const float x_max = float(stride - 2);
+    const float dxdy  = (e.x1 - e.x0) / (e.y1 - e.y0);
+    float       x     = e.x0 + (ys - e.y0) * dxdy - float(bx0);
+    for (int y = int(std::floor(ys)); float(y) < ye; ++ y) {
+        float      *row   = acc + size_t(y - band_y0) * stride;
+        const float dy    = std::min(float(y + 1), ye) - std::max(float(y), ys);
+        const float xnext = x + dxdy * dy;
+        const float d     = dy * e.dir;
+        // Clamping guards against rounding errors only, the edge was clipped to the buffer already.
+        const float xa    = std::clamp(std::min(x, xnext), 0.f, x_max);
+        const float xb    = std::clamp(std::max(x, xnext), 0.f, x_max);
+        const float xa_floor = std::floor(xa);
+        const int   xai   = int(xa_floor);
+        const float xb_ceil = std::ceil(xb);
+        const int   xbi   = int(xb_ceil);
+        if (xbi <= xai + 1) {
+            // The edge crosses a single pixel of this row.
+            const float xmf = 0.5f * (xa + xb) - xa_floor;
+            row[xai]     += d - d * xmf;
+            row[xai + 1] += d * xmf;
+            spans[y - band_y0].emplace_back(xai, xai + 1);
+        } else {
+            // The edge crosses multiple pixels of this row, split the trapezoid.
+            const float s   = 1.f / (xb - xa);
+            const float xaf = xa - xa_floor;
+            const float a0  = 0.5f * s * (1.f - xaf) * (1.f - xaf);
+            const float xbf = xb - xb_ceil + 1.f;
+            const float am  = 0.5f * s * xbf * xbf;
+            row[xai] += d * a0;
+            if (xbi == xai + 2) {
+                row[xai + 1] += d * (1.f - a0 - am);
+            } else {
+                const float a1 = s * (1.5f - xaf);
+                row[xai + 1] += d * (a1 - a0);
+                for (int xi = xai + 2; xi < xbi - 1; ++ xi)
+                    row[xi] += d * s;
+                const float a2 = a1 + float(xbi - xai - 3) * s;
+                row[xbi - 1] += d * (1.f - a2 - am);
+            }
+            row[xbi] += d * am;
+            spans[y - band_y0].emplace_back(xai, xbi);
+        }
+        x = xnext;
+    }
+}
+
+// Same as agg::gray8::lerp(p, 255, alpha).
+inline uint8_t blend_white(uint8_t p, uint8_t alpha)
+{
+    int t = (255 - int(p)) * int(alpha) + 128;
+    return uint8_t(int(p) + (((t >> 8) + t) >> 8));
+}
+
+} // namespace
+
+CoverageRasterGrayscaleAA::CoverageRasterGrayscaleAA(const Resolution &res, const PixelDim &pd, const Trafo &trafo)
+    : m_resolution(res)
+    , m_pxdim_scaled(SCALING_FACTOR, SCALING_FACTOR)
+    , m_trafo(trafo)
+    , m_buf(res.pixels(), uint8_t(0))
+{
+    // Visual Studio compiler gives warnings about possible division by zero.
+    assert(pd.w_mm != 0 && pd.h_mm != 0);
+    if (pd.w_mm != 0 && pd.h_mm != 0) {
+        m_pxdim_scaled.w_mm /= pd.w_mm;
+        m_pxdim_scaled.h_mm /= pd.h_mm;
+    }
+}
+
+void CoverageRasterGrayscaleAA::draw(const ExPolygon &poly)
+{
+    const int   width  = int(m_resolution.width_px);
+    const int   height = int(m_resolution.height_px);
+    if (width == 0 || height == 0)
+        return;
+
+    // Transform the scaled coordinates to pixels the same way AGGRaster::to_path() does.
+    const double cx = m_trafo.center_x * m_pxdim_scaled.w_mm;
+    const double cy = m_trafo.center_y * m_pxdim_scaled.h_mm;
+    auto to_px = [this, cx, cy, width, height](const Point &p) {
+        double x = m_trafo.flipXY ? p.y() * m_pxdim_scaled.h_mm : p.x() * m_pxdim_scaled.w_mm;
+        double y = m_trafo.flipXY ? p.x() * m_pxdim_scaled.w_mm : p.y() * m_pxdim_scaled.h_mm;
+        x += cx;
+        y += cy;
+        if (m_trafo.mirror_x) x = width - x;
+        if (m_trafo.mirror_y) y = height - y;
+        return Vec2f(float(x), float(y));
+    };
+
+    std::vector<CoverageEdge> edges;
+    size_t num_points = poly.contour.size();
+    for (const Polygon &hole : poly.holes)
+        num_points += hole.size();
+    // The clipping may add a few more edges.
+    edges.reserve(num_points + 4);
+    float min_x = float(width), max_x = 0.f;
+    auto add_edge = [&edges, &min_x, &max_x](Vec2f a, Vec2f b) {
+        if (a.y() == b.y())
+            return;
+        min_x = std::min(min_x, std::min(a.x(), b.x()));
+        max_x = std::max(max_x, std::max(a.x(), b.x()));
+        edges.push_back(a.y() < b.y() ? CoverageEdge{ a.x(), a.y(), b.x(), b.y(), 1.f } : CoverageEdge{ b.x(), b.y(), a.x(), a.y(), -1.f });
+    };
+    // Clip the edge to <0, width> horizontally. The parts outside are projected onto the raster boundary,
+    // which keeps the winding of the pixels inside the raster intact.
+    auto add_clipped_edge = [&add_edge, width](Vec2f a, Vec2f b) {
+        const float w = float(width);
+        // Sort the end points by x, but keep the orientation of the edge.
+        const bool reversed = a.x() > b.x();
+        if (reversed)
+            std::swap(a, b);
+        auto add = [&add_edge, reversed](const Vec2f &p, const Vec2f &q) { reversed ? add_edge(q, p) : add_edge(p, q); };
+        auto at_x = [&a, &b](float x) { return Vec2f(x, a.y() + (b.y() - a.y()) * (x - a.x()) / (b.x() - a.x())); };
+        if (a.x() < 0.f) {
+            if (b.x() <= 0.f) {
+                add({ 0.f, a.y() }, { 0.f, b.y() });
+                return;
+            }
+            Vec2f p = at_x(0.f);
+            add({ 0.f, a.y() }, p);
+            a = p;
+        }
+        if (b.x() > w) {
+            if (a.x() >= w) {
+                add({ w, a.y() }, { w, b.y() });
+                return;
+            }
+            Vec2f p = at_x(w);
+            add(p, { w, b.y() });
+            b = p;
+        }
+        add(a, b);
+    };
+    auto add_polygon = [&to_px, &add_clipped_edge](const Polygon &polygon) {
+        if (polygon.size() < 3)
+            return;
+        Vec2f prev = to_px(polygon.points.back());
+        for (const Point &pt : polygon.points) {
+            Vec2f p = to_px(pt);
+            add_clipped_edge(prev, p);
+            prev = p;
+        }
+    };
+    add_polygon(poly.contour);
+    for (const Polygon &hole : poly.holes)
+        add_polygon(hole);
+    if (edges.empty())
+        return;
+
+    std::sort(edges.begin(), edges.end(), [](const CoverageEdge &l, const CoverageEdge &r) { return l.y0 < r.y0; });
+    const int y_begin = std::max(0, int(std::floor(edges.front().y0)));
+    const int y_end   = std::min(height, int(std::ceil(std::max_element(edges.begin(), edges.end(),
+        [](const CoverageEdge &l, const CoverageEdge &r) { return l.y1 < r.y1; })->y1)));
+    if (y_begin >= y_end)
+        return;
+
+    // Accumulation buffer covering the bounding box horizontally, with a spare column for the contributions
+    // right of the last pixel.
+    const int    bx0    = std::max(0, int(std::floor(min_x)));
+    const int    bx1    = std::min(width, int(std::ceil(max_x)));
+    const size_t stride = size_t(bx1 - bx0) + 2;
+    // The accumulation buffer is zeroed again while sweeping the touched cells.
+    std::vector<float>     acc(stride * BAND_HEIGHT, 0.f);
+    std::vector<CellSpans> spans(BAND_HEIGHT);
+
+    // Blend a run of pixels of the same coverage.
+    auto fill_run = [this](uint8_t *dst, int len, float coverage) {
+        const unsigned cover = std::min(unsigned(std::abs(coverage) * 256.f), 255u);
+        if (cover == 0 || len <= 0)
+            return;
+        if (const uint8_t alpha = m_gamma[cover]; alpha == 255)
+            std::fill(dst, dst + len, uint8_t(255));
+        else
+            for (int i = 0; i < len; ++ i)
+                dst[i] = blend_white(dst[i], alpha);
+    };
+
+    std::vector<const CoverageEdge*> active;
+    auto next_edge = edges.begin();
+    const int num_px = bx1 - bx0;
+    for (int band_y0 = y_begin; band_y0 < y_end; band_y0 += BAND_HEIGHT) {
+        const int band_y1 = std::min(band_y0 + BAND_HEIGHT, y_end);
+        // Update the list of edges crossing the band.
+        active.erase(std::remove_if(active.begin(), active.end(), [band_y0](const CoverageEdge *e) { return e->y1 <= float(band_y0); }), active.end());
+        for (; next_edge != edges.end() && next_edge->y0 < float(band_y1); ++ next_edge)
+            if (next_edge->y1 > float(band_y0))
+                active.emplace_back(&*next_edge);
+
+        for (const CoverageEdge *e : active)
+            accumulate_edge(*e, acc.data(), stride, bx0, band_y0, band_y1, spans);
+
+        for (int y = band_y0; y < band_y1; ++ y) {
+            float     *row        = acc.data() + size_t(y - band_y0) * stride;
+            uint8_t   *dst        = m_buf.data() + size_t(y) * size_t(width) + size_t(bx0);
+            CellSpans &row_spans  = spans[y - band_y0];
+            std::sort(row_spans.begin(), row_spans.end());
+            // Prefix sum of the signed area contributions gives the winding weighted coverage of each pixel.
+            // The coverage only changes at the cells touched by the edges, the runs in between are filled at once.
+            float sum = 0.f;
+            int   x   = 0;
+            for (auto it = row_spans.begin(); it != row_spans.end();) {
+                const int first = std::max(x, it->first);
+                int       last  = it->second;
+                // Merge the overlapping spans.
+                for (++ it; it != row_spans.end() && it->first <= last + 1; ++ it)
+                    last = std::max(last, it->second);
+                fill_run(dst + x, std::min(first, num_px) - x, sum);
+                for (int i = first; i <= last; ++ i) {
+                    sum += row[i];
+                    row[i] = 0.f;
+                    if (i < num_px) {
+                        // Non-zero fill rule, coverage quantized the same way as agg::rasterizer_scanline_aa::calculate_alpha(),
+                        // followed by gamma correction and blending the white foreground over the canvas.
+                        const unsigned cover = std::min(unsigned(std::abs(sum) * 256.f), 255u);
+                        dst[i] = blend_white(dst[i], m_gamma[cover]);
+                    }
+                }
+                x = std::min(last + 1, num_px);
+            }
+            fill_run(dst + x, num_px - x, sum);
+            row_spans.clear();
+        }
+    }
+}
+
+}} // namespace Slic3r::sla
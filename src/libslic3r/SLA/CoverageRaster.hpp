@@ -0,0 +1,76 @@
+///|/ Copyright (c) Prusa Research 2024
+///|/
+///|/ PrusaSlicer is released under the terms of the AGPLv3 or higher
+///|/
+#ifndef SLA_COVERAGERASTER_HPP
+#define SLA_COVERAGERASTER_HPP
+
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+#include <libslic3r/SLA/RasterBase.hpp>
+
+namespace Slic3r { namespace sla {
+
+// Anti-aliased monochrome canvas specialised for the axis aligned LCD masks of
+// SLA printers. Fill color is always white and the background is black.
+//
+// Instead of AGG's generic scanline renderer, the signed area covered by the
+// polygon edges is accumulated into a floating point buffer, one band of rows
+// at a time, and the pixel coverage is obtained by a prefix sum over each row.
+// The gamma correction and the blending into the canvas are fused into a single
+// pass through a lookup table. The output matches RasterGrayscaleAA (AGG) within
+// a few levels of grey.
+class CoverageRasterGrayscaleAA : public RasterBase {
+public:
+    template<class GammaFn>
+    CoverageRasterGrayscaleAA(const Resolution &res,
+                              const PixelDim   &pd,
+                              const Trafo      &trafo,
+                              GammaFn         &&gammafn)
+        : CoverageRasterGrayscaleAA(res, pd, trafo)
+    {
+        // Same sampling of the gamma function as agg::rasterizer_scanline_aa::gamma().
+        for (size_t i = 0; i < m_gamma.size(); ++ i)
+            m_gamma[i] = uint8_t(std::lround(std::clamp(double(gammafn(double(i) / 255.)), 0., 1.) * 255.));
+        // Pixels not covered at all are never touched by AGG.
+        m_gamma[0] = 0;
+    }
+
+    Trafo      trafo() const override { return m_trafo; }
+    Resolution resolution() const { return m_resolution; }
+    PixelDim   pixel_dimensions() const
+    {
+        return {SCALING_FACTOR / m_pxdim_scaled.w_mm,
+                SCALING_FACTOR / m_pxdim_scaled.h_mm};
+    }
+
+    void draw(const ExPolygon &poly) override;
+
+    EncodedRaster encode(RasterEncoder encoder) const override
+    {
+        return encoder(m_buf.data(), m_resolution.width_px, m_resolution.height_px, 1);
+    }
+
+    uint8_t read_pixel(size_t col, size_t row) const { return m_buf[row * m_resolution.width_px + col]; }
+
+    void clear() { std::fill(m_buf.begin(), m_buf.end(), uint8_t(0)); }
+
+private:
+    CoverageRasterGrayscaleAA(const Resolution &res, const PixelDim &pd, const Trafo &trafo);
+
+    Resolution               m_resolution;
+    PixelDim                 m_pxdim_scaled; // used for scaled coordinate polygons
+    Trafo                    m_trafo;
+    std::vector<uint8_t>     m_buf;
+    // Pixel coverage (0 to 255) to alpha.
+    std::array<uint8_t, 256> m_gamma;
+};
+
+}} // namespace Slic3r::sla
+
+#endif // SLA_COVERAGERASTER_HPP
@@ -13,6 +13,8 @@
 #include <functional>
 #include <iterator>
 #include <set>
+#include <array>
+#include <map>
 #include <string>
 #include <cassert>
 #include <cstddef>
@@ -20,6 +22,7 @@
 #include "libslic3r/Geometry.hpp"
 #include "libslic3r/Optimize/Optimizer.hpp"
 #include "libslic3r/Point.hpp"
+#include "libslic3r/SLA/PinheadCache.hpp"
 #include "libslic3r/SLA/SpatIndex.hpp"
 #include "libslic3r/SLA/SupportPoint.hpp"
 #include "libslic3r/SLA/SupportTreeStrategies.hpp"
@@ -399,16 +402,6 @@ void DefaultSupportTree::add_pinheads()
         filtered_indices.emplace_back(a.front());
     }
 
-    // calculate the normals to the triangles for filtered points
-    auto nmls = normals(suptree_ex_policy, m_points, m_sm.emesh,
-                        m_sm.cfg.head_front_radius_mm, m_thr,
-                        filtered_indices);
-
-    // Not all of the support points have to be a valid position for
-    // support creation. The angle may be inappropriate or there may
-    // not be enough space for the pinhead. Filtering is applied for
-    // these reasons.
-
     auto heads = reserve_vector<Head>(m_sm.pts.size());
     for (const SupportPoint &sp : m_sm.pts) {
         m_thr();
@@ -422,6 +415,34 @@ void DefaultSupportTree::add_pinheads()
             );
     }
 
+    // Reuse the pinheads calculated by the previous support tree generation,
+    // only the support points not found in the cache are processed further.
+    PinheadCache *cache = m_sm.pinhead_cache;
+    PtIndices     uncached_indices;
+    uncached_indices.reserve(filtered_indices.size());
+    for (unsigned fidx : filtered_indices) {
+        const std::optional<Head> *cached = cache ? cache->find(m_sm.pts[fidx]) : nullptr;
+        if (cached == nullptr)
+            uncached_indices.emplace_back(fidx);
+        else if (*cached) {
+            heads[fidx]    = **cached;
+            heads[fidx].id = fidx;
+        }
+    }
+
+    // calculate the normals to the triangles for filtered points
+    // (an empty selection would mean all the points)
+    auto nmls = uncached_indices.empty() ?
+                    Eigen::MatrixXd{} :
+                    normals(suptree_ex_policy, m_points, m_sm.emesh,
+                            m_sm.cfg.head_front_radius_mm, m_thr,
+                            uncached_indices);
+
+    // Not all of the support points have to be a valid position for
+    // support creation. The angle may be inappropriate or there may
+    // not be enough space for the pinhead. Filtering is applied for
+    // these reasons.
+
     std::function<void(unsigned, size_t, double)> filterfn;
     filterfn = [this, &nmls, &heads, &filterfn](unsigned fidx, size_t i, double back_r) {
         m_thr();
@@ -510,12 +531,16 @@ void DefaultSupportTree::add_pinheads()
     };
 
     execution::for_each(
-        suptree_ex_policy, size_t(0), filtered_indices.size(),
-        [this, &filterfn, &filtered_indices](size_t i) {
-            filterfn(filtered_indices[i], i, m_sm.cfg.head_back_radius_mm);
+        suptree_ex_policy, size_t(0), uncached_indices.size(),
+        [this, &filterfn, &uncached_indices](size_t i) {
+            filterfn(uncached_indices[i], i, m_sm.cfg.head_back_radius_mm);
         },
         execution::max_concurrency(suptree_ex_policy));
 
+    if (cache)
+        for (unsigned fidx : filtered_indices)
+            cache->store(m_sm.pts[fidx], heads[fidx].is_valid() ? std::make_optional(heads[fidx]) : std::nullopt);
+
     for (size_t i = 0; i < heads.size(); ++i)
         if (heads[i].is_valid()) {
             m_builder.add_head(i, heads[i]);
@@ -576,74 +601,185 @@ void DefaultSupportTree::classify()
 
 void DefaultSupportTree::routing_to_ground()
 {
-    ClusterEl cl_centroids;
-    cl_centroids.reserve(m_pillar_clusters.size());
+    std::vector<long> cl_centroids(m_pillar_clusters.size(), SupportTreeNode::ID_UNSET);
+    std::vector<std::pair<bool, long>> cl_pillars(m_pillar_clusters.size(),
+                                                  {true, SupportTreeNode::ID_UNSET});
+
+    // Create a ground pillar for the centroid head of every cluster. These
+    // do not depend on each other so the clusters are processed in parallel,
+    // the results are put into the pillar index afterwards in cluster order.
+    // The pillars get their IDs in the order in which the threads create
+    // them, they are renumbered afterwards as the IDs determine the order in
+    // which interconnect_pillars() processes the pillars.
+    size_t first_pillar = m_builder.pillarcount();
+    execution::for_each(
+        suptree_ex_policy, size_t(0), m_pillar_clusters.size(),
+        [this, &cl_centroids, &cl_pillars](size_t ci) {
+            m_thr();
 
-    for (auto &cl : m_pillar_clusters) {
-        m_thr();
+            const PtIndices &cl = m_pillar_clusters[ci];
+            if (cl.empty()) return;
+
+            // get the current cluster centroid
+            auto &      thr    = m_thr;
+            const auto &points = m_points;
+
+            long lcid = cluster_centroid(
+                cl, [&points](size_t idx) { return points.row(long(idx)); },
+                [thr](const Vec3d &p1, const Vec3d &p2) {
+                    thr();
+                    return distance(Vec2d(p1.x(), p1.y()), Vec2d(p2.x(), p2.y()));
+                });
 
-        // place all the centroid head positions into the index. We
-        // will query for alternative pillar positions. If a sidehead
-        // cannot connect to the cluster centroid, we have to search
-        // for another head with a full pillar. Also when there are two
-        // elements in the cluster, the centroid is arbitrary and the
-        // sidehead is allowed to connect to a nearby pillar to
-        // increase structural stability.
+            assert(lcid >= 0);
+            unsigned hid = cl[size_t(lcid)]; // Head ID
 
-        if (cl.empty()) continue;
+            cl_centroids[ci] = hid;
 
-           // get the current cluster centroid
-        auto &      thr    = m_thr;
-        const auto &points = m_points;
+            const Head &h = m_builder.head(hid);
+            cl_pillars[ci] = sla::create_ground_pillar(suptree_ex_policy,
+                                                       m_builder, m_sm,
+                                                       h.junction_point(),
+                                                       h.dir, h.r_back_mm,
+                                                       h.r_back_mm, h.id);
+        },
+        execution::max_concurrency(suptree_ex_policy));
 
-        long lcid = cluster_centroid(
-            cl, [&points](size_t idx) { return points.row(long(idx)); },
-            [thr](const Vec3d &p1, const Vec3d &p2) {
-                thr();
-                return distance(Vec2d(p1.x(), p1.y()), Vec2d(p2.x(), p2.y()));
-            });
+    std::vector<long> new_ids = m_builder.renumber_pillars(first_pillar);
 
-        assert(lcid >= 0);
-        unsigned hid = cl[size_t(lcid)]; // Head ID
+    for (size_t ci = 0; ci < m_pillar_clusters.size(); ++ci) {
+        auto [ret, pillar_id] = cl_pillars[ci];
 
-        cl_centroids.emplace_back(hid);
+        if (pillar_id >= long(first_pillar))
+            pillar_id = new_ids[size_t(pillar_id) - first_pillar];
 
-        Head &h = m_builder.head(hid);
+        if (pillar_id >= 0) // Save the pillar endpoint in the spatial index
+            m_pillar_index.insert(m_builder.pillar(pillar_id).endpt,
+                                  unsigned(pillar_id));
 
-        if (!create_ground_pillar(h.junction(), h.dir, h.id)) {
+        if (!ret) {
             BOOST_LOG_TRIVIAL(warning)
-                << "Pillar cannot be created for support point id: " << hid;
-            m_iheads_onmodel.emplace_back(h.id);
-            continue;
+                << "Pillar cannot be created for support point id: "
+                << cl_centroids[ci];
+            m_iheads_onmodel.emplace_back(cl_centroids[ci]);
         }
     }
 
-    // now we will go through the clusters ones again and connect the
-    // sidepoints with the cluster centroid (which is a ground pillar)
-    // or a nearby pillar if the centroid is unreachable.
-    size_t ci = 0;
-    for (const std::vector<unsigned> &cl : m_pillar_clusters) {
-        m_thr();
+    // Now the sidepoints of the clusters are connected with the cluster
+    // centroid (which is a ground pillar) or a nearby pillar if the
+    // centroid is unreachable. A head can only be bridged to a pillar within
+    // the maximum bridge length and a pillar created for a side head may be
+    // displaced from it by a widening and a corrector bridge. Clusters which
+    // are further apart than that can not influence each other, so the
+    // clusters are sorted into a grid of cells and cells of the same color
+    // in a four color checkerboard pattern are routed in parallel. Every
+    // cell searches only its own copy of the nearby part of the pillar index
+    // and the pillars created in a round are renumbered and merged into the
+    // global index in a fixed order before the next round, so the result
+    // does not depend on the scheduling of the cells.
+    double max_spread = 0.;
+    for (size_t ci = 0; ci < m_pillar_clusters.size(); ++ci) {
+        if (cl_centroids[ci] < 0) continue;
+
+        Vec2d cp = to_2d(m_builder.head(cl_centroids[ci]).junction_point());
+        for (unsigned c : m_pillar_clusters[ci])
+            max_spread = std::max(max_spread,
+                                  distance(cp, to_2d(m_builder.head(c).junction_point())));
+    }
+
+    double reach    = m_sm.cfg.max_bridge_length_mm;
+    double cellsize = 3 * reach + 2 * max_spread + EPSILON;
+
+    struct Cell {
+        Vec2d minc, maxc;
+        PtIndices clusters;
+        std::vector<PointIndexEl> new_pillars;
+    };
 
-        auto cidx = cl_centroids[ci++];
+    std::map<std::pair<long, long>, Cell> cells;
+    for (size_t ci = 0; ci < m_pillar_clusters.size(); ++ci) {
+        if (cl_centroids[ci] < 0 || m_pillar_clusters[ci].size() < 2) continue;
+
+        Vec3d cp = m_builder.head(cl_centroids[ci]).junction_point();
+        std::pair<long, long> key{long(std::floor(cp.x() / cellsize)),
+                                  long(std::floor(cp.y() / cellsize))};
+
+        Cell &cell = cells[key];
+        if (cell.clusters.empty()) {
+            cell.minc = Vec2d{key.first * cellsize, key.second * cellsize};
+            cell.maxc = cell.minc + Vec2d::Constant(cellsize);
+        }
+
+        cell.clusters.emplace_back(ci);
+    }
+
+    std::array<std::vector<Cell *>, 4> rounds;
+    for (auto &[key, cell] : cells)
+        rounds[(key.first & 1) + 2 * (key.second & 1)].emplace_back(&cell);
+
+    auto route_cell = [this, reach, max_spread, &cl_centroids](Cell &cell) {
+        Vec2d minc = cell.minc - Vec2d::Constant(reach + max_spread);
+        Vec2d maxc = cell.maxc + Vec2d::Constant(reach + max_spread);
+
+        PointIndex spindex;
+        for (const PointIndexEl &el : m_pillar_index.guarded_query(
+                 [minc, maxc](const PointIndexEl &e) {
+                     return e.first.x() >= minc.x() && e.first.x() <= maxc.x() &&
+                            e.first.y() >= minc.y() && e.first.y() <= maxc.y();
+                 }))
+            spindex.insert(el);
+
+        for (unsigned ci : cell.clusters) {
+            m_thr();
+
+            auto cidx = unsigned(cl_centroids[ci]);
+
+            auto q = spindex.query(m_builder.head(cidx).junction_point(), 1);
+            if (q.empty()) continue;
 
-        auto q = m_pillar_index.query(m_builder.head(cidx).junction_point(), 1);
-        if (!q.empty()) {
             long centerpillarID = q.front().second;
-            for (auto c : cl) {
+            for (auto c : m_pillar_clusters[ci]) {
                 m_thr();
                 if (c == cidx) continue;
 
                 auto &sidehead = m_builder.head(c);
 
                 if (!connect_to_nearpillar(sidehead, centerpillarID) &&
-                    !search_pillar_and_connect(sidehead)) {
-                    // Vec3d pend = Vec3d{pstart.x(), pstart.y(), gndlvl};
+                    !search_pillar_and_connect(sidehead, spindex)) {
                     // Could not find a pillar, create one
-                    create_ground_pillar(sidehead.junction(), sidehead.dir, sidehead.id);
+                    auto [ret, pillar_id] = sla::create_ground_pillar(
+                        suptree_ex_policy, m_builder, m_sm,
+                        sidehead.junction_point(), sidehead.dir,
+                        sidehead.r_back_mm, sidehead.r_back_mm, sidehead.id);
+
+                    if (pillar_id >= 0) {
+                        PointIndexEl el{m_builder.pillar(pillar_id).endpt,
+                                        unsigned(pillar_id)};
+                        spindex.insert(el);
+                        cell.new_pillars.emplace_back(el);
+                    }
                 }
             }
         }
+    };
+
+    for (std::vector<Cell *> &round : rounds) {
+        first_pillar = m_builder.pillarcount();
+
+        execution::for_each(
+            suptree_ex_policy, round.begin(), round.end(),
+            [&route_cell](Cell *cell) { route_cell(*cell); },
+            execution::max_concurrency(suptree_ex_policy));
+
+        new_ids = m_builder.renumber_pillars(first_pillar);
+
+        for (const Cell *cell : round)
+            for (PointIndexEl el : cell->new_pillars) {
+                if (el.second >= first_pillar)
+                    el.second = unsigned(new_ids[el.second - first_pillar]);
+
+                m_pillar_index.insert(el);
+            }
     }
 }
 
@@ -723,9 +859,13 @@ bool DefaultSupportTree::connect_to_model_body(Head &head)
 bool DefaultSupportTree::search_pillar_and_connect(const Head &source)
 {
     // Hope that a local copy takes less time than the whole search loop.
-    // We also need to remove elements progressively from the copied index.
-    PointIndex spindex = m_pillar_index.guarded_clone();
+    return search_pillar_and_connect(source, m_pillar_index.guarded_clone());
+}
 
+bool DefaultSupportTree::search_pillar_and_connect(const Head &source,
+                                                   PointIndex  spindex)
+{
+    // We need to remove elements progressively from the copied index.
     long nearest_id = SupportTreeNode::ID_UNSET;
 
     Vec3d querypt = source.junction_point();
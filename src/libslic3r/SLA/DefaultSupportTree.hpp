@@ -187,6 +187,10 @@ class DefaultSupportTree {
 
     bool search_pillar_and_connect(const Head& source);
 
+    // Same as above but searching only the pillars of the given index. The
+    // index is taken by value as the visited pillars are removed from it.
+    bool search_pillar_and_connect(const Head& source, PointIndex spindex);
+
     // This is a proxy function for pillar creation which will mind the gap
     // between the pad and the model bottom in zero elevation mode.
     // jp is the starting junction point which needs to be routed down.
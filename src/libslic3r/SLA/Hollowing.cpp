@@ -31,6 +31,7 @@
 #include "libslic3r/Line.hpp"
 #include "libslic3r/SLA/JobController.hpp"
 #include "libslic3r/SLA/Pad.hpp"
+#include "libslic3r/Timer.hpp"
 
 namespace Slic3r {
 struct VoxelGrid;
@@ -78,30 +79,99 @@ VoxelGrid &get_grid(Interior &interior)
     return *interior.gridptr;
 }
 
+// The minimum number of voxels across the wall of the hollowed model
+static constexpr double MIN_SAMPLES_IN_WALL = 3.5;
+
+// The interior surface is the model surface offset inwards by 'depth'. The
+// active voxels of the band in between grow with the depth and with the cube
+// of the voxel scale, while only the isosurface at the bottom of the band is
+// used. If the band would exceed the voxel limit, a smaller voxel scale is
+// returned for calculating it, but not smaller than the one get_voxel_scale()
+// gives for the lowest quality.
+static double get_interior_voxel_scale(const VoxelGrid       &vgrid,
+                                       double                 depth,
+                                       const HollowingConfig &hc)
+{
+    // The input is a narrow band level set with +-3 voxels around the
+    // surface, so its active voxel count is proportional to the surface area.
+    static constexpr double InputBandVoxels = 6.;
+
+    double voxsc   = get_voxel_scale(vgrid);
+    double minsc   = std::max(MIN_SAMPLES_IN_WALL / hc.min_thickness, 1.);
+    double surface = get_active_voxel_count(vgrid) / InputBandVoxels;
+
+    auto band_voxels = [voxsc, surface, depth](double sc) {
+        double r = sc / voxsc;
+        return surface * r * r * (InputBandVoxels + depth * sc);
+    };
+
+    double sc = voxsc;
+    while (sc > minsc && band_voxels(sc) > double(hc.max_band_voxels))
+        sc = std::max(minsc, sc / 1.25);
+
+    return sc;
+}
+
 InteriorPtr generate_interior(const VoxelGrid       &vgrid,
                               const HollowingConfig &hc,
                               const JobController   &ctl)
 {
-    double voxsc    = get_voxel_scale(vgrid);
     double offset   = hc.min_thickness;              // world units
     double D        = hc.closing_distance;           // world units
     float  in_range = 1.1f * float(offset + D);      // world units
-    float  out_range = 1.f / voxsc; // world units
     auto   narrowb  = 1.f;  // voxel units (voxel count)
 
+    Timing::Timer timer;
+    timer.start();
+
+    // Memory of the grids existing at the same time, the input grid included
+    size_t peak_mem = 0;
+    auto track_mem = [&peak_mem, &vgrid](const auto &...grids) {
+        peak_mem = std::max(peak_mem, get_memory_usage(vgrid) +
+                                          (size_t(0) + ... + get_memory_usage(grids)));
+    };
+
     if (ctl.stopcondition()) return {};
     else ctl.statuscb(0, _u8L("Hollowing"));
 
-    auto gridptr = dilate_grid(vgrid, out_range, in_range);
+    // Deep bands are calculated with coarser voxels than the input grid
+    VoxelGridPtr coarse;
+    double voxsc = get_interior_voxel_scale(vgrid, in_range, hc);
+    if (voxsc < get_voxel_scale(vgrid)) {
+        coarse = resample_grid(vgrid, float(voxsc));
+        track_mem(*coarse);
+
+        BOOST_LOG_TRIVIAL(info) << "Hollowing: interior voxel scale lowered from "
+                                << get_voxel_scale(vgrid) << " to " << voxsc;
+    }
+
+    float out_range = 1.f / voxsc; // world units
+
+    const VoxelGrid *srcgrid = coarse ? coarse.get() : &vgrid;
+    auto gridptr = dilate_grid(*srcgrid, out_range, in_range);
+    if (coarse)
+        track_mem(*coarse, *gridptr);
+    else
+        track_mem(*gridptr);
+
+    coarse.reset();
+
+    BOOST_LOG_TRIVIAL(debug) << "Hollowing: band dilated to "
+                             << get_active_voxel_count(*gridptr)
+                             << " active voxels in " << timer.elapsed_seconds() << " s";
 
     if (ctl.stopcondition()) return {};
     else ctl.statuscb(30, _u8L("Hollowing"));
 
     double iso_surface = D;
     if (D > EPSILON) {
-        gridptr = redistance_grid(*gridptr, -(offset + D), narrowb, narrowb);
+        auto redist = redistance_grid(*gridptr, -(offset + D), narrowb, narrowb);
+        track_mem(*gridptr, *redist);
+        gridptr = std::move(redist);
 
-        gridptr = dilate_grid(*gridptr, 1.1 * std::ceil(iso_surface), 0.f);
+        auto dilated = dilate_grid(*gridptr, 1.1 * std::ceil(iso_surface), 0.f);
+        track_mem(*gridptr, *dilated);
+        gridptr = std::move(dilated);
 
         out_range = iso_surface;
         in_range  = narrowb / voxsc;
@@ -125,6 +195,10 @@ InteriorPtr generate_interior(const VoxelGrid       &vgrid,
     interior->thickness   = offset;
     interior->full_narrowb = (out_range + in_range) / 2.;
 
+    BOOST_LOG_TRIVIAL(info) << "Hollowing: interior generated in "
+                            << timer.elapsed_seconds() << " s, peak grid memory: "
+                            << peak_mem / (1024 * 1024) << " MB";
+
     return interior;
 }
 
@@ -754,7 +828,6 @@ DrainHoles transformed_drainhole_points(const ModelObject &mo,
 
 double get_voxel_scale(double mesh_volume, const HollowingConfig &hc)
 {
-    static constexpr double MIN_SAMPLES_IN_WALL = 3.5;
     static constexpr double MAX_OVERSAMPL = 8.;
     static constexpr double UNIT_VOLUME   = 500000; // empiric
 
@@ -37,6 +37,11 @@ struct HollowingConfig
     double quality          = 0.5;
     double closing_distance = 0.5;
     bool enabled = true;
+
+    // Upper limit for the active voxels of the band between the model
+    // surface and the interior. Larger bands are calculated with coarser
+    // voxels, but with at least the minimum samples across the wall.
+    size_t max_band_voxels = 64000000;
 };
 
 enum HollowingFlags { hfRemoveInsideTriangles = 0x1 };
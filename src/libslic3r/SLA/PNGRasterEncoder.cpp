@@ -0,0 +1,509 @@
+///|/ Copyright (c) Prusa Research 2024
+///|/
+///|/ PrusaSlicer is released under the terms of the AGPLv3 or higher
+///|/
+// PNG encoder specialized for the SLA layer masks.
+//
+// The masks are huge (tens of megapixels), mostly empty and vertically coherent. The rows are filtered
+// with a cheap heuristic, which turns empty rows, constant rows and rows repeating the previous row
+// into runs of zeros without looking at the data twice. The filtered data is then compressed by
+// a run length only deflate encoder (all matches have distance 1) with dynamic Huffman codes.
+// Such an encoder is several times faster than a general LZ77 matcher, while the SLA masks
+// compress to within about 15% of the size produced at the default zlib compression level.
+// Large layers are split into blocks of rows, which are compressed independently in parallel
+// and concatenated into a single zlib stream, separated by empty stored blocks as zlib's full flush does.
+
+#include <libslic3r/SLA/RasterBase.hpp>
+
+#include <miniz.h>
+
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <queue>
+
+namespace Slic3r { namespace sla {
+
+namespace {
+
+// PNG row filter types used by the encoder.
+enum PNGFilter : uint8_t { pfNone = 0, pfSub = 1, pfUp = 2 };
+
+// Amount of filtered image data compressed as a single independent deflate block.
+constexpr size_t PNG_DEFLATE_BLOCK_SIZE = 1024 * 1024;
+
+constexpr uint32_t ADLER32_BASE = 65521;
+
+// Adler-32 checksum updated with count bytes of the same value, without touching the data.
+uint32_t adler32_run(uint32_t adler, uint8_t value, size_t count)
+{
+    uint64_t s1 = adler & 0xffff;
+    uint64_t s2 = adler >> 16;
+    uint64_t n  = count % ADLER32_BASE;
+    // s2 accumulates s1 + value, s1 + 2 * value, ..., s1 + count * value.
+    s2 = (s2 + n * s1 + uint64_t(value) * ((uint64_t(count) * (uint64_t(count) + 1) / 2) % ADLER32_BASE)) % ADLER32_BASE;
+    s1 = (s1 + n * value) % ADLER32_BASE;
+    return uint32_t(s1 | (s2 << 16));
+}
+
+// Adler-32 checksum of two concatenated buffers from the checksums of the two buffers, see zlib's adler32_combine().
+uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t len2)
+{
+    uint32_t rem  = uint32_t(len2 % ADLER32_BASE);
+    uint32_t sum1 = adler1 & 0xffff;
+    uint32_t sum2 = (rem * sum1) % ADLER32_BASE;
+    sum1 += (adler2 & 0xffff) + ADLER32_BASE - 1;
+    sum2 += ((adler1 >> 16) & 0xffff) + ((adler2 >> 16) & 0xffff) + ADLER32_BASE - rem;
+    if (sum1 >= ADLER32_BASE) sum1 -= ADLER32_BASE;
+    if (sum1 >= ADLER32_BASE) sum1 -= ADLER32_BASE;
+    if (sum2 >= (ADLER32_BASE << 1)) sum2 -= (ADLER32_BASE << 1);
+    if (sum2 >= ADLER32_BASE) sum2 -= ADLER32_BASE;
+    return sum1 | (sum2 << 16);
+}
+
+// Select the filter of a single row, write the filter type followed by the filtered row into dst.
+// Returns the number of bytes written into dst, the rest of the filtered row is implicitly zero.
+// Empty and constant rows and rows repeating the previous row are detected first, as they are
+// the most common rows of the SLA masks. For the other rows, the filter is selected by the minimum
+// sum of absolute differences heuristic, as libpng does.
+size_t png_filter_row(const uint8_t *row, const uint8_t *prev, size_t row_size, size_t bpp, uint8_t *dst)
+{
+    uint8_t *out = dst + 1;
+    if (prev != nullptr && std::equal(row, row + row_size, prev)) {
+        dst[0] = pfUp;
+        return 1;
+    }
+    if (row_size <= bpp || std::equal(row + bpp, row + row_size, row)) {
+        // Constant row. An empty row is the same for both filters, keep it unfiltered.
+        bool empty = std::all_of(row, row + bpp, [](uint8_t v) { return v == 0; });
+        dst[0] = empty ? pfNone : pfSub;
+        if (empty)
+            return 1;
+        std::copy(row, row + bpp, out);
+        return bpp + 1;
+    }
+
+    // Filtered bytes are interpreted as signed values by the heuristic.
+    // 32 bit sums are sufficient for rows shorter than 32MB and they vectorize well.
+    auto cost = [](uint8_t v) -> uint32_t { return uint32_t(std::abs(int(int8_t(v)))); };
+    uint32_t cost_none = 0, cost_sub = 0, cost_up = std::numeric_limits<uint32_t>::max();
+    for (size_t i = 0; i < row_size; ++ i)
+        cost_none += cost(row[i]);
+    for (size_t i = 0; i < bpp; ++ i)
+        cost_sub += cost(row[i]);
+    for (size_t i = bpp; i < row_size; ++ i)
+        cost_sub += cost(uint8_t(row[i] - row[i - bpp]));
+    if (prev != nullptr) {
+        cost_up = 0;
+        for (size_t i = 0; i < row_size; ++ i)
+            cost_up += cost(uint8_t(row[i] - prev[i]));
+    }
+
+    if (cost_up <= cost_sub && cost_up <= cost_none) {
+        dst[0] = pfUp;
+        for (size_t i = 0; i < row_size; ++ i)
+            out[i] = uint8_t(row[i] - prev[i]);
+    } else if (cost_sub < cost_none) {
+        dst[0] = pfSub;
+        std::copy(row, row + bpp, out);
+        for (size_t i = bpp; i < row_size; ++ i)
+            out[i] = uint8_t(row[i] - row[i - bpp]);
+    } else {
+        dst[0] = pfNone;
+        std::copy(row, row + row_size, out);
+    }
+    return row_size + 1;
+}
+
+// Least significant bit first bit stream, as required by deflate.
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t> &out) : m_out(out) {}
+
+    // Write the lowest num_bits of bits, num_bits <= 32.
+    void put(uint32_t bits, unsigned num_bits) {
+        m_acc |= uint64_t(bits) << m_num_bits;
+        m_num_bits += num_bits;
+        while (m_num_bits >= 8) {
+            m_out.push_back(uint8_t(m_acc));
+            m_acc >>= 8;
+            m_num_bits -= 8;
+        }
+    }
+    // Pad with zero bits to a byte boundary.
+    void align() { if (m_num_bits > 0) put(0, 8 - m_num_bits); }
+
+private:
+    std::vector<uint8_t> &m_out;
+    uint64_t              m_acc      = 0;
+    unsigned              m_num_bits = 0;
+};
+
+// Calculate Huffman code lengths of at most max_bits for the symbol frequencies.
+// Symbols with zero frequency get zero length. At least two symbols have to be used.
+void huffman_code_lengths(const uint32_t *freqs, size_t num_symbols, unsigned max_bits, uint8_t *lengths)
+{
+    std::vector<uint32_t> f(freqs, freqs + num_symbols);
+    for (;;) {
+        // Leaves first, then the internal nodes in the order of their creation.
+        std::vector<int> parent;
+        std::vector<int> leaf_symbol;
+        using Item = std::pair<uint64_t, int>;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+        for (size_t i = 0; i < num_symbols; ++ i)
+            if (f[i] > 0) {
+                queue.emplace(f[i], int(parent.size()));
+                parent.emplace_back(-1);
+                leaf_symbol.emplace_back(int(i));
+            }
+        assert(queue.size() >= 2);
+        while (queue.size() > 1) {
+            Item a = queue.top(); queue.pop();
+            Item b = queue.top(); queue.pop();
+            int node = int(parent.size());
+            parent.emplace_back(-1);
+            parent[a.second] = node;
+            parent[b.second] = node;
+            queue.emplace(a.first + b.first, node);
+        }
+        // Parents are created after their children, thus the depths may be propagated from the root down.
+        std::vector<unsigned> depth(parent.size(), 0);
+        unsigned max_depth = 0;
+        for (int node = int(parent.size()) - 2; node >= 0; -- node) {
+            depth[node] = depth[parent[node]] + 1;
+            max_depth = std::max(max_depth, depth[node]);
+        }
+        if (max_depth <= max_bits) {
+            std::fill(lengths, lengths + num_symbols, 0);
+            for (size_t i = 0; i < leaf_symbol.size(); ++ i)
+                lengths[leaf_symbol[i]] = uint8_t(depth[i]);
+            return;
+        }
+        // Flatten the distribution and try again.
+        for (uint32_t &v : f)
+            if (v > 0)
+                v = (v >> 1) | 1;
+    }
+}
+
+// Canonical Huffman codes for the code lengths, bit reversed for the LSB first bit stream.
+void huffman_codes(const uint8_t *lengths, size_t num_symbols, uint16_t *codes)
+{
+    uint16_t count[16] = {};
+    for (size_t i = 0; i < num_symbols; ++ i)
+        ++ count[lengths[i]];
+    count[0] = 0;
+    uint16_t next_code[16] = {};
+    uint16_t code = 0;
+    for (unsigned bits = 1; bits < 16; ++ bits)
+        next_code[bits] = code = uint16_t((code + count[bits - 1]) << 1);
+    for (size_t i = 0; i < num_symbols; ++ i)
+        if (unsigned len = lengths[i]; len > 0) {
+            uint16_t c = next_code[len] ++;
+            uint16_t reversed = 0;
+            for (unsigned b = 0; b < len; ++ b)
+                reversed |= ((c >> b) & 1) << (len - 1 - b);
+            codes[i] = reversed;
+        }
+}
+
+// Deflate encoder emitting literals and matches of distance 1 only, compressing a single block of data
+// into a single dynamic Huffman deflate block.
+class RLEDeflater {
+public:
+    void put_bytes(const uint8_t *data, size_t len) {
+        for (size_t i = 0; i < len;) {
+            if (int(data[i]) == m_prev) {
+                // Scan the run a word at a time.
+                size_t   j       = i + 1;
+                uint64_t pattern = 0x0101010101010101ull * data[i];
+                for (uint64_t word; j + 8 <= len; j += 8) {
+                    memcpy(&word, data + j, 8);
+                    if (word != pattern)
+                        break;
+                }
+                while (j < len && data[j] == data[i])
+                    ++ j;
+                m_run += j - i;
+                i = j;
+            } else
+                this->start_run(data[i ++]);
+        }
+    }
+    void put_run(uint8_t value, size_t count) {
+        if (count == 0)
+            return;
+        if (int(value) != m_prev) {
+            this->start_run(value);
+            -- count;
+        }
+        m_run += count;
+    }
+    // Finish the deflate block. If not last, the block is followed by an empty stored block
+    // to align the output to a byte boundary, so that the outputs of multiple deflaters may be concatenated.
+    void finish(std::vector<uint8_t> &out, bool last);
+
+private:
+    static constexpr size_t NUM_LITLEN = 286;
+    static constexpr size_t NUM_DIST   = 2;
+    static constexpr size_t NUM_CL     = 19;
+    static constexpr uint32_t MATCH    = 0x10000;
+
+    void start_run(uint8_t value) {
+        this->flush_run();
+        this->literal(value);
+        m_prev = value;
+    }
+    void literal(uint8_t value) {
+        m_tokens.emplace_back(value);
+        ++ m_litlen_freqs[value];
+    }
+    void flush_run() {
+        for (; m_run >= 3;) {
+            size_t len = std::min<size_t>(m_run, 258);
+            m_tokens.emplace_back(MATCH | uint32_t(len));
+            ++ m_litlen_freqs[257 + length_code(len)];
+            m_run -= len;
+        }
+        for (; m_run > 0; -- m_run)
+            this->literal(uint8_t(m_prev));
+    }
+
+    static constexpr uint16_t LENGTH_BASE[29]  = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static constexpr uint8_t  LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static size_t length_code(size_t len) {
+        return size_t(std::upper_bound(std::begin(LENGTH_BASE), std::end(LENGTH_BASE), len) - std::begin(LENGTH_BASE)) - 1;
+    }
+
+    // Literal value or MATCH | match length.
+    std::vector<uint32_t> m_tokens;
+    uint32_t              m_litlen_freqs[NUM_LITLEN] = {};
+    // Last byte written and the number of its repetitions not yet emitted.
+    int                   m_prev = -1;
+    size_t                m_run  = 0;
+};
+
+void RLEDeflater::finish(std::vector<uint8_t> &out, bool last)
+{
+    this->flush_run();
+    // End of block.
+    ++ m_litlen_freqs[256];
+    if (m_tokens.empty())
+        // Huffman codes need at least two symbols.
+        ++ m_litlen_freqs[0];
+
+    uint8_t  litlen_lengths[NUM_LITLEN];
+    uint16_t litlen_codes[NUM_LITLEN];
+    huffman_code_lengths(m_litlen_freqs, NUM_LITLEN, 15, litlen_lengths);
+    huffman_codes(litlen_lengths, NUM_LITLEN, litlen_codes);
+    // Only distance 1 is ever used. A complete distance code of two symbols is emitted
+    // to stay on the safe side with inflaters not accepting incomplete codes.
+    const uint8_t dist_lengths[NUM_DIST] = { 1, 1 };
+
+    size_t num_litlen = NUM_LITLEN;
+    while (num_litlen > 257 && litlen_lengths[num_litlen - 1] == 0)
+        -- num_litlen;
+
+    // Run length encode the code lengths with the code length alphabet.
+    std::vector<uint8_t> lengths(litlen_lengths, litlen_lengths + num_litlen);
+    lengths.insert(lengths.end(), std::begin(dist_lengths), std::end(dist_lengths));
+    // Code length symbol and the value of its extra bits.
+    std::vector<std::pair<uint8_t, uint8_t>> cl_symbols;
+    uint32_t cl_freqs[NUM_CL] = {};
+    auto emit_cl = [&cl_symbols, &cl_freqs](uint8_t symbol, uint8_t extra) {
+        cl_symbols.emplace_back(symbol, extra);
+        ++ cl_freqs[symbol];
+    };
+    for (size_t i = 0; i < lengths.size();) {
+        uint8_t len = lengths[i];
+        size_t  run = 1;
+        while (i + run < lengths.size() && lengths[i + run] == len)
+            ++ run;
+        i += run;
+        if (len == 0) {
+            for (; run >= 11; ) {
+                size_t n = std::min<size_t>(run, 138);
+                emit_cl(18, uint8_t(n - 11));
+                run -= n;
+            }
+            if (run >= 3) {
+                emit_cl(17, uint8_t(run - 3));
+                run = 0;
+            }
+        } else {
+            emit_cl(len, 0);
+            -- run;
+            for (; run >= 3; ) {
+                size_t n = std::min<size_t>(run, 6);
+                emit_cl(16, uint8_t(n - 3));
+                run -= n;
+            }
+        }
+        for (; run > 0; -- run)
+            emit_cl(len, 0);
+    }
+    if (std::count_if(std::begin(cl_freqs), std::end(cl_freqs), [](uint32_t f) { return f > 0; }) < 2)
+        // Huffman codes need at least two symbols.
+        ++ cl_freqs[cl_freqs[0] > 0 ? 1 : 0];
+    uint8_t  cl_lengths[NUM_CL];
+    uint16_t cl_codes[NUM_CL];
+    huffman_code_lengths(cl_freqs, NUM_CL, 7, cl_lengths);
+    huffman_codes(cl_lengths, NUM_CL, cl_codes);
+    static constexpr uint8_t cl_order[NUM_CL] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+    size_t num_cl = NUM_CL;
+    while (num_cl > 4 && cl_lengths[cl_order[num_cl - 1]] == 0)
+        -- num_cl;
+
+    BitWriter bits(out);
+    // Block header: BFINAL, BTYPE = 2 (dynamic Huffman codes).
+    bits.put(last ? 1 : 0, 1);
+    bits.put(2, 2);
+    bits.put(uint32_t(num_litlen - 257), 5);
+    bits.put(uint32_t(NUM_DIST - 1), 5);
+    bits.put(uint32_t(num_cl - 4), 4);
+    for (size_t i = 0; i < num_cl; ++ i)
+        bits.put(cl_lengths[cl_order[i]], 3);
+    for (const auto &[symbol, extra] : cl_symbols) {
+        bits.put(cl_codes[symbol], cl_lengths[symbol]);
+        if (symbol == 16)
+            bits.put(extra, 2);
+        else if (symbol == 17)
+            bits.put(extra, 3);
+        else if (symbol == 18)
+            bits.put(extra, 7);
+    }
+
+    for (uint32_t token : m_tokens) {
+        if (token & MATCH) {
+            size_t len  = token & ~MATCH;
+            size_t code = length_code(len);
+            bits.put(litlen_codes[257 + code], litlen_lengths[257 + code]);
+            if (LENGTH_EXTRA[code] > 0)
+                bits.put(uint32_t(len - LENGTH_BASE[code]), LENGTH_EXTRA[code]);
+            // Distance 1 is the distance code 0 of length 1, which is encoded by a zero bit.
+            bits.put(0, 1);
+        } else
+            bits.put(litlen_codes[token], litlen_lengths[token]);
+    }
+    bits.put(litlen_codes[256], litlen_lengths[256]);
+
+    if (! last) {
+        // Empty stored block: BFINAL = 0, BTYPE = 0, aligned LEN = 0, NLEN = 0xffff.
+        bits.put(0, 3);
+        bits.align();
+        out.insert(out.end(), { 0, 0, 0xff, 0xff });
+    } else
+        bits.align();
+}
+
+void png_append_u32(std::vector<uint8_t> &buf, uint32_t v)
+{
+    buf.insert(buf.end(), { uint8_t(v >> 24), uint8_t(v >> 16), uint8_t(v >> 8), uint8_t(v) });
+}
+
+// Start a PNG chunk: reserve space for its length and append its type. Returns the chunk start.
+size_t png_begin_chunk(std::vector<uint8_t> &buf, const char (&type)[5])
+{
+    size_t chunk_begin = buf.size();
+    png_append_u32(buf, 0);
+    buf.insert(buf.end(), type, type + 4);
+    return chunk_begin;
+}
+
+// Fill in the length of a PNG chunk started by png_begin_chunk() and append its CRC.
+void png_end_chunk(std::vector<uint8_t> &buf, size_t chunk_begin)
+{
+    // The length covers the chunk data only, the CRC covers the chunk type and data.
+    uint32_t len = uint32_t(buf.size() - chunk_begin - 8);
+    for (int i = 0; i < 4; ++ i)
+        buf[chunk_begin + i] = uint8_t(len >> (24 - 8 * i));
+    png_append_u32(buf, uint32_t(mz_crc32(MZ_CRC32_INIT, buf.data() + chunk_begin + 4, len + 4)));
+}
+
+} // namespace
+
+EncodedRaster PNGRasterEncoder::operator()(const void *ptr, size_t w, size_t h,
+                                           size_t      num_components)
+{
+    // PNG color types of gray, gray + alpha, RGB and RGBA images.
+    static constexpr uint8_t color_types[] = { 0, 0, 4, 2, 6 };
+    if (num_components < 1 || num_components > 4 || w == 0 || h == 0)
+        return EncodedRaster({}, "png");
+
+    auto   src            = static_cast<const uint8_t *>(ptr);
+    size_t row_size       = w * num_components;
+    size_t rows_per_block = std::max<size_t>(1, PNG_DEFLATE_BLOCK_SIZE / (row_size + 1));
+    size_t num_blocks     = (h + rows_per_block - 1) / rows_per_block;
+
+    struct Block {
+        std::vector<uint8_t> deflated;
+        // Adler-32 checksum of the filtered rows of this block.
+        uint32_t             adler = MZ_ADLER32_INIT;
+        size_t               size  = 0;
+    };
+    std::vector<Block> blocks(num_blocks);
+    auto encode_block = [&](size_t block_idx) {
+        Block       &block   = blocks[block_idx];
+        size_t       row_beg = block_idx * rows_per_block;
+        size_t       row_end = std::min(h, row_beg + rows_per_block);
+        RLEDeflater  deflater;
+        std::vector<uint8_t> filtered(row_size + 1);
+        for (size_t r = row_beg; r < row_end; ++ r) {
+            // Filtering refers to the previous row of the image even at the start of a block.
+            size_t n = png_filter_row(src + r * row_size, r == 0 ? nullptr : src + (r - 1) * row_size,
+                                      row_size, num_components, filtered.data());
+            deflater.put_bytes(filtered.data(), n);
+            deflater.put_run(0, row_size + 1 - n);
+            block.adler = adler32_run(uint32_t(mz_adler32(block.adler, filtered.data(), n)), 0, row_size + 1 - n);
+        }
+        block.size = (row_end - row_beg) * (row_size + 1);
+        deflater.finish(block.deflated, block_idx + 1 == num_blocks);
+    };
+    if (num_blocks == 1)
+        encode_block(0);
+    else
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, num_blocks, 1), [&encode_block](const tbb::blocked_range<size_t> &range) {
+            for (size_t block_idx = range.begin(); block_idx < range.end(); ++ block_idx)
+                encode_block(block_idx);
+        });
+
+    size_t   deflated_size = 0;
+    uint32_t adler         = MZ_ADLER32_INIT;
+    for (const Block &block : blocks) {
+        deflated_size += block.deflated.size();
+        adler = adler32_combine(adler, block.adler, block.size);
+    }
+
+    std::vector<uint8_t> buf;
+    buf.reserve(deflated_size + 64);
+    static constexpr uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    buf.insert(buf.end(), std::begin(signature), std::end(signature));
+
+    size_t chunk_begin = png_begin_chunk(buf, "IHDR");
+    png_append_u32(buf, uint32_t(w));
+    png_append_u32(buf, uint32_t(h));
+    // Bit depth, color type, compression method, filter method, interlace method.
+    buf.insert(buf.end(), { 8, color_types[num_components], 0, 0, 0 });
+    png_end_chunk(buf, chunk_begin);
+
+    chunk_begin = png_begin_chunk(buf, "IDAT");
+    // zlib header: deflate with 32K window, fastest compression.
+    buf.insert(buf.end(), { 0x78, 0x01 });
+    for (const Block &block : blocks)
+        buf.insert(buf.end(), block.deflated.begin(), block.deflated.end());
+    png_append_u32(buf, adler);
+    png_end_chunk(buf, chunk_begin);
+
+    chunk_begin = png_begin_chunk(buf, "IEND");
+    png_end_chunk(buf, chunk_begin);
+
+    return EncodedRaster(std::move(buf), "png");
+}
+
+}} // namespace Slic3r::sla
@@ -0,0 +1,82 @@
+///|/ Copyright (c) Prusa Research 2024
+///|/
+///|/ PrusaSlicer is released under the terms of the AGPLv3 or higher
+///|/
+#include <libslic3r/SLA/PinheadCache.hpp>
+
+#include <boost/container_hash/hash.hpp>
+#include <boost/log/trivial.hpp>
+
+namespace Slic3r { namespace sla {
+
+size_t PinheadCache::KeyHash::operator()(const Key &key) const
+{
+    size_t seed = 0;
+    boost::hash_combine(seed, key.pos.x());
+    boost::hash_combine(seed, key.pos.y());
+    boost::hash_combine(seed, key.pos.z());
+    boost::hash_combine(seed, key.head_front_radius);
+    return seed;
+}
+
+bool PinheadCache::Signature::operator==(const Signature &rhs) const
+{
+    return tree_type               == rhs.tree_type &&
+           head_front_radius_mm    == rhs.head_front_radius_mm &&
+           head_penetration_mm     == rhs.head_penetration_mm &&
+           head_back_radius_mm     == rhs.head_back_radius_mm &&
+           head_fallback_radius_mm == rhs.head_fallback_radius_mm &&
+           head_width_mm           == rhs.head_width_mm &&
+           bridge_slope            == rhs.bridge_slope &&
+           ground_level            == rhs.ground_level;
+}
+
+void PinheadCache::begin_generation(const SupportableMesh &sm)
+{
+    Signature signature{ sm.cfg.tree_type,
+                         sm.cfg.head_front_radius_mm,
+                         sm.cfg.head_penetration_mm,
+                         sm.cfg.head_back_radius_mm,
+                         sm.cfg.head_fallback_radius_mm,
+                         sm.cfg.head_width_mm,
+                         sm.cfg.bridge_slope,
+                         ground_level(sm) };
+
+    if (m_signature && *m_signature == signature) {
+        // If the last generation was canceled, it stored just a part of its pinheads.
+        if (! m_finished)
+            m_heads.merge(m_prev_heads);
+        m_prev_heads = std::move(m_heads);
+    } else
+        m_prev_heads.clear();
+
+    m_heads.clear();
+    m_signature = signature;
+    m_finished  = false;
+
+    BOOST_LOG_TRIVIAL(debug) << "Pinhead cache: " << m_prev_heads.size() << " cached pinheads";
+}
+
+const std::optional<Head>* PinheadCache::find(const SupportPoint &sp) const
+{
+    auto it = m_prev_heads.find(make_key(sp));
+    return it == m_prev_heads.end() ? nullptr : &it->second;
+}
+
+void PinheadCache::store(const SupportPoint &sp, const std::optional<Head> &head)
+{
+    std::optional<Head> &dst = m_heads[make_key(sp)];
+    dst = head;
+    if (dst)
+        dst->invalidate();
+}
+
+void PinheadCache::clear()
+{
+    m_prev_heads.clear();
+    m_heads.clear();
+    m_signature.reset();
+    m_finished = false;
+}
+
+}} // namespace Slic3r::sla
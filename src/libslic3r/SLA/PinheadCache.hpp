@@ -0,0 +1,86 @@
+///|/ Copyright (c) Prusa Research 2024
+///|/
+///|/ PrusaSlicer is released under the terms of the AGPLv3 or higher
+///|/
+#ifndef SLA_PINHEADCACHE_HPP
+#define SLA_PINHEADCACHE_HPP
+
+#include <libslic3r/SLA/SupportTreeBuilder.hpp>
+#include <optional>
+#include <unordered_map>
+
+namespace Slic3r { namespace sla {
+
+// Pinhead placements of the support points calculated by the previous support
+// tree generation. When the user edits a few support points, the pinheads of
+// the untouched points are reused instead of searching for a collision free
+// pinhead direction again, which is the most expensive part of the support
+// tree generation. Only the routing of the pillars and bridges is repeated.
+//
+// The pinhead of a support point depends on the support point itself, on the
+// model mesh and on the support tree configuration. The configuration is
+// checked by begin_generation(), the owner of the cache is responsible for
+// clearing the cache whenever the model mesh changes.
+// Not thread safe except for find().
+class PinheadCache {
+public:
+    // Start a new support tree generation. The pinheads stored by the previous
+    // generation become available through find(), unless the configuration
+    // affecting the pinhead placement changed.
+    void begin_generation(const SupportableMesh &sm);
+    // The support tree generation finished without being canceled, the pinheads
+    // stored by the previous generations for other support points may be dropped.
+    void end_generation() { m_finished = true; }
+
+    // Pinhead of the support point calculated by the previous generation.
+    // Returns nullptr if the support point is not cached, pointer to an empty
+    // optional if the support point is known not to hold a pinhead.
+    // The returned head has its id unset.
+    const std::optional<Head>* find(const SupportPoint &sp) const;
+
+    // Store the pinhead of a support point for the next generation.
+    // The support tree generators store all their pinheads, cached or not.
+    void store(const SupportPoint &sp, const std::optional<Head> &head);
+
+    void clear();
+
+    size_t size() const { return m_heads.size(); }
+
+private:
+    struct Key {
+        Vec3f pos;
+        float head_front_radius;
+
+        bool operator==(const Key &rhs) const { return pos == rhs.pos && head_front_radius == rhs.head_front_radius; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key &key) const;
+    };
+    using Heads = std::unordered_map<Key, std::optional<Head>, KeyHash>;
+
+    // Configuration values the pinhead placement depends on.
+    struct Signature {
+        SupportTreeType tree_type;
+        double          head_front_radius_mm;
+        double          head_penetration_mm;
+        double          head_back_radius_mm;
+        double          head_fallback_radius_mm;
+        double          head_width_mm;
+        double          bridge_slope;
+        double          ground_level;
+
+        bool operator==(const Signature &rhs) const;
+    };
+
+    static Key make_key(const SupportPoint &sp) { return { sp.pos, sp.head_front_radius }; }
+
+    // Pinheads of the previous and of the current generation.
+    Heads                    m_prev_heads;
+    Heads                    m_heads;
+    std::optional<Signature> m_signature;
+    bool                     m_finished = false;
+};
+
+}} // namespace Slic3r::sla
+
+#endif // SLA_PINHEADCACHE_HPP
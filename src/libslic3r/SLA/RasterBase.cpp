@@ -8,8 +8,7 @@
 
 #include <libslic3r/SLA/RasterBase.hpp>
 #include <libslic3r/SLA/AGGRaster.hpp>
-// minz image write:
-#include <miniz.h>
+#include <libslic3r/SLA/CoverageRaster.hpp>
 #include <algorithm>
 #include <cmath>
 #include <iterator>
@@ -19,28 +18,6 @@
 
 namespace Slic3r { namespace sla {
 
-EncodedRaster PNGRasterEncoder::operator()(const void *ptr, size_t w, size_t h,
-                                           size_t      num_components)
-{
-    std::vector<uint8_t> buf;
-    size_t s = 0;
-    
-    void *rawdata = tdefl_write_image_to_png_file_in_memory(
-        ptr, int(w), int(h), int(num_components), &s);
-    
-    // On error, data() will return an empty vector. No other info can be
-    // retrieved from miniz anyway...
-    if (rawdata == nullptr) return EncodedRaster({}, "png");
-    
-    auto pptr = static_cast<std::uint8_t*>(rawdata);
-    
-    buf.reserve(s);
-    std::copy(pptr, pptr + s, std::back_inserter(buf));
-    
-    MZ_FREE(rawdata);
-    return EncodedRaster(std::move(buf), "png");
-}
-
 std::ostream &operator<<(std::ostream &stream, const EncodedRaster &bytes)
 {
     stream.write(reinterpret_cast<const char *>(bytes.data()),
@@ -79,11 +56,11 @@ std::unique_ptr<RasterBase> create_raster_grayscale_aa(
     std::unique_ptr<RasterBase> rst;
     
     if (gamma > 0)
-        rst = std::make_unique<RasterGrayscaleAAGammaPower>(res, pxdim, tr, gamma);
+        rst = std::make_unique<CoverageRasterGrayscaleAA>(res, pxdim, tr, agg::gamma_power(gamma));
     else if (std::abs(gamma - 1.) < 1e-6)
-        rst = std::make_unique<RasterGrayscaleAA>(res, pxdim, tr, agg::gamma_none());
+        rst = std::make_unique<CoverageRasterGrayscaleAA>(res, pxdim, tr, agg::gamma_none());
     else
-        rst = std::make_unique<RasterGrayscaleAA>(res, pxdim, tr, agg::gamma_threshold(.5));
+        rst = std::make_unique<CoverageRasterGrayscaleAA>(res, pxdim, tr, agg::gamma_threshold(.5));
     
     return rst;
 }
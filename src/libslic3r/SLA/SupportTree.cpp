@@ -11,6 +11,7 @@
 #include <libslic3r/SLA/SupportTreeBuilder.hpp>
 #include <libslic3r/SLA/DefaultSupportTree.hpp>
 #include <libslic3r/SLA/BranchingTreeSLA.hpp>
+#include <libslic3r/SLA/PinheadCache.hpp>
 #include <libslic3r/MTUtils.hpp>
 #include <libslic3r/TriangleMeshSlicer.hpp>
 #include <boost/log/trivial.hpp>
@@ -37,6 +38,9 @@ indexed_triangle_set create_support_tree(const SupportableMesh &sm,
         using std::chrono::high_resolution_clock;
         auto start{high_resolution_clock::now()};
 
+        if (sm.pinhead_cache)
+            sm.pinhead_cache->begin_generation(sm);
+
         switch (sm.cfg.tree_type) {
         case SupportTreeType::Default: {
             create_default_tree(*builder, sm);
@@ -52,6 +56,9 @@ indexed_triangle_set create_support_tree(const SupportableMesh &sm,
         default:;
         }
 
+        if (sm.pinhead_cache && ! ctl.stopcondition())
+            sm.pinhead_cache->end_generation();
+
         auto stop{high_resolution_clock::now()};
 
         using std::chrono::duration;
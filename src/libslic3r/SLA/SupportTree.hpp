@@ -24,6 +24,7 @@ namespace Slic3r {
 
 namespace sla {
 struct JobController;
+class PinheadCache;
 
 struct SupportTreeConfig
 {
@@ -125,6 +126,8 @@ struct SupportableMesh
     SupportTreeConfig cfg;
     PadConfig         pad_cfg;
     double            zoffset = 0.;
+    // Optional cache of pinheads from the previous support tree generation.
+    PinheadCache     *pinhead_cache = nullptr;
 
     explicit SupportableMesh(const indexed_triangle_set &trmsh,
                              const SupportPoints        &sp,
@@ -9,6 +9,9 @@
 #include "libslic3r/SLA/SupportTree.hpp"
 #include "libslic3r/TriangleMesh.hpp"
 
+#include <algorithm>
+#include <tuple>
+
 namespace Slic3r {
 namespace sla {
 
@@ -87,6 +90,39 @@ void SupportTreeBuilder::add_pillar_base(long pid, double baseheight, double rad
     m_meshcache_valid = false;
 }
 
+std::vector<long> SupportTreeBuilder::renumber_pillars(size_t first_id)
+{
+    std::lock_guard<Mutex> lk(m_mutex);
+    assert(first_id <= m_pillars.size());
+
+    auto key = [](const Pillar &p) {
+        return std::make_tuple(p.endpt.x(), p.endpt.y(), p.endpt.z(), p.height,
+                               p.r_start, p.r_end, p.start_junction_id);
+    };
+
+    std::vector<Pillar> sorted(m_pillars.begin() + first_id, m_pillars.end());
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [&key](const Pillar &p1, const Pillar &p2) {
+                         return key(p1) < key(p2);
+                     });
+
+    std::vector<long> new_ids(sorted.size());
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        long new_id = long(first_id + i);
+        new_ids[size_t(sorted[i].id) - first_id] = new_id;
+        sorted[i].id = new_id;
+    }
+
+    std::move(sorted.begin(), sorted.end(), m_pillars.begin() + first_id);
+
+    for (Head &head : m_heads)
+        if (head.pillar_id >= long(first_id))
+            head.pillar_id = new_ids[size_t(head.pillar_id) - first_id];
+
+    m_meshcache_valid = false;
+    return new_ids;
+}
+
 const indexed_triangle_set &SupportTreeBuilder::merged_mesh(size_t steps) const
 {
     if (m_meshcache_valid) return m_meshcache;
@@ -310,6 +310,13 @@ public:
     
     void add_pillar_base(long pid, double baseheight = 3, double radius = 2);
 
+    // Sort the pillars with IDs starting from first_id by their geometry and
+    // renumber them, so that the IDs of pillars created concurrently do not
+    // depend on the order in which the threads created them. The heads
+    // referring to the pillars are updated. Returns the new ID of each
+    // renumbered pillar, indexed by its old ID minus first_id.
+    std::vector<long> renumber_pillars(size_t first_id);
+
     template<class...Args> const Anchor& add_anchor(Args&&...args)
     {
         std::lock_guard<Mutex> lk(m_mutex);
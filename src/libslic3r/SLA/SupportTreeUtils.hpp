@@ -163,31 +163,34 @@ Hit beam_mesh_hit(Ex policy,
 
     using Hit = AABBMesh::hit_result;
 
+    // The rays around the beam are coherent, they are cast as one batch.
+    std::array<Vec3d, RayCount> srcs, dirs;
+    for (size_t i = 0; i < RayCount; ++i) {
+        // Point on the circle on the pin sphere
+        Vec3d p_src = ring.get(i, src, r_src + sd);
+        Vec3d p_dst = ring.get(i, dst, r_dst + sd);
+        dirs[i] = (p_dst - p_src).normalized();
+        srcs[i] = p_src + r_src * dirs[i];
+    }
+
     // Hit results
-    std::array<Hit, RayCount> hits;
+    std::vector<Hit> hits = mesh.query_ray_hit(srcs, dirs);
 
     execution::for_each(
         policy, size_t(0), hits.size(),
-        [&mesh, r_src, r_dst, src, dst, &ring, dir, sd, &hits](size_t i) {
+        [&mesh, r_src, sd, &srcs, &dirs, &hits](size_t i) {
             Hit &hit = hits[i];
 
-            // Point on the circle on the pin sphere
-            Vec3d p_src = ring.get(i, src, r_src + sd);
-            Vec3d p_dst = ring.get(i, dst, r_dst + sd);
-            Vec3d raydir = (p_dst - p_src).normalized();
-
-            auto hr = mesh.query_ray_hit(p_src + r_src * raydir, raydir);
-
-            if (hr.is_inside()) {
-                if (hr.distance() > 2 * r_src + sd)
+            if (hit.is_inside()) {
+                if (hit.distance() > 2 * r_src + sd)
                     hit = Hit(0.0);
                 else {
                     // re-cast the ray from the outside of the object
-                    auto q = p_src + (hr.distance() + EPSILON) * raydir;
-                    hit = mesh.query_ray_hit(q, raydir);
+                    Vec3d p_src = srcs[i] - r_src * dirs[i];
+                    auto q = p_src + (hit.distance() + EPSILON) * dirs[i];
+                    hit = mesh.query_ray_hit(q, dirs[i]);
                 }
-            } else
-                hit = hr;
+            }
         }, std::min(execution::max_concurrency(policy), RayCount));
 
     return min_hit(hits.begin(), hits.end());
@@ -214,9 +217,6 @@ Hit pinhead_mesh_hit(Ex              ex,
     auto &m         = mesh;
     using HitResult = AABBMesh::hit_result;
 
-       // Hit results
-    std::array<HitResult, SAMPLES> hits;
-
     struct Rings
     {
         double             rpin;
@@ -231,16 +231,24 @@ Hit pinhead_mesh_hit(Ex              ex,
 
     // We will shoot multiple rays from the head pinpoint in the direction
     // of the pinhead robe (side) surface. The result will be the smallest
-    // hit distance.
+    // hit distance. The rays are coherent, so they are cast as one batch.
+
+    // Points on the circle on the pin sphere and the ray directions towards
+    // the points on the circle on the back sphere.
+    std::array<Vec3d, SAMPLES> pins, srcs, dirs;
+    for (size_t i = 0; i < SAMPLES; ++i) {
+        pins[i] = rings.pinring(i);
+        dirs[i] = (rings.backring(i) - pins[i]).normalized();
+        srcs[i] = pins[i] + sd * dirs[i];
+    }
 
-    execution::for_each(
-        ex, size_t(0), hits.size(), [&m, &rings, sd, &hits](size_t i) {
-            // Point on the circle on the pin sphere
-            Vec3d ps = rings.pinring(i);
-            // This is the point on the circle on the back sphere
-            Vec3d p = rings.backring(i);
+    // Hit results
+    std::vector<HitResult> hits = m.query_ray_hit(srcs, dirs);
 
+    execution::for_each(
+        ex, size_t(0), hits.size(), [&m, &rings, sd, &pins, &dirs, &hits](size_t i) {
             auto &hit = hits[i];
+            const Vec3d &ps = pins[i], &n = dirs[i];
 
                // Point ps is not on mesh but can be inside or
                // outside as well. This would cause many problems
@@ -248,11 +256,8 @@ Hit pinhead_mesh_hit(Ex              ex,
                // use the ray-casting result (which has an is_inside
                // predicate).
 
-            Vec3d n = (p - ps).normalized();
-            auto  q = m.query_ray_hit(ps + sd * n, n);
-
-            if (q.is_inside()) { // the hit is inside the model
-                if (q.distance() > rings.rpin) {
+            if (hit.is_inside()) { // the hit is inside the model
+                if (hit.distance() > rings.rpin) {
                     // If we are inside the model and the hit
                     // distance is bigger than our pin circle
                     // diameter, it probably indicates that the
@@ -269,11 +274,9 @@ Hit pinhead_mesh_hit(Ex              ex,
                     // object. The starting point has an offset
                     // of 2*safety_distance because the
                     // original ray has also had an offset
-                    auto q2 = m.query_ray_hit(ps + (q.distance() + 2 * sd) * n, n);
-                    hit     = q2;
+                    hit = m.query_ray_hit(ps + (hit.distance() + 2 * sd) * n, n);
                 }
-            } else
-                hit = q;
+            }
         }, std::min(execution::max_concurrency(ex), SAMPLES));
 
     return min_hit(hits.begin(), hits.end());
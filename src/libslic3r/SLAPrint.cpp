@@ -313,7 +313,6 @@ SLAPrint::ApplyStatus SLAPrint::apply(const Model &model, DynamicPrintConfig con
     // Apply variables to placeholder parser. The placeholder parser is currently used
     // only to generate the output file name.
     if (! placeholder_parser_diff.empty()) {
-        // update_apply_status(this->invalidate_step(slapsRasterize));
         m_placeholder_parser.apply_config(config);
         // Set the profile aliases for the PrintBase::output_filename()
         m_placeholder_parser.set("print_preset",            config.option("sla_print_settings_id")->clone());
@@ -706,9 +705,18 @@ std::string SLAPrint::validate(std::vector<std::string>*) const
 
 void SLAPrint::export_print(const std::string &fname, const ThumbnailsList &thumbnails, const std::string &projectname)
 {
-    if (m_archiver)
-        m_archiver->export_print(fname, *this, thumbnails, projectname);
-    else {
+    if (m_archiver) {
+        // The layers are rasterized while being written into the archive, report the progress per written layer.
+        int prev_status = -1;
+        m_archiver->export_print(fname, *this, thumbnails, projectname,
+            [this, &prev_status](size_t layers_written, size_t layers_count) {
+                int status = int(100 * layers_written / layers_count);
+                if (status > prev_status) {
+                    this->set_status(status, _u8L("Rasterizing layers"));
+                    prev_status = status;
+                }
+            });
+    } else {
         throw ExportError(format(_u8L("Unknown archive format: %s"), m_printer_config.sla_archive_format.value));
     }
 }
@@ -757,7 +765,7 @@ void SLAPrint::process()
         slaposSliceSupports
     };
 
-    SLAPrintStep print_steps[] = { slapsMergeSlicesAndEval, slapsRasterize };
+    SLAPrintStep print_steps[] = { slapsMergeSlicesAndEval };
     
     double st = Steps::min_objstatus;
 
@@ -992,7 +1000,10 @@ bool SLAPrintObject::invalidate_state_by_config_options(const std::vector<t_conf
     std::vector<SLAPrintObjectStep> steps;
     bool invalidated = false;
     for (const t_config_option_key &opt_key : opt_keys) {
-        if (   opt_key == "hollowing_enable"
+        if (opt_key == "slice_level_csg") {
+            // All the preview meshes are generated differently.
+            steps.emplace_back(slaposAssembly);
+        } else if (   opt_key == "hollowing_enable"
             || opt_key == "hollowing_min_thickness"
             || opt_key == "hollowing_quality"
             || opt_key == "hollowing_closing_distance"
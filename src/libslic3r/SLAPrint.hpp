@@ -26,6 +26,7 @@
 
 #include "PrintBase.hpp"
 #include "SLA/SupportTree.hpp"
+#include "SLA/PinheadCache.hpp"
 #include "SLA/SupportPointGenerator.hpp" // SupportPointGeneratorData
 #include "Point.hpp"
 #include "Format/SLAArchiveWriter.hpp"
@@ -52,7 +53,6 @@ struct JobController;
 
 enum SLAPrintStep : unsigned int {
     slapsMergeSlicesAndEval,
-    slapsRasterize,
 	slapsCount
 };
 
@@ -291,8 +291,8 @@ public:
     //
     // These methods should be callable on the client side (e.g. UI thread)
     // when the appropriate steps slaposObjectSlice and slaposSliceSupports
-    // are ready. All the print objects are processed before slapsRasterize so
-    // it is safe to call them during and/or after slapsRasterize.
+    // are ready. All the print objects are processed before slapsMergeSlicesAndEval
+    // so it is safe to call them during and/or after slapsMergeSlicesAndEval.
     //
     // /////////////////////////////////////////////////////////////////////////
 
@@ -376,14 +376,24 @@ private:
         sla::SupportableMesh    input; // the input
         std::vector<ExPolygons> support_slices;   // sliced supports
         TriangleMesh tree_mesh, pad_mesh, full_mesh; // cached artifacts
-        
+        // Pinheads of the last support tree generation. The support data
+        // is discarded together with the cache whenever the mesh changes.
+        sla::PinheadCache       pinhead_cache;
+
         inline SupportData(const TriangleMesh &t)
             : input{t.its, {}, {}}
-        {}
+        {
+            input.pinhead_cache = &pinhead_cache;
+        }
 
         inline SupportData(const indexed_triangle_set &t)
             : input{t, {}, {}}
-        {}
+        {
+            input.pinhead_cache = &pinhead_cache;
+        }
+
+        SupportData(const SupportData &) = delete;
+        SupportData& operator=(const SupportData &) = delete;
         
         void create_support_tree(const sla::JobController &ctl)
         {
@@ -502,7 +512,7 @@ public:
     // Returns true if an object step is done on all objects and there's at least one object.
     bool                is_step_done(SLAPrintObjectStep step) const;
     // Returns true if the last step was finished with success.
-    bool                finished() const override { return this->is_step_done(slaposSliceSupports) && this->Inherited::is_step_done(slapsRasterize); }
+    bool                finished() const override { return this->is_step_done(slaposSliceSupports) && this->Inherited::is_step_done(slapsMergeSlicesAndEval); }
 
     const PrintObjects& objects() const { return m_objects; }
     // PrintObject by its ObjectID, to be used to uniquely bind slicing warnings to their source PrintObjects
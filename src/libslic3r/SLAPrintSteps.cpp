@@ -17,6 +17,7 @@
 #include <libslic3r/CSGMesh/PerformCSGMeshBooleans.hpp>
 #include <libslic3r/OpenVDBUtils.hpp>
 #include <libslic3r/QuadricEdgeCollapse.hpp>
+#include <libslic3r/SlicesToTriangleMesh.hpp>
 #include <libslic3r/ClipperUtils.hpp>
 #include <libslic3r/KDTreeIndirect.hpp>
 #include <chrono>
@@ -92,15 +93,13 @@ std::string OBJ_STEP_LABELS(size_t idx)
 }
 
 const std::array<unsigned, slapsCount> PRINT_STEP_LEVELS = {
-    10, // slapsMergeSlicesAndEval
-    90, // slapsRasterize
+    100, // slapsMergeSlicesAndEval
 };
 
 std::string PRINT_STEP_LABELS(size_t idx)
 {
     switch (idx) {
     case slapsMergeSlicesAndEval:   return _u8L("Merging slices and calculating statistics");
-    case slapsRasterize:            return _u8L("Rasterizing layers");
     default:;
     }
     assert(false); return "Out of bounds!";
@@ -268,6 +267,12 @@ void SLAPrint::Steps::generate_preview(SLAPrintObject &po, SLAPrintObjectStep st
     if (is_all_positive(r)) {
         m = csgmesh_merge_positive_parts(r);
         handled = true;
+    } else if (po.m_config.slice_level_csg.getBool()) {
+        // The negative parts are only subtracted from the slices. Until the
+        // object is sliced, the positive parts are previewed, slice_model()
+        // replaces them with a mesh reconstructed from the slices.
+        m = csgmesh_merge_positive_parts(r);
+        handled = true;
     } else if (csg::check_csgmesh_booleans(r) == r.end()) {
         MeshBoolean::cgal::CGALMeshPtr cgalmeshptr;
         try {
@@ -633,6 +638,27 @@ void SLAPrint::Steps::slice_model(SLAPrintObject &po)
         mit->set_model_slice_idx(po, id); ++mit;
     }
 
+    po.m_preview_meshes[slaposObjectSlice] = {};
+    if (po.m_config.slice_level_csg.getBool() &&
+        !is_all_positive(po.mesh_to_slice()) && !po.m_model_slices.empty()) {
+        // No mesh booleans were performed in the previous steps, the mesh to
+        // print (and to generate the supports for) is reconstructed from the
+        // slices before the printer corrections are applied.
+        std::vector<float> tops;
+        tops.reserve(po.m_model_slices.size());
+        for (auto it = slindex_it; tops.size() < po.m_model_slices.size(); ++it)
+            tops.emplace_back(unscaled<float>(it->print_level()));
+
+        po.m_preview_meshes[slaposObjectSlice] =
+            std::make_shared<const indexed_triangle_set>(
+                slices_to_mesh(po.m_model_slices,
+                               tops.front() - slindex_it->layer_height(), tops));
+
+        using namespace std::string_literals;
+        report_status(-2, "Reload preview from step "s + std::to_string(int(slaposObjectSlice)),
+                      SlicingStatus::RELOAD_SLA_PREVIEW);
+    }
+
     // We apply the printer correction offset here.
     apply_printer_corrections(po, soModel);
 
@@ -1453,57 +1479,6 @@ void SLAPrint::Steps::merge_slices_and_eval_stats() {
     report_status(-2, "", SlicingStatus::RELOAD_SLA_PREVIEW);
 }
 
-// Rasterizing the model objects, and their supports
-void SLAPrint::Steps::rasterize()
-{
-    if(canceled() || !m_print->m_archiver) return;
-
-    // coefficient to map the rasterization state (0-99) to the allocated
-    // portion (slot) of the process state
-    double sd = (100 - max_objstatus) / 100.0;
-
-    // slot is the portion of 100% that is realted to rasterization
-    unsigned slot = PRINT_STEP_LEVELS[slapsRasterize];
-
-    // pst: previous state
-    double pst = current_status();
-
-    double increment = (slot * sd) / m_print->m_printer_input.size();
-    double dstatus = current_status();
-
-    execution::SpinningMutex<ExecutionTBB> slck;
-
-    // procedure to process one height level. This will run in parallel
-    auto lvlfn =
-        [this, &slck, increment, &dstatus, &pst]
-        (sla::RasterBase& raster, size_t idx)
-    {
-        PrintLayer& printlayer = m_print->m_printer_input[idx];
-        if(canceled()) return;
-
-        for (const ExPolygon& poly : printlayer.transformed_slices())
-            raster.draw(poly);
-
-        // Status indication guarded with the spinlock
-        {
-            std::lock_guard lck(slck);
-            dstatus += increment;
-            double st = std::round(dstatus);
-            if(st > pst) {
-                report_status(st, PRINT_STEP_LABELS(slapsRasterize));
-                pst = st;
-            }
-        }
-    };
-
-    // last minute escape
-    if(canceled()) return;
-
-    // Print all the layers in parallel
-    m_print->m_archiver->draw_layers(m_print->m_printer_input.size(), lvlfn,
-                                    [this]() { return canceled(); }, ex_tbb);
-}
-
 std::string SLAPrint::Steps::label(SLAPrintObjectStep step)
 {
     return OBJ_STEP_LABELS(step);
@@ -1543,7 +1518,6 @@ void SLAPrint::Steps::execute(SLAPrintStep step)
 {
     switch (step) {
     case slapsMergeSlicesAndEval: merge_slices_and_eval_stats(); break;
-    case slapsRasterize: rasterize(); break;
     case slapsCount: assert(false);
     }
 }
@@ -71,7 +71,6 @@ public:
     void slice_supports(SLAPrintObject& po);
 
     void merge_slices_and_eval_stats();
-    void rasterize();
 
     void execute(SLAPrintObjectStep step, SLAPrintObject &obj);
     void execute(SLAPrintStep step);
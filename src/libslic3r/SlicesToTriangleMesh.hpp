@@ -13,6 +13,12 @@
 
 namespace Slic3r {
 
+// Stack the slices into a closed stepped mesh. grid contains the top of each
+// layer, zmin is the bottom of the first one.
+indexed_triangle_set slices_to_mesh(const std::vector<ExPolygons> &slices,
+                                    double                         zmin,
+                                    const std::vector<float>      &grid);
+
 void slices_to_mesh(indexed_triangle_set &         mesh,
                     const std::vector<ExPolygons> &slices,
                     double                         zmin,
@@ -26,6 +26,7 @@
 #include <oneapi/tbb/blocked_range.h>
 #include <oneapi/tbb/concurrent_vector.h>
 #include <oneapi/tbb/parallel_for.h>
+#include <oneapi/tbb/parallel_sort.h>
 #include <cmath>
 #include <vector>
 #include <utility>
@@ -38,6 +39,7 @@
 
 #include "TriangleMesh.hpp"
 #include "TriangleMeshSlicer.hpp"
+#include "TriangleMeshRepair.hpp"
 #include "MeshSplitImpl.hpp"
 #include "ClipperUtils.hpp"
 #include "Geometry.hpp"
@@ -93,110 +95,6 @@ TriangleMesh::TriangleMesh(indexed_triangle_set &&its, const RepairedMeshErrors&
     fill_initial_stats(this->its, m_stats);
 }
 
-// #define SLIC3R_TRACE_REPAIR
-
-static void trianglemesh_repair_on_import(stl_file &stl)
-{
-    // admesh fails when repairing empty meshes
-    if (stl.stats.number_of_facets == 0)
-        return;
-
-    BOOST_LOG_TRIVIAL(debug) << "TriangleMesh::repair() started";
-
-    // checking exact
-#ifdef SLIC3R_TRACE_REPAIR
-    BOOST_LOG_TRIVIAL(trace) << "\tstl_check_faces_exact";
-#endif /* SLIC3R_TRACE_REPAIR */
-    assert(stl_validate(&stl));
-    stl_check_facets_exact(&stl);
-    assert(stl_validate(&stl));
-    stl.stats.facets_w_1_bad_edge = (stl.stats.connected_facets_2_edge - stl.stats.connected_facets_3_edge);
-    stl.stats.facets_w_2_bad_edge = (stl.stats.connected_facets_1_edge - stl.stats.connected_facets_2_edge);
-    stl.stats.facets_w_3_bad_edge = (stl.stats.number_of_facets - stl.stats.connected_facets_1_edge);
-    
-    // checking nearby
-    //int last_edges_fixed = 0;
-    float tolerance = (float)stl.stats.shortest_edge;
-    float increment = (float)stl.stats.bounding_diameter / 10000.0f;
-    int iterations = 2;
-    if (stl.stats.connected_facets_3_edge < int(stl.stats.number_of_facets)) {
-        // Not a manifold, some triangles have unconnected edges.
-        for (int i = 0; i < iterations; ++ i) {
-            if (stl.stats.connected_facets_3_edge < int(stl.stats.number_of_facets)) {
-                // Still not a manifold, some triangles have unconnected edges.
-                //printf("Checking nearby. Tolerance= %f Iteration=%d of %d...", tolerance, i + 1, iterations);
-#ifdef SLIC3R_TRACE_REPAIR
-                BOOST_LOG_TRIVIAL(trace) << "\tstl_check_faces_nearby";
-#endif /* SLIC3R_TRACE_REPAIR */
-                stl_check_facets_nearby(&stl, tolerance);
-                //printf("  Fixed %d edges.\n", stl.stats.edges_fixed - last_edges_fixed);
-                //last_edges_fixed = stl.stats.edges_fixed;
-                tolerance += increment;
-            } else {
-                break;
-            }
-        }
-    }
-    assert(stl_validate(&stl));
-    
-    // remove_unconnected
-    if (stl.stats.connected_facets_3_edge < (int)stl.stats.number_of_facets) {
-#ifdef SLIC3R_TRACE_REPAIR
-        BOOST_LOG_TRIVIAL(trace) << "\tstl_remove_unconnected_facets";
-#endif /* SLIC3R_TRACE_REPAIR */
-        stl_remove_unconnected_facets(&stl);
-        assert(stl_validate(&stl));
-    }
-    
-    // fill_holes
-#if 0
-    // Don't fill holes, the current algorithm does more harm than good on complex holes.
-    // Rather let the slicing algorithm close gaps in 2D slices.
-    if (stl.stats.connected_facets_3_edge < stl.stats.number_of_facets) {
-#ifdef SLIC3R_TRACE_REPAIR
-        BOOST_LOG_TRIVIAL(trace) << "\tstl_fill_holes";
-#endif /* SLIC3R_TRACE_REPAIR */
-        stl_fill_holes(&stl);
-        stl_clear_error(&stl);
-    }
-#endif
-
-    // normal_directions
-#ifdef SLIC3R_TRACE_REPAIR
-    BOOST_LOG_TRIVIAL(trace) << "\tstl_fix_normal_directions";
-#endif /* SLIC3R_TRACE_REPAIR */
-    stl_fix_normal_directions(&stl);
-    assert(stl_validate(&stl));
-
-    // normal_values
-#ifdef SLIC3R_TRACE_REPAIR
-    BOOST_LOG_TRIVIAL(trace) << "\tstl_fix_normal_values";
-#endif /* SLIC3R_TRACE_REPAIR */
-    stl_fix_normal_values(&stl);
-    assert(stl_validate(&stl));
-    
-    // always calculate the volume and reverse all normals if volume is negative
-#ifdef SLIC3R_TRACE_REPAIR
-    BOOST_LOG_TRIVIAL(trace) << "\tstl_calculate_volume";
-#endif /* SLIC3R_TRACE_REPAIR */
-    // If the volume is negative, all the facets are flipped and added to stats.facets_reversed.
-    stl_calculate_volume(&stl);
-    assert(stl_validate(&stl));
-    
-    // neighbors
-#ifdef SLIC3R_TRACE_REPAIR
-    BOOST_LOG_TRIVIAL(trace) << "\tstl_verify_neighbors";
-#endif /* SLIC3R_TRACE_REPAIR */
-    stl_verify_neighbors(&stl);
-    assert(stl_validate(&stl));
-
-    //FIXME The admesh repair function may break the face connectivity, rather refresh it here as the slicing code relies on it.
-    if (auto nr_degenerated = stl.stats.degenerate_facets; stl.stats.number_of_facets > 0 && nr_degenerated > 0)
-        stl_check_facets_exact(&stl);
-
-    BOOST_LOG_TRIVIAL(debug) << "TriangleMesh::repair() finished";
-}
-
 void TriangleMesh::from_facets(std::vector<stl_facet> &&facets, bool repair)
 {
     stl_file stl;
@@ -207,11 +105,10 @@ void TriangleMesh::from_facets(std::vector<stl_facet> &&facets, bool repair)
     stl_allocate(&stl);
     stl.facet_start               = std::move(facets);
 
-    if (repair) {
-        trianglemesh_repair_on_import(stl);
-    }
-
-    stl_generate_shared_vertices(&stl, this->its);
+    if (repair)
+        this->its = its_repair_stl(stl);
+    else
+        stl_generate_shared_vertices(&stl, this->its);
     fill_initial_stats(this->its, this->m_stats);
 }
 
@@ -221,7 +118,7 @@ bool TriangleMesh::ReadSTLFile(const char* input_file, bool repair)
     if (! stl_open(&stl, input_file))
         return false;
     if (repair)
-        trianglemesh_repair_on_import(stl);
+        this->its = its_repair_stl(stl);
 
     m_stats.number_of_facets        = stl.stats.number_of_facets;
     m_stats.min                     = stl.stats.min;
@@ -242,7 +139,8 @@ bool TriangleMesh::ReadSTLFile(const char* input_file, bool repair)
 
     m_stats.number_of_parts         = stl.stats.number_of_parts;
 
-    stl_generate_shared_vertices(&stl, this->its);
+    if (! repair)
+        stl_generate_shared_vertices(&stl, this->its);
     return true;
 }
 
@@ -721,27 +619,33 @@ std::vector<Vec3i> its_face_edge_ids(const indexed_triangle_set &its, std::vecto
 // Merge duplicate vertices, return number of vertices removed.
 int its_merge_vertices(indexed_triangle_set &its, bool shrink_to_fit)
 {
-    // 1) Sort indices to vertices lexicographically by coordinates AND vertex index.
-    auto sorted = reserve_vector<int>(its.vertices.size());
-    for (int i = 0; i < int(its.vertices.size()); ++ i)
-        sorted.emplace_back(i);
-    std::sort(sorted.begin(), sorted.end(), [&its](int il, int ir) {
-        const Vec3f &l = its.vertices[il];
-        const Vec3f &r = its.vertices[ir];
+    // 1) Sort vertices lexicographically by coordinates AND vertex index.
+    // The coordinates are sorted along with the indices, which is much more cache friendly than sorting the indices only.
+    struct SortedVertex {
+        Vec3f p;
+        int   idx;
+    };
+    std::vector<SortedVertex> sorted(its.vertices.size());
+    execution::for_each(ex_tbb, size_t(0), sorted.size(), [&its, &sorted](size_t i) {
+        sorted[i] = { its.vertices[i], int(i) };
+    }, 4096);
+    tbb::parallel_sort(sorted.begin(), sorted.end(), [](const SortedVertex &vl, const SortedVertex &vr) {
+        const Vec3f &l = vl.p;
+        const Vec3f &r = vr.p;
         // Sort lexicographically by coordinates AND vertex index.
-        return l.x() < r.x() || (l.x() == r.x() && (l.y() < r.y() || (l.y() == r.y() && (l.z() < r.z() || (l.z() == r.z() && il < ir)))));
+        return l.x() < r.x() || (l.x() == r.x() && (l.y() < r.y() || (l.y() == r.y() && (l.z() < r.z() || (l.z() == r.z() && vl.idx < vr.idx)))));
     });
 
     // 2) Map duplicate vertices to the one with the lowest vertex index.
     // The vertex to stay will have a map_vertices[...] == -1 index assigned, the other vertices will point to it.
     std::vector<int> map_vertices(its.vertices.size(), -1);
     for (int i = 0; i < int(sorted.size());) {
-        const int    u = sorted[i];
-        const Vec3f &p = its.vertices[u];
+        const int    u = sorted[i].idx;
+        const Vec3f &p = sorted[i].p;
         int j = i;
         for (++ j; j < int(sorted.size()); ++ j) {
-            const int    v = sorted[j];
-            const Vec3f &q = its.vertices[v];
+            const int    v = sorted[j].idx;
+            const Vec3f &q = sorted[j].p;
             if (p != q)
                 break;
             assert(v > u);
@@ -749,6 +653,8 @@ int its_merge_vertices(indexed_triangle_set &its, bool shrink_to_fit)
         }
         i = j;
     }
+    // Release the memory before the vertices are shrunk.
+    sorted = {};
 
     // 3) Shrink its.vertices, update map_vertices with the new vertex indices.
     int k = 0;
@@ -770,9 +676,11 @@ int its_merge_vertices(indexed_triangle_set &its, bool shrink_to_fit)
         // Shrink the vertices.
         its.vertices.erase(its.vertices.begin() + k, its.vertices.end());
         // Remap face indices.
-        for (stl_triangle_vertex_indices &face : its.indices)
+        execution::for_each(ex_tbb, size_t(0), its.indices.size(), [&its, &map_vertices](size_t iface) {
+            stl_triangle_vertex_indices &face = its.indices[iface];
             for (int i = 0; i < 3; ++ i)
                 face(i) = map_vertices[face(i)];
+        }, 4096);
         // Optionally shrink to fit (reallocate) vertices.
         if (shrink_to_fit)
             its.vertices.shrink_to_fit();
@@ -0,0 +1,813 @@
+///|/ Copyright (c) Prusa Research 2024
+///|/
+///|/ PrusaSlicer is released under the terms of the AGPLv3 or higher
+///|/
+#include "TriangleMeshRepair.hpp"
+
+#include <boost/container_hash/hash.hpp>
+#include <boost/log/trivial.hpp>
+#include <oneapi/tbb/parallel_sort.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "Execution/ExecutionTBB.hpp"
+
+namespace Slic3r {
+
+namespace {
+
+// Number of facets processed by a single task.
+constexpr size_t Granularity = 4096;
+
+// An edge of a facet as admesh stores it in its hash tables: which_edge is the index of the edge inside the facet,
+// increased by 3 if the edge is stored backwards.
+struct EdgeRef {
+    int facet;
+    int which_edge;
+};
+
+// Indexed counterpart of admesh stl_file. The facets reference vertices, which are unique by their coordinates,
+// thus comparing vertex indices is equivalent to comparing vertex coordinates as admesh does.
+// The neighborship is stored in the very same form as admesh stores it, so that the fan traversals and the facet
+// reversals are performed exactly the same way as admesh performs them.
+class MeshRepair
+{
+public:
+    explicit MeshRepair(const stl_file &stl);
+
+    void check_facets_exact();
+    void check_facets_nearby(float tolerance);
+    void remove_unconnected_facets();
+    void fix_normal_directions();
+    // stl_fix_normal_values() and stl_calculate_volume() in one go.
+    void calculate_volume();
+    void verify_neighbors();
+    indexed_triangle_set generate_shared_vertices() const;
+
+    stl_stats stats;
+
+private:
+    bool       degenerate(size_t facet) const
+        { const stl_triangle_vertex_indices &f = m_faces[facet]; return f(0) == f(1) || f(1) == f(2) || f(0) == f(2); }
+    // Which edge of the facet, increased by 3 if the edge goes from a higher vertex index to a lower one.
+    EdgeRef    edge_ref(int facet, int edge) const
+        { return { facet, m_faces[facet](edge) < m_faces[facet]((edge + 1) % 3) ? edge : edge + 3 }; }
+    // stl_calculate_normal() followed by stl_normalize_vector().
+    stl_normal facet_normal(size_t facet) const;
+    // check_normal_vector() of admesh with normal_fix_flag == 0: Is the normal stored in the STL file pointing backwards?
+    bool       normal_backwards(size_t facet) const;
+
+    void       record_neighbors(const EdgeRef &edge_a, const EdgeRef &edge_b);
+    void       update_connects_add_1(int facet);
+    void       match_neighbors_nearby(const EdgeRef &edge_a, const EdgeRef &edge_b);
+    void       change_vertices(int facet, int vnot, int new_vertex);
+    void       remove_facet(int facet);
+    void       remove_degenerate(int facet);
+    void       reverse_facet(int facet);
+    // Orient a single patch starting with facet seed. Returns false if admesh would give up orienting the facets.
+    bool       fix_patch_normal_directions(int seed, std::vector<char> &norm_sw, std::vector<int> &reversed);
+
+    std::vector<stl_vertex>                  m_vertices;
+    std::vector<stl_triangle_vertex_indices> m_faces;
+    // Normals as read from the STL file, only used to decide orientation of the first facet of a patch.
+    std::vector<stl_normal>                  m_normals;
+    std::vector<stl_neighbors>               m_neighbors;
+};
+
+MeshRepair::MeshRepair(const stl_file &stl) : stats(stl.stats)
+{
+    const size_t num_facets = stl.stats.number_of_facets;
+    indexed_triangle_set its;
+    its.vertices.assign(num_facets * 3, stl_vertex::Zero());
+    its.indices.assign(num_facets, stl_triangle_vertex_indices::Zero());
+    m_normals.assign(num_facets, stl_normal::Zero());
+    execution::for_each(ex_tbb, size_t(0), num_facets, [this, &stl, &its](size_t i) {
+        const stl_facet &facet = stl.facet_start[i];
+        for (int j = 0; j < 3; ++ j)
+            its.vertices[i * 3 + j] = facet.vertex[j];
+        its.indices[i] = stl_triangle_vertex_indices(int(i * 3), int(i * 3 + 1), int(i * 3 + 2));
+        m_normals[i]   = facet.normal;
+    }, Granularity);
+    // Positive and negative zeros are merged, as admesh considers them equal.
+    its_merge_vertices(its);
+    m_vertices = std::move(its.vertices);
+    m_faces    = std::move(its.indices);
+    m_neighbors.assign(num_facets, stl_neighbors());
+}
+
+stl_normal MeshRepair::facet_normal(size_t facet) const
+{
+    const stl_triangle_vertex_indices &f = m_faces[facet];
+    stl_normal normal = (m_vertices[f(1)] - m_vertices[f(0)]).cross(m_vertices[f(2)] - m_vertices[f(0)]);
+    stl_normalize_vector(normal);
+    return normal;
+}
+
+bool MeshRepair::normal_backwards(size_t facet) const
+{
+    const stl_normal normal = this->facet_normal(facet);
+    const float      eps    = 0.001f;
+    auto within_eps = [&normal, eps](const stl_normal &n) {
+        const stl_normal normal_dif = (normal - n).cwiseAbs();
+        return normal_dif(0) < eps && normal_dif(1) < eps && normal_dif(2) < eps;
+    };
+    if (within_eps(m_normals[facet]))
+        return false;
+    stl_normal test_norm = m_normals[facet];
+    stl_normalize_vector(test_norm);
+    if (within_eps(test_norm))
+        return false;
+    test_norm *= -1.f;
+    return within_eps(test_norm);
+}
+
+void MeshRepair::record_neighbors(const EdgeRef &edge_a, const EdgeRef &edge_b)
+{
+    stl_neighbors &neighbors_a = m_neighbors[edge_a.facet];
+    stl_neighbors &neighbors_b = m_neighbors[edge_b.facet];
+    neighbors_a.neighbor[edge_a.which_edge % 3]         = edge_b.facet;
+    neighbors_a.which_vertex_not[edge_a.which_edge % 3] = (edge_b.which_edge + 2) % 3;
+    neighbors_b.neighbor[edge_b.which_edge % 3]         = edge_a.facet;
+    neighbors_b.which_vertex_not[edge_b.which_edge % 3] = (edge_a.which_edge + 2) % 3;
+    if ((edge_a.which_edge < 3) == (edge_b.which_edge < 3)) {
+        // These facets are oriented in opposite directions, their normals are probably messed up.
+        neighbors_a.which_vertex_not[edge_a.which_edge % 3] += 3;
+        neighbors_b.which_vertex_not[edge_b.which_edge % 3] += 3;
+    }
+}
+
+void MeshRepair::update_connects_add_1(int facet)
+{
+    switch (m_neighbors[facet].num_neighbors()) {
+    case 1: ++ stats.connected_facets_1_edge; break;
+    case 2: ++ stats.connected_facets_2_edge; break;
+    case 3: ++ stats.connected_facets_3_edge; break;
+    default: assert(false);
+    }
+}
+
+void MeshRepair::check_facets_exact()
+{
+    // Remove degenerate facets first, moving the last facet into the place of the removed one.
+    for (uint32_t i = 0; i < stats.number_of_facets;) {
+        if (this->degenerate(i)) {
+            -- stats.number_of_facets;
+            m_faces[i]   = m_faces.back();
+            m_normals[i] = m_normals.back();
+            m_faces.pop_back();
+            m_normals.pop_back();
+            m_neighbors.pop_back();
+            ++ stats.facets_removed;
+            ++ stats.degenerate_facets;
+        } else
+            ++ i;
+    }
+
+    const size_t num_facets = stats.number_of_facets;
+    const size_t num_edges  = num_facets * 3;
+    // Edges are keyed by their end vertex indices, lower index first. Edges with equal keys are sorted by
+    // their facet and edge index, which is the order admesh inserts the edges into its hash table.
+    struct EdgeKey {
+        uint64_t key;
+        uint32_t edge;
+    };
+    std::vector<EdgeKey> edges(num_edges);
+    execution::for_each(ex_tbb, size_t(0), num_facets, [this, &edges](size_t i) {
+        m_neighbors[i].reset();
+        const stl_triangle_vertex_indices &f = m_faces[i];
+        for (int j = 0; j < 3; ++ j) {
+            uint64_t a = uint32_t(f(j));
+            uint64_t b = uint32_t(f((j + 1) % 3));
+            if (a > b)
+                std::swap(a, b);
+            edges[i * 3 + j] = { (a << 32) | b, uint32_t(i * 3 + j) };
+        }
+    }, Granularity);
+    stats.shortest_edge = execution::reduce(ex_tbb, size_t(0), num_facets, stats.shortest_edge,
+        [](float l, float r) { return std::min(l, r); },
+        [this](size_t i) {
+            const stl_triangle_vertex_indices &f = m_faces[i];
+            float shortest = std::numeric_limits<float>::max();
+            for (int j = 0; j < 3; ++ j)
+                shortest = std::min(shortest, (m_vertices[f(j)] - m_vertices[f((j + 1) % 3)]).cwiseAbs().maxCoeff());
+            return shortest;
+        }, Granularity);
+    tbb::parallel_sort(edges.begin(), edges.end(),
+        [](const EdgeKey &l, const EdgeKey &r) { return l.key < r.key || (l.key == r.key && l.edge < r.edge); });
+
+    // Connect neighbor edges. The admesh hash table matches an edge with the first unmatched equal edge,
+    // thus a run of equal edges is connected pair wise.
+    execution::for_each(ex_tbb, size_t(0), num_edges, [this, &edges, num_edges](size_t i) {
+        if (i > 0 && edges[i - 1].key == edges[i].key)
+            // Not the first edge of a run.
+            return;
+        for (size_t j = i; j + 1 < num_edges && edges[j + 1].key == edges[i].key; j += 2)
+            this->record_neighbors(this->edge_ref(edges[j + 1].edge / 3, edges[j + 1].edge % 3),
+                                   this->edge_ref(edges[j].edge / 3, edges[j].edge % 3));
+    }, Granularity);
+
+    using Connects = std::array<int, 4>;
+    const Connects connects = execution::reduce(ex_tbb, size_t(0), num_facets, Connects{ 0, 0, 0, 0 },
+        [](const Connects &l, const Connects &r) { return Connects{ l[0] + r[0], l[1] + r[1], l[2] + r[2], l[3] + r[3] }; },
+        [this](size_t i) {
+            const int n = m_neighbors[i].num_neighbors();
+            return Connects{ n, n >= 1, n >= 2, n == 3 };
+        }, Granularity);
+    stats.connected_edges         = connects[0];
+    stats.connected_facets_1_edge = connects[1];
+    stats.connected_facets_2_edge = connects[2];
+    stats.connected_facets_3_edge = connects[3];
+}
+
+void MeshRepair::check_facets_nearby(float tolerance)
+{
+    if (stats.connected_facets_3_edge == int(stats.number_of_facets))
+        // No need to check any further.  All facets are connected.
+        return;
+
+    // Key of an edge: Indices of grid cells of its end points, spaced by tolerance.
+    using Key = std::array<int32_t, 6>;
+    struct KeyHash {
+        size_t operator()(const Key &k) const { return boost::hash_range(k.begin(), k.end()); }
+    };
+    // Only the open edges are hashed, they are matched in the order of insertion as admesh does.
+    std::unordered_map<Key, std::vector<EdgeRef>, KeyHash> open_edges;
+
+    for (uint32_t i = 0; i < stats.number_of_facets; ++ i) {
+        // Vertices of the facet before it is modified by matching its edges.
+        const stl_triangle_vertex_indices facet = m_faces[i];
+        for (int j = 0; j < 3; ++ j) {
+            if (m_neighbors[i].neighbor[j] != -1)
+                continue;
+            using Vec3i32 = Eigen::Matrix<int32_t, 3, 1, Eigen::DontAlign>;
+            EdgeRef edge { int(i), j };
+            Vec3i32 vertex1 = ((m_vertices[facet(j)] - stats.min) / tolerance).cast<int32_t>();
+            Vec3i32 vertex2 = ((m_vertices[facet((j + 1) % 3)] - stats.min) / tolerance).cast<int32_t>();
+            if (vertex1 == vertex2)
+                // Both vertices hash to the same value.
+                continue;
+            if (! ((vertex1[0] != vertex2[0]) ? (vertex1[0] < vertex2[0]) : (vertex1[1] != vertex2[1]) ? (vertex1[1] < vertex2[1]) : (vertex1[2] < vertex2[2]))) {
+                std::swap(vertex1, vertex2);
+                // This edge is loaded backwards.
+                edge.which_edge += 3;
+            }
+            std::vector<EdgeRef> &pending = open_edges[Key{ vertex1[0], vertex1[1], vertex1[2], vertex2[0], vertex2[1], vertex2[2] }];
+            // Edges of the same facet are not matched.
+            if (auto it = std::find_if(pending.begin(), pending.end(), [&edge](const EdgeRef &e) { return e.facet != edge.facet; });
+                it == pending.end())
+                pending.push_back(edge);
+            else {
+                const EdgeRef other = *it;
+                pending.erase(it);
+                this->match_neighbors_nearby(edge, other);
+            }
+        }
+    }
+}
+
+void MeshRepair::match_neighbors_nearby(const EdgeRef &edge_a, const EdgeRef &edge_b)
+{
+    this->record_neighbors(edge_a, edge_b);
+    stats.connected_edges += 2;
+    this->update_connects_add_1(edge_a.facet);
+    this->update_connects_add_1(edge_b.facet);
+
+    // Which vertices to change
+    int facet1 = -1;
+    int facet2 = -1;
+    int vertex1 = 0, vertex2 = 0;
+    int new_vertex1 = -1, new_vertex2 = -1;
+    {
+        // pair 1 & 2, facet a & b
+        int v1a, v1b, v2a, v2b;
+        if (edge_a.which_edge < 3) {
+            v1a = edge_a.which_edge;
+            v2a = (edge_a.which_edge + 1) % 3;
+        } else {
+            v2a = edge_a.which_edge % 3;
+            v1a = (edge_a.which_edge + 1) % 3;
+        }
+        if (edge_b.which_edge < 3) {
+            v1b = edge_b.which_edge;
+            v2b = (edge_b.which_edge + 1) % 3;
+        } else {
+            v2b = edge_b.which_edge % 3;
+            v1b = (edge_b.which_edge + 1) % 3;
+        }
+        const stl_triangle_vertex_indices &face_a      = m_faces[edge_a.facet];
+        const stl_triangle_vertex_indices &face_b      = m_faces[edge_b.facet];
+        const stl_neighbors               &neighbors_a = m_neighbors[edge_a.facet];
+
+        // Of the first pair, which vertex, if any, should be changed
+        if (face_a(v1a) != face_b(v1b)) {
+            if (neighbors_a.neighbor[v1a] == -1 && neighbors_a.neighbor[(v1a + 2) % 3] == -1) {
+                // This vertex has no neighbors.  This is a good one to change.
+                facet1      = edge_a.facet;
+                vertex1     = v1a;
+                new_vertex1 = face_b(v1b);
+            } else {
+                facet1      = edge_b.facet;
+                vertex1     = v1b;
+                new_vertex1 = face_a(v1a);
+            }
+        }
+
+        // Of the second pair, which vertex, if any, should be changed.
+        // admesh tests the second pair for equality, not for inequality. Keep it to produce the same results.
+        if (face_a(v2a) == face_b(v2b)) {
+            if (neighbors_a.neighbor[v2a] == -1 && neighbors_a.neighbor[(v2a + 2) % 3] == -1) {
+                facet2      = edge_a.facet;
+                vertex2     = v2a;
+                new_vertex2 = face_b(v2b);
+            } else {
+                facet2      = edge_b.facet;
+                vertex2     = v2b;
+                new_vertex2 = face_a(v2a);
+            }
+        }
+    }
+
+    if (facet1 != -1) {
+        int vnot1 = (facet1 == edge_a.facet) ? (edge_a.which_edge + 2) % 3 : (edge_b.which_edge + 2) % 3;
+        if ((vnot1 + 2) % 3 == vertex1)
+            vnot1 += 3;
+        this->change_vertices(facet1, vnot1, new_vertex1);
+    }
+    if (facet2 != -1) {
+        int vnot2 = (facet2 == edge_a.facet) ? (edge_a.which_edge + 2) % 3 : (edge_b.which_edge + 2) % 3;
+        if ((vnot2 + 2) % 3 == vertex2)
+            vnot2 += 3;
+        this->change_vertices(facet2, vnot2, new_vertex2);
+    }
+    stats.edges_fixed += 2;
+}
+
+void MeshRepair::change_vertices(int facet_num, int vnot, int new_vertex)
+{
+    const int first_facet = facet_num;
+    bool      direction   = false;
+    for (;;) {
+        int pivot_vertex;
+        int next_edge;
+        if (vnot > 2) {
+            if (direction) {
+                pivot_vertex = (vnot + 1) % 3;
+                next_edge    = vnot % 3;
+            } else {
+                pivot_vertex = (vnot + 2) % 3;
+                next_edge    = pivot_vertex;
+            }
+            direction = ! direction;
+        } else {
+            if (direction) {
+                pivot_vertex = (vnot + 2) % 3;
+                next_edge    = pivot_vertex;
+            } else {
+                pivot_vertex = (vnot + 1) % 3;
+                next_edge    = vnot;
+            }
+        }
+        m_faces[facet_num](pivot_vertex) = new_vertex;
+        vnot      = m_neighbors[facet_num].which_vertex_not[next_edge];
+        facet_num = m_neighbors[facet_num].neighbor[next_edge];
+        if (facet_num == -1)
+            break;
+        if (facet_num == first_facet) {
+            BOOST_LOG_TRIVIAL(info) << "Back to the first facet changing vertices: probably a mobius part. Try using a smaller tolerance or don't do a nearby check.";
+            return;
+        }
+    }
+}
+
+void MeshRepair::remove_facet(int facet_number)
+{
+    ++ stats.facets_removed;
+    stl_neighbors &neighbors = m_neighbors[facet_number];
+    // Update statistics on unconnected triangle edges.
+    switch (neighbors.num_neighbors()) {
+    case 3: -- stats.connected_facets_3_edge; [[fallthrough]];
+    case 2: -- stats.connected_facets_2_edge; [[fallthrough]];
+    case 1: -- stats.connected_facets_1_edge; [[fallthrough]];
+    case 0: break;
+    default: assert(false);
+    }
+
+    const int last = int(-- stats.number_of_facets);
+    if (facet_number < last) {
+        // Move the last facet into the place of the removed one.
+        m_faces[facet_number]   = m_faces[last];
+        m_normals[facet_number] = m_normals[last];
+        neighbors               = m_neighbors[last];
+        // Update neighborship of faces, which used to point to the last face, now moved to facet_number.
+        for (int i = 0; i < 3; ++ i)
+            if (neighbors.neighbor[i] != -1) {
+                int &other_face_idx = m_neighbors[neighbors.neighbor[i]].neighbor[(neighbors.which_vertex_not[i] + 1) % 3];
+                if (other_face_idx != last) {
+                    BOOST_LOG_TRIVIAL(info) << "in remove_facet: neighbor = " << other_face_idx << " numfacets = " << last << " this is wrong";
+                    break;
+                }
+                other_face_idx = facet_number;
+            }
+    }
+    m_faces.pop_back();
+    m_normals.pop_back();
+    m_neighbors.pop_back();
+}
+
+void MeshRepair::remove_degenerate(int facet)
+{
+    // Update statistics on face connectivity after one edge was disconnected on the facet "facet_num".
+    auto update_connects_remove_1 = [this](int facet_num) {
+        switch (m_neighbors[facet_num].num_neighbors()) {
+        case 1: -- stats.connected_facets_1_edge; break;
+        case 2: -- stats.connected_facets_2_edge; break;
+        case 3: -- stats.connected_facets_3_edge; break;
+        default: assert(false);
+        }
+    };
+
+    const stl_triangle_vertex_indices &f = m_faces[facet];
+    int edge_to_collapse = 0;
+    if (f(0) == f(1)) {
+        if (f(1) == f(2)) {
+            // All 3 vertices are equal. Collapse the edge with no neighbor if it exists.
+            const int *nbr = m_neighbors[facet].neighbor;
+            edge_to_collapse = (nbr[0] == -1) ? 0 : (nbr[1] == -1) ? 1 : 2;
+        } else
+            edge_to_collapse = 0;
+    } else if (f(1) == f(2))
+        edge_to_collapse = 1;
+    else if (f(2) == f(0))
+        edge_to_collapse = 2;
+    else
+        // No degenerate. Function shouldn't have been called.
+        return;
+
+    const int edge[3]     = { (edge_to_collapse + 1) % 3, (edge_to_collapse + 2) % 3, edge_to_collapse };
+    const int neighbor[3] = { m_neighbors[facet].neighbor[edge[0]], m_neighbors[facet].neighbor[edge[1]], m_neighbors[facet].neighbor[edge[2]] };
+    int       vnot[3]     = { m_neighbors[facet].which_vertex_not[edge[0]], m_neighbors[facet].which_vertex_not[edge[1]], m_neighbors[facet].which_vertex_not[edge[2]] };
+
+    // Update statistics on edge connectivity.
+    if (neighbor[0] == -1 && neighbor[1] != -1)
+        update_connects_remove_1(neighbor[1]);
+    if (neighbor[1] == -1 && neighbor[0] != -1)
+        update_connects_remove_1(neighbor[0]);
+
+    if (neighbor[0] >= 0) {
+        if (neighbor[1] >= 0) {
+            // Adjust the "flip" flag for the which_vertex_not values.
+            if (vnot[0] > 2) {
+                if (vnot[1] > 2) {
+                    // The face to be removed has its normal flipped compared to the left & right neighbors.
+                    vnot[0] -= 3;
+                    vnot[1] -= 3;
+                } else
+                    vnot[1] += 3;
+            } else if (vnot[1] > 2)
+                vnot[0] += 3;
+        }
+        m_neighbors[neighbor[0]].neighbor[(vnot[0] + 1) % 3]         = (neighbor[0] == neighbor[1]) ? -1 : neighbor[1];
+        m_neighbors[neighbor[0]].which_vertex_not[(vnot[0] + 1) % 3] = vnot[1];
+    }
+    if (neighbor[1] >= 0) {
+        m_neighbors[neighbor[1]].neighbor[(vnot[1] + 1) % 3]         = (neighbor[0] == neighbor[1]) ? -1 : neighbor[0];
+        m_neighbors[neighbor[1]].which_vertex_not[(vnot[1] + 1) % 3] = vnot[0];
+    }
+    if (neighbor[2] >= 0) {
+        update_connects_remove_1(neighbor[2]);
+        m_neighbors[neighbor[2]].neighbor[(vnot[2] + 1) % 3] = -1;
+    }
+
+    this->remove_facet(facet);
+}
+
+void MeshRepair::remove_unconnected_facets()
+{
+    // Remove degenerate facets created by check_facets_nearby().
+    for (uint32_t i = 0; i < stats.number_of_facets;)
+        if (this->degenerate(i))
+            this->remove_degenerate(int(i));
+        else
+            ++ i;
+
+    if (stats.connected_facets_1_edge < int(stats.number_of_facets)) {
+        // There are some faces with no connected edge at all. Remove completely unconnected facets.
+        for (uint32_t i = 0; i < stats.number_of_facets;)
+            if (m_neighbors[i].num_neighbors() == 0)
+                this->remove_facet(int(i));
+            else
+                ++ i;
+    }
+}
+
+// Same as admesh reverse_facet(), but not counting the reversals.
+void MeshRepair::reverse_facet(int facet_num)
+{
+    stl_neighbors &neighbors = m_neighbors[facet_num];
+    const int  neighbor[3] = { neighbors.neighbor[0], neighbors.neighbor[1], neighbors.neighbor[2] };
+    const int  vnot[3]     = { neighbors.which_vertex_not[0], neighbors.which_vertex_not[1], neighbors.which_vertex_not[2] };
+
+    // reverse the facet
+    std::swap(m_faces[facet_num](0), m_faces[facet_num](1));
+
+    // fix the vnots of the neighboring facets
+    if (neighbor[0] != -1) {
+        char &v = m_neighbors[neighbor[0]].which_vertex_not[(vnot[0] + 1) % 3];
+        v = (v + 3) % 6;
+    }
+    if (neighbor[1] != -1) {
+        char &v = m_neighbors[neighbor[1]].which_vertex_not[(vnot[1] + 1) % 3];
+        v = (v + 4) % 6;
+    }
+    if (neighbor[2] != -1) {
+        char &v = m_neighbors[neighbor[2]].which_vertex_not[(vnot[2] + 1) % 3];
+        v = (v + 2) % 6;
+    }
+
+    // swap the neighbors of the facet that is being reversed, reverse the values of its vnots
+    neighbors.neighbor[1]         = neighbor[2];
+    neighbors.neighbor[2]         = neighbor[1];
+    neighbors.which_vertex_not[0] = (vnot[0] + 3) % 6;
+    neighbors.which_vertex_not[1] = (vnot[2] + 3) % 6;
+    neighbors.which_vertex_not[2] = (vnot[1] + 3) % 6;
+}
+
+bool MeshRepair::fix_patch_normal_directions(int seed, std::vector<char> &norm_sw, std::vector<int> &reversed)
+{
+    // Mimic the linked list of admesh, where the neighbors are added to and taken from the head of the list.
+    std::vector<int> stack;
+    int facet_num = seed;
+    // If the normal vector is backwards, the facet is reversed. Starting with a facet with a wrong normal
+    // stored in the STL file flips the whole patch, the chances are low though if most of the triangles are right.
+    if (this->normal_backwards(seed)) {
+        this->reverse_facet(seed);
+        reversed.emplace_back(seed);
+    }
+    norm_sw[seed] = 1;
+    for (;;) {
+        for (int j = 0; j < 3; ++ j) {
+            const int neighbor = m_neighbors[facet_num].neighbor[j];
+            if (neighbor != -1 && m_neighbors[facet_num].which_vertex_not[j] > 2) {
+                if (norm_sw[neighbor] == 1)
+                    // Trying to modify a facet already marked as fixed.
+                    return false;
+                this->reverse_facet(neighbor);
+                reversed.emplace_back(neighbor);
+            }
+            if (neighbor != -1 && norm_sw[neighbor] != 1)
+                stack.emplace_back(neighbor);
+        }
+        if (stack.empty())
+            return true;
+        facet_num = stack.back();
+        stack.pop_back();
+        norm_sw[facet_num] = 1;
+    }
+}
+
+void MeshRepair::fix_normal_directions()
+{
+    const int num_facets = int(stats.number_of_facets);
+    if (num_facets == 0)
+        return;
+
+    // Label the patches with the lowest facet index, which is the facet admesh starts to traverse a patch with.
+    std::vector<std::atomic<int>> parent(num_facets);
+    execution::for_each(ex_tbb, 0, num_facets, [&parent](int i) { parent[i].store(i, std::memory_order_relaxed); }, Granularity);
+    auto find = [&parent](int i) {
+        for (;;) {
+            int p  = parent[i].load(std::memory_order_relaxed);
+            if (p == i)
+                return i;
+            int gp = parent[p].load(std::memory_order_relaxed);
+            if (gp != p)
+                // Path halving, the parent pointers only ever decrease.
+                parent[i].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+            i = gp;
+        }
+    };
+    execution::for_each(ex_tbb, 0, num_facets, [this, &parent, &find](int i) {
+        for (int neighbor : m_neighbors[i].neighbor)
+            if (neighbor > i)
+                for (int a = i, b = neighbor;;) {
+                    a = find(a);
+                    b = find(b);
+                    if (a == b)
+                        break;
+                    if (a > b)
+                        std::swap(a, b);
+                    if (parent[b].compare_exchange_strong(b, a, std::memory_order_relaxed))
+                        break;
+                }
+    }, Granularity);
+    std::vector<int> seeds;
+    for (int i = 0; i < num_facets; ++ i)
+        if (parent[i].load(std::memory_order_relaxed) == i)
+            seeds.emplace_back(i);
+
+    // Orient the patches in parallel, each patch is traversed exactly the way admesh traverses it.
+    struct Patch {
+        std::vector<int> reversed;
+        bool             consistent;
+    };
+    std::vector<Patch> patches(seeds.size());
+    std::vector<char>  norm_sw(num_facets, 0);
+    execution::for_each(ex_tbb, size_t(0), seeds.size(), [this, &seeds, &patches, &norm_sw](size_t i) {
+        patches[i].consistent = this->fix_patch_normal_directions(seeds[i], norm_sw, patches[i].reversed);
+    });
+
+    auto inconsistent = std::find_if(patches.begin(), patches.end(), [](const Patch &p) { return ! p.consistent; });
+    int  num_reversed = 0;
+    for (auto it = patches.begin(); it != patches.end() && it <= inconsistent; ++ it)
+        num_reversed += int(it->reversed.size());
+    if (inconsistent == patches.end()) {
+        stats.number_of_parts += int(patches.size());
+        stats.facets_reversed += num_reversed;
+    } else {
+        // admesh reverts all changes made until the inconsistent patch was found and quits,
+        // the patches following the inconsistent one are not processed at all.
+        execution::for_each(ex_tbb, patches.begin(), patches.end(), [this](const Patch &patch) {
+            for (auto it = patch.reversed.rbegin(); it != patch.reversed.rend(); ++ it)
+                this->reverse_facet(*it);
+        });
+        stats.number_of_parts += int(inconsistent - patches.begin());
+        stats.facets_reversed += 2 * num_reversed;
+    }
+}
+
+void MeshRepair::calculate_volume()
+{
+    const size_t num_facets = stats.number_of_facets;
+    if (num_facets == 0)
+        return;
+
+    // The normals read from the file are replaced with the normals calculated from the vertices.
+    // Volume contribution of each facet is calculated in parallel, they are summed up serially to produce
+    // the same rounding as admesh.
+    const stl_vertex   p0 = m_vertices[m_faces.front()(0)];
+    std::vector<float> volumes(num_facets);
+    execution::for_each(ex_tbb, size_t(0), num_facets, [this, &p0, &volumes](size_t i) {
+        const stl_normal normal = this->facet_normal(i);
+        m_normals[i] = normal;
+        const stl_triangle_vertex_indices &f = m_faces[i];
+        // Cast to double before calculating cross product because large coordinates can result in overflowing product.
+        double sum[3] = { 0., 0., 0. };
+        for (int j = 0; j < 3; ++ j) {
+            const stl_vertex &a = m_vertices[f(j)];
+            const stl_vertex &b = m_vertices[f((j + 1) % 3)];
+            sum[0] += (double)a(1) * (double)b(2) - (double)a(2) * (double)b(1);
+            sum[1] += (double)a(2) * (double)b(0) - (double)a(0) * (double)b(2);
+            sum[2] += (double)a(0) * (double)b(1) - (double)a(1) * (double)b(0);
+        }
+        const float area   = 0.5f * normal.dot(stl_normal(float(sum[0]), float(sum[1]), float(sum[2])));
+        const float height = normal.dot(m_vertices[f(0)] - p0);
+        volumes[i] = (area * height) / 3.0f;
+    }, Granularity);
+    float volume = 0.f;
+    for (float v : volumes)
+        volume += v;
+
+    if (volume < 0.f) {
+        // Reverse all facets. Reversal of a facet modifies its neighbors, therefore the reversals are performed serially.
+        for (size_t i = 0; i < num_facets; ++ i)
+            this->reverse_facet(int(i));
+        stats.facets_reversed += int(num_facets);
+        volume = - volume;
+    }
+    stats.volume = volume;
+}
+
+void MeshRepair::verify_neighbors()
+{
+    stats.backwards_edges = execution::reduce(ex_tbb, size_t(0), size_t(stats.number_of_facets), 0, std::plus<int>{},
+        [this](size_t i) {
+            int backwards = 0;
+            for (int j = 0; j < 3; ++ j)
+                if (m_neighbors[i].neighbor[j] != -1 && m_neighbors[i].which_vertex_not[j] > 2)
+                    ++ backwards;
+            return backwards;
+        }, Granularity);
+}
+
+// Same as stl_generate_shared_vertices(): Vertices are shared only along fans of connected facets.
+indexed_triangle_set MeshRepair::generate_shared_vertices() const
+{
+    const int            num_facets = int(stats.number_of_facets);
+    indexed_triangle_set its;
+    its.indices.assign(num_facets, stl_triangle_vertex_indices(-1, -1, -1));
+    its.vertices.reserve(num_facets / 2);
+
+    // A degenerate mesh may contain loops: Traversing a fan will end up in an endless loop
+    // while never reaching the starting face. Traversed faces are marked with a unique stamp for each fan.
+    unsigned int              fan_traversal_stamp = 0;
+    std::vector<unsigned int> fan_traversal_facet_visited(num_facets, 0);
+
+    for (int facet_idx = 0; facet_idx < num_facets; ++ facet_idx)
+        for (int j = 0; j < 3; ++ j) {
+            if (its.indices[facet_idx][j] != -1)
+                // Shared vertex was already assigned.
+                continue;
+            its.vertices.emplace_back(m_vertices[m_faces[facet_idx](j)]);
+            int  facet_in_fan_idx   = facet_idx;
+            bool edge_direction     = false;
+            bool traversal_reversed = false;
+            int  vnot               = (j + 2) % 3;
+            ++ fan_traversal_stamp;
+            for (;;) {
+                int next_edge    = 0;
+                int pivot_vertex = 0;
+                if (vnot > 2) {
+                    // The neighboring facet is flipped.
+                    if (! edge_direction) {
+                        pivot_vertex = (vnot + 2) % 3;
+                        next_edge    = pivot_vertex;
+                    } else {
+                        pivot_vertex = (vnot + 1) % 3;
+                        next_edge    = vnot % 3;
+                    }
+                    edge_direction = ! edge_direction;
+                } else {
+                    if (! edge_direction) {
+                        pivot_vertex = (vnot + 1) % 3;
+                        next_edge    = vnot;
+                    } else {
+                        pivot_vertex = (vnot + 2) % 3;
+                        next_edge    = pivot_vertex;
+                    }
+                }
+                its.indices[facet_in_fan_idx][pivot_vertex]   = int(its.vertices.size()) - 1;
+                fan_traversal_facet_visited[facet_in_fan_idx] = fan_traversal_stamp;
+
+                const int next_facet = m_neighbors[facet_in_fan_idx].neighbor[next_edge];
+                if (next_facet == -1) {
+                    if (traversal_reversed)
+                        // Went to one limit, then turned back and reached the other limit.
+                        break;
+                    // Reached the first limit. Now try to reverse and traverse up to the other limit.
+                    edge_direction     = true;
+                    vnot               = (j + 1) % 3;
+                    traversal_reversed = true;
+                    facet_in_fan_idx   = facet_idx;
+                } else if (next_facet == facet_idx || next_facet >= num_facets || fan_traversal_facet_visited[next_facet] == fan_traversal_stamp) {
+                    // Traversed a closed fan all around or the mesh is not valid.
+                    break;
+                } else {
+                    vnot             = m_neighbors[facet_in_fan_idx].which_vertex_not[next_edge];
+                    facet_in_fan_idx = next_facet;
+                }
+            }
+        }
+    return its;
+}
+
+} // namespace
+
+indexed_triangle_set its_repair_stl(stl_file &stl)
+{
+    MeshRepair mesh(stl);
+    stl_stats &stats = mesh.stats;
+    // admesh fails when repairing empty meshes
+    if (stats.number_of_facets > 0) {
+        BOOST_LOG_TRIVIAL(debug) << "TriangleMesh::repair() started";
+
+        mesh.check_facets_exact();
+        stats.facets_w_1_bad_edge = stats.connected_facets_2_edge - stats.connected_facets_3_edge;
+        stats.facets_w_2_bad_edge = stats.connected_facets_1_edge - stats.connected_facets_2_edge;
+        stats.facets_w_3_bad_edge = int(stats.number_of_facets) - stats.connected_facets_1_edge;
+
+        float tolerance = stats.shortest_edge;
+        float increment = stats.bounding_diameter / 10000.0f;
+        for (int i = 0; i < 2 && stats.connected_facets_3_edge < int(stats.number_of_facets); ++ i) {
+            // Not a manifold, some triangles have unconnected edges.
+            mesh.check_facets_nearby(tolerance);
+            tolerance += increment;
+        }
+
+        if (stats.connected_facets_3_edge < int(stats.number_of_facets))
+            mesh.remove_unconnected_facets();
+
+        // Holes are not filled, the admesh algorithm did more harm than good on complex holes.
+        // Rather let the slicing algorithm close gaps in 2D slices.
+
+        mesh.fix_normal_directions();
+        // If the volume is negative, all the facets are flipped and added to stats.facets_reversed.
+        mesh.calculate_volume();
+        mesh.verify_neighbors();
+
+        // Removing degenerate facets may break the face connectivity, rather refresh it here as the slicing code relies on it.
+        if (stats.number_of_facets > 0 && stats.degenerate_facets > 0)
+            mesh.check_facets_exact();
+
+        BOOST_LOG_TRIVIAL(debug) << "TriangleMesh::repair() finished";
+    }
+    stl.stats = stats;
+    return mesh.generate_shared_vertices();
+}
+
+} // namespace Slic3r
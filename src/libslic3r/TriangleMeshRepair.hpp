@@ -0,0 +1,25 @@
+///|/ Copyright (c) Prusa Research 2024
+///|/
+///|/ PrusaSlicer is released under the terms of the AGPLv3 or higher
+///|/
+#ifndef slic3r_TriangleMeshRepair_hpp_
+#define slic3r_TriangleMeshRepair_hpp_
+
+#include "TriangleMesh.hpp"
+
+namespace Slic3r {
+
+// Repair a triangle soup loaded by admesh (stl_open() or facets tessellated from STEP), mimicking the former admesh
+// repair pipeline on import: exact edge matching, connecting open edges with nearby end points, removing degenerate
+// and unconnected facets, orienting the patches consistently and flipping inside out meshes.
+// Unlike admesh, the facets are indexed into shared vertices from the start, edges are matched by sorting,
+// patches are oriented in parallel. The admesh traversal orders are maintained, therefore the resulting mesh
+// and the statistics are the same as produced by admesh.
+// stl.stats.min, bounding_diameter and shortest_edge are expected to be filled in by stl_read(), stl.stats are updated
+// with the repair statistics the same way admesh updates them, stl.facet_start is left untouched.
+// Returns the repaired mesh with vertices shared along the fans, as stl_generate_shared_vertices() would do.
+indexed_triangle_set its_repair_stl(stl_file &stl);
+
+} // namespace Slic3r
+
+#endif // slic3r_TriangleMeshRepair_hpp_
@@ -6026,6 +6026,7 @@ void TabSLAPrint::build()
     optgroup = page->new_optgroup(L("Slicing"));
     optgroup->append_single_option_line("slice_closing_radius");
     optgroup->append_single_option_line("slicing_mode");
+    optgroup->append_single_option_line("slice_level_csg");
 
     page = add_options_page(L("Output options"), "output+page_white");
     optgroup = page->new_optgroup(L("Output file"));
@@ -0,0 +1,62 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "libslic3r/GCode/ConflictChecker.hpp"
+
+using namespace Slic3r;
+
+static ExtrusionPath make_path(const Points &pts)
+{
+    return ExtrusionPath(Polyline(pts), ExtrusionAttributes{ ExtrusionRole::Perimeter, ExtrusionFlow{ 0., 0.45f, 0.2f } });
+}
+
+TEST_CASE("Conflict checker finds crossing lines of different instances", "[ConflictChecker]") {
+    const Line horizontal{ Point::new_scale(0., 5.), Point::new_scale(10., 5.) };
+    const Line vertical  { Point::new_scale(5., 0.), Point::new_scale(5., 10.) };
+
+    SECTION("Lines of the same instance do not conflict") {
+        LineWithIDs lines{ { horizontal, 0, 0, ExtrusionRole::Perimeter }, { vertical, 0, 0, ExtrusionRole::Perimeter } };
+        REQUIRE(! ConflictChecker::find_inter_of_lines(lines).has_value());
+    }
+    SECTION("Lines of different instances of the same object conflict") {
+        LineWithIDs lines{ { horizontal, 0, 0, ExtrusionRole::Perimeter }, { vertical, 0, 1, ExtrusionRole::Perimeter } };
+        REQUIRE(ConflictChecker::find_inter_of_lines(lines).has_value());
+    }
+    SECTION("Lines of different objects conflict, also at negative coordinates") {
+        LineWithIDs lines{ { Line{ horizontal.a - Point::new_scale(20., 20.), horizontal.b - Point::new_scale(20., 20.) }, 0, 0, ExtrusionRole::Perimeter },
+                           { Line{ vertical.a - Point::new_scale(20., 20.), vertical.b - Point::new_scale(20., 20.) }, 1, 0, ExtrusionRole::Perimeter } };
+        ConflictComputeOpt conflict = ConflictChecker::find_inter_of_lines(lines);
+        REQUIRE(conflict.has_value());
+        REQUIRE(conflict->_obj1 != conflict->_obj2);
+    }
+    SECTION("Lines touching at their ends do not conflict") {
+        LineWithIDs lines{ { horizontal, 0, 0, ExtrusionRole::Perimeter }, { Line{ horizontal.b, Point::new_scale(10., 10.) }, 1, 0, ExtrusionRole::Perimeter } };
+        REQUIRE(! ConflictChecker::find_inter_of_lines(lines).has_value());
+    }
+}
+
+TEST_CASE("Conflict checker only tests lines close to other instances", "[ConflictChecker]") {
+    // A square and a line crossing its right edge.
+    std::vector<ExtrusionPaths> square{ { make_path({ Point::new_scale(0., 0.), Point::new_scale(10., 0.), Point::new_scale(10., 10.), Point::new_scale(0., 10.), Point::new_scale(0., 0.) }) } };
+    std::vector<ExtrusionPaths> line{ { make_path({ Point::new_scale(8., 5.), Point::new_scale(12., 5.) }) } };
+    auto refs = [](const std::vector<ExtrusionPaths> &layers) {
+        std::vector<ExtrusionPathRefs> out;
+        for (const ExtrusionPaths &layer : layers) {
+            out.emplace_back();
+            for (const ExtrusionPath &path : layer)
+                out.back().push_back(&path);
+        }
+        return out;
+    };
+
+    LinesBucket squareBucket(refs(square), 0, Points{ Point(0, 0) });
+    LinesBucket lineBucket(refs(line), 1, Points{ Point(0, 0) });
+    REQUIRE(squareBucket.pileBBox(0) == BoundingBox(Point::new_scale(0., 0.), Point::new_scale(10., 10.)));
+
+    LineWithIDs lines = ConflictChecker::get_candidate_lines({ { &squareBucket, 0 }, { &lineBucket, 0 } });
+    // The right edge of the square and the line, the other edges of the square are far from the line.
+    REQUIRE(lines.size() == 2);
+    REQUIRE(ConflictChecker::find_inter_of_lines(lines).has_value());
+
+    LinesBucket farLineBucket(refs(line), 1, Points{ Point::new_scale(0., 20.) });
+    REQUIRE(ConflictChecker::get_candidate_lines({ { &squareBucket, 0 }, { &farLineBucket, 0 } }).empty());
+}
@@ -4,12 +4,23 @@
 
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
+#include <catch2/generators/catch_generators.hpp>
 
+#include <algorithm>
 #include <memory>
 #include <regex>
 #include <fstream>
+#include <sstream>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <boost/nowide/cstdio.hpp>
+
+#include <LibBGCode/convert/convert.hpp>
 
 #include "libslic3r/GCode.hpp"
+#include "libslic3r/GCode/GCodeProcessor.hpp"
 #include "libslic3r/Geometry/ConvexHull.hpp"
 #include "test_data.hpp"
 
@@ -316,6 +327,148 @@ TEST_CASE("M73s have correct percent values", "[GCode]") {
 }
 
 
+TEST_CASE("Post-processing of the G-code tail only", "[GCode]") {
+    // Without remaining times, the post-processing only rewrites the placeholders and the filament statistics
+    // at the end of the G-code. The result shall be the same as of the full post-processing, minus the M73 lines.
+    auto export_gcode = [](bool remaining_times) {
+        DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({
+            { "remaining_times", remaining_times },
+        });
+        Print print;
+        Model model;
+        Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        std::istringstream gcode(Test::gcode(print));
+        std::string out;
+        for (std::string line; std::getline(gcode, line);)
+            if (! boost::starts_with(line, "M73") && ! boost::starts_with(line, "; remaining_times = "))
+                out += line + "\n";
+        return out;
+    };
+
+    const std::string gcode_tail_only = export_gcode(false);
+    const std::string gcode_full      = export_gcode(true);
+    CHECK(gcode_tail_only.find("; estimated printing time (normal mode) = ") != std::string::npos);
+    CHECK(gcode_tail_only.find("_GP_ESTIMATED_PRINTING_TIME_PLACEHOLDER") == std::string::npos);
+    CHECK(gcode_tail_only.find("; filament used [mm] = ") != std::string::npos);
+    CHECK(gcode_tail_only == gcode_full);
+}
+
+TEST_CASE("Post-processing of the G-code tail only keeps the G-code line ids of moves", "[GCode]") {
+    // The custom end G-code with Windows line endings is the first line modified by the post-processing,
+    // thus the moves of the end G-code are in the post-processed tail.
+    auto export_gcode = [](bool remaining_times, std::vector<std::string> &lines, std::vector<size_t> &gcode_ids) {
+        DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({
+            { "remaining_times", remaining_times },
+        });
+        config.set_key_value("end_gcode", new ConfigOptionString("G1 Z30 F600\r\nG1 X5 Y150 F6000\r\nM84"));
+        Print print;
+        Model model;
+        Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        print.set_status_silent();
+        print.process();
+        boost::filesystem::path temp = boost::filesystem::unique_path();
+        GCodeProcessorResult result;
+        print.export_gcode(temp.string(), &result, nullptr);
+        boost::nowide::ifstream t(temp.string());
+        for (std::string line; std::getline(t, line);)
+            lines.emplace_back(line);
+        t.close();
+        boost::nowide::remove(temp.string().c_str());
+        for (const GCodeProcessorResult::MoveVertex &move : result.moves)
+            gcode_ids.emplace_back(move.gcode_id);
+    };
+
+    std::vector<std::string> lines_tail_only, lines_full;
+    std::vector<size_t>      ids_tail_only, ids_full;
+    export_gcode(false, lines_tail_only, ids_tail_only);
+    export_gcode(true, lines_full, ids_full);
+    REQUIRE(ids_tail_only.size() == ids_full.size());
+
+    // Map the 1-based line ids of the full post-processing to the line ids without the M73 lines.
+    std::vector<size_t> full_to_tail_only(lines_full.size() + 1, 0);
+    for (size_t i = 0, id = 0; i < lines_full.size(); ++ i) {
+        if (! boost::starts_with(lines_full[i], "M73"))
+            ++ id;
+        full_to_tail_only[i + 1] = id;
+    }
+    REQUIRE(full_to_tail_only.back() == lines_tail_only.size());
+
+    size_t num_mismatches = 0;
+    for (size_t i = 0; i < ids_full.size(); ++ i)
+        if (ids_full[i] < full_to_tail_only.size() && full_to_tail_only[ids_full[i]] != ids_tail_only[i])
+            ++ num_mismatches;
+    CHECK(num_mismatches == 0);
+    // The move of the end G-code references its line in the post-processed tail.
+    CHECK(std::any_of(ids_tail_only.begin(), ids_tail_only.end(), [&lines_tail_only](size_t id) {
+        return id > 0 && id <= lines_tail_only.size() && boost::starts_with(lines_tail_only[id - 1], "G1 X5 Y150");
+    }));
+}
+
+TEST_CASE("Binary G-code of the binarizer worker thread", "[GCode]") {
+    // The binary G-code binarized on the worker thread during the post-processing shall contain the same G-code
+    // as the ASCII export of the same print converted by the single threaded binarizer of LibBGCode.
+    auto export_gcode = [](bool binary, bool backtrace, const boost::filesystem::path &path) {
+        DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({
+            { "binary_gcode", binary },
+        });
+        // The backtrace of the G-code lines is enabled for the XL printer.
+        if (backtrace)
+            config.set_key_value("printer_notes", new ConfigOptionString("PRINTER_VENDOR_PRUSA3D PRINTER_MODEL_XL"));
+        Print print;
+        Model model;
+        Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        print.set_status_silent();
+        print.process();
+        print.export_gcode(path.string(), nullptr, nullptr);
+    };
+    auto convert = [](const boost::filesystem::path &src, const boost::filesystem::path &dst, bool to_binary) {
+        FILE *in  = boost::nowide::fopen(src.string().c_str(), "rb");
+        FILE *out = boost::nowide::fopen(dst.string().c_str(), "wb");
+        REQUIRE(in != nullptr);
+        REQUIRE(out != nullptr);
+        const bgcode::core::EResult res = to_binary ?
+            bgcode::convert::from_ascii_to_binary(*in, *out, GCodeProcessor::get_binarizer_config()) :
+            bgcode::convert::from_binary_to_ascii(*in, *out, true);
+        fclose(in);
+        fclose(out);
+        REQUIRE(res == bgcode::core::EResult::Success);
+    };
+    // G-code lines without the comments, which hold the metadata of the converted files.
+    auto read_gcode = [](const boost::filesystem::path &path) {
+        std::vector<std::string> lines;
+        boost::nowide::ifstream ifs(path.string());
+        for (std::string line; std::getline(ifs, line);)
+            if (! line.empty() && line.front() != ';')
+                lines.emplace_back(line);
+        return lines;
+    };
+
+    const bool backtrace = GENERATE(false, true);
+    INFO("backtrace_enabled " << backtrace);
+    const boost::filesystem::path temp     = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("bgcode-%%%%-%%%%");
+    const boost::filesystem::path ascii    = temp.string() + ".gcode";
+    const boost::filesystem::path binary   = temp.string() + ".bgcode";
+    const boost::filesystem::path expected = temp.string() + "-expected.bgcode";
+    const boost::filesystem::path decoded  = temp.string() + "-decoded.gcode";
+    const boost::filesystem::path decoded_expected = temp.string() + "-decoded-expected.gcode";
+
+    export_gcode(false, backtrace, ascii);
+    export_gcode(true, backtrace, binary);
+    convert(ascii, expected, true);
+    convert(binary, decoded, false);
+    convert(expected, decoded_expected, false);
+    const std::vector<std::string> gcode          = read_gcode(decoded);
+    const std::vector<std::string> gcode_expected = read_gcode(decoded_expected);
+    for (const boost::filesystem::path &path : { ascii, binary, expected, decoded, decoded_expected })
+        boost::nowide::remove(path.string().c_str());
+
+    REQUIRE(! gcode_expected.empty());
+    CHECK(gcode == gcode_expected);
+}
+
 TEST_CASE("M201 for acceleation reset", "[GCode]") {
     DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
     config.set_deserialize_strict({
@@ -1,4 +1,5 @@
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark_all.hpp>
 
 #include <memory>
 
@@ -290,3 +291,86 @@ SCENARIO("Find/Replace with regexp", "[GCodeFindReplace]") {
         }
     }
 }
+
+SCENARIO("Find/Replace with multiple plain text rules", "[GCodeFindReplace]") {
+    GIVEN("G-code") {
+        const std::string gcode =
+            "G1 Z0; home\n"
+            "G1 Z1; move up\n"
+            "G1 X0 Y1 Z1; perimeter\n"
+            "G1 X13 Y32 Z1; infill\n"
+            "G1 X13 Y32 Z1; wipe\n";
+        WHEN("Independent rules are applied") {
+            GCodeFindReplace find_replace({ "home", "origin", "", "",
+                                            "PERIMETER", "wall", "i", "",
+                                            "Y32", "Y31", "w", "",
+                                            "wipe", "clean", "", "" });
+            REQUIRE(find_replace.process_layer(gcode) ==
+                "G1 Z0; origin\n"
+                "G1 Z1; move up\n"
+                "G1 X0 Y1 Z1; wall\n"
+                "G1 X13 Y31 Z1; infill\n"
+                "G1 X13 Y31 Z1; clean\n");
+        }
+        WHEN("A rule matches the replacement of a preceding rule") {
+            GCodeFindReplace find_replace({ "move up", "move down", "", "",
+                                            "down", "up again", "", "" });
+            REQUIRE(find_replace.process_layer(gcode) ==
+                "G1 Z0; home\n"
+                "G1 Z1; move up again\n"
+                "G1 X0 Y1 Z1; perimeter\n"
+                "G1 X13 Y32 Z1; infill\n"
+                "G1 X13 Y32 Z1; wipe\n");
+        }
+        WHEN("A rule matches across the text deleted by a preceding rule") {
+            GCodeFindReplace find_replace({ "Z1; ", "", "", "",
+                                            "G1 X0 Y1 perimeter", "G1 X0 Y1 Z1; wall", "", "" });
+            REQUIRE(find_replace.process_layer(gcode) ==
+                "G1 Z0; home\n"
+                "G1 move up\n"
+                "G1 X0 Y1 Z1; wall\n"
+                "G1 X13 Y32 infill\n"
+                "G1 X13 Y32 wipe\n");
+        }
+        WHEN("A preceding rule changes the word boundary of a whole word rule") {
+            GCodeFindReplace find_replace({ "Y32 ", "Y32a", "", "",
+                                            "Z1", "Z2", "w", "" });
+            REQUIRE(find_replace.process_layer(gcode) ==
+                "G1 Z0; home\n"
+                "G1 Z2; move up\n"
+                "G1 X0 Y1 Z2; perimeter\n"
+                "G1 X13 Y32aZ1; infill\n"
+                "G1 X13 Y32aZ1; wipe\n");
+        }
+        WHEN("Plain text rules are interleaved with regular expressions") {
+            GCodeFindReplace find_replace({ "infill", "sparse infill", "", "",
+                                            "Y([0-9]+)", "Y${1}0", "r", "",
+                                            "Y320", "Y321", "", "" });
+            REQUIRE(find_replace.process_layer(gcode) ==
+                "G1 Z0; home\n"
+                "G1 Z1; move up\n"
+                "G1 X0 Y10 Z1; perimeter\n"
+                "G1 X13 Y321 Z1; sparse infill\n"
+                "G1 X13 Y321 Z1; wipe\n");
+        }
+    }
+}
+
+TEST_CASE("Find/Replace benchmark", "[GCodeFindReplace][.Benchmarks]") {
+    std::string gcode;
+    for (size_t i = 0; i < 20000; ++ i)
+        gcode += ";TYPE:Perimeter\nG1 X" + std::to_string(i % 200) + ".123 Y45.678 E0.0123 ; perimeter\nM106 S255\nG1 Z1.2 F7200\n";
+
+    std::vector<std::string> substitutions;
+    for (size_t i = 0; i < 20; ++ i) {
+        const std::string idx = std::to_string(i);
+        substitutions.insert(substitutions.end(), { "; comment " + idx, "; note " + idx, (i % 2) ? "i" : "", "" });
+    }
+    substitutions.insert(substitutions.end(), { "M106 S255", "M106 S204", "", "" });
+    substitutions.insert(substitutions.end(), { "perimeter", "wall", "w", "" });
+    GCodeFindReplace find_replace(substitutions);
+
+    BENCHMARK("22 plain text rules") {
+        return find_replace.process_layer(gcode);
+    };
+}
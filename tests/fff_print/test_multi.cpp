@@ -4,6 +4,7 @@
 #include <sstream>
 
 #include "libslic3r/ClipperUtils.hpp"
+#include "libslic3r/GCode/WipeTower.hpp"
 #include "libslic3r/Geometry.hpp"
 #include "libslic3r/Geometry/ConvexHull.hpp"
 #include "libslic3r/Print.hpp"
@@ -269,3 +270,88 @@ SCENARIO("Stacked cubes", "[Multi]")
         }
     }
 }
+
+SCENARIO("Tool ordering", "[Multi]")
+{
+    GIVEN("20mm cube printed with separate perimeter and infill extruders and a wipe tower") {
+        DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config_with({
+            { "nozzle_diameter",        "0.4, 0.4" },
+            { "perimeter_extruder",     1 },
+            { "infill_extruder",        2 },
+            { "solid_infill_extruder",  1 },
+            { "wipe_tower",             true },
+            { "layer_height",           0.4 },
+            { "first_layer_height",     0.4 }
+        });
+        Print print;
+        Model model;
+        Slic3r::Test::init_print({ Slic3r::Test::TestMesh::cube_20x20x20 }, print, model, config);
+        print.process();
+        auto extruders = [&print]() {
+            std::vector<std::vector<unsigned int>> out;
+            for (const LayerTools &lt : print.tool_ordering())
+                out.emplace_back(lt.extruders);
+            return out;
+        };
+        const std::vector<std::vector<unsigned int>> extruders_before = extruders();
+        THEN("Both extruders are used on the sparse infill layers") {
+            REQUIRE(! extruders_before.empty());
+            size_t num_both = std::count_if(extruders_before.begin(), extruders_before.end(),
+                [](const std::vector<unsigned int> &e) { return e.size() == 2; });
+            REQUIRE(num_both > 0);
+        }
+        WHEN("Only the wipe tower width is changed") {
+            config.set("wipe_tower_width", 80.);
+            print.apply(model, config);
+            print.process();
+            THEN("Tool ordering is the same") {
+                REQUIRE(extruders() == extruders_before);
+            }
+        }
+    }
+}
+
+SCENARIO("Wipe tower planning", "[Multi]")
+{
+    GIVEN("Wipe tower of three extruders with a varying number of toolchanges per layer") {
+        DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config_with({
+            { "nozzle_diameter",        "0.4, 0.4, 0.4" },
+            { "wiping_volumes_matrix",  "0, 70, 70, 70, 0, 70, 70, 70, 0" },
+            { "layer_height",           0.3 },
+            { "first_layer_height",     0.3 }
+        });
+        FullPrintConfig print_config;
+        print_config.apply(config);
+        auto wipe_tower_gcode = [&print_config](bool stop_planning_early) {
+            WipeTower wipe_tower(Vec2f(100.f, 100.f), 0., print_config, print_config, WipeTower::extract_wipe_volumes(print_config), 0);
+            for (size_t i = 0; i < 3; ++ i)
+                wipe_tower.set_extruder(i, print_config);
+            unsigned int tool = 0;
+            for (int layer = 0; layer < 30; ++ layer) {
+                const float print_z = 0.3f * float(layer + 1);
+                wipe_tower.plan_toolchange(print_z, 0.3f, tool, tool);
+                for (int i = 0; i < layer % 3; ++ i) {
+                    const unsigned int new_tool = (tool + 1) % 3;
+                    // Large enough for the sparse infill of the layer to save on the last wipe, which changes with the planning passes.
+                    wipe_tower.plan_toolchange(print_z, 0.3f, tool, new_tool, 100.f + 60.f * float(layer % 4));
+                    tool = new_tool;
+                }
+            }
+            std::vector<std::vector<WipeTower::ToolChangeResult>> tool_changes;
+            wipe_tower.generate(tool_changes, stop_planning_early);
+            std::vector<std::string> out;
+            for (const std::vector<WipeTower::ToolChangeResult> &layer : tool_changes)
+                for (const WipeTower::ToolChangeResult &tcr : layer)
+                    out.emplace_back(tcr.gcode);
+            return out;
+        };
+        WHEN("The planning passes stop as soon as they converge") {
+            const std::vector<std::string> gcode      = wipe_tower_gcode(true);
+            const std::vector<std::string> gcode_full = wipe_tower_gcode(false);
+            THEN("The wipe tower G-code is the same as with all the five planning passes") {
+                REQUIRE(gcode_full.size() > 1);
+                REQUIRE(gcode == gcode_full);
+            }
+        }
+    }
+}
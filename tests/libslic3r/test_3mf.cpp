@@ -82,6 +82,42 @@ SCENARIO("Export+Import geometry to/from 3mf file cycle", "[3mf]") {
     }
 }
 
+SCENARIO("Export+Import of a mesh spanning multiple export chunks", "[3mf]") {
+    GIVEN("object with two volumes of more than 16k vertices each") {
+        Model src_model;
+        ModelObject *src_object = src_model.add_object();
+        src_object->add_volume(TriangleMesh(its_make_sphere(10., 0.02)));
+        ModelVolume *second = src_object->add_volume(TriangleMesh(its_make_sphere(5., 0.03)));
+        second->set_offset({ 30., 0., 0. });
+        src_object->add_instance();
+
+        WHEN("model is saved with the fastest compression level and loaded back") {
+            std::string test_file = std::string(TEST_DATA_DIR) + "/test_3mf/chunks.3mf";
+            REQUIRE(store_3mf(test_file.c_str(), &src_model, nullptr, false, nullptr, true, 1));
+
+            Model dst_model;
+            DynamicPrintConfig dst_config;
+            {
+                ConfigSubstitutionContext ctxt{ ForwardCompatibilitySubstitutionRule::Disable };
+                boost::optional<Semver> version;
+                load_3mf(test_file.c_str(), dst_config, ctxt, &dst_model, false, version);
+            }
+            boost::filesystem::remove(test_file);
+
+            THEN("both volumes are restored") {
+                REQUIRE(dst_model.objects.size() == 1);
+                REQUIRE(dst_model.objects.front()->volumes.size() == 2);
+                TriangleMesh src_mesh = src_model.mesh();
+                TriangleMesh dst_mesh = dst_model.mesh();
+                REQUIRE(src_mesh.its.vertices.size() == dst_mesh.its.vertices.size());
+                REQUIRE(src_mesh.its.indices == dst_mesh.its.indices);
+                for (size_t i = 0; i < dst_mesh.its.vertices.size(); ++ i)
+                    REQUIRE(dst_mesh.its.vertices[i].isApprox(src_mesh.its.vertices[i]));
+            }
+        }
+    }
+}
+
 SCENARIO("2D convex hull of sinking object", "[3mf]") {
     GIVEN("model") {
         // load a model
@@ -1,11 +1,15 @@
 #include <algorithm>
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <catch2/benchmark/catch_benchmark_all.hpp>
 #include <test_utils.hpp>
+#include <random>
 
 #include <libslic3r/TriangleMesh.hpp>
 #include <libslic3r/AABBTreeIndirect.hpp>
 #include <libslic3r/AABBTreeLines.hpp>
+#include <libslic3r/AABBMesh.hpp>
 
 using namespace Slic3r;
 using namespace Catch;
@@ -63,6 +67,220 @@ TEST_CASE("Building a tree over a box, ray caster and closest query", "[AABBIndi
     REQUIRE(closest_point.z() == Approx(1.));
 }
 
+// Rays shot from random points around a sphere towards its center, slightly
+// diverging like the rays sampling a support beam.
+static void make_coherent_rays(size_t N, double spread, std::vector<Vec3d> &origins, std::vector<Vec3d> &dirs)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> dist(-1., 1.);
+
+    origins.clear(), dirs.clear();
+    for (size_t i = 0; i < N; i += 8) {
+        Vec3d o = 30. * Vec3d{dist(rng), dist(rng), dist(rng)}.normalized();
+        for (size_t j = 0; j < 8 && i + j < N; ++j) {
+            origins.emplace_back(o + spread * Vec3d{dist(rng), dist(rng), dist(rng)});
+            dirs.emplace_back((-o + spread * Vec3d{dist(rng), dist(rng), dist(rng)}).normalized());
+        }
+    }
+}
+
+// Axis aligned rays shot from a grid of points outside of a sphere of the given radius towards it,
+// in packets of 8 rays of the same direction. The inverse of their zero direction components is infinite,
+// like the one of the rays sampling vertical pillars.
+static void append_axis_aligned_rays(double radius, std::vector<Vec3d> &origins, std::vector<Vec3d> &dirs)
+{
+    for (int axis = 0; axis < 3; ++ axis)
+        for (double sign : { -1., 1. })
+            for (int i = -4; i < 4; ++ i)
+                for (int j = -4; j < 4; ++ j) {
+                    Vec3d o = Vec3d::Zero();
+                    o[axis]           = - sign * 3. * radius;
+                    o[(axis + 1) % 3] = radius * (0.25 * i + 0.03);
+                    o[(axis + 2) % 3] = radius * (0.25 * j + 0.03);
+                    Vec3d d = Vec3d::Zero();
+                    d[axis] = sign;
+                    origins.emplace_back(o);
+                    dirs.emplace_back(d);
+                }
+}
+
+TEST_CASE("Ray packets hit the same triangles as single rays", "[AABBIndirect]")
+{
+    indexed_triangle_set its = its_make_sphere(10., PI / 64.);
+    auto tree = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(its.vertices, its.indices);
+
+    double spread = GENERATE(0.01, 0.5, 5.);
+    std::vector<Vec3d> origins, dirs;
+    make_coherent_rays(1000, spread, origins, dirs);
+    append_axis_aligned_rays(10., origins, dirs);
+
+    std::vector<igl::Hit> hits(origins.size());
+    AABBTreeIndirect::intersect_rays_first_hit(its.vertices, its.indices, tree,
+        tcb::span<const Vec3d>{origins}, tcb::span<const Vec3d>{dirs}, tcb::span<igl::Hit>{hits});
+
+    for (size_t i = 0; i < origins.size(); ++i) {
+        igl::Hit hit;
+        bool intersected = AABBTreeIndirect::intersect_ray_first_hit(its.vertices, its.indices, tree, origins[i], dirs[i], hit);
+        REQUIRE(intersected == (hits[i].id >= 0));
+        if (intersected) {
+            REQUIRE(hits[i].id == hit.id);
+            REQUIRE(hits[i].t == Approx(hit.t));
+        }
+    }
+
+    AABBMesh emesh{its};
+    std::vector<AABBMesh::hit_result> results = emesh.query_ray_hit(origins, dirs);
+    REQUIRE(results.size() == origins.size());
+    for (size_t i = 0; i < origins.size(); ++i) {
+        AABBMesh::hit_result single = emesh.query_ray_hit(origins[i], dirs[i]);
+        REQUIRE(results[i].face() == single.face());
+        REQUIRE(results[i].distance() == Approx(single.distance()));
+    }
+}
+
+template<int Width>
+static void test_wide_tree_queries(const indexed_triangle_set &its)
+{
+    auto tree = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(its.vertices, its.indices);
+    auto wide = AABBTreeIndirect::build_wide_aabb_tree_over_indexed_triangle_set<Width>(its.vertices, its.indices);
+    REQUIRE(! wide.empty());
+
+    // Each triangle is referenced by a single leaf, which bounding box contains the triangle.
+    std::vector<int> referenced(its.indices.size(), 0);
+    for (const auto &node : wide.nodes())
+        for (int i = 0; i < Width; ++ i)
+            if (node.is_leaf(i)) {
+                ++ referenced[node.idx(i)];
+                for (int j = 0; j < 3; ++ j)
+                    REQUIRE(node.bbox(i).contains(its.vertices[its.indices[node.idx(i)](j)]));
+            }
+    REQUIRE(std::all_of(referenced.begin(), referenced.end(), [](int cnt) { return cnt == 1; }));
+
+    std::vector<Vec3d> origins, dirs;
+    make_coherent_rays(400, 0.5, origins, dirs);
+    // Packets of axis aligned rays, whose zero direction components have an infinite inverse.
+    append_axis_aligned_rays(10., origins, dirs);
+
+    for (size_t i = 0; i < origins.size(); ++i) {
+        igl::Hit hit, hit_wide;
+        bool intersected = AABBTreeIndirect::intersect_ray_first_hit(its.vertices, its.indices, tree, origins[i], dirs[i], hit);
+        REQUIRE(AABBTreeIndirect::intersect_ray_first_hit(its.vertices, its.indices, wide, origins[i], dirs[i], hit_wide) == intersected);
+        if (intersected)
+            REQUIRE(hit_wide.t == Approx(hit.t));
+
+        std::vector<igl::Hit> hits, hits_wide;
+        AABBTreeIndirect::intersect_ray_all_hits(its.vertices, its.indices, tree, origins[i], dirs[i], hits);
+        AABBTreeIndirect::intersect_ray_all_hits(its.vertices, its.indices, wide, origins[i], dirs[i], hits_wide);
+        REQUIRE(hits_wide.size() == hits.size());
+
+        size_t idx, idx_wide;
+        Vec3d  pt, pt_wide;
+        double dist      = AABBTreeIndirect::squared_distance_to_indexed_triangle_set(its.vertices, its.indices, tree, origins[i], idx, pt);
+        double dist_wide = AABBTreeIndirect::squared_distance_to_indexed_triangle_set(its.vertices, its.indices, wide, origins[i], idx_wide, pt_wide);
+        REQUIRE(dist_wide == Approx(dist));
+
+        std::vector<size_t> in_radius      = AABBTreeIndirect::all_triangles_in_radius(its.vertices, its.indices, tree, origins[i], dist + 4.);
+        std::vector<size_t> in_radius_wide = AABBTreeIndirect::all_triangles_in_radius(its.vertices, its.indices, wide, origins[i], dist + 4.);
+        std::sort(in_radius.begin(), in_radius.end());
+        std::sort(in_radius_wide.begin(), in_radius_wide.end());
+        REQUIRE(in_radius_wide == in_radius);
+    }
+
+    std::vector<igl::Hit> packet_hits(origins.size());
+    AABBTreeIndirect::intersect_rays_first_hit(its.vertices, its.indices, wide,
+        tcb::span<const Vec3d>{origins}, tcb::span<const Vec3d>{dirs}, tcb::span<igl::Hit>{packet_hits});
+    for (size_t i = 0; i < origins.size(); ++i) {
+        igl::Hit hit;
+        if (AABBTreeIndirect::intersect_ray_first_hit(its.vertices, its.indices, tree, origins[i], dirs[i], hit))
+            REQUIRE(packet_hits[i].t == Approx(hit.t));
+        else
+            REQUIRE(packet_hits[i].id == -1);
+    }
+
+    // The quantised bounding boxes are conservative, the traversal may only find more candidates.
+    Eigen::AlignedBox<float, 3> box(Vec3f(-2.f, -2.f, 0.f), Vec3f(12.f, 3.f, 4.f));
+    std::vector<size_t> found, found_wide;
+    AABBTreeIndirect::traverse(tree, AABBTreeIndirect::intersecting(box), [&found](const auto &node) { found.emplace_back(node.idx); return true; });
+    AABBTreeIndirect::traverse(wide, AABBTreeIndirect::intersecting(box), [&found_wide](const auto &node) { found_wide.emplace_back(node.idx); return true; });
+    std::sort(found.begin(), found.end());
+    std::sort(found_wide.begin(), found_wide.end());
+    REQUIRE(! found.empty());
+    REQUIRE(std::includes(found_wide.begin(), found_wide.end(), found.begin(), found.end()));
+}
+
+TEST_CASE("Wide tree queries match the balanced tree", "[AABBIndirect]")
+{
+    // A sphere with a dense cluster of small triangles inside.
+    indexed_triangle_set its = its_make_sphere(10., PI / 32.);
+    indexed_triangle_set cluster = its_make_sphere(0.5, PI / 16.);
+    for (Vec3f &v : cluster.vertices)
+        v += Vec3f(5.f, 0.f, 0.f);
+    its_merge(its, cluster);
+
+    SECTION("4-wide") { test_wide_tree_queries<4>(its); }
+    SECTION("8-wide") { test_wide_tree_queries<8>(its); }
+}
+
+TEST_CASE("Casting ray packets vs single rays", "[AABBIndirect][.Benchmarks]")
+{
+    indexed_triangle_set its = its_make_sphere(10., PI / 256.);
+    AABBMesh emesh{its};
+
+    std::vector<Vec3d> origins, dirs;
+    make_coherent_rays(16000, 0.1, origins, dirs);
+
+    BENCHMARK("Single rays") {
+        std::vector<AABBMesh::hit_result> results;
+        results.reserve(origins.size());
+        for (size_t i = 0; i < origins.size(); ++i)
+            results.emplace_back(emesh.query_ray_hit(origins[i], dirs[i]));
+        return results;
+    };
+
+    BENCHMARK("Ray packets") {
+        return emesh.query_ray_hit(origins, dirs);
+    };
+}
+
+TEST_CASE("Balanced vs wide tree", "[AABBIndirect][.Benchmarks]")
+{
+    indexed_triangle_set its = its_make_sphere(10., PI / 256.);
+
+    std::vector<Vec3d> origins, dirs;
+    make_coherent_rays(16000, 5., origins, dirs);
+
+    auto tree = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(its.vertices, its.indices);
+    auto wide = AABBTreeIndirect::build_wide_aabb_tree_over_indexed_triangle_set(its.vertices, its.indices);
+
+    BENCHMARK("Build balanced tree") {
+        return AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(its.vertices, its.indices);
+    };
+    BENCHMARK("Build wide tree") {
+        return AABBTreeIndirect::build_wide_aabb_tree_over_indexed_triangle_set(its.vertices, its.indices);
+    };
+
+    auto cast_rays = [&its, &origins, &dirs](const auto &tree) {
+        std::vector<igl::Hit> hits(origins.size());
+        for (size_t i = 0; i < origins.size(); ++i)
+            AABBTreeIndirect::intersect_ray_first_hit(its.vertices, its.indices, tree, origins[i], dirs[i], hits[i]);
+        return hits;
+    };
+    BENCHMARK("Ray casting, balanced tree") { return cast_rays(tree); };
+    BENCHMARK("Ray casting, wide tree") { return cast_rays(wide); };
+
+    auto closest_points = [&its, &origins](const auto &tree) {
+        double sum = 0.;
+        for (const Vec3d &pt : origins) {
+            size_t idx;
+            Vec3d  closest;
+            sum += AABBTreeIndirect::squared_distance_to_indexed_triangle_set(its.vertices, its.indices, tree, pt, idx, closest);
+        }
+        return sum;
+    };
+    BENCHMARK("Closest point, balanced tree") { return closest_points(tree); };
+    BENCHMARK("Closest point, wide tree") { return closest_points(wide); };
+}
+
 TEST_CASE("Creating a several 2d lines, testing closest point query", "[AABBIndirect]")
 {
     std::vector<Linef> lines { };
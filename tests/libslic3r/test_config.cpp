@@ -6,6 +6,7 @@
 #include "libslic3r/PrintConfig.hpp"
 
 #include <LocalesUtils.hpp>
+#include <algorithm>
 #include <cereal/types/polymorphic.hpp>
 #include <cereal/types/string.hpp> 
 #include <cereal/types/vector.hpp> 
@@ -130,6 +131,20 @@ TEST_CASE("Config apply static to dynamic", "[Config]") {
 
 }
 
+TEST_CASE("Static config keys are sorted and indexed", "[Config]") {
+    auto check = [](const auto &config) {
+        const t_config_option_keys &keys = config.keys_ref();
+        CHECK(std::is_sorted(keys.begin(), keys.end()));
+        for (size_t i = 0; i < keys.size(); ++ i)
+            REQUIRE(config.optptr_by_key_idx(i) == config.option(keys[i]));
+    };
+    check(PrintObjectConfig());
+    check(PrintRegionConfig());
+    check(PrintConfig());
+    check(FullPrintConfig());
+    check(SLAPrintObjectConfig());
+}
+
 TEST_CASE("Config apply dynamic to dynamic", "[Config]") {
 
     DynamicPrintConfig config;
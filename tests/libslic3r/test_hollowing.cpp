@@ -1,6 +1,7 @@
 #include <iostream>
 #include <fstream>
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
 
 #include "libslic3r/SLA/Hollowing.hpp"
 
@@ -19,3 +20,28 @@ TEST_CASE("Hollow two overlapping spheres") {
     sphere1.WriteOBJFile("twospheres.obj");
 }
 
+
+TEST_CASE("Hollowing deep bands with coarser voxels") {
+    using namespace Slic3r;
+    using Catch::Approx;
+
+    indexed_triangle_set sphere = its_make_sphere(20., 2 * PI / 60.);
+
+    sla::HollowingConfig cfg;
+    cfg.quality = 1.;
+    sla::InteriorPtr fine = sla::generate_interior(sphere, cfg);
+
+    cfg.max_band_voxels = 100000;
+    sla::InteriorPtr coarse = sla::generate_interior(sphere, cfg);
+
+    REQUIRE(fine);
+    REQUIRE(coarse);
+    REQUIRE(get_voxel_scale(sla::get_grid(*coarse)) <
+            get_voxel_scale(sla::get_grid(*fine)));
+
+    double fine_vol   = std::abs(its_volume(sla::get_mesh(*fine)));
+    double coarse_vol = std::abs(its_volume(sla::get_mesh(*coarse)));
+
+    REQUIRE(fine_vol > 0.);
+    REQUIRE(coarse_vol == Approx(fine_vol).epsilon(0.05));
+}
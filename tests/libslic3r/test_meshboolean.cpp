@@ -1,9 +1,12 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
+#include <catch2/benchmark/catch_benchmark_all.hpp>
 #include <test_utils.hpp>
 
 #include <libslic3r/TriangleMesh.hpp>
 #include <libslic3r/MeshBoolean.hpp>
+#include <libslic3r/MeshBooleanFast.hpp>
+#include <libslic3r/Geometry.hpp>
 
 using namespace Slic3r;
 using namespace Catch;
@@ -51,3 +54,76 @@ TEST_CASE("Add TriangleMeshes", "[MeshBoolean]")
     //its_write_obj(tm1.its, "test_add.obj");
     CHECK(tm1.its.indices.size() > init_size);
 }
+
+static indexed_triangle_set transformed(indexed_triangle_set its, double angle, const Vec3d &axis, const Vec3d &offset)
+{
+    const Transform3d trafo = Geometry::translation_transform(offset) * Eigen::AngleAxisd(angle, axis.normalized());
+    its_transform(its, trafo);
+    return its;
+}
+
+TEST_CASE("Fast mesh booleans", "[MeshBoolean]")
+{
+    indexed_triangle_set A, B;
+    SECTION("Sphere and a rotated cube") {
+        A = its_make_sphere(10., 2. * PI / 180.);
+        B = transformed(its_make_cube(12., 12., 12.), 0.3, Vec3d(1., 2., 3.), Vec3d(1.1, -2.3, 0.7));
+    }
+    SECTION("Cube drilled by a cylinder") {
+        A = transformed(its_make_cube(12., 12., 12.), 0.01, Vec3d::UnitX(), Vec3d::Zero());
+        B = transformed(its_make_cylinder(2., 40., 2. * PI / 64.), 0.02, Vec3d(1., 1., 0.), Vec3d(6.1, 5.9, -10.3));
+    }
+    SECTION("Nested spheres") {
+        A = its_make_sphere(10., 2. * PI / 180.);
+        B = transformed(its_make_sphere(3., 2. * PI / 60.), 0.1, Vec3d::UnitX(), Vec3d(1., 1., 1.));
+    }
+
+    auto run = [&A, &B](MeshBoolean::fast::BooleanOperation op) {
+        indexed_triangle_set result = A;
+        REQUIRE(MeshBoolean::fast::mesh_boolean(result, B, op));
+        REQUIRE(its_num_open_edges(result) == 0);
+        return double(its_volume(result));
+    };
+    const double volume_a  = its_volume(A);
+    const double volume_b  = its_volume(B);
+    const double united    = run(MeshBoolean::fast::BooleanOperation::Union);
+    const double subtracted = run(MeshBoolean::fast::BooleanOperation::Difference);
+    const double common    = run(MeshBoolean::fast::BooleanOperation::Intersection);
+    CHECK(common > 0.);
+    CHECK(united + common == Approx(volume_a + volume_b).epsilon(1e-5));
+    CHECK(subtracted + common == Approx(volume_a).epsilon(1e-5));
+
+    TriangleMesh exact{A};
+    MeshBoolean::minus(exact, TriangleMesh{B});
+    CHECK(subtracted == Approx(exact.volume()).epsilon(1e-5));
+}
+
+TEST_CASE("Fast mesh boolean leaves coplanar facets to CGAL", "[MeshBoolean]")
+{
+    indexed_triangle_set A = its_make_cube(12., 12., 12.);
+    indexed_triangle_set B = its_make_cube(5., 5., 5.);
+    indexed_triangle_set result = A;
+    REQUIRE(! MeshBoolean::fast::minus(result, B));
+    CHECK(result.vertices == A.vertices);
+    CHECK(result.indices == A.indices);
+
+    MeshBoolean::cgal::minus(result, B);
+    CHECK(its_volume(result) == Approx(12. * 12. * 12. - 5. * 5. * 5.));
+}
+
+TEST_CASE("Fast vs CGAL mesh booleans", "[MeshBoolean][.Benchmarks]")
+{
+    const indexed_triangle_set A = its_make_sphere(10., PI / 128.);
+    const indexed_triangle_set B = transformed(its_make_sphere(10., PI / 100.), 0.3, Vec3d(1., 2., 3.), Vec3d(5.1, 3.3, 1.7));
+
+    BENCHMARK("Fast difference") {
+        indexed_triangle_set result = A;
+        MeshBoolean::fast::minus(result, B);
+        return result;
+    };
+    BENCHMARK("CGAL difference") {
+        TriangleMesh result{A};
+        MeshBoolean::minus(result, TriangleMesh{B});
+        return result;
+    };
+}
@@ -3,6 +3,7 @@
 #endif
 
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark_all.hpp>
 
 #include <numeric>
 
@@ -56,3 +57,49 @@ TEST_CASE("PNG read", "[PNG]") {
         REQUIRE(sum == rstsum);
     }
 }
+
+// Layer mask larger than a single deflate block of the PNG encoder, containing empty rows, constant rows,
+// rows repeating the previous row and rows of varying content.
+static std::vector<uint8_t> create_layer_mask(size_t w, size_t h)
+{
+    std::vector<uint8_t> img(w * h, 0);
+    for (size_t r = 0; r < h; ++r) {
+        uint8_t *row = img.data() + r * w;
+        switch (r % 7) {
+        case 0: break;
+        case 1: std::fill(row, row + w, uint8_t(255)); break;
+        case 2: std::copy(row - w, row, row); break;
+        default:
+            for (size_t c = 0; c < w; ++c)
+                row[c] = (c + 3 * r) % 97 < 40 ? 255 : uint8_t((c * 7 + r * 13) % 251);
+        }
+    }
+    return img;
+}
+
+TEST_CASE("PNG encode of a large layer", "[PNG]") {
+    const size_t w = 2560, h = 1440;
+    std::vector<uint8_t> mask = create_layer_mask(w, h);
+
+    auto enc_rst = sla::PNGRasterEncoder{}(mask.data(), w, h, 1);
+    REQUIRE(png::is_png({enc_rst.data(), enc_rst.size()}));
+
+    png::ImageGreyscale img;
+    REQUIRE(png::decode_png({enc_rst.data(), enc_rst.size()}, img));
+    REQUIRE(img.rows == h);
+    REQUIRE(img.cols == w);
+    REQUIRE(img.buf == mask);
+}
+
+TEST_CASE("PNG encode benchmark", "[PNG][.Benchmarks]") {
+    const size_t w = 11520, h = 5120;
+    std::vector<uint8_t> empty(w * h, 0);
+    std::vector<uint8_t> mask = create_layer_mask(w, h);
+
+    BENCHMARK("Encode empty layer") {
+        return sla::PNGRasterEncoder{}(empty.data(), w, h, 1);
+    };
+    BENCHMARK("Encode layer") {
+        return sla::PNGRasterEncoder{}(mask.data(), w, h, 1);
+    };
+}
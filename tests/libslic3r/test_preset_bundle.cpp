@@ -0,0 +1,245 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "libslic3r/AppConfig.hpp"
+#include "libslic3r/PresetBundle.hpp"
+#include "libslic3r/Utils.hpp"
+
+#include <algorithm>
+
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+
+using namespace Slic3r;
+
+// Temporary data directory, into which the config bundle snapshots are stored.
+struct TempDataDir
+{
+    TempDataDir() : previous(data_dir()), path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("presets-%%%%-%%%%"))
+    {
+        boost::filesystem::create_directories(path);
+        set_data_dir(path.string());
+    }
+    ~TempDataDir()
+    {
+        set_data_dir(previous);
+        boost::system::error_code ec;
+        boost::filesystem::remove_all(path, ec);
+    }
+
+    std::string             previous;
+    boost::filesystem::path path;
+};
+
+static const char *test_vendor_bundle = R"(
+[vendor]
+name = Test
+config_version = 1.0.0
+
+[printer_model:TEST]
+name = Test Printer
+variants = 0.4
+technology = FFF
+
+[print:*common*]
+layer_height = 0.2
+perimeters = 3
+
+[print:0.20mm NORMAL]
+inherits = *common*
+fill_density = 20%
+
+[print:0.15mm DETAIL]
+inherits = 0.20mm NORMAL
+layer_height = 0.15
+
+[print:0.30mm DRAFT]
+inherits = *common*
+layer_height = 0.3
+
+[filament:*PLA*]
+temperature = 210
+filament_type = PLA
+
+[filament:Test PLA]
+inherits = *PLA*
+filament_colour = #FF8000
+
+[filament:Test PETG]
+inherits = *PLA*
+temperature = 240
+filament_type = PETG
+
+[printer:*common*]
+printer_technology = FFF
+bed_shape = 0x0,250x0,250x210,0x210
+max_print_height = 210
+
+[printer:Test Printer]
+inherits = *common*
+printer_model = TEST
+printer_variant = 0.4
+nozzle_diameter = 0.4
+)";
+
+static void write_file(const boost::filesystem::path &path, const std::string &data)
+{
+    boost::nowide::ofstream ofs(path.string(), std::ios::binary);
+    ofs << data;
+}
+
+static std::string read_file(const boost::filesystem::path &path)
+{
+    boost::nowide::ifstream ifs(path.string(), std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+// Snapshots of the config bundles stored in the data directory.
+static std::vector<boost::filesystem::path> config_bundle_snapshots(const boost::filesystem::path &data_dir)
+{
+    std::vector<boost::filesystem::path> out;
+    const boost::filesystem::path dir = data_dir / "cache" / "config_bundles";
+    if (boost::filesystem::exists(dir))
+        for (const boost::filesystem::directory_entry &entry : boost::filesystem::directory_iterator(dir))
+            if (entry.path().extension() == ".cereal")
+                out.emplace_back(entry.path());
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+static void check_same_presets(const PresetCollection &lhs, const PresetCollection &rhs)
+{
+    REQUIRE(lhs.size() == rhs.size());
+    for (const Preset &preset : lhs) {
+        INFO("Preset " << preset.name);
+        const Preset *other = rhs.find_preset(preset.name);
+        REQUIRE(other != nullptr);
+        CHECK(other->alias == preset.alias);
+        CHECK(other->renamed_from == preset.renamed_from);
+        CHECK(other->config == preset.config);
+    }
+}
+
+static void check_same_presets(const PresetBundle &lhs, const PresetBundle &rhs)
+{
+    check_same_presets(lhs.prints, rhs.prints);
+    check_same_presets(lhs.filaments, rhs.filaments);
+    check_same_presets(lhs.printers, rhs.printers);
+}
+
+TEST_CASE("Config bundle snapshot", "[PresetBundle]") {
+    TempDataDir data_dir;
+    const boost::filesystem::path bundle_path = data_dir.path / "Test.ini";
+    write_file(bundle_path, test_vendor_bundle);
+
+    // Loading the INI file saves the snapshot.
+    PresetBundle from_ini;
+    from_ini.load_configbundle(bundle_path.string(), PresetBundle::LoadSystem, ForwardCompatibilitySubstitutionRule::EnableSystemSilent);
+    REQUIRE(from_ini.prints.find_preset("0.15mm DETAIL") != nullptr);
+    const std::vector<boost::filesystem::path> snapshots = config_bundle_snapshots(data_dir.path);
+    REQUIRE(snapshots.size() == 1);
+    const boost::filesystem::path snapshot_path = snapshots.front();
+
+    SECTION("Snapshot round trip") {
+        PresetBundle from_snapshot;
+        from_snapshot.load_configbundle(bundle_path.string(), PresetBundle::LoadSystem, ForwardCompatibilitySubstitutionRule::EnableSystemSilent);
+        check_same_presets(from_ini, from_snapshot);
+        CHECK(from_snapshot.prints.find_preset("0.15mm DETAIL")->config.opt_float("layer_height") == 0.15);
+        CHECK(from_snapshot.prints.find_preset("0.15mm DETAIL")->config.opt_int("perimeters") == 3);
+    }
+
+    SECTION("Damaged snapshot is rejected") {
+        // Flip the last byte of the payload.
+        std::string data = read_file(snapshot_path);
+        REQUIRE(! data.empty());
+        data.back() ^= 0x5a;
+        write_file(snapshot_path, data);
+        PresetBundle from_damaged;
+        from_damaged.load_configbundle(bundle_path.string(), PresetBundle::LoadSystem, ForwardCompatibilitySubstitutionRule::EnableSystemSilent);
+        check_same_presets(from_ini, from_damaged);
+    }
+
+    SECTION("Snapshot is rejected after the INI file changed") {
+        std::string modified = test_vendor_bundle;
+        const std::string old_value = "layer_height = 0.15";
+        modified.replace(modified.find(old_value), old_value.size(), "layer_height = 0.1");
+        write_file(bundle_path, modified);
+        PresetBundle from_modified;
+        from_modified.load_configbundle(bundle_path.string(), PresetBundle::LoadSystem, ForwardCompatibilitySubstitutionRule::EnableSystemSilent);
+        CHECK(from_modified.prints.find_preset("0.15mm DETAIL")->config.opt_float("layer_height") == 0.1);
+        // The snapshot was replaced by the one of the modified INI file.
+        PresetBundle from_snapshot;
+        from_snapshot.load_configbundle(bundle_path.string(), PresetBundle::LoadSystem, ForwardCompatibilitySubstitutionRule::EnableSystemSilent);
+        check_same_presets(from_modified, from_snapshot);
+    }
+
+    SECTION("Config bundles of the same name in different directories have their own snapshots") {
+        // Such as the config bundles in resources/profiles, vendor and cache/vendor.
+        const boost::filesystem::path other_path = data_dir.path / "vendor" / "Test.ini";
+        std::string modified = test_vendor_bundle;
+        const std::string old_value = "layer_height = 0.15";
+        modified.replace(modified.find(old_value), old_value.size(), "layer_height = 0.1");
+        boost::filesystem::create_directories(other_path.parent_path());
+        write_file(other_path, modified);
+        const std::string snapshot_data = read_file(snapshot_path);
+        PresetBundle from_other;
+        from_other.load_configbundle(other_path.string(), PresetBundle::LoadSystem, ForwardCompatibilitySubstitutionRule::EnableSystemSilent);
+        CHECK(from_other.prints.find_preset("0.15mm DETAIL")->config.opt_float("layer_height") == 0.1);
+        // The snapshot of the first config bundle was not replaced.
+        REQUIRE(config_bundle_snapshots(data_dir.path).size() == 2);
+        CHECK(read_file(snapshot_path) == snapshot_data);
+        PresetBundle from_snapshot;
+        from_snapshot.load_configbundle(bundle_path.string(), PresetBundle::LoadSystem, ForwardCompatibilitySubstitutionRule::EnableSystemSilent);
+        check_same_presets(from_ini, from_snapshot);
+    }
+}
+
+TEST_CASE("Loading a subset of a system config bundle", "[PresetBundle]") {
+    TempDataDir data_dir;
+    const boost::filesystem::path bundle_path = data_dir.path / "Test.ini";
+    write_file(bundle_path, test_vendor_bundle);
+
+    PresetBundle full;
+    full.load_configbundle(bundle_path.string(), PresetBundle::LoadSystem, ForwardCompatibilitySubstitutionRule::EnableSystemSilent);
+
+    SECTION("Parent chains and internal presets") {
+        PresetBundle subset;
+        subset.system_presets_filter = { "0.15mm DETAIL", "Test PLA" };
+        subset.load_configbundle(bundle_path.string(), PresetBundle::LoadSystem, ForwardCompatibilitySubstitutionRule::EnableSystemSilent);
+        // The named presets are loaded with the values inherited over the parent chain, including the internal *common* presets.
+        const Preset *print = subset.prints.find_preset("0.15mm DETAIL");
+        REQUIRE(print != nullptr);
+        CHECK(print->config == full.prints.find_preset("0.15mm DETAIL")->config);
+        CHECK(print->config.opt_int("perimeters") == 3);
+        const Preset *filament = subset.filaments.find_preset("Test PLA");
+        REQUIRE(filament != nullptr);
+        CHECK(filament->config == full.filaments.find_preset("Test PLA")->config);
+        CHECK(filament->config.opt_int("temperature", 0) == 210);
+        // The visible parents are loaded as well, the internal presets are not.
+        CHECK(subset.prints.find_preset("0.20mm NORMAL") != nullptr);
+        CHECK(subset.prints.find_preset("*common*") == nullptr);
+        // Presets outside of the filter and of the parent chains are not loaded.
+        CHECK(subset.prints.find_preset("0.30mm DRAFT") == nullptr);
+        CHECK(subset.filaments.find_preset("Test PETG") == nullptr);
+        CHECK(subset.printers.find_preset("Test Printer") == nullptr);
+    }
+
+    SECTION("User preset inheriting from a system preset") {
+        boost::filesystem::create_directories(data_dir.path / "vendor");
+        boost::filesystem::rename(bundle_path, data_dir.path / "vendor" / "Test.ini");
+        PresetBundle subset;
+        subset.setup_directories();
+        write_file(data_dir.path / "print" / "My Print.ini", "inherits = 0.15mm DETAIL\nlayer_height = 0.1\n");
+        subset.system_presets_filter = { "My Print", "Test PLA", "Test Printer" };
+        AppConfig app_config(AppConfig::EAppMode::Editor);
+        subset.load_presets(app_config, ForwardCompatibilitySubstitutionRule::EnableSystemSilent);
+        // The system parents of the user preset are loaded.
+        const Preset *user_print = subset.prints.find_preset("My Print");
+        REQUIRE(user_print != nullptr);
+        CHECK(user_print->config.opt_float("layer_height") == 0.1);
+        const Preset *parent = subset.prints.get_preset_parent(*user_print);
+        REQUIRE(parent != nullptr);
+        CHECK(parent->name == "0.15mm DETAIL");
+        CHECK(subset.prints.find_preset("0.20mm NORMAL") != nullptr);
+        CHECK(subset.prints.find_preset("0.30mm DRAFT") == nullptr);
+    }
+}
@@ -240,6 +240,55 @@ TEST_CASE("Simplify frog_legs.obj to 5% by Quadric edge collapse", "[its][quadri
     Private::is_better_similarity(mesh.its, its, Private::frog_leg_5);
 }
 
+TEST_CASE("Simplify frog_legs.obj to 5% by parallel Quadric edge collapse", "[its][quadric_edge_collapse]")
+{
+    TriangleMesh mesh            = load_model("frog_legs.obj");
+    double       original_volume = its_volume(mesh.its);
+    uint32_t     wanted_count    = mesh.its.indices.size() * 0.05;
+    REQUIRE_FALSE(mesh.empty());
+    indexed_triangle_set its_serial = mesh.its; // copy
+    float                max_error  = std::numeric_limits<float>::max();
+    its_quadric_edge_collapse(its_serial, wanted_count, &max_error);
+
+    indexed_triangle_set its = mesh.its; // copy
+    max_error                = std::numeric_limits<float>::max();
+    int last_status          = 0;
+    its_quadric_edge_collapse_parallel(its, wanted_count, &max_error, nullptr, [&last_status](int status) {
+        CHECK(status >= last_status);
+        last_status = status;
+    });
+    CHECK(last_status == 100);
+    CHECK(its.indices.size() <= wanted_count);
+    CHECK(!Private::exist_triangle_with_twice_vertices(its.indices));
+    double volume = its_volume(its);
+    CHECK(fabs(original_volume - volume) < 33.);
+    Private::is_better_similarity(mesh.its, its, Private::frog_leg_5);
+
+    // distance from the original surface is close to the serial simplification
+    Private::Similarity serial   = Private::get_similarity(mesh.its, its_serial);
+    Private::Similarity parallel = Private::get_similarity(mesh.its, its);
+    CHECK(parallel.average_distance < 1.1f * serial.average_distance);
+    CHECK(parallel.max_distance < 1.1f * serial.max_distance);
+}
+
+TEST_CASE("Parallel Quadric edge collapse does not exceed maximal error", "[its][quadric_edge_collapse]")
+{
+    TriangleMesh mesh = load_model("frog_legs.obj");
+    REQUIRE_FALSE(mesh.empty());
+    const float          maximal_error = 1e-3f;
+    indexed_triangle_set its_serial    = mesh.its; // copy
+    float                max_error     = maximal_error;
+    its_quadric_edge_collapse(its_serial, 0, &max_error);
+    indexed_triangle_set its = mesh.its; // copy
+    max_error                = maximal_error;
+    its_quadric_edge_collapse_parallel(its, 0, &max_error);
+    CHECK(max_error < maximal_error);
+    CHECK(its.indices.size() < mesh.its.indices.size());
+    // collapses are limited by the same error, most of the serial collapses are found
+    CHECK(its.indices.size() < 1.1 * its_serial.indices.size());
+    CHECK(!Private::exist_triangle_with_twice_vertices(its.indices));
+}
+
 TEST_CASE("Simplify frog_legs.obj to 5% by IGL/qslim", "[its]")
 {
     std::string  obj_filename    = "frog_legs.obj";
@@ -294,6 +343,17 @@ TEST_CASE("Simplify trouble case", "[its]")
     CHECK(!Private::exist_triangle_with_twice_vertices(tm.its.indices));
 }
 
+TEST_CASE("Simplify trouble case in parallel", "[its]")
+{
+    TriangleMesh tm = load_model("simplification.obj");
+    REQUIRE_FALSE(tm.empty());
+    float    max_error    = std::numeric_limits<float>::max();
+    uint32_t wanted_count = 0;
+    its_quadric_edge_collapse_parallel(tm.its, wanted_count, &max_error);
+    CHECK(!Private::exist_triangle_with_twice_vertices(tm.its.indices));
+    CHECK(!tm.its.indices.empty());
+}
+
 TEST_CASE("Simplified cube should not be empty.", "[its]")
 {
     auto     its          = its_make_cube(1, 2, 3);
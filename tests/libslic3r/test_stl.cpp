@@ -1,9 +1,18 @@
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <random>
 
 #include "libslic3r/Model.hpp"
 #include "libslic3r/Format/STL.hpp"
+#include "libslic3r/TriangleMeshRepair.hpp"
+#include "libslic3r/MeshOutOfCore.hpp"
+
+#include <boost/filesystem.hpp>
 
 using namespace Slic3r;
+using namespace Catch;
 
 static inline std::string stl_path(const char* path)
 {
@@ -55,3 +64,136 @@ SCENARIO("Reading an STL file", "[stl]") {
 		}
 	}
 }
+
+// Soup of facets as read by stl_open(), with holes, flipped, degenerate, duplicate and slightly displaced facets.
+static stl_file broken_stl(const indexed_triangle_set &its, bool inside_out)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dist(0.f, 1.f);
+    stl_file stl;
+    for (const stl_triangle_vertex_indices &face : its.indices) {
+        stl_facet facet;
+        for (int i = 0; i < 3; ++ i)
+            facet.vertex[i] = its.vertices[face(i)];
+        facet.normal = (facet.vertex[1] - facet.vertex[0]).cross(facet.vertex[2] - facet.vertex[0]).normalized();
+        if (inside_out)
+            std::swap(facet.vertex[0], facet.vertex[1]);
+        if (float r = dist(rng); r < 0.02f)
+            continue;
+        else if (r < 0.05f)
+            std::swap(facet.vertex[0], facet.vertex[1]);
+        else if (r < 0.06f)
+            facet.vertex[1] = facet.vertex[0];
+        else if (r < 0.08f)
+            facet.vertex[2] += stl_vertex(1e-4f * dist(rng), 1e-4f * dist(rng), 0.f);
+        else if (r < 0.09f)
+            stl.facet_start.emplace_back(facet);
+        stl.facet_start.emplace_back(facet);
+    }
+    stl.stats.number_of_facets    = uint32_t(stl.facet_start.size());
+    stl.stats.original_num_facets = int(stl.stats.number_of_facets);
+    stl.neighbors_start.assign(stl.facet_start.size(), stl_neighbors());
+    bool first = true;
+    for (const stl_facet &facet : stl.facet_start)
+        stl_facet_stats(&stl, facet, first);
+    stl.stats.size              = stl.stats.max - stl.stats.min;
+    stl.stats.bounding_diameter = stl.stats.size.norm();
+    return stl;
+}
+
+// The repair pipeline as it used to be run with admesh on import.
+static void admesh_repair(stl_file &stl)
+{
+    stl_check_facets_exact(&stl);
+    float tolerance = stl.stats.shortest_edge;
+    for (int i = 0; i < 2 && stl.stats.connected_facets_3_edge < int(stl.stats.number_of_facets); ++ i) {
+        stl_check_facets_nearby(&stl, tolerance);
+        tolerance += stl.stats.bounding_diameter / 10000.0f;
+    }
+    if (stl.stats.connected_facets_3_edge < int(stl.stats.number_of_facets))
+        stl_remove_unconnected_facets(&stl);
+    stl_fix_normal_directions(&stl);
+    stl_fix_normal_values(&stl);
+    stl_calculate_volume(&stl);
+    stl_verify_neighbors(&stl);
+    if (stl.stats.degenerate_facets > 0)
+        stl_check_facets_exact(&stl);
+}
+
+TEST_CASE("Repairing a broken STL produces the same mesh and statistics as admesh", "[stl]") {
+    const bool inside_out = GENERATE(false, true);
+    stl_file stl = broken_stl(its_make_sphere(10., 2. * PI / 180.), inside_out);
+    stl_file stl_admesh = stl;
+
+    admesh_repair(stl_admesh);
+    indexed_triangle_set its_admesh;
+    stl_generate_shared_vertices(&stl_admesh, its_admesh);
+    indexed_triangle_set its = its_repair_stl(stl);
+
+    REQUIRE(stl_admesh.stats.edges_fixed > 0);
+    REQUIRE(stl_admesh.stats.degenerate_facets > 0);
+    REQUIRE(stl_admesh.stats.facets_reversed > 0);
+    CHECK(stl.stats.number_of_facets == stl_admesh.stats.number_of_facets);
+    CHECK(stl.stats.edges_fixed == stl_admesh.stats.edges_fixed);
+    CHECK(stl.stats.degenerate_facets == stl_admesh.stats.degenerate_facets);
+    CHECK(stl.stats.facets_removed == stl_admesh.stats.facets_removed);
+    CHECK(stl.stats.facets_reversed == stl_admesh.stats.facets_reversed);
+    CHECK(stl.stats.backwards_edges == stl_admesh.stats.backwards_edges);
+    CHECK(stl.stats.number_of_parts == stl_admesh.stats.number_of_parts);
+    CHECK(stl.stats.connected_facets_1_edge == stl_admesh.stats.connected_facets_1_edge);
+    CHECK(stl.stats.connected_facets_2_edge == stl_admesh.stats.connected_facets_2_edge);
+    CHECK(stl.stats.connected_facets_3_edge == stl_admesh.stats.connected_facets_3_edge);
+    CHECK(stl.stats.volume == stl_admesh.stats.volume);
+    CHECK(its.vertices == its_admesh.vertices);
+    CHECK(its.indices == its_admesh.indices);
+}
+
+TEST_CASE("Out of core mesh is sliced the same as the mesh loaded at once", "[stl]") {
+    indexed_triangle_set sphere = its_make_sphere(10., 2. * PI / 180.);
+    const std::string path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("ooc-%%%%-%%%%.stl")).string();
+    REQUIRE(its_write_stl_binary(path.c_str(), "sphere", sphere));
+
+    OutOfCoreMesh::Params params;
+    params.chunk_facets = 1000;
+    params.slab_height  = 3.f;
+    {
+        OutOfCoreMesh mesh(path, params);
+        REQUIRE(mesh.facets_count() == sphere.indices.size());
+        REQUIRE(mesh.slabs_count() == 8);
+        size_t facets = 0;
+        for (size_t i = 0; i < mesh.slabs_count(); ++ i)
+            facets += mesh.slab_facets_count(i);
+        CHECK(facets > sphere.indices.size());
+
+        std::vector<float> zs;
+        for (float z = -10.5f; z < 10.5f; z += 0.25f)
+            zs.emplace_back(z);
+        MeshSlicingParamsEx slicing_params;
+        slicing_params.trafo.translate(Vec3d(1., 2., 5.)).scale(Vec3d(1.1, 0.9, 1.5));
+        std::vector<ExPolygons> expected = slice_mesh_ex(sphere, zs, slicing_params);
+        std::vector<ExPolygons> slices   = slice_mesh_ex(mesh, zs, slicing_params);
+        REQUIRE(slices.size() == expected.size());
+        for (size_t i = 0; i < zs.size(); ++ i) {
+            REQUIRE(slices[i].size() == expected[i].size());
+            double area = 0., area_expected = 0.;
+            for (const ExPolygon &expoly : slices[i])
+                area += expoly.area();
+            for (const ExPolygon &expoly : expected[i])
+                area_expected += expoly.area();
+            CHECK(area == Approx(area_expected));
+        }
+
+        slicing_params.trafo.rotate(Eigen::AngleAxisd(0.1, Vec3d::UnitX()));
+        CHECK_THROWS_AS(slice_mesh_ex(mesh, zs, slicing_params), Slic3r::InvalidArgument);
+    }
+
+    SECTION("Simplification keeps the volume") {
+        indexed_triangle_set simplified = its_simplify_stl_out_of_core(path, 1.f, 1000);
+        CHECK(simplified.indices.size() < sphere.indices.size() / 4);
+        CHECK(its_volume(simplified) == Approx(its_volume(sphere)).epsilon(0.02));
+        for (const stl_triangle_vertex_indices &face : simplified.indices)
+            CHECK((face(0) != face(1) && face(1) != face(2) && face(2) != face(0)));
+    }
+
+    boost::filesystem::remove(path);
+}
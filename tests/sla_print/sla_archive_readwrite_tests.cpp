@@ -6,10 +6,15 @@
 #include "libslic3r/Format/SLAArchiveFormatRegistry.hpp"
 #include "libslic3r/Format/SLAArchiveWriter.hpp"
 #include "libslic3r/Format/SLAArchiveReader.hpp"
+#include "libslic3r/Format/SL1.hpp"
+#include "libslic3r/Format/ZipperArchiveImport.hpp"
 #include "libslic3r/FileReader.hpp"
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+#include <cstring>
+
 using namespace Slic3r;
 
 TEST_CASE("Archive export test", "[sla_archives]") {
@@ -69,3 +74,67 @@ TEST_CASE("Archive export test", "[sla_archives]") {
         }
     }
 }
+
+// Rasterizes and encodes the layers one after another, as the export did before the layers were streamed
+// into the archive by SLAArchiveWriter::write_layers().
+class SL1ArchiveSerial: public SL1Archive {
+public:
+    using SL1Archive::SL1Archive;
+
+    std::vector<sla::EncodedRaster> encode_layers(const SLAPrint &print) const
+    {
+        std::vector<sla::EncodedRaster> layers;
+        for (const SLAPrint::PrintLayer &layer : print.print_layers()) {
+            auto rst = create_raster();
+            for (const ExPolygon &poly : layer.transformed_slices())
+                rst->draw(poly);
+            layers.emplace_back(rst->encode(get_encoder()));
+        }
+        return layers;
+    }
+};
+
+TEST_CASE("Archive export streams the same layers as the serial export", "[sla_archives]") {
+    SLAPrint print;
+    SLAFullPrintConfig fullcfg;
+
+    auto m = FileReader::load_model(TEST_DATA_DIR PATH_SEPARATOR + std::string("20mm_cube.obj"));
+
+    fullcfg.printer_technology.setInt(ptSLA);
+    fullcfg.set("sla_archive_format", "SL1");
+    fullcfg.set("supports_enable", false);
+    fullcfg.set("pad_enable", false);
+
+    DynamicPrintConfig cfg;
+    cfg.apply(fullcfg);
+
+    std::vector<int> progress;
+    print.set_status_callback([&progress](const PrintBase::SlicingStatus &status) { progress.emplace_back(status.percent); });
+    print.apply(m, cfg);
+    print.process();
+    progress.clear();
+
+    const std::string outputfname = "output_20mm_cube_streamed.sl1";
+    print.export_print(outputfname, ThumbnailsList{}, "20mm_cube");
+    REQUIRE(boost::filesystem::exists(outputfname));
+
+    // The progress is reported while the layers are written.
+    REQUIRE(! progress.empty());
+    CHECK(std::is_sorted(progress.begin(), progress.end()));
+    CHECK(progress.back() == 100);
+
+    const std::vector<sla::EncodedRaster> layers = SL1ArchiveSerial{print.printer_config()}.encode_layers(print);
+    REQUIRE(layers.size() > 1);
+
+    ZipperArchive arch = read_zipper_archive(outputfname, {".png"}, {"thumbnail"});
+    std::sort(arch.entries.begin(), arch.entries.end(),
+              [](const EntryBuffer &a, const EntryBuffer &b) { return a.fname < b.fname; });
+    REQUIRE(arch.entries.size() == layers.size());
+    for (size_t i = 0; i < layers.size(); ++ i) {
+        INFO("Layer " << i);
+        REQUIRE(arch.entries[i].buf.size() == layers[i].size());
+        CHECK(std::memcmp(arch.entries[i].buf.data(), layers[i].data(), layers[i].size()) == 0);
+    }
+
+    boost::filesystem::remove(outputfname);
+}
@@ -3,10 +3,16 @@
 #include <numeric>
 #include <cstdint>
 
+#include <catch2/generators/catch_generators.hpp>
+#include <tbb/task_arena.h>
+
 #include "sla_test_utils.hpp"
 
 #include <libslic3r/TriangleMeshSlicer.hpp>
+#include <libslic3r/SLA/DefaultSupportTree.hpp>
 #include <libslic3r/SLA/SupportTreeMesher.hpp>
+#include <libslic3r/SLA/PinheadCache.hpp>
+#include <libslic3r/SLA/CoverageRaster.hpp>
 #include <libslic3r/BranchingTree/PointCloud.hpp>
 
 namespace {
@@ -140,6 +146,82 @@ TEST_CASE("BranchingSupports::FloorSupportsDoNotPierceModel", "[SLASupportGenera
         test_support_model_collision(fname, supportcfg);
 }
 
+TEST_CASE("Support tree with cached pinheads matches full regeneration", "[SLASupportGeneration]") {
+    TriangleMesh mesh = load_model("20mm_cube.obj");
+    BoundingBoxf3 bb = mesh.bounding_box();
+
+    // Support points on a grid covering the bottom face of the cube.
+    sla::SupportPoints pts;
+    for (double x = bb.min.x() + 2.; x < bb.max.x() - 1.; x += 4.)
+        for (double y = bb.min.y() + 2.; y < bb.max.y() - 1.; y += 4.)
+            pts.push_back({ Vec3f(float(x), float(y), float(bb.min.z())), 0.4f, sla::SupportPointType::manual_add });
+
+    auto tree_type = GENERATE(sla::SupportTreeType::Default, sla::SupportTreeType::Branching);
+    sla::SupportTreeConfig supportcfg;
+    supportcfg.tree_type = tree_type;
+
+    sla::SupportableMesh sm{mesh.its, pts, supportcfg};
+    sla::PinheadCache    cache;
+    sm.pinhead_cache = &cache;
+
+    indexed_triangle_set first = sla::create_support_tree(sm, {});
+    REQUIRE(! first.empty());
+    REQUIRE(cache.size() == pts.size());
+
+    // Edit the support points: move one, remove one and add a new one.
+    sm.pts[0].pos += Vec3f(1.f, 0.5f, 0.f);
+    sm.pts.pop_back();
+    sm.pts.push_back({ Vec3f(float(bb.center().x()) + 0.5f, float(bb.center().y()), float(bb.min.z())), 0.4f, sla::SupportPointType::manual_add });
+
+    indexed_triangle_set cached = sla::create_support_tree(sm, {});
+    REQUIRE(cache.size() == sm.pts.size());
+
+    sm.pinhead_cache = nullptr;
+    indexed_triangle_set full = sla::create_support_tree(sm, {});
+
+    REQUIRE(cached.indices.size() == full.indices.size());
+    REQUIRE(its_volume(cached) == Approx(its_volume(full)));
+}
+
+TEST_CASE("Parallel routing to the ground matches serial routing", "[SLASupportGeneration]") {
+    TriangleMesh mesh = load_model("20mm_cube.obj");
+    BoundingBoxf3 bb = mesh.bounding_box();
+
+    // Dense support points on the bottom face of the elevated cube, routed to the ground in many clusters.
+    sla::SupportPoints pts;
+    for (double x = bb.min.x() + 1.; x < bb.max.x() - 0.5; x += 1.5)
+        for (double y = bb.min.y() + 1.; y < bb.max.y() - 0.5; y += 1.5)
+            pts.push_back({ Vec3f(float(x), float(y), float(bb.min.z())), 0.4f, sla::SupportPointType::manual_add });
+
+    sla::SupportTreeConfig supportcfg;
+    supportcfg.tree_type = sla::SupportTreeType::Default;
+    sla::SupportableMesh sm{mesh.its, pts, supportcfg};
+
+    sla::SupportTreeBuilder parallel;
+    sla::DefaultSupportTree::execute(parallel, sm);
+
+    // A single thread arena routes the clusters one after another.
+    sla::SupportTreeBuilder serial;
+    tbb::task_arena arena(1);
+    arena.execute([&serial, &sm]() { sla::DefaultSupportTree::execute(serial, sm); });
+
+    REQUIRE(serial.pillarcount() > 0);
+    REQUIRE(parallel.pillarcount() == serial.pillarcount());
+
+    // The pillar IDs do not depend on the order in which the threads created the pillars.
+    for (size_t i = 0; i < serial.pillarcount(); ++ i) {
+        const sla::Pillar &p = parallel.pillar(i);
+        const sla::Pillar &s = serial.pillar(i);
+        CHECK((p.endpt - s.endpt).norm() < EPSILON);
+        CHECK(p.height == Approx(s.height));
+        CHECK(p.links == s.links);
+        CHECK(p.bridges == s.bridges);
+    }
+
+    REQUIRE(its_volume(parallel.retrieve_mesh(sla::MeshType::Support)) ==
+            Approx(its_volume(serial.retrieve_mesh(sla::MeshType::Support))));
+}
+
 TEST_CASE("InitializedRasterShouldBeNONEmpty", "[SLARasterOutput]") {
     // Default Prusa SL1 display parameters
     sla::Resolution res{2560, 1440};
@@ -206,6 +288,56 @@ TEST_CASE("RasterizedPolygonAreaShouldMatch", "[SLARasterOutput]") {
 }
 
 
+TEST_CASE("CoverageRasterShouldMatchAGG", "[SLARasterOutput]") {
+    double disp_w = 120., disp_h = 68.;
+    sla::Resolution res{2560, 1440};
+    sla::PixelDim pixdim{disp_w / res.width_px, disp_h / res.height_px};
+    auto bb = BoundingBox({0, 0}, {scaled(disp_w), scaled(disp_h)});
+
+    // Wavy ring, partially outside of the display.
+    ExPolygon ring;
+    for (int i = 0; i < 360; ++ i) {
+        double a = 2. * PI * i / 360., r = 15. * (1. + 0.2 * std::sin(7. * a));
+        ring.contour.points.emplace_back(scaled(r * std::cos(a)), scaled(r * std::sin(a)));
+    }
+    ring.holes.emplace_back(ring.contour.points);
+    ring.holes.front().scale(0.4);
+    ring.holes.front().reverse();
+    ring.translate(bb.min.x(), bb.center().y());
+
+    ExPolygon square = square_with_hole(10.);
+    square.rotate(0.3);
+    square.translate(bb.center().x(), bb.center().y());
+
+    for (auto orientation : {sla::RasterBase::roLandscape, sla::RasterBase::roPortrait})
+        for (auto &mirror : {sla::RasterBase::NoMirror, sla::RasterBase::MirrorX, sla::RasterBase::MirrorY, sla::RasterBase::MirrorXY}) {
+            sla::RasterBase::Trafo trafo{orientation, mirror};
+            trafo.center_x = bb.center().x() / 4;
+            trafo.center_y = bb.center().y() / 4;
+
+            sla::RasterGrayscaleAAGammaPower  agg_raster(res, pixdim, trafo, 1.);
+            sla::CoverageRasterGrayscaleAA    raster(res, pixdim, trafo, agg::gamma_power(1.));
+            for (const ExPolygon *poly : { &ring, &square }) {
+                agg_raster.draw(*poly);
+                raster.draw(*poly);
+            }
+
+            int  max_diff = 0;
+            long sum_agg  = 0;
+            long sum      = 0;
+            for (size_t y = 0; y < res.height_px; ++ y)
+                for (size_t x = 0; x < res.width_px; ++ x) {
+                    max_diff = std::max(max_diff, std::abs(int(agg_raster.read_pixel(x, y)) - int(raster.read_pixel(x, y))));
+                    sum_agg += agg_raster.read_pixel(x, y);
+                    sum     += raster.read_pixel(x, y);
+                }
+
+            REQUIRE(sum_agg > 0);
+            REQUIRE(max_diff <= 4);
+            REQUIRE(std::abs(sum - sum_agg) <= sum_agg / 10000);
+        }
+}
+
 TEST_CASE("halfcone test", "[halfcone]") {
     sla::DiffBridge br{Vec3d{1., 1., 1.}, Vec3d{10., 10., 10.}, 0.25, 0.5};
 
@@ -225,3 +357,50 @@ TEST_CASE("Test concurrency")
 
     REQUIRE(s == Approx(ref));
 }
+
+TEST_CASE("Slice level CSG subtracts negative volumes from the slices", "[SLAPrint]")
+{
+    Model model;
+    ModelObject *obj = model.add_object();
+    obj->add_volume(make_cube(20., 20., 20.));
+    TriangleMesh hole = make_cylinder(5., 30.);
+    hole.translate(10.f, 10.f, -5.f);
+    obj->add_volume(std::move(hole), ModelVolumeType::NEGATIVE_VOLUME);
+    obj->add_instance();
+
+    SLAFullPrintConfig fullcfg;
+    fullcfg.printer_technology.setInt(ptSLA);
+    fullcfg.set("supports_enable", false);
+    fullcfg.set("pad_enable", false);
+    fullcfg.set("slice_level_csg", true);
+
+    DynamicPrintConfig cfg;
+    cfg.apply(fullcfg);
+
+    SLAPrint print;
+    print.set_status_callback([](const PrintBase::SlicingStatus&) {});
+    print.apply(model, cfg);
+    print.process();
+
+    REQUIRE(print.objects().size() == 1);
+    const SLAPrintObject &po = *print.objects().front();
+
+    // The negative volume pierces the whole cube.
+    size_t layers = 0;
+    for (const SLAPrintObject::SliceRecord &rec : po.get_slice_index()) {
+        if (rec.get_slice_idx(soModel) == SLAPrintObject::SliceRecord::NONE)
+            continue;
+
+        const ExPolygons &slice = rec.get_slice(soModel);
+        REQUIRE(slice.size() == 1);
+        REQUIRE(slice.front().holes.size() == 1);
+        ++layers;
+    }
+    REQUIRE(layers > 0);
+
+    // The mesh to print is reconstructed from the slices.
+    auto mesh = po.get_mesh_to_print();
+    REQUIRE(mesh);
+    double vol = 20. * 20. * 20. - PI * 5. * 5. * 20.;
+    REQUIRE(its_volume(*mesh) == Approx(vol).epsilon(0.02));
+}